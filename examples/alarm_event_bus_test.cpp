@@ -0,0 +1,221 @@
+/*
+ * AlarmEventBus 压力测试：多生产者发布，检查不丢失、不重复、各消费者顺序一致，以及缓冲区满时的背压
+ *
+ * 1. 8个生产者各发布 20000 个事件到容量 256 的总线，3个消费者（其中一个较慢）；等待不限时，
+ *    每个消费者收到全部事件各一次，每个生产者的事件保持发布顺序，各消费者收到的顺序完全相同。
+ * 2. 消费者阻塞时缓冲区写满，等待不限时的发布方被阻塞，消费者恢复后全部投递。
+ * 3. 等待有上限时，发布方等待超时后丢弃事件并计数，之后直接丢弃，不再逐个等待。
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -I/usr/include/mysql -Iinclude -Iinclude/resource examples/alarm_event_bus_test.cpp \
+ *     src/alarms/alarm_event_bus.cpp src/core/log_manager.cpp -o alarm_event_bus_test -lpthread
+ */
+#include "alarm_event_bus.h"
+#include "log_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (condition) {
+        std::cout << "  ✅ " << what << std::endl;
+    } else {
+        std::cout << "  ❌ " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+AlarmEvent makeEvent(int producer, int index) {
+    AlarmEvent event;
+    event.status = "firing";
+    event.fingerprint = std::to_string(producer) + ":" + std::to_string(index);
+    event.labels["producer"] = std::to_string(producer);
+    event.labels["index"] = std::to_string(index);
+    return event;
+}
+
+// 每个消费者按收到的顺序记录 (生产者, 序号)
+struct Recorder {
+    std::vector<std::pair<int, int>> received;
+
+    void add(const std::vector<AlarmEvent>& events) {
+        for (const auto& event : events) {
+            received.emplace_back(std::stoi(event.labels.at("producer")), std::stoi(event.labels.at("index")));
+        }
+    }
+};
+
+// 关闭闸门前消费者在处理函数中阻塞
+class Gate {
+public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_open; });
+    }
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_open = true;
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_open = false;
+};
+
+void testStress() {
+    std::cout << "\n1. 多生产者压力测试..." << std::endl;
+    const int kProducers = 8;
+    const int kEvents = 20000;
+
+    AlarmEventBus bus(256, 64, std::chrono::milliseconds(0));
+    std::vector<Recorder> recorders(3);
+    bus.addConsumer("fast-1", [&](const std::vector<AlarmEvent>& events) { recorders[0].add(events); });
+    bus.addConsumer("fast-2", [&](const std::vector<AlarmEvent>& events) { recorders[1].add(events); });
+    bus.addConsumer("slow", [&](const std::vector<AlarmEvent>& events) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        recorders[2].add(events);
+    });
+    bus.start();
+
+    std::atomic<int> rejected{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kEvents; ++i) {
+                if (!bus.publish(makeEvent(p, i))) {
+                    ++rejected;
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    bus.stop();
+
+    const size_t total = static_cast<size_t>(kProducers) * kEvents;
+    check(rejected == 0 && bus.publishedCount() == total && bus.droppedCount() == 0,
+          "发布 " + std::to_string(bus.publishedCount()) + " 个事件，拒绝 " + std::to_string(rejected.load()));
+    check(bus.fullWaitCount() > 0, "缓冲区写满等待 " + std::to_string(bus.fullWaitCount()) + " 次");
+
+    for (size_t c = 0; c < recorders.size(); ++c) {
+        const auto& received = recorders[c].received;
+        std::set<std::pair<int, int>> unique(received.begin(), received.end());
+        std::vector<int> next(kProducers, 0);
+        bool ordered = true;
+        for (const auto& item : received) {
+            ordered = ordered && item.second == next[item.first];
+            next[item.first] = item.second + 1;
+        }
+        check(received.size() == total && unique.size() == total,
+              "消费者 " + std::to_string(c) + " 收到 " + std::to_string(received.size()) + " 个，不重复 " +
+                  std::to_string(unique.size()) + " 个");
+        check(ordered, "消费者 " + std::to_string(c) + " 收到的每个生产者的事件保持发布顺序");
+    }
+    check(recorders[0].received == recorders[1].received && recorders[0].received == recorders[2].received,
+          "各消费者收到的顺序相同");
+}
+
+void testBackpressure() {
+    std::cout << "\n2. 缓冲区满时阻塞发布方..." << std::endl;
+    const int kEvents = 40;
+
+    AlarmEventBus bus(8, 8, std::chrono::milliseconds(0));
+    Gate gate;
+    Recorder recorder;
+    bus.addConsumer("blocked", [&](const std::vector<AlarmEvent>& events) {
+        gate.wait();
+        recorder.add(events);
+    });
+    bus.start();
+
+    std::atomic<int> published{0};
+    std::thread producer([&]() {
+        for (int i = 0; i < kEvents; ++i) {
+            bus.publish(makeEvent(0, i));
+            ++published;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // 消费者取走一批（最多8个）后阻塞，缓冲区再写满8个，发布方阻塞在下一个
+    int blocked_at = published.load();
+    check(blocked_at < kEvents && blocked_at <= 16, "消费者阻塞时发布方停在第 " + std::to_string(blocked_at) + " 个");
+    check(bus.fullWaitCount() > 0, "记录缓冲区满等待");
+
+    gate.open();
+    producer.join();
+    bus.stop();
+    check(published == kEvents && recorder.received.size() == static_cast<size_t>(kEvents) &&
+              bus.droppedCount() == 0,
+          "消费者恢复后全部投递，未丢弃");
+}
+
+void testBoundedWait() {
+    std::cout << "\n3. 等待有上限时丢弃并计数..." << std::endl;
+    const int kEvents = 40;
+
+    AlarmEventBus bus(8, 8, std::chrono::milliseconds(50));
+    Gate gate;
+    Recorder recorder;
+    bus.addConsumer("blocked", [&](const std::vector<AlarmEvent>& events) {
+        gate.wait();
+        recorder.add(events);
+    });
+    bus.start();
+
+    int accepted = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEvents; ++i) {
+        // 等第一批被消费者取走，保证缓冲区的状态确定
+        if (i == 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (bus.publish(makeEvent(0, i))) {
+            ++accepted;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+    check(bus.droppedCount() > 0 && accepted + static_cast<int>(bus.droppedCount()) == kEvents,
+          "接受 " + std::to_string(accepted) + " 个，丢弃 " + std::to_string(bus.droppedCount()) + " 个");
+    // 只有第一次写满等待一个上限，之后直接丢弃
+    check(elapsed.count() < 500, "发布耗时 " + std::to_string(elapsed.count()) + " ms，没有逐个等待");
+
+    gate.open();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    check(bus.publish(makeEvent(1, 0)), "消费者恢复后可以再次发布");
+    bus.stop();
+    check(recorder.received.size() == static_cast<size_t>(accepted + 1), "已接受的事件全部投递");
+}
+
+}  // namespace
+
+int main() {
+    LogManager::init("log_config.json");
+    std::cout << "=== AlarmEventBus 测试 ===" << std::endl;
+
+    testStress();
+    testBackpressure();
+    testBoundedWait();
+
+    if (g_failures > 0) {
+        std::cout << "\n❌ " << g_failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "\n🎉 所有检查通过" << std::endl;
+    return 0;
+}
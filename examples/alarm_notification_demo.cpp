@@ -0,0 +1,146 @@
+/*
+ * 告警分组通知演示：本地 webhook 接收方 + 告警风暴
+ *
+ * 在本地启动一个 httplib 服务器充当 webhook 接收方（第一次请求返回503以演示重试），
+ * 向 AlarmNotifier 投递 200 台主机 × 5 个组件的 ComponentFailed、200 个 NodeOffline 和两条规则的告警，
+ * 之后全部恢复，统计接收方实际收到的消息数，并检查两条规则的告警分别发往两个分组。
+ * 事件的标签与生产者一致：AlarmSystem 的事件带 alert_name，AlarmRuleEngine 的事件带 alertname。
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -I/usr/include/mysql -Iinclude -Iinclude/resource examples/alarm_notification_demo.cpp \
+ *     src/alarms/alarm_notifier.cpp src/core/log_manager.cpp -o alarm_notification_demo -lpthread
+ */
+#include "alarm_notifier.h"
+#include "alarm_rule_engine.h"
+#include "httplib.h"
+#include "json.hpp"
+#include "log_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kPort = 18089;
+const int kHosts = 200;
+const int kComponents = 5;
+
+// name_label 为 alert_name（AlarmSystem 的 NodeOffline / ComponentFailed）或 alertname（AlarmRuleEngine）
+AlarmEvent makeEvent(const std::string& name_label, const std::string& alert_name,
+                     const std::map<std::string, std::string>& extra, const std::string& status) {
+    AlarmEvent event;
+    event.status = status;
+    event.labels = extra;
+    event.labels[name_label] = alert_name;
+    event.labels["severity"] = "严重";
+    event.labels["alert_type"] = "硬件资源";
+    event.fingerprint = "alertname=" + alert_name;
+    for (const auto& label : extra) {
+        event.fingerprint += "," + label.first + "=" + label.second;
+    }
+    event.starts_at = std::chrono::system_clock::now();
+    if (status == "resolved") {
+        event.ends_at = event.starts_at;
+    }
+    return event;
+}
+
+AlarmEvent makeRuleEvent(const std::string& alert_name, const std::string& host_ip, const std::string& status) {
+    AlarmEvent event = makeEvent("alertname", alert_name, {{"host_ip", host_ip}}, status);
+    event.labels["value"] = "95.000000";
+    event.labels["metrics"] = "usage_percent";
+    return event;
+}
+
+std::vector<AlarmEvent> storm(const std::string& status) {
+    std::vector<AlarmEvent> events;
+    for (int h = 0; h < kHosts; ++h) {
+        std::string host_ip = "192.168.10." + std::to_string(h);
+        events.push_back(makeEvent("alert_name", "NodeOffline", {{"host_ip", host_ip}}, status));
+        for (int c = 0; c < kComponents; ++c) {
+            events.push_back(makeEvent("alert_name", "ComponentFailed",
+                                       {{"host_ip", host_ip}, {"index", std::to_string(c)}}, status));
+        }
+        if (h % 4 == 0) {
+            events.push_back(makeRuleEvent("HighCpuUsage", host_ip, status));
+        }
+        if (h % 8 == 0) {
+            events.push_back(makeRuleEvent("HighMemoryUsage", host_ip, status));
+        }
+    }
+    return events;
+}
+
+}  // namespace
+
+int main() {
+    LogManager::init("log_config.json");
+
+    std::atomic<int> requests{0};
+    std::atomic<int> alerts{0};
+    std::mutex groups_mutex;
+    std::set<std::string> groups;
+    httplib::Server server;
+    server.Post("/webhook", [&](const httplib::Request& req, httplib::Response& res) {
+        if (requests.fetch_add(1) == 0) {
+            res.status = 503;
+            return;
+        }
+        auto message = nlohmann::json::parse(req.body);
+        alerts += static_cast<int>(message["alerts"].size());
+        {
+            std::lock_guard<std::mutex> lock(groups_mutex);
+            groups.insert(message["groupKey"].get<std::string>());
+        }
+        std::cout << "  收到 " << message["groupKey"].get<std::string>() << " " << message["status"].get<std::string>()
+                  << "，告警 " << message["alerts"].size() << " 条" << std::endl;
+        res.set_content("{}", "application/json");
+    });
+    std::thread server_thread([&]() { server.listen("127.0.0.1", kPort); });
+    server.wait_until_ready();
+
+    AlarmNotificationConfig config;
+    config.group_by = {"alert_name"};
+    config.group_wait = std::chrono::seconds(1);
+    config.group_interval = std::chrono::seconds(2);
+    AlarmWebhookReceiver receiver;
+    receiver.name = "local";
+    receiver.url = "http://127.0.0.1:" + std::to_string(kPort) + "/webhook";
+    receiver.retry_backoff = std::chrono::milliseconds(100);
+    config.receivers.push_back(receiver);
+
+    AlarmNotifier notifier(config);
+    notifier.start();
+
+    // 事件总线按批投递
+    size_t events = 0;
+    for (const std::string status : {"firing", "resolved"}) {
+        std::vector<AlarmEvent> all = storm(status);
+        events += all.size();
+        for (size_t i = 0; i < all.size(); i += 256) {
+            notifier.enqueue(std::vector<AlarmEvent>(all.begin() + i, all.begin() + std::min(all.size(), i + 256)));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    }
+    notifier.stop();
+
+    AlarmNotificationStats stats = notifier.getStats();
+    std::cout << "告警事件 " << events << " 个 -> 分组通知 " << stats.notifications << " 条，接收方收到 "
+              << stats.receivers[0].sent << " 条（重试 " << stats.receivers[0].retries << " 次），共 " << alerts
+              << " 条告警" << std::endl;
+
+    server.stop();
+    server_thread.join();
+
+    // 两条规则的告警应分别成组，不能落入同一个 {alert_name=} 分组
+    bool grouped = groups.count("{alert_name=HighCpuUsage}") && groups.count("{alert_name=HighMemoryUsage}") &&
+                   !groups.count("{alert_name=}");
+    std::cout << "分组 " << groups.size() << " 个：" << (grouped ? "规则告警按 alertname 分组" : "规则告警分组错误")
+              << std::endl;
+    return stats.receivers[0].failed == 0 && grouped ? 0 : 1;
+}
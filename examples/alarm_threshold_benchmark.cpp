@@ -0,0 +1,164 @@
+/*
+ * 阈值规则评估基准测试：10k 主机 × 500 条简单阈值规则
+ *
+ * 对比两种评估方式：
+ * - 逐行：每条规则遍历查询结果，按指标名查 std::map 后逐个比较（原 evaluateGroupedRule 的做法）
+ * - 列式：结果先转换为每个指标一列连续的 double，规则在列上用 threshold_kernel 生成位图，只展开置位的行
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -Iinclude/resource examples/alarm_threshold_benchmark.cpp src/utils/threshold_kernel.cpp -o alarm_threshold_benchmark
+ */
+#include "threshold_kernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t kHosts = 10000;
+const size_t kRules = 500;
+const int kRounds = 20;
+
+const char* kMetrics[] = {
+    "usage_percent", "load_avg_1m", "load_avg_5m", "load_avg_15m", "temperature",
+    "voltage", "current", "power", "core_allocated", "core_count"
+};
+
+struct Row {
+    std::map<std::string, std::string> labels;
+    std::map<std::string, double> metrics;
+};
+
+struct Rule {
+    std::string metric;
+    std::vector<std::pair<ThresholdOp, double>> conditions;
+};
+
+bool evaluateCondition(double value, ThresholdOp op, double threshold) {
+    switch (op) {
+        case ThresholdOp::GT: return value > threshold;
+        case ThresholdOp::LT: return value < threshold;
+        case ThresholdOp::GE: return value >= threshold;
+        case ThresholdOp::LE: return value <= threshold;
+        case ThresholdOp::EQ: return value == threshold;
+        case ThresholdOp::NE: return value != threshold;
+    }
+    return false;
+}
+
+// 逐行评估，返回满足条件的 (规则, 行) 数
+size_t evaluateRowWise(const std::vector<Row>& rows, const std::vector<Rule>& rules) {
+    size_t matched = 0;
+    for (const auto& rule : rules) {
+        for (const auto& row : rows) {
+            auto it = row.metrics.find(rule.metric);
+            if (it == row.metrics.end()) {
+                continue;
+            }
+            bool ok = true;
+            for (const auto& condition : rule.conditions) {
+                if (!evaluateCondition(it->second, condition.first, condition.second)) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (ok) {
+                ++matched;
+            }
+        }
+    }
+    return matched;
+}
+
+// 列式评估（含构建列式快照的开销）
+size_t evaluateColumnar(const std::vector<Row>& rows, const std::vector<Rule>& rules) {
+    std::unordered_map<std::string, std::vector<double>> columns;
+    for (const char* metric : kMetrics) {
+        columns.emplace(metric, std::vector<double>(rows.size(), std::numeric_limits<double>::quiet_NaN()));
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (const auto& metric : rows[i].metrics) {
+            auto it = columns.find(metric.first);
+            if (it != columns.end()) {
+                it->second[i] = metric.second;
+            }
+        }
+    }
+
+    size_t matched = 0;
+    for (const auto& rule : rules) {
+        const std::vector<double>& values = columns.at(rule.metric);
+        std::vector<uint64_t> mask = threshold_kernel::fullMask(values.size());
+        for (const auto& condition : rule.conditions) {
+            threshold_kernel::compareAnd(values.data(), values.size(), condition.first, condition.second, mask.data());
+        }
+        threshold_kernel::forEachSetBit(mask.data(), values.size(), [&](size_t i) {
+            if (!std::isnan(values[i])) {
+                ++matched;
+            }
+        });
+    }
+    return matched;
+}
+
+template <typename F>
+double measureMs(F&& f, size_t& result) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        result = f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / kRounds;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> percent(0.0, 100.0);
+    const size_t metric_count = sizeof(kMetrics) / sizeof(kMetrics[0]);
+
+    std::vector<Row> rows(kHosts);
+    for (size_t i = 0; i < kHosts; ++i) {
+        rows[i].labels["host_ip"] = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+        for (size_t m = 0; m < metric_count; ++m) {
+            // 约 2% 的主机缺少某个指标
+            if (rng() % 50 != 0) {
+                rows[i].metrics[kMetrics[m]] = percent(rng);
+            }
+        }
+    }
+
+    std::vector<Rule> rules(kRules);
+    for (auto& rule : rules) {
+        rule.metric = kMetrics[rng() % metric_count];
+        rule.conditions.emplace_back(static_cast<ThresholdOp>(rng() % 4), percent(rng));
+        // 约 1/4 的规则是区间条件
+        if (rng() % 4 == 0) {
+            rule.conditions.emplace_back(static_cast<ThresholdOp>(rng() % 4), percent(rng));
+        }
+    }
+
+    size_t row_wise_matched = 0;
+    size_t columnar_matched = 0;
+    double row_wise_ms = measureMs([&]() { return evaluateRowWise(rows, rules); }, row_wise_matched);
+    double columnar_ms = measureMs([&]() { return evaluateColumnar(rows, rules); }, columnar_matched);
+
+    std::cout << "阈值规则评估: " << kHosts << " 主机 x " << kRules << " 条规则, 每种方式 " << kRounds << " 轮" << std::endl;
+    std::cout << "  逐行 (std::map):     " << row_wise_ms << " ms/周期, 命中 " << row_wise_matched << std::endl;
+    std::cout << "  列式 (" << threshold_kernel::implementation() << "):        " << columnar_ms
+              << " ms/周期, 命中 " << columnar_matched << std::endl;
+    std::cout << "  加速比: " << (columnar_ms > 0 ? row_wise_ms / columnar_ms : 0.0) << "x" << std::endl;
+
+    if (row_wise_matched != columnar_matched) {
+        std::cerr << "结果不一致" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * SlidingWindow 测试：窗口淘汰、AVG/MIN/MAX/SUM/COUNT 与逐窗口重新计算的结果一致、RATE 跨计数器重置
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -Iinclude/resource examples/sliding_window_test.cpp src/utils/sliding_window.cpp \
+ *     -o sliding_window_test
+ */
+#include "sliding_window.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (condition) {
+        std::cout << "  ✅ " << what << std::endl;
+    } else {
+        std::cout << "  ❌ " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+// 按定义重新计算前 count 个样本中 (now - window, now] 内样本的聚合值，now 为第 count 个样本的时间
+bool reference(WindowFunc func, const std::vector<std::pair<int64_t, double>>& samples, size_t count,
+               int64_t window_ms, double& result) {
+    const int64_t now = samples[count - 1].first;
+    std::vector<double> values;
+    for (size_t i = 0; i < count; ++i) {
+        if (samples[i].first > now - window_ms) {
+            values.push_back(samples[i].second);
+        }
+    }
+    if (values.empty()) {
+        return false;
+    }
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    switch (func) {
+        case WindowFunc::AVG: result = sum / values.size(); break;
+        case WindowFunc::MIN: result = *std::min_element(values.begin(), values.end()); break;
+        case WindowFunc::MAX: result = *std::max_element(values.begin(), values.end()); break;
+        case WindowFunc::SUM: result = sum; break;
+        case WindowFunc::COUNT: result = static_cast<double>(values.size()); break;
+        case WindowFunc::RATE: return false;
+    }
+    return true;
+}
+
+void testEviction() {
+    std::cout << "\n1. 窗口淘汰..." << std::endl;
+    SlidingWindow window(WindowFunc::COUNT, 10000);
+    double value = 0.0;
+    check(!window.value(value) && window.empty(), "空窗口没有值");
+
+    window.add(0, 1.0);
+    window.add(5000, 2.0);
+    window.add(9999, 3.0);
+    check(window.value(value) && value == 3.0, "10秒内的3个样本都在窗口内");
+
+    window.add(10000, 4.0);
+    check(window.value(value) && value == 3.0, "恰好 window 之前的样本被淘汰");
+
+    window.evict(19999);
+    check(window.value(value) && value == 1.0, "evict 只保留最后一个样本");
+    window.evict(20000);
+    check(!window.value(value) && window.empty(), "全部淘汰后窗口为空");
+
+    SlidingWindow max_window(WindowFunc::MAX, 10000);
+    max_window.add(0, 9.0);
+    max_window.add(5000, 5.0);
+    max_window.add(12000, 1.0);
+    check(max_window.value(value) && value == 5.0, "MAX 的极值被淘汰后取窗口内的次大值");
+
+    SlidingWindow clamped(WindowFunc::COUNT, 1000);
+    clamped.add(5000, 1.0);
+    clamped.add(3000, 2.0);
+    check(clamped.lastTimestamp() == 5000 && clamped.value(value) && value == 2.0,
+          "时间戳倒退的样本按上一个样本的时间处理");
+}
+
+void testAggregates() {
+    std::cout << "\n2. AVG/MIN/MAX/SUM/COUNT 与逐窗口重新计算一致..." << std::endl;
+    const int64_t kWindowMs = 30000;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> step(0, 4000);
+    std::uniform_real_distribution<double> dist(-50.0, 150.0);
+
+    std::vector<std::pair<int64_t, double>> samples;
+    int64_t ts = 1700000000000LL;
+    for (int i = 0; i < 5000; ++i) {
+        ts += step(rng);
+        samples.emplace_back(ts, dist(rng));
+    }
+
+    const std::pair<WindowFunc, const char*> funcs[] = {
+        {WindowFunc::AVG, "AVG"}, {WindowFunc::MIN, "MIN"}, {WindowFunc::MAX, "MAX"},
+        {WindowFunc::SUM, "SUM"}, {WindowFunc::COUNT, "COUNT"}};
+    for (const auto& func : funcs) {
+        SlidingWindow window(func.first, kWindowMs);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            window.add(samples[i].first, samples[i].second);
+            double got = 0.0;
+            double want = 0.0;
+            bool has_got = window.value(got);
+            bool has_want = reference(func.first, samples, i + 1, kWindowMs, want);
+            if (has_got != has_want || (has_want && !near(got, want))) {
+                ++mismatches;
+            }
+        }
+        check(mismatches == 0, std::string(func.second) + " 在5000个样本上逐个比较，不一致 " +
+                                   std::to_string(mismatches) + " 次");
+    }
+}
+
+void testRate() {
+    std::cout << "\n3. RATE 跨计数器重置..." << std::endl;
+    double value = 0.0;
+
+    SlidingWindow single(WindowFunc::RATE, 60000);
+    single.add(0, 100.0);
+    check(!single.value(value), "只有一个样本时没有值");
+
+    SlidingWindow steady(WindowFunc::RATE, 60000);
+    for (int i = 0; i <= 10; ++i) {
+        steady.add(i * 1000, 1000.0 + i * 50.0);
+    }
+    check(steady.value(value) && near(value, 50.0), "单调递增的计数器每秒增长50");
+
+    // 100 -> 200 -> 50（重置，新值计为增量）-> 150：增量 100 + 50 + 100，共3秒
+    SlidingWindow reset(WindowFunc::RATE, 60000);
+    reset.add(0, 100.0);
+    reset.add(1000, 200.0);
+    reset.add(2000, 50.0);
+    reset.add(3000, 150.0);
+    bool has_value = reset.value(value);
+    check(has_value && near(value, 250.0 / 3.0), "重置后的值计为增量: " + std::to_string(value));
+
+    // 重置发生在窗口首个样本之后，淘汰首个样本时减去新首个样本的增量
+    SlidingWindow evicting(WindowFunc::RATE, 2500);
+    evicting.add(0, 100.0);
+    evicting.add(1000, 200.0);
+    evicting.add(2000, 50.0);
+    evicting.add(3000, 150.0);
+    has_value = evicting.value(value);
+    check(has_value && near(value, 150.0 / 2.0), "淘汰首个样本后只计窗口内的增量: " + std::to_string(value));
+
+    SlidingWindow same_time(WindowFunc::RATE, 60000);
+    same_time.add(1000, 1.0);
+    same_time.add(1000, 2.0);
+    check(!same_time.value(value), "样本时间相同时没有值");
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "=== SlidingWindow 测试 ===" << std::endl;
+
+    testEviction();
+    testAggregates();
+    testRate();
+
+    if (g_failures > 0) {
+        std::cout << "\n❌ " << g_failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "\n🎉 所有检查通过" << std::endl;
+    return 0;
+}
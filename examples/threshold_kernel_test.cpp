@@ -0,0 +1,156 @@
+/*
+ * threshold_kernel 测试：AVX2 / SSE2 / 标量实现与逐值比较的结果一致
+ *
+ * 每种实现对所有操作符、包含 NaN / ±inf / -0.0 / 恰好等于阈值的数据，以及不是向量宽度（2、4）
+ * 和位图字长（64）整数倍的长度，与逐值比较的结果逐位比较；位图的初始值随机，同时检查按位与的语义。
+ * CPU 不支持的实现跳过并打印提示。
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -Iinclude/resource examples/threshold_kernel_test.cpp src/utils/threshold_kernel.cpp \
+ *     -o threshold_kernel_test
+ */
+#include "threshold_kernel.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (condition) {
+        std::cout << "  ✅ " << what << std::endl;
+    } else {
+        std::cout << "  ❌ " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+const ThresholdOp kOps[] = {ThresholdOp::GT, ThresholdOp::LT, ThresholdOp::GE,
+                            ThresholdOp::LE, ThresholdOp::EQ, ThresholdOp::NE};
+const char* const kOpNames[] = {">", "<", ">=", "<=", "==", "!="};
+
+// 逐值比较，NaN（值或阈值）不满足任何条件
+bool expected(double value, ThresholdOp op, double threshold) {
+    if (std::isnan(value) || std::isnan(threshold)) {
+        return false;
+    }
+    switch (op) {
+        case ThresholdOp::GT: return value > threshold;
+        case ThresholdOp::LT: return value < threshold;
+        case ThresholdOp::GE: return value >= threshold;
+        case ThresholdOp::LE: return value <= threshold;
+        case ThresholdOp::EQ: return value == threshold;
+        case ThresholdOp::NE: return value != threshold;
+    }
+    return false;
+}
+
+std::vector<double> makeValues(size_t count, double threshold, std::mt19937_64& rng) {
+    const double kNaN = std::numeric_limits<double>::quiet_NaN();
+    const double kInf = std::numeric_limits<double>::infinity();
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_real_distribution<double> dist(threshold - 10.0, threshold + 10.0);
+    std::vector<double> values(count);
+    for (auto& value : values) {
+        switch (kind(rng)) {
+            case 0: value = kNaN; break;
+            case 1: value = threshold; break;
+            case 2: value = (kind(rng) % 2) ? kInf : -kInf; break;
+            case 3: value = -0.0; break;
+            default: value = dist(rng); break;
+        }
+    }
+    return values;
+}
+
+// 对一种实现比较所有操作符和长度，返回不一致的位数
+size_t compareImplementation(const std::vector<size_t>& lengths, const std::vector<double>& thresholds) {
+    std::mt19937_64 rng(2024);
+    size_t mismatches = 0;
+    for (size_t count : lengths) {
+        for (double threshold : thresholds) {
+            std::vector<double> values = makeValues(count, threshold, rng);
+            for (ThresholdOp op : kOps) {
+                std::vector<uint64_t> mask = threshold_kernel::fullMask(count);
+                for (auto& word : mask) {
+                    word &= rng();
+                }
+                const std::vector<uint64_t> initial = mask;
+                threshold_kernel::compareAnd(values.data(), count, op, threshold, mask.data());
+                for (size_t i = 0; i < count; ++i) {
+                    bool initial_bit = (initial[i / 64] >> (i % 64)) & 1;
+                    bool bit = (mask[i / 64] >> (i % 64)) & 1;
+                    if (bit != (initial_bit && expected(values[i], op, threshold))) {
+                        ++mismatches;
+                    }
+                }
+                // 超出 count 的位保持为0
+                if (count % 64 != 0 && (mask.back() >> (count % 64)) != 0) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+void testNaN() {
+    std::cout << "\n1. NaN 不满足任何条件（包括 !=）..." << std::endl;
+    const double kNaN = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values(67, kNaN);
+    values[1] = 5.0;
+    for (size_t o = 0; o < 6; ++o) {
+        std::vector<uint64_t> mask = threshold_kernel::fullMask(values.size());
+        threshold_kernel::compareAnd(values.data(), values.size(), kOps[o], 3.0, mask.data());
+        bool only_value = mask[0] == (expected(5.0, kOps[o], 3.0) ? 2ULL : 0ULL) && mask[1] == 0;
+
+        std::vector<uint64_t> nan_threshold = threshold_kernel::fullMask(values.size());
+        threshold_kernel::compareAnd(values.data(), values.size(), kOps[o], kNaN, nan_threshold.data());
+        check(only_value && nan_threshold[0] == 0 && nan_threshold[1] == 0,
+              std::string("NaN ") + kOpNames[o] + " 3、5 " + kOpNames[o] + " NaN 都不满足");
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "=== threshold_kernel 测试 ===" << std::endl;
+    std::cout << "默认实现: " << threshold_kernel::implementation() << std::endl;
+
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 130; ++n) {
+        lengths.push_back(n);
+    }
+    for (size_t n : {191, 192, 193, 255, 1000, 1023, 1025, 4099}) {
+        lengths.push_back(n);
+    }
+    const std::vector<double> thresholds = {0.0, 90.0, -1.5, 1e300};
+
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (!threshold_kernel::setImplementation(name)) {
+            std::cout << "\n⚠️  本机不支持 " << name << " 实现，跳过" << std::endl;
+            continue;
+        }
+        std::cout << "\n== 实现: " << threshold_kernel::implementation() << " ==" << std::endl;
+        testNaN();
+        std::cout << "\n2. 与逐值比较一致（长度 0..130 及非向量宽度整数倍的长度）..." << std::endl;
+        size_t mismatches = compareImplementation(lengths, thresholds);
+        check(mismatches == 0, std::string(name) + " 不一致的位数: " + std::to_string(mismatches));
+    }
+    threshold_kernel::setImplementation("");
+    std::cout << std::endl;
+    check(!threshold_kernel::setImplementation("neon"), "不存在的实现返回false");
+
+    if (g_failures > 0) {
+        std::cout << "\n❌ " << g_failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "\n🎉 所有检查通过" << std::endl;
+    return 0;
+}
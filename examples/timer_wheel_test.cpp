@@ -0,0 +1,163 @@
+/*
+ * TimerWheel 测试：高层下放、到期前取消、超出最高层范围的定时器、已过期的定时器
+ *
+ * 时间轮只由 advance 的参数推进，测试用构造后取得的时间点加整数个刻度驱动，不依赖真实的等待。
+ * 构造时间与测试起点之间有不足一个刻度的偏差，因此第 k 个刻度的定时器在推进到 k 或 k+1 时到期，
+ * 但不会早于 k。
+ *
+ * 编译：
+ * g++ -std=c++14 -O2 -Iinclude/resource examples/timer_wheel_test.cpp -o timer_wheel_test
+ */
+#include "timer_wheel.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Wheel = TimerWheel<int>;
+
+const std::chrono::milliseconds kTick(10);
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (condition) {
+        std::cout << "  ✅ " << what << std::endl;
+    } else {
+        std::cout << "  ❌ " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+// 测试用时间轮：4个槽、3层，共覆盖64个刻度，少量刻度即可经过所有层
+struct Fixture {
+    Wheel wheel{kTick, 4, 3};
+    Clock::time_point start = Clock::now();
+
+    Clock::time_point at(int64_t ticks) const { return start + kTick * ticks; }
+
+    // 逐刻度推进到 ticks，记录每个定时器到期时的刻度
+    void runTo(int64_t from, int64_t ticks, std::map<int, int64_t>& fired_at) {
+        std::vector<std::pair<uint64_t, int>> expired;
+        for (int64_t t = from; t <= ticks; ++t) {
+            expired.clear();
+            wheel.advance(at(t), expired);
+            for (const auto& item : expired) {
+                fired_at[item.second] = t;
+            }
+        }
+    }
+};
+
+void testCascade() {
+    std::cout << "\n1. 高层定时器逐层下放后按时到期..." << std::endl;
+    Fixture f;
+    // 2 在第0层，9 在第1层，40 在第2层
+    for (int k : {2, 9, 40}) {
+        f.wheel.schedule(f.at(k), k);
+    }
+    std::map<int, int64_t> fired_at;
+    f.runTo(1, 45, fired_at);
+    for (int k : {2, 9, 40}) {
+        auto it = fired_at.find(k);
+        check(it != fired_at.end() && it->second >= k && it->second <= k + 1,
+              "第 " + std::to_string(k) + " 刻度的定时器在 " +
+                  (it == fired_at.end() ? std::string("-") : std::to_string(it->second)) + " 到期");
+    }
+
+    // 随机到期时间：每个定时器只到期一次，且不早于到期时间
+    Fixture g;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(1, 63);
+    std::map<int, int> deadlines;
+    for (int i = 0; i < 500; ++i) {
+        int k = dist(rng);
+        g.wheel.schedule(g.at(k), i);
+        deadlines[i] = k;
+    }
+    std::map<int, int64_t> random_fired;
+    g.runTo(1, 70, random_fired);
+    bool on_time = random_fired.size() == deadlines.size();
+    for (const auto& item : random_fired) {
+        int k = deadlines[item.first];
+        on_time = on_time && item.second >= k && item.second <= k + 1;
+    }
+    check(on_time && g.wheel.size() == 0, "500个随机定时器全部到期且不早于到期时间");
+}
+
+void testCancel() {
+    std::cout << "\n2. 到期前取消..." << std::endl;
+    Fixture f;
+    uint64_t low = f.wheel.schedule(f.at(3), 1);
+    uint64_t high = f.wheel.schedule(f.at(30), 2);
+    f.wheel.schedule(f.at(31), 3);
+
+    std::map<int, int64_t> fired_at;
+    f.runTo(1, 2, fired_at);
+    check(f.wheel.cancel(low), "取消第0层的定时器");
+    check(f.wheel.cancel(high), "取消高层的定时器");
+    check(!f.wheel.cancel(high), "重复取消返回false");
+    check(f.wheel.size() == 1, "剩余1个定时器");
+
+    f.runTo(3, 40, fired_at);
+    check(fired_at.count(1) == 0 && fired_at.count(2) == 0, "已取消的定时器不到期");
+    check(fired_at.count(3) == 1, "未取消的定时器照常到期");
+    check(!f.wheel.cancel(3), "已到期的定时器取消返回false");
+}
+
+void testBeyondRange() {
+    std::cout << "\n3. 超出最高层范围的定时器..." << std::endl;
+    Fixture f;
+    f.wheel.schedule(f.at(200), 1);
+    std::map<int, int64_t> fired_at;
+    f.runTo(1, 199, fired_at);
+    check(fired_at.empty() && f.wheel.size() == 1, "第199刻度前未到期");
+    f.runTo(200, 201, fired_at);
+    check(fired_at.count(1) == 1, "第 " + std::to_string(fired_at.count(1) ? fired_at[1] : -1) + " 刻度到期");
+
+    // 一次推进跨过多圈
+    Fixture g;
+    g.wheel.schedule(g.at(1000), 2);
+    std::vector<std::pair<uint64_t, int>> expired;
+    g.wheel.advance(g.at(999), expired);
+    check(expired.empty(), "一次推进到第999刻度未到期");
+    g.wheel.advance(g.at(1001), expired);
+    check(expired.size() == 1 && expired[0].second == 2, "一次推进到第1001刻度到期");
+}
+
+void testPastDeadline() {
+    std::cout << "\n4. 已过期的定时器在下一个刻度到期..." << std::endl;
+    Fixture f;
+    std::vector<std::pair<uint64_t, int>> expired;
+    f.wheel.advance(f.at(10), expired);
+
+    f.wheel.schedule(f.at(2), 1);
+    f.wheel.schedule(f.start - std::chrono::seconds(1), 2);
+    f.wheel.advance(f.at(10), expired);
+    check(expired.empty(), "当前刻度内不到期");
+    f.wheel.advance(f.at(11), expired);
+    check(expired.size() == 2, "下一个刻度到期 " + std::to_string(expired.size()) + " 个");
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "=== TimerWheel 测试 ===" << std::endl;
+
+    testCascade();
+    testCancel();
+    testBeyondRange();
+    testPastDeadline();
+
+    if (g_failures > 0) {
+        std::cout << "\n❌ " << g_failures << " 项检查失败" << std::endl;
+        return 1;
+    }
+    std::cout << "\n🎉 所有检查通过" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "alarm_rule_engine.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 单个消费者的投递统计
+struct AlarmEventConsumerStats {
+    std::string name;
+    uint64_t delivered = 0;      // 已投递的事件数
+    uint64_t batches = 0;        // 已投递的批次数
+    uint64_t lag = 0;            // 已发布但尚未投递的事件数
+    uint64_t max_lag = 0;        // 取批时观察到的最大积压
+    uint64_t last_batch_us = 0;  // 最近一批处理耗时（微秒）
+};
+
+/**
+ * @brief 告警事件总线
+ *
+ * 规则引擎和节点/组件监控只负责把事件发布到固定容量的环形缓冲区，MySQL 持久化、WebSocket
+ * 推送和用户回调作为独立的消费者在各自线程中按批取出事件，慢消费者不会阻塞评估，也不会拖慢
+ * 其他消费者。
+ *
+ * 多个生产者通过 CAS 领取序号后写入槽位，再以槽位序号发布，发布路径不加锁；每个消费者维护
+ * 自己的读游标，所有消费者都读过的槽位才会被复用。缓冲区写满时生产者让出CPU等待最慢的
+ * 消费者，等待次数计入统计；规则引擎在分片锁内发布事件，因此等待时长有上限（max_full_wait），
+ * 超时的事件被丢弃并计数，之后缓冲区仍满时的发布直接丢弃，直到有事件发布成功，避免慢消费者
+ * 让每个事件都阻塞写入路径。max_full_wait 为0时一直等待，不丢弃事件。
+ * 每个消费者按发布顺序收到全部已发布的事件。
+ *
+ * 消费者须在 start() 之前注册；stop() 在投递完已发布的事件后返回，调用前应先停止所有生产者。
+ */
+class AlarmEventBus {
+public:
+    using BatchHandler = std::function<void(const std::vector<AlarmEvent>&)>;
+
+    // capacity 向上取整为2的幂；max_batch 为单次投递的最大事件数；max_full_wait 为缓冲区满时发布方的最长等待时间
+    explicit AlarmEventBus(size_t capacity = 65536, size_t max_batch = 256,
+                           std::chrono::milliseconds max_full_wait = std::chrono::milliseconds(100));
+    ~AlarmEventBus();
+
+    AlarmEventBus(const AlarmEventBus&) = delete;
+    AlarmEventBus& operator=(const AlarmEventBus&) = delete;
+
+    // 注册消费者，start() 之后调用返回false
+    bool addConsumer(const std::string& name, BatchHandler handler);
+
+    void start();
+    void stop();
+
+    // 发布事件，总线未运行或缓冲区满等待超时被丢弃时返回false
+    bool publish(const AlarmEvent& event);
+
+    std::vector<AlarmEventConsumerStats> getConsumerStats() const;
+    uint64_t publishedCount() const { return m_claim.load(std::memory_order_relaxed); }
+    uint64_t fullWaitCount() const { return m_full_waits.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    size_t capacity() const { return m_slots.size(); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};  // 序号 s 的事件写入完成后置为 s + 1
+        AlarmEvent event;
+    };
+
+    struct Consumer {
+        std::string name;
+        BatchHandler handler;
+        std::atomic<uint64_t> cursor{0};  // 下一个待读取的序号
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> max_lag{0};
+        std::atomic<uint64_t> last_batch_us{0};
+        std::thread thread;
+    };
+
+    void consumerLoop(Consumer& consumer);
+    uint64_t minCursor() const;
+
+    std::vector<Slot> m_slots;
+    uint64_t m_mask;
+    size_t m_max_batch;
+    std::chrono::milliseconds m_max_full_wait;
+    std::vector<std::unique_ptr<Consumer>> m_consumers;
+
+    std::atomic<uint64_t> m_claim{0};  // 下一个待领取的序号
+    std::atomic<uint64_t> m_full_waits{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<bool> m_overflowing{false};  // 上一次等待超时后尚无事件发布成功
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopping{false};
+
+    // 消费者空闲时等待，生产者仅在有等待者时通知
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait_cv;
+    std::atomic<int> m_waiters{0};
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "alarm_rule_engine.h"
+#include "bmc_listener.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class AlarmManager;
+class NodeStorage;
+
+// 拓扑抑制统计
+struct AlarmInhibitionStats {
+    uint64_t roots_raised = 0;        // 已产生的根因告警数
+    uint64_t events_inhibited = 0;    // 被根因吸收的 firing 事件数
+    uint64_t resolved_absorbed = 0;   // 被吸收告警的 resolved 事件数（同样不发布）
+    uint64_t events_released = 0;     // 根因恢复后仍未恢复、补发的 firing 事件数
+    size_t active_roots = 0;          // 当前活动的根因告警数
+    size_t inhibited_alarms = 0;      // 当前被吸收的告警数
+};
+
+// 活动的根因告警及其吸收的告警数
+struct AlarmInhibitionRoot {
+    std::string fingerprint;
+    std::string alert_name;           // ChassisUnreachable 或 BoardAbsent
+    int box_id = 0;
+    int slot_id = 0;                  // 机箱级根因为0
+    size_t dependents = 0;
+    std::chrono::system_clock::time_point starts_at;
+};
+
+/**
+ * @brief 按机箱/槽位拓扑抑制告警
+ *
+ * 整箱掉电时每块板卡各产生一个 NodeOffline，每个容器各产生一个 ComponentFailed，再加上资源规则的告警，
+ * 每个都是一次MySQL写入和WebSocket广播。抑制器位于事件总线之前，维护 host_ip -> (box_id, slot_id)
+ * 的拓扑索引（BMC组播按 Utils::calculateHostIP 计算，其余节点取自 NodeStorage），识别两类根因：
+ *
+ * - ChassisUnreachable：机箱的BMC组播和机箱内所有节点的心跳都已超时；
+ * - BoardAbsent：BMC组播仍在上报，但此前在位的板卡不再在位。
+ *
+ * 带 host_ip 标签的告警在其节点属于活动根因时被吸收，不发布到总线，只记在根因下；其 resolved 事件
+ * 同样被吸收。根因恢复后等待 release_delay，仍未恢复的告警再补发 firing。每个事件的判定只做几次
+ * 哈希查找，不遍历节点。
+ */
+class AlarmInhibitor {
+public:
+    using Publisher = std::function<void(const AlarmEvent&)>;
+
+    AlarmInhibitor(std::shared_ptr<NodeStorage> node_storage, std::shared_ptr<AlarmManager> alarm_manager,
+                   Publisher publisher);
+    ~AlarmInhibitor();
+
+    AlarmInhibitor(const AlarmInhibitor&) = delete;
+    AlarmInhibitor& operator=(const AlarmInhibitor&) = delete;
+
+    // 根因恢复后等待多久再补发仍未恢复的告警
+    void setReleaseDelay(std::chrono::seconds delay);
+
+    void start();
+    void stop();
+
+    // 告警事件发布前调用，返回false表示事件已被根因吸收，调用方不应再发布
+    bool admit(const AlarmEvent& event);
+
+    // BMC组播数据：更新拓扑索引、机箱最近上报时间和板卡在位状态，须在写入NodeStorage之前调用
+    void observeBmc(const UdpInfo& info);
+
+    AlarmInhibitionStats getStats() const;
+    std::vector<AlarmInhibitionRoot> getActiveRoots() const;
+
+private:
+    struct HostLocation {
+        int box_id = 0;
+        int slot_id = 0;
+    };
+
+    struct Box {
+        int64_t last_bmc_ms = 0;                // 最近一次BMC组播的到达时间（steady_clock），0表示未收到过
+        uint32_t present_slots = 0;             // 最近一次BMC组播中在位的槽位（第 slot_id 位）
+        std::unordered_set<std::string> hosts;  // 属于该机箱的节点
+    };
+
+    struct Root {
+        AlarmInhibitionRoot info;
+        AlarmEvent event;                            // 发布的 firing 事件
+        int64_t cleared_ms = 0;                      // 恢复时间，0表示活动
+        std::unordered_set<std::string> dependents;  // 被吸收告警的指纹
+    };
+
+    struct Inhibited {
+        std::string root;  // 根因指纹
+        AlarmEvent event;  // 被吸收的 firing 事件，补发时原样发布
+    };
+
+    void run();
+    void tick(int64_t now_ms, std::vector<AlarmEvent>& out);
+
+    const HostLocation* locate(const std::string& host_ip);
+    void indexHost(const std::string& host_ip, int box_id, int slot_id);
+    bool hostLost(const std::string& host_ip, int64_t now_ms) const;
+    bool chassisUnreachable(const Box& box, int64_t now_ms) const;
+    Root* activeRoot(const std::string& fingerprint);
+    Root* findRoot(const std::string& host_ip, const HostLocation& location, int64_t now_ms,
+                   std::vector<AlarmEvent>& out);
+
+    void raiseRoot(const std::string& alert_name, int box_id, int slot_id, const std::string& host_ip,
+                   const std::string& description, std::vector<AlarmEvent>& out);
+    void clearRoot(const std::string& fingerprint, int64_t now_ms, std::vector<AlarmEvent>& out);
+    std::string chassisFingerprint(int box_id) const;
+    std::string boardFingerprint(int box_id, int slot_id) const;
+
+    void publishAll(const std::vector<AlarmEvent>& events);
+    // 离线判定的阈值：活跃超时减去两个监控检查周期，容忍同一机箱内节点心跳的先后
+    int64_t lostAfterMs() const;
+    static int64_t steadyNowMs();
+
+    std::shared_ptr<NodeStorage> m_node_storage;
+    std::shared_ptr<AlarmManager> m_alarm_manager;
+    Publisher m_publisher;
+    std::chrono::milliseconds m_release_delay{std::chrono::seconds(60)};
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, HostLocation> m_hosts;
+    std::unordered_map<int, Box> m_boxes;
+    std::unordered_map<std::string, Root> m_roots;
+    std::unordered_map<std::string, Inhibited> m_inhibited;
+    std::unordered_map<int, std::string> m_chassis_roots;  // box_id -> 根因指纹
+    std::unordered_map<std::string, std::string> m_board_roots;  // host_ip -> 根因指纹
+
+    uint64_t m_roots_raised = 0;
+    uint64_t m_events_inhibited = 0;
+    uint64_t m_resolved_absorbed = 0;
+    uint64_t m_events_released = 0;
+
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait_cv;
+};
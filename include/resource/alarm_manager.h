@@ -12,6 +12,7 @@
 
 // 前向声明以避免传播MySQL重依赖
 class MySQLConnectionPool;
+typedef struct st_mysql MYSQL;
 
 // 告警事件 (从 alarm_rule_engine.h 复制定义)
 struct AlarmEvent;
@@ -43,7 +44,7 @@ struct PaginatedAlarmEvents {
 
 // 简单告警管理器
 // 功能：接收告警事件，存储到MySQL数据库
-// 暂不实现：分组、静默、抑制等高级功能
+// 分组通知见 AlarmNotifier，拓扑抑制见 AlarmInhibitor；暂不实现：静默
 class AlarmManager {
 public:
     // 常量定义 - 保留用于向后兼容，但实际使用连接池配置
@@ -77,6 +78,9 @@ public:
     // 核心功能：处理告警事件
     bool processAlarmEvent(const AlarmEvent& event);
     
+    // 批量处理告警事件（同一连接、同一事务），返回成功处理的事件数
+    size_t processAlarmEvents(const std::vector<AlarmEvent>& events);
+    
     // 查询功能
     std::vector<AlarmEventRecord> getActiveAlarmEvents();
     std::vector<AlarmEventRecord> getRecentAlarmEvents(int limit = 100);
@@ -101,7 +105,9 @@ private:
     
     // 告警事件处理
     bool insertAlarmEvent(const AlarmEvent& event);
+    bool insertAlarmEvent(MYSQL* mysql, const AlarmEvent& event);
     bool updateAlarmEventToResolved(const std::string& fingerprint, const AlarmEvent& event);
+    bool updateAlarmEventToResolved(MYSQL* mysql, const std::string& fingerprint);
     bool alarmEventExists(const std::string& fingerprint);
     
     // 工具函数
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct AlarmEvent;
+
+// HTTP webhook 接收方
+struct AlarmWebhookReceiver {
+    std::string name;
+    std::string url;                              // http://host:port/path
+    size_t queue_capacity = 1024;                 // 待发送通知数上限，写满时丢弃最旧的通知
+    int max_retries = 3;                          // 连接失败、5xx、429 时的重试次数
+    std::chrono::milliseconds retry_backoff{500}; // 首次重试等待，之后每次加倍
+    std::chrono::milliseconds timeout{5000};      // 连接和读写超时
+};
+
+// 告警分组通知配置
+struct AlarmNotificationConfig {
+    std::vector<std::string> group_by = {"alert_name"};  // 分组标签，缺失的标签按空值处理；alert_name 与 alertname 视为同一标签
+    std::chrono::seconds group_wait{30};        // 新分组第一次通知前的等待时间，收集同一批告警
+    std::chrono::seconds group_interval{300};   // 同一分组两次通知之间的最短间隔
+    size_t max_alerts_per_message = 1000;       // 单条通知携带的告警数上限，超出部分计入 truncatedAlerts，0表示不限
+    std::vector<AlarmWebhookReceiver> receivers;
+};
+
+// 单个接收方的投递统计
+struct AlarmReceiverStats {
+    std::string name;
+    uint64_t sent = 0;      // 投递成功的通知数
+    uint64_t failed = 0;    // 重试耗尽后放弃的通知数
+    uint64_t retries = 0;   // 重试次数
+    uint64_t dropped = 0;   // 队列已满被丢弃的通知数
+    size_t queued = 0;      // 当前待发送的通知数
+    uint64_t last_latency_ms = 0;  // 最近一次成功投递的耗时（含重试）
+};
+
+struct AlarmNotificationStats {
+    uint64_t events = 0;         // 收到的告警事件数
+    uint64_t notifications = 0;  // 生成的分组通知数（每个接收方各一条计一次）
+    size_t groups = 0;           // 当前分组数
+    std::vector<AlarmReceiverStats> receivers;
+};
+
+/**
+ * @brief 告警分组与通知分发
+ *
+ * 作为告警事件总线的消费者，按 group_by 标签把告警事件归入分组：新分组等待 group_wait 后发出
+ * 第一条通知，之后分组内有新的 firing / resolved 时最多每 group_interval 通知一次，每条通知包含
+ * 分组内所有告警（Alertmanager webhook 格式，version 4），已通知的 resolved 告警随后移出分组。
+ * 上千个告警事件到接收方只是每个分组的几条消息。
+ *
+ * 每个接收方有独立的有界队列和发送线程，发送线程复用一个 keep-alive 的 HTTP 连接，连接失败、
+ * 5xx 和 429 按指数退避重试。慢接收方只会积压自己的队列，不影响总线和其他接收方。
+ */
+class AlarmNotifier {
+public:
+    explicit AlarmNotifier(const AlarmNotificationConfig& config);
+    ~AlarmNotifier();
+
+    AlarmNotifier(const AlarmNotifier&) = delete;
+    AlarmNotifier& operator=(const AlarmNotifier&) = delete;
+
+    void start();
+    // 立即通知所有有变化的分组，发送完队列中的通知（不再重试）后返回
+    void stop();
+
+    // 事件总线消费者入口，只更新分组状态，不做网络IO
+    void enqueue(const std::vector<AlarmEvent>& events);
+
+    AlarmNotificationStats getStats() const;
+
+private:
+    struct AlertState {
+        std::string status;
+        std::map<std::string, std::string> labels;
+        std::map<std::string, std::string> annotations;
+        std::chrono::system_clock::time_point starts_at;
+        std::chrono::system_clock::time_point ends_at;
+    };
+
+    struct Group {
+        std::map<std::string, std::string> labels;   // 分组标签
+        std::map<std::string, AlertState> alerts;    // 指纹 -> 告警，按指纹有序保证通知内容稳定
+        int64_t next_flush_ms = 0;                   // 下一次可以通知的时间（steady_clock）
+        int64_t last_flush_ms = 0;                   // 上一次通知时间，0表示尚未通知
+        bool dirty = false;                          // 上次通知后是否有变化
+    };
+
+    struct Receiver {
+        AlarmWebhookReceiver config;
+        std::string scheme_host_port;
+        std::string path;
+        std::deque<std::string> queue;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread thread;
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> retries{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> last_latency_ms{0};
+    };
+
+    void dispatchLoop();
+    void flushDue(int64_t now_ms, bool all);
+    std::string buildMessage(const std::string& group_key, const Group& group, const std::string& receiver) const;
+    std::string groupKey(const std::map<std::string, std::string>& labels,
+                         std::map<std::string, std::string>& group_labels) const;
+
+    void deliverLoop(Receiver& receiver);
+    void push(Receiver& receiver, std::string body);
+
+    static int64_t steadyNowMs();
+
+    AlarmNotificationConfig m_config;
+    std::vector<std::unique_ptr<Receiver>> m_receivers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unordered_map<std::string, Group> m_groups;
+    std::unordered_map<std::string, std::string> m_alert_groups;  // 指纹 -> 分组键
+    uint64_t m_events = 0;
+    uint64_t m_notifications = 0;
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopping{false};
+    std::thread m_dispatch_thread;
+};
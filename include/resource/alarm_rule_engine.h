@@ -9,9 +9,20 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
 #include "json.hpp"
 #include "alarm_rule_storage.h"
 #include "resource_storage.h"
+#include "worker_pool.h"
+#include "timer_wheel.h"
+#include "sliding_window.h"
+#include "ewma_baseline.h"
+#include "forecast_index.h"
+#include "threshold_kernel.h"
+#include "flap_detector.h"
+#include "rolling_histogram.h"
 
 
 // 告警实例状态
@@ -22,6 +33,89 @@ enum class AlarmInstanceState {
     RESOLVED    // 此前处于FIRING状态的告警，条件不再满足
 };
 
+// 规则评估模式
+enum class AlarmEvaluationMode {
+    POLLING,    // 每个评估周期为每条规则执行一次SQL查询
+    STREAMING   // 写入路径推送样本并在进程内评估，SQL查询仅用于周期性一致性校验和没有推送来源的超级表
+};
+
+// SQL评估周期统计
+struct AlarmEvaluationStats {
+    uint64_t cycles = 0;                 // 已完成的SQL评估周期数
+    uint64_t total_queries = 0;          // 累计执行的查询数
+    size_t last_cycle_rules = 0;         // 上一周期执行SQL评估的规则数（逐条评估时即为查询数）
+    size_t last_cycle_queries = 0;       // 上一周期实际执行的查询数（按超级表和标签分组后）
+    int64_t last_cycle_duration_ms = 0;  // 上一周期耗时（毫秒）
+    int64_t max_cycle_duration_ms = 0;   // 最长周期耗时（毫秒）
+    uint64_t overruns = 0;               // 耗时超过评估间隔的周期数
+    size_t worker_threads = 0;           // 评估工作线程数
+    uint64_t suppressed_events = 0;      // 实例抖动期间被抑制的告警事件数
+    int64_t rule_cost_budget_ms = 0;     // 单条规则每次评估的开销预算（毫秒），0 表示不检查
+    size_t slow_rules = 0;               // 窗口内平均开销超过预算的规则数
+};
+
+// 单条规则最近窗口内的SQL评估开销，每次评估记录一次（耗时单位为微秒）
+struct AlarmRuleProfile {
+    std::string alert_name;
+    std::string kind;               // "sql"、"join"（组合条件）或 "stream"（只在写入路径上评估，不记录开销）
+    uint64_t evaluations = 0;       // 累计评估次数
+    HistogramSummary query_us;      // 分摊到本规则的查询耗时：分组查询按组内规则数平分，组合条件的共享查询按引用规则数平分
+    HistogramSummary rows;          // 查询返回的行数
+    HistogramSummary reconcile_us;  // 条件评估与实例状态协调耗时
+    HistogramSummary cost_us;       // 查询分摊耗时 + 评估与协调耗时
+    HistogramSummary instances;     // 评估后的告警实例数
+    HistogramSummary events;        // 两次评估之间产生的告警事件数
+    uint64_t events_total = 0;      // 累计产生的告警事件数（含定时器触发和抖动结束补发的事件）
+    size_t current_instances = 0;   // 当前告警实例数
+    bool over_budget = false;       // 窗口内平均开销超过预算
+};
+
+// 规则回测生成的事件
+struct AlarmBacktestEvent {
+    std::string status;                         // "firing" 或 "resolved"
+    int64_t timestamp = 0;                      // 事件时间（毫秒）：firing 为到达 for 时长的时间，resolved 为恢复时间
+    int64_t starts_at = 0;                      // 实例首次满足条件的时间（毫秒）
+    double value = 0.0;                         // 事件发生时的指标值（窗口条件为窗口聚合值）
+    std::map<std::string, std::string> labels;  // host_ip 与规则的标签过滤
+};
+
+// 规则回测结果
+struct AlarmBacktestResult {
+    std::vector<AlarmBacktestEvent> events;  // 按时间排序的事件时间线
+    bool truncated = false;                  // 事件数超过上限，时间线被截断（计数不受影响）
+    size_t partitions = 0;                   // 按主机划分的回放分区数
+    uint64_t rows = 0;                       // 回放的历史样本数
+    uint64_t firing_events = 0;              // 实际产生的 firing 事件数（不含被抑制的）
+    uint64_t resolved_events = 0;
+    uint64_t suppressed_events = 0;          // 实例抖动期间被抑制的事件数
+    uint64_t pending_cleared = 0;            // 未到 for 时长即恢复的 PENDING 次数
+    size_t firing_at_end = 0;                // 区间结束时仍处于 FIRING 的实例数
+    int64_t firing_duration_ms = 0;          // 各实例处于 FIRING 的总时长，结束时仍在触发的计到区间结束
+    int64_t elapsed_ms = 0;                  // 回测耗时
+};
+
+// 规则预览中满足条件的序列
+struct AlarmPreviewMatch {
+    std::string fingerprint;                    // 会生成的实例指纹（host_ip 与规则的标签过滤）
+    std::map<std::string, std::string> labels;  // 序列的全部标签
+    double value = 0.0;                         // 当前值（窗口条件为窗口聚合值）
+    int64_t timestamp = 0;                      // 最新样本时间（毫秒）
+    std::string state;                          // 同名规则正在运行时该实例的状态：pending / firing，空表示尚无实例
+};
+
+// 规则预览结果
+struct AlarmPreviewResult {
+    std::vector<AlarmPreviewMatch> matches;
+    bool truncated = false;      // 满足条件的序列数超过上限（计数不受影响）
+    std::string sql;             // 执行的查询
+    size_t series = 0;           // 查询返回的序列数
+    size_t matched_series = 0;   // 满足条件的序列数
+    size_t matched_hosts = 0;    // 满足条件的主机数
+    size_t instances = 0;        // 会生成的实例数（同一实例的多条序列计一次）
+    int64_t query_ms = 0;        // 查询耗时
+    int64_t elapsed_ms = 0;      // 总耗时
+};
+
 // 告警实例
 struct AlarmInstance {
     std::string fingerprint;        // 告警指纹 (alert_name + 实例的唯一标签组合)
@@ -32,6 +126,7 @@ struct AlarmInstance {
     std::map<std::string, std::string> labels;              // 标签 (用于生成事件)
     std::map<std::string, std::string> annotations;         // 注解 (用于生成事件)
     double value;                   // 触发告警的值
+    bool flapping = false;          // 状态变化过于频繁，中间的 firing / resolved 事件被抑制
 };
 
 // 告警事件
@@ -61,62 +156,397 @@ public:
     // 设置评估间隔
     void setEvaluationInterval(std::chrono::seconds interval);
     
+    // 设置评估工作线程数（在 start 之前调用）
+    void setWorkerThreads(size_t thread_count);
+    
+    // 设置评估模式（默认流式）
+    void setEvaluationMode(AlarmEvaluationMode mode);
+    
+    // 流式模式下对推送规则执行SQL一致性校验的间隔
+    void setSweepInterval(std::chrono::seconds interval);
+    
+    // 告警实例状态快照文件，为空表示不持久化（在 start 之前调用）
+    void setStateFile(const std::string& path);
+    
+    // 快照写入间隔
+    void setSnapshotInterval(std::chrono::seconds interval);
+    
+    // 抖动检测：window 内状态变化达到 threshold 次的实例进入抖动状态，threshold 为0表示不检测（在 start 之前调用）
+    void setFlapDetection(std::chrono::seconds window, size_t threshold);
+    
+    // 趋势预测的回溯时间（回归的遗忘时间常数），在 start 之前调用
+    void setForecastLookback(std::chrono::seconds lookback);
+    
+    // 单条规则每次评估的开销预算，窗口内平均开销超过预算的规则标记为慢规则并记录警告，0 表示不检查（在 start 之前调用）
+    void setRuleCostBudget(std::chrono::milliseconds budget);
+    
+    // 按 host_ip 查找节点所在机箱，供按 box_id 关联的组合条件规则使用没有 box_id 标签的超级表（在 start 之前调用）
+    void setHostLocator(std::function<bool(const std::string& host_ip, int& box_id)> locator);
+    
+    // 写入路径推送的样本，由 ResourceStorage 的样本观察者调用
+    void ingestSamples(const std::vector<MetricSample>& samples);
+    
     // 获取当前告警实例
     std::vector<AlarmInstance> getCurrentAlarmInstances() const;
     
+    // 获取SQL评估周期统计
+    AlarmEvaluationStats getEvaluationStats() const;
+    
+    // 当前规则集中各规则的评估开销，window_ms 输出统计窗口长度
+    std::vector<AlarmRuleProfile> getRuleProfiles(int64_t& window_ms) const;
+    
+    // 按到达 capacity 的剩余时间升序列出趋势索引中的序列，参数见 ForecastIndex::closest
+    std::vector<SeriesForecast> getForecasts(const std::string& stable, const std::string& metric, double capacity,
+                                             double within_s, size_t limit, size_t& tracked) const;
+    
+    // 在 [start_ms, end_ms) 的历史数据上回放规则，不影响运行中的告警实例；max_events 为时间线的事件上限
+    bool backtestRule(const AlarmRule& rule, int64_t start_ms, int64_t end_ms, size_t max_events,
+                      AlarmBacktestResult& result, std::string& error);
+    
+    // 用最新数据立即评估一条规则（一次 LAST / 窗口聚合查询），不创建实例、不产生事件；max_matches 为返回的序列上限
+    bool previewRule(const AlarmRule& rule, size_t max_matches, AlarmPreviewResult& result, std::string& error);
+    
     // 获取告警事件回调
     void setAlarmEventCallback(std::function<void(const AlarmEvent&)> callback);
     
     // 工具函数 (public for AlarmEvent)
     static std::string formatTimestamp(const std::chrono::system_clock::time_point& tp);
+    // 解析 30s / 5m / 24h / 7d 形式的时长，无法解析时返回0
+    static std::chrono::seconds parseDuration(const std::string& duration);
 
 private:
     std::shared_ptr<AlarmRuleStorage> m_rule_storage;
     std::shared_ptr<ResourceStorage> m_resource_storage;
     
-    std::vector<AlarmRule> m_rules;                           // 内存中的告警规则
-    std::map<std::string, AlarmInstance> m_alarm_instances;   // 告警实例状态
+    // 比较操作符
+    using CompareOp = ThresholdOp;
+    
+    // 模板片段：文本原样输出，占位符按标签名替换
+    struct TemplateSegment {
+        bool placeholder;
+        std::string text;  // 文本内容或标签名
+    };
+    
+    // 组合条件的一项：一个超级表上一个指标的标签过滤和条件
+    struct JoinTerm {
+        std::string stable;
+        std::string metric;
+        std::vector<std::pair<std::string, std::string>> tags;
+        std::vector<std::pair<CompareOp, double>> conditions;
+        std::vector<std::pair<CompareOp, double>> hold_conditions;  // 为空表示没有回差
+    };
+    
+    // 组合条件的布尔表达式：叶子为 join_terms 的下标，all 取各子节点关联键的交集，any 取并集
+    struct JoinNode {
+        bool all = true;
+        int term = -1;  // 大于等于0时为叶子
+        std::vector<JoinNode> children;
+    };
+    
+    // 编译后的规则，加载时生成一次，之后只读，SQL评估与流式评估共用
+    struct CompiledRule {
+        AlarmRule rule;
+        std::string stable;
+        std::string metric;
+        std::vector<std::pair<std::string, std::string>> tags;     // 标签过滤 (标签名, 取值)
+        std::vector<std::pair<CompareOp, double>> conditions;      // (操作符, 阈值)
+        std::vector<std::pair<CompareOp, double>> hold_conditions; // 已活动的序列保持活动的条件（resolve_threshold），为空表示没有回差
+        std::chrono::seconds keep_firing_for{0};                   // 条件不再满足后 FIRING 实例继续保持的时长
+        std::chrono::seconds for_duration{0};
+        std::vector<TemplateSegment> description_template;
+        bool windowed = false;                  // 表达式带 func/window 时按窗口聚合值评估，只在写入路径上评估
+        WindowFunc window_func = WindowFunc::AVG;
+        int64_t window_ms = 0;
+        std::chrono::seconds absent_for{0};     // 大于0时为缺失数据规则：序列超过该时长没有样本即告警，只在写入路径上评估
+        bool anomaly = false;                   // 异常检测规则：conditions 比较序列相对 EWMA 基线的偏离分数，只在写入路径上评估
+        EwmaParams anomaly_params;
+        std::chrono::seconds predict_full_within{0};  // 大于0时为耗尽预测规则：按趋势到达 capacity 的剩余时间不超过该值，只在写入路径上评估
+        double capacity = 100.0;
+        std::string join_on;                    // 非空时为组合条件规则：各项按该标签（host_ip 或 box_id）关联，stable / metric 为空
+        std::vector<JoinTerm> join_terms;
+        JoinNode join_tree;
+        bool join_hysteresis = false;           // 有项带 resolve_threshold
+    };
+    
+    // 超级表和标签过滤相同的规则共用一次查询，指标取并集
+    struct RuleGroup {
+        std::string stable;
+        std::vector<std::pair<std::string, std::string>> tags;
+        std::set<std::string> metrics;
+        std::vector<std::shared_ptr<const CompiledRule>> rules;
+        std::string sql;        // 预生成的查询语句
+        bool streamed = false;  // 由写入路径推送评估，SQL只在一致性校验周期执行
+    };
+    
+    // 分组查询结果的列式快照：组内每个指标一列连续的 double，按行下标索引，缺失值为 NaN
+    struct MetricColumns {
+        size_t rows = 0;
+        std::unordered_map<std::string, std::vector<double>> columns;
+    };
+    
+    // 组合条件规则在一个超级表上的共享查询：所有组合条件规则在该超级表上引用的指标和标签列，每个评估周期执行一次
+    struct JoinFetch {
+        std::string stable;
+        std::set<std::string> metrics;
+        std::set<std::string> labels;  // 关联标签和各项标签过滤的列
+        bool box_join = false;         // 有按 box_id 关联的规则
+        size_t rules = 0;              // 引用该超级表的规则数
+        std::string sql;
+    };
+    
+    // 一个评估周期内共享查询的结果，同一超级表上的所有组合条件规则共用
+    struct JoinSnapshot {
+        bool ok = false;                   // 查询失败时引用该超级表的规则本周期不评估
+        int64_t query_share_us = 0;        // 查询耗时按引用该超级表的规则数平分
+        std::vector<QueryResult> rows;
+        MetricColumns columns;
+        std::vector<std::string> box_ids;  // 按 box_id 关联时每行的机箱号（行上没有 box_id 标签时按 host_ip 查找），空串表示未知
+    };
+    
+    // 组合条件的评估结果：关联键 -> 各满足条件的项（join_terms 下标 -> 值）
+    using JoinMatches = std::unordered_map<std::string, std::map<size_t, double>>;
+    
+    // 超级表名 -> 引用该超级表的规则
+    using StreamRuleIndex = std::unordered_map<std::string, std::vector<std::shared_ptr<const CompiledRule>>>;
+    
+    // 编译后的规则集，规则变化时整体替换，评估线程与写入路径只持有快照
+    struct CompiledRuleSet {
+        std::vector<std::shared_ptr<const CompiledRule>> rules;
+        std::vector<RuleGroup> groups;
+        StreamRuleIndex stream_index;
+        std::unordered_map<std::string, std::shared_ptr<const CompiledRule>> by_name;  // alert_name -> 规则
+        std::unordered_map<std::string, std::set<std::string>> forecast_targets;        // 超级表 -> 计入趋势索引的指标
+        std::vector<std::shared_ptr<const CompiledRule>> join_rules;                    // 组合条件规则
+        std::map<std::string, JoinFetch> join_fetches;                                  // 超级表 -> 组合条件规则的共享查询
+    };
+    
+    // 实例键：alert_name 与标签集合的64位哈希，字符串形式的指纹只在创建实例时生成一次用于展示和事件
+    using FingerprintHash = uint64_t;
+    
+    // 流式实例的满足条件序列，序列全部恢复或超过窗口未再满足时实例恢复
+    struct StreamInstanceState {
+        std::shared_ptr<const CompiledRule> rule;
+        std::unordered_map<FingerprintHash, std::chrono::system_clock::time_point> series;  // 序列标签哈希 -> 最近一次满足条件的时间
+        uint64_t expiry_timer = 0;  // 最早一条序列的过期定时器
+    };
+    
+    // 缺失数据规则的一条序列：最近一次样本的到达时间，定时器按 last_seen + absent_for 登记
+    struct AbsentSeries {
+        std::map<std::string, std::string> labels;  // host_ip 与超级表标签
+        std::chrono::system_clock::time_point last_seen;
+        double last_value = 0.0;
+        uint64_t timer = 0;  // 0 表示序列已缺失，等待下一个样本
+    };
+    
+    // 实例的抖动状态，实例恢复后仍保留到窗口结束；last_event 为最近一次实际发送的事件
+    struct FlapState {
+        FlapDetector detector;
+        AlarmEvent last_event;
+        bool has_last_event = false;
+        uint64_t timer = 0;
+        
+        explicit FlapState(const FlapDetector& d) : detector(d) {}
+    };
+    
+    // 规则的SQL评估开销，每次评估记录一次
+    struct RuleProfile {
+        RollingHistogram query_us;
+        RollingHistogram rows;
+        RollingHistogram reconcile_us;
+        RollingHistogram cost_us;
+        RollingHistogram instances;
+        RollingHistogram events;
+        uint64_t evaluations = 0;
+        uint64_t events_total = 0;     // 发送事件时累加
+        uint64_t events_recorded = 0;  // 上次评估时的 events_total
+        bool over_budget = false;
+    };
+    
+    // 单条规则（按 alert_name）的告警实例分片，状态协调只访问本规则的实例，不同规则的评估互不阻塞
+    struct InstanceShard : std::enable_shared_from_this<InstanceShard> {
+        std::string alert_name;
+        std::mutex mutex;
+        std::unordered_map<FingerprintHash, AlarmInstance> instances;            // 指纹哈希 -> 告警实例状态
+        std::unordered_map<FingerprintHash, StreamInstanceState> stream_states;  // 指纹哈希 -> 流式序列状态
+        std::unordered_map<FingerprintHash, uint64_t> fire_timers;               // PENDING 实例 -> 触发定时器
+        std::unordered_map<FingerprintHash, SlidingWindow> windows;              // 序列标签哈希 -> 窗口聚合状态
+        std::unordered_map<FingerprintHash, EwmaBaseline> baselines;             // 序列标签哈希 -> 异常检测基线
+        std::unordered_map<FingerprintHash, AbsentSeries> absent_series;         // 指纹哈希 -> 缺失数据规则的序列
+        std::unordered_map<FingerprintHash, uint64_t> keep_firing_timers;        // 条件已不满足、按 keep_firing_for 保持的 FIRING 实例 -> 定时器（0 表示已到期）
+        std::unordered_map<FingerprintHash, FlapState> flap_states;              // 指纹哈希 -> 抖动状态
+        RuleProfile profile;                                                     // 评估开销
+    };
+    
+    // 时间轮定时器：PENDING 实例到达 for 时长，流式实例的序列到达过期窗口，窗口聚合状态或异常检测基线长时间没有样本，
+    // 缺失数据规则的序列到达 absent_for，FIRING 实例的 keep_firing_for 到期，或抖动检测窗口结束
+    struct InstanceTimer {
+        enum class Kind { FIRE, EXPIRE, WINDOW, BASELINE, ABSENT, KEEP_FIRING, FLAP };
+        Kind kind;
+        std::shared_ptr<InstanceShard> shard;
+        FingerprintHash key;
+        std::shared_ptr<const CompiledRule> rule;
+    };
+    
+    std::shared_ptr<const CompiledRuleSet> m_rule_set;  // 通过 std::atomic_load / std::atomic_store 访问
+    std::map<std::string, std::shared_ptr<InstanceShard>> m_instance_shards;  // alert_name -> 实例分片
     
     std::atomic<bool> m_running;
     std::thread m_evaluation_thread;
     std::chrono::seconds m_evaluation_interval;
+    AlarmEvaluationMode m_evaluation_mode;
+    std::chrono::seconds m_sweep_interval;
+    size_t m_worker_threads;
+    std::unique_ptr<WorkerPool> m_worker_pool;
+    std::string m_state_file;
+    std::chrono::seconds m_snapshot_interval;
+    std::chrono::seconds m_flap_window;
+    size_t m_flap_threshold;
+    std::atomic<uint64_t> m_suppressed_events;
+    ForecastIndex m_forecasts;
+    std::function<bool(const std::string&, int&)> m_host_locator;
+    std::chrono::milliseconds m_rule_cost_budget;
+    
+    mutable std::mutex m_instances_mutex;  // 只保护分片表，分片内容由各分片的锁保护
     
-    mutable std::mutex m_instances_mutex;
-    mutable std::mutex m_rules_mutex;
+    // 定时器线程按时间轮刻度推进，加锁顺序为 分片锁 -> m_timer_mutex
+    TimerWheel<InstanceTimer> m_timer_wheel;
+    std::mutex m_timer_mutex;
+    std::condition_variable m_timer_cv;
+    std::thread m_timer_thread;
+    
+    // 规则集变化检测（仅评估线程访问）
+    bool m_rules_loaded;
+    uint64_t m_loaded_rule_version;                                  // 本进程内规则修改计数
+    std::string m_loaded_rule_signature;                             // 规则表 COUNT/MAX(updated_at)
+    std::chrono::steady_clock::time_point m_next_signature_check;   // 下次检查规则表签名的时间
+    
+    AlarmEvaluationStats m_evaluation_stats;
+    mutable std::mutex m_stats_mutex;
     
     std::function<void(const AlarmEvent&)> m_alarm_event_callback;
     
     // 核心逻辑
     void evaluationLoop();
-    void loadRulesFromDatabase();
-    void evaluateRules();
-    void evaluateRule(const AlarmRule& rule);
+    void loadRulesFromDatabase(bool force);
+    void evaluateRules(bool include_streamed);
+    void evaluateRuleGroup(const RuleGroup& group);
+    static MetricColumns buildMetricColumns(const std::set<std::string>& metrics, const std::vector<QueryResult>& rows);
+    void evaluateGroupedRule(const std::shared_ptr<const CompiledRule>& compiled, const std::vector<QueryResult>& rows,
+                             const MetricColumns& columns);
+    
+    // 记录规则一次SQL评估的开销并检查预算（耗时单位为微秒）
+    void recordRuleCost(const std::string& alert_name, int64_t query_us, size_t rows, int64_t reconcile_us);
+    
+    // 组合条件：每个评估周期每个超级表查询一次，各规则在共享快照上按关联键求交集 / 并集
+    void fetchJoinSnapshot(const JoinFetch& fetch, JoinSnapshot& snapshot);
+    void evaluateJoinRule(const std::shared_ptr<const CompiledRule>& compiled,
+                          const std::map<std::string, JoinSnapshot>& snapshots);
+    JoinMatches evaluateJoinNode(const CompiledRule& compiled, const JoinNode& node,
+                                 const std::map<std::string, JoinSnapshot>& snapshots, bool hold);
+    void matchJoinTerm(const CompiledRule& compiled, size_t term_index, const JoinSnapshot& snapshot, bool hold,
+                       JoinMatches& matches);
+    static std::string convertJoinFetchToSQL(const JoinFetch& fetch);
+    static bool stableHasLabel(const std::string& stable, const std::string& label);
     
-    // 规则到SQL转换 (新设计)
-    std::string convertRuleToSQL(const nlohmann::json& expression, const std::string& stable, const std::string& metric);
-    bool evaluateCondition(double value, const std::string& op, double threshold);
+    // 规则编译
+    std::shared_ptr<const CompiledRule> compileRule(const AlarmRule& rule);
+    bool compileConditions(const AlarmRule& rule, const nlohmann::json& expression,
+                           std::vector<std::pair<CompareOp, double>>& conditions,
+                           std::vector<std::pair<CompareOp, double>>& hold_conditions);
+    bool compileJoinRule(const AlarmRule& rule, const nlohmann::json& expression, CompiledRule& compiled);
+    bool compileJoinNode(const AlarmRule& rule, const nlohmann::json& node, int depth, CompiledRule& compiled,
+                         JoinNode& result);
+    std::shared_ptr<const CompiledRuleSet> compileRuleSet(const std::vector<AlarmRule>& rules);
+    std::shared_ptr<const CompiledRuleSet> currentRuleSet() const;
+    static bool parseCompareOp(const std::string& op, CompareOp& result);
+    static std::vector<TemplateSegment> compileTemplate(const std::string& template_str);
+    static std::string renderTemplate(const std::vector<TemplateSegment>& segments,
+                                      const std::map<std::string, std::string>& values);
+    
+    // 流式评估
+    static bool isStreamedStable(const std::string& stable);
+    void evaluateStreamSample(const std::shared_ptr<const CompiledRule>& stream_rule, const MetricSample& sample,
+                              std::chrono::system_clock::time_point now, const LinearTrend* trend);
+    void observeAbsentSeries(const std::shared_ptr<const CompiledRule>& absent_rule, const MetricSample& sample,
+                             std::chrono::system_clock::time_point now);
+    void resolveStreamInstance(InstanceShard& shard, FingerprintHash key,
+                               const std::shared_ptr<const CompiledRule>& compiled,
+                               std::chrono::system_clock::time_point now);
+    
+    // 定时器
+    void timerLoop();
+    uint64_t scheduleTimer(std::chrono::steady_clock::time_point deadline, InstanceTimer timer);
+    void cancelTimer(uint64_t timer_id);
+    void schedulePendingInstance(const std::shared_ptr<InstanceShard>& shard, FingerprintHash key,
+                                 const std::shared_ptr<const CompiledRule>& compiled,
+                                 std::chrono::system_clock::time_point now);
+    void cancelPendingInstance(InstanceShard& shard, FingerprintHash key);
+    void fireInstance(InstanceShard& shard, FingerprintHash key, const AlarmRule& rule,
+                      std::chrono::system_clock::time_point now);
+    void onFireTimer(const InstanceTimer& timer, uint64_t timer_id);
+    void onExpireTimer(const InstanceTimer& timer, uint64_t timer_id);
+    void onWindowTimer(const InstanceTimer& timer);
+    void onBaselineTimer(const InstanceTimer& timer);
+    void onAbsentTimer(const InstanceTimer& timer, uint64_t timer_id);
+    void onKeepFiringTimer(const InstanceTimer& timer, uint64_t timer_id);
+    void onFlapTimer(const InstanceTimer& timer, uint64_t timer_id);
+    void cancelKeepFiring(InstanceShard& shard, FingerprintHash key);
+    
+    // 窗口聚合：把样本加入序列的滑动窗口，返回窗口聚合值（调用方持有分片锁）
+    bool aggregateWindow(const std::shared_ptr<InstanceShard>& shard, FingerprintHash series_key,
+                         const std::shared_ptr<const CompiledRule>& compiled, double& value);
+    
+    // 异常检测：把样本计入序列的基线，预热完成后 value 替换为偏离分数，baseline_labels 为样本值和基线（调用方持有分片锁）
+    bool scoreAnomaly(const std::shared_ptr<InstanceShard>& shard, FingerprintHash series_key,
+                      const std::shared_ptr<const CompiledRule>& compiled, double& value,
+                      std::map<std::string, std::string>& baseline_labels);
+    
+    // 耗尽预测：按趋势的拟合值和斜率计算到达规则 capacity 的剩余秒数，超过 predict_full_within 或趋势不增长时返回false
+    static bool predictExhaustion(const CompiledRule& compiled, double level, double slope, double& seconds);
+    
+    // 规则组到SQL转换：一次查询取回组内所有指标每条序列（子表）的最新值
+    std::string convertGroupToSQL(const RuleGroup& group);
+    bool evaluateCondition(double value, CompareOp op, double threshold);
+    bool evaluateConditions(const std::vector<std::pair<CompareOp, double>>& conditions, double value);
     
     // 查询执行
     std::vector<QueryResult> executeQuery(const std::string& sql);
     
     // 告警实例管理 (新的状态协调算法)
+    std::shared_ptr<InstanceShard> shardFor(const std::string& alert_name);
+    std::shared_ptr<InstanceShard> findShard(const std::string& alert_name) const;  // 不存在时返回空
+    std::vector<std::shared_ptr<InstanceShard>> allShards() const;
+    static FingerprintHash hashFingerprint(const std::string& alert_name, const std::map<std::string, std::string>& labels);
     std::string generateFingerprint(const std::string& alert_name, const std::map<std::string, std::string>& labels);
-    void reconcileAlarmStates(const AlarmRule& rule, const std::set<std::string>& active_from_db, 
-                             const std::vector<QueryResult>& results);
-    void createNewAlarmInstance(const std::string& fingerprint, const AlarmRule& rule, 
-                               const QueryResult& result, std::chrono::system_clock::time_point now);
-    void updateExistingAlarmInstance(AlarmInstance& instance, const AlarmRule& rule, 
-                                   const QueryResult& result, std::chrono::system_clock::time_point now);
-    void handleResolvedAlarm(AlarmInstance& instance, const AlarmRule& rule, 
+    void reconcileAlarmStates(const std::shared_ptr<const CompiledRule>& compiled, 
+                             const std::unordered_map<FingerprintHash, QueryResult>& active_from_db,
+                             const std::unordered_map<FingerprintHash, QueryResult>& held_from_db);
+    void createNewAlarmInstance(const std::shared_ptr<InstanceShard>& shard, FingerprintHash key, 
+                               const std::shared_ptr<const CompiledRule>& compiled, 
+                               const QueryResult& result, std::chrono::system_clock::time_point now,
+                               const std::map<std::string, std::string>& extra_labels = {});
+    void updateExistingAlarmInstance(AlarmInstance& instance, const QueryResult& result);
+    void handleResolvedAlarm(InstanceShard& shard, FingerprintHash key, AlarmInstance& instance,
+                           const std::shared_ptr<const CompiledRule>& compiled,
                            const QueryResult& result, std::chrono::system_clock::time_point now);
     
-    // 告警事件生成
-    void generateAlarmEvent(const AlarmInstance& instance, const AlarmRule& rule, 
-                          const std::string& status);
+    // 告警事件生成：经过抖动检测后发送（调用方持有分片锁）
+    void generateAlarmEvent(InstanceShard& shard, FingerprintHash key, const AlarmInstance& instance,
+                          const AlarmRule& rule, const std::string& status);
+    static AlarmEvent makeAlarmEvent(const AlarmInstance& instance, const std::string& status);
+    void publishAlarmEvent(const AlarmEvent& event);
+    
+    // 规则回测：按主机分区查询历史样本，按时间顺序回放状态机
+    static std::vector<std::string> stableLabelColumns(const std::string& stable);
+    std::string convertPreviewToSQL(const CompiledRule& compiled);
+    std::string convertBacktestToSQL(const CompiledRule& compiled, const std::string& host_ip,
+                                     int64_t start_ms, int64_t end_ms);
+    void replayBacktestPartition(const CompiledRule& compiled, const std::string& sql,
+                                 int64_t start_ms, int64_t end_ms, AlarmBacktestResult& result);
     
-    // 工具函数
-    std::chrono::seconds parseDuration(const std::string& duration);
-    std::string replaceTemplate(const std::string& template_str, const std::map<std::string, std::string>& values);
+    // 实例状态快照：定期写入本地文件，start 时恢复
+    bool saveSnapshot();
+    size_t restoreSnapshot();
     
     // 日志输出
     void logDebug(const std::string& message);
@@ -90,6 +90,12 @@ public:
     // 分页查询功能
     PaginatedAlarmRules getPaginatedAlarmRules(int page = 1, int page_size = 20, bool enabled_only = false);
 
+    // 本进程内规则修改计数，每次成功增删改后递增
+    uint64_t getRuleVersion() const { return m_rule_version.load(); }
+    
+    // 规则表签名（记录数|最近更新时间），用于发现其他进程对规则表的修改；查询失败返回false
+    bool getRuleSetSignature(std::string& signature);
+
     // 连接池相关方法
     MySQLConnectionPool::PoolStats getConnectionPoolStats() const;
     void updateConnectionPoolConfig(const MySQLPoolConfig& config);
@@ -99,6 +105,7 @@ private:
     std::shared_ptr<MySQLConnectionPool> m_connection_pool;
     std::atomic<bool> m_initialized;
     bool m_owns_connection_pool;  // 标记是否拥有连接池的所有权
+    std::atomic<uint64_t> m_rule_version;
 
     bool executeQuery(const std::string& sql);
     MYSQL_RES* executeSelectQuery(const std::string& sql);
@@ -9,11 +9,16 @@
 #include <chrono>
 #include <mutex>
 
+#include "alarm_notifier.h"
+
 // 前向声明
 class ResourceStorage;
 class AlarmRuleStorage;
 class AlarmManager;
 class AlarmRuleEngine;
+class AlarmEventBus;
+class AlarmInhibitor;
+class AlarmNotifier;
 class HttpServer;
 class MulticastSender;
 class NodeStorage;
@@ -44,6 +49,7 @@ struct AlarmSystemConfig {
     
     // HTTP服务器配置
     int http_port = 8080;
+    int http_query_timeout_ms = 10000;  // 查询类接口的截止时间，<= 0 表示不限时
     
     // 组播配置
     std::string multicast_ip = "239.192.168.80";
@@ -59,6 +65,21 @@ struct AlarmSystemConfig {
     // 监控配置
     std::chrono::seconds evaluation_interval = std::chrono::seconds(3);
     std::chrono::seconds stats_interval = std::chrono::seconds(60);
+    bool alarm_streaming_evaluation = true;  // 资源指标的告警规则在写入路径上评估，SQL仅作一致性校验
+    std::chrono::seconds alarm_sweep_interval = std::chrono::seconds(60);  // 流式规则的SQL一致性校验间隔
+    int alarm_worker_threads = 4;  // 告警规则评估工作线程数
+    std::string alarm_state_file = "alarm_state.bin";  // 告警实例状态快照文件，重启后恢复，为空表示不持久化
+    std::chrono::seconds alarm_snapshot_interval = std::chrono::seconds(10);  // 告警实例状态快照间隔
+    std::chrono::seconds alarm_flap_window = std::chrono::seconds(600);  // 告警实例抖动检测窗口
+    int alarm_flap_threshold = 6;  // 窗口内 firing/resolved 次数达到该值的实例视为抖动并抑制中间事件，0 表示不检测
+    std::chrono::seconds alarm_forecast_lookback = std::chrono::hours(6);  // 耗尽预测的回溯时间常数，也是无样本序列的释放时间
+    std::chrono::milliseconds alarm_rule_cost_budget = std::chrono::milliseconds(500);  // 单条规则每次SQL评估的开销预算，超过的规则标记为慢规则，0 表示不检查
+    int alarm_event_bus_capacity = 65536;  // 告警事件总线缓冲区容量（事件数），写满时发布方等待
+    std::chrono::milliseconds alarm_event_full_wait = std::chrono::milliseconds(100);  // 缓冲区写满时发布方的最长等待时间，超时丢弃事件，0 表示一直等待
+    int alarm_event_batch_size = 256;      // 告警事件消费者单批最大事件数
+    bool alarm_inhibition_enabled = true;  // 按机箱/槽位拓扑把机箱失联、板卡不在位下的告警合并到根因告警
+    std::chrono::seconds alarm_inhibition_release_delay = std::chrono::seconds(60);  // 根因恢复后补发仍未恢复告警的等待时间
+    AlarmNotificationConfig alarm_notification;  // 告警分组通知，receivers 为空表示不向外部发送
     
     
     // 日志配置
@@ -86,6 +107,20 @@ struct AlarmSystemStats {
     int firing_events = 0;
     int resolved_events = 0;
     int alarm_instances = 0;
+    int alarm_eval_rules = 0;           // 上一评估周期执行SQL评估的规则数
+    int alarm_eval_queries = 0;         // 上一评估周期执行的查询数
+    int64_t alarm_eval_cycle_ms = 0;    // 上一评估周期耗时（毫秒）
+    int64_t alarm_eval_overruns = 0;    // 耗时超过评估间隔的周期数
+    int alarm_eval_slow_rules = 0;      // 评估开销超过预算的规则数
+    int64_t alarm_event_lag = 0;        // 告警事件总线上最慢消费者的积压事件数
+    int64_t alarm_event_full_waits = 0; // 发布告警事件时缓冲区已满的次数
+    int64_t alarm_events_dropped = 0;   // 缓冲区已满且等待超时被丢弃的告警事件数
+    int64_t alarm_events_suppressed = 0; // 实例抖动期间被抑制的告警事件数
+    int64_t alarm_events_inhibited = 0;  // 被根因告警吸收的事件数（firing 与 resolved）
+    int alarm_inhibition_roots = 0;      // 当前活动的根因告警数
+    int64_t alarm_notifications_sent = 0;    // 已投递到外部接收方的分组通知数
+    int64_t alarm_notifications_failed = 0;  // 重试耗尽后放弃的分组通知数
+    int64_t alarm_notifications_dropped = 0; // 接收方队列已满被丢弃的分组通知数
     AlarmSystemStatus status = AlarmSystemStatus::STOPPED;
 };
 
@@ -186,6 +221,9 @@ private:
     bool initializeSignalHandlers();
     bool initializeDatabase();
     bool initializeServices();
+    void initializeEventBus();
+    void publishAlarmEvent(const AlarmEvent& event);
+    void broadcastAlarmEvents(const std::vector<AlarmEvent>& events);
     
     // 信号处理
     static void signalHandler(int signal);
@@ -207,6 +245,9 @@ private:
     std::shared_ptr<AlarmRuleStorage> alarm_rule_storage_;
     std::shared_ptr<AlarmManager> alarm_manager_;
     std::shared_ptr<AlarmRuleEngine> alarm_rule_engine_;
+    std::shared_ptr<AlarmEventBus> alarm_event_bus_;
+    std::shared_ptr<AlarmInhibitor> alarm_inhibitor_;
+    std::shared_ptr<AlarmNotifier> alarm_notifier_;
     std::shared_ptr<HttpServer> http_server_;
     std::shared_ptr<MulticastSender> multicast_sender_;
     std::shared_ptr<NodeStorage> node_storage_;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// 异常检测方向：偏离分数按方向取 z（高于基线）、-z（低于基线）或 |z|
+enum class AnomalyDirection {
+    BOTH,
+    UP,
+    DOWN
+};
+
+// 异常检测参数，由规则编译生成，同一规则的所有序列共用
+struct EwmaParams {
+    double alpha = 0.05;        // 平滑系数，越大基线跟随越快，约 1/alpha 个样本的记忆
+    uint32_t warmup = 30;       // 基线累计的样本数达到该值后才计算偏离分数
+    double min_stddev = 0.0;    // 标准差下限，避免几乎恒定的序列因微小变化得到极大的分数
+    double clip = 3.0;          // 预热后计入基线的样本截断到 mean ± clip·σ，0表示不截断
+    AnomalyDirection direction = AnomalyDirection::BOTH;
+};
+
+/**
+ * @brief 单条序列的指数加权均值/方差基线
+ *
+ * 告警规则引擎在写入路径上为异常检测规则的每条序列维护一个实例，update() 先用当前基线计算样本的
+ * 偏离分数（z-score），再把样本计入基线，O(1) 且不保存历史样本。参数由调用方每次传入，每条序列
+ * 只保存均值、方差、样本数和最近一次样本时间（32字节）。
+ *
+ * 预热期内平滑系数取 max(alpha, 1/n)，前若干个样本等价于累计均值和总体方差，基线不偏向第一个样本。
+ * 预热后离群样本按 clip 截断再计入：单个尖峰只让基线移动有限的距离，持续的电平偏移仍会被逐渐吸收。
+ */
+class EwmaBaseline {
+public:
+    // 计入样本（毫秒时间戳），预热完成后返回true并输出按方向取值的偏离分数；非有限值被忽略
+    bool update(const EwmaParams& params, int64_t timestamp_ms, double value, double& score);
+
+    double mean() const { return m_mean; }
+    double stddev() const;
+    uint32_t count() const { return m_count; }
+    int64_t lastTimestamp() const { return m_last_timestamp; }
+
+    // 解析方向 both / up / down
+    static bool parseDirection(const std::string& name, AnomalyDirection& direction);
+
+private:
+    double m_mean = 0.0;
+    double m_variance = 0.0;
+    int64_t m_last_timestamp = 0;
+    uint32_t m_count = 0;
+};
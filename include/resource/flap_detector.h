@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * @brief 单个告警实例的抖动检测
+ *
+ * 记录实例的状态变化（firing / resolved 事件）时间，滑动窗口内的状态变化次数达到阈值即进入抖动状态，
+ * 之后的中间状态变化由调用方抑制；最近一次状态变化之后经过一个完整窗口没有新的变化时退出抖动状态。
+ * 告警规则引擎和规则回测共用同一实现。
+ */
+class FlapDetector {
+public:
+    FlapDetector(int64_t window_ms, size_t threshold);
+
+    // 记录一次状态变化（毫秒时间戳），返回记录后是否处于抖动状态
+    bool record(int64_t timestamp_ms);
+
+    bool flapping() const { return m_flapping; }
+
+    // 最近一次状态变化之后经过一个完整窗口的时刻，到达后退出抖动状态，检测器可以回收
+    int64_t quietAt() const;
+
+    bool quiet(int64_t timestamp_ms) const { return timestamp_ms >= quietAt(); }
+
+private:
+    int64_t m_window_ms;
+    size_t m_threshold;
+    bool m_flapping = false;
+    std::deque<int64_t> m_changes;  // 窗口内的状态变化时间
+};
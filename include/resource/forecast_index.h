@@ -0,0 +1,88 @@
+#pragma once
+
+#include "linear_trend.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 单条序列的耗尽预测
+struct SeriesForecast {
+    std::string stable;
+    std::string metric;
+    std::map<std::string, std::string> labels;  // host_ip 与超级表标签
+    double value = 0.0;            // 最近一次样本值
+    double level = 0.0;            // 拟合的当前值
+    double slope_per_hour = 0.0;   // 拟合的每小时变化量
+    double time_to_full_s = 0.0;   // 到达容量的剩余秒数
+    int64_t updated_at = 0;        // 最近一次样本的到达时间（毫秒）
+    uint32_t samples = 0;
+};
+
+/**
+ * @brief 全机群序列的趋势索引
+ *
+ * 告警规则引擎在写入路径上把磁盘、内存等序列的样本计入各自的 LinearTrend（指数加权线性回归），
+ * 供 predict_full_within 规则和耗尽预测接口使用，不查询TDengine历史数据。按序列哈希分为64个分片，
+ * 写入路径每个样本只锁一个分片。
+ */
+class ForecastIndex {
+public:
+    // 回归的遗忘时间常数：约反映最近 lookback 内的趋势
+    void setLookback(std::chrono::seconds lookback);
+    std::chrono::seconds lookback() const { return m_lookback; }
+
+    // 计入样本（毫秒时间戳），返回更新后的趋势副本
+    LinearTrend observe(const std::string& stable, const std::string& metric,
+                        const std::map<std::string, std::string>& labels, int64_t timestamp_ms, double value);
+
+    // 拟合至少需要的等效时间跨度（秒），序列刚出现时不预测
+    double minSpanSeconds() const;
+
+    // 按到达 capacity 的剩余时间升序列出正在增长（或已达到容量）的序列；stable / metric 为空表示不过滤，
+    // within_s 大于0时只返回剩余时间不超过该值的序列；tracked 输出参与筛选的序列数
+    std::vector<SeriesForecast> closest(const std::string& stable, const std::string& metric, double capacity,
+                                        double within_s, size_t limit, size_t& tracked) const;
+
+    // 释放 idle_ms 内没有样本的序列，返回释放数
+    size_t evictIdle(int64_t now_ms, int64_t idle_ms);
+
+    size_t size() const;
+
+    // 快照：遍历全部序列 / 恢复一条序列（覆盖已有的同一序列）
+    using SeriesVisitor = std::function<void(const std::string& stable, const std::string& metric,
+                                             const std::map<std::string, std::string>& labels,
+                                             const LinearTrend& trend, double last_value)>;
+    void forEach(const SeriesVisitor& visitor) const;
+    void restore(const std::string& stable, const std::string& metric,
+                 const std::map<std::string, std::string>& labels, const LinearTrend& trend, double last_value);
+
+private:
+    struct Series {
+        std::string stable;
+        std::string metric;
+        std::map<std::string, std::string> labels;
+        LinearTrend trend;
+        double last_value = 0.0;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Series> series;  // 超级表、指标与标签的哈希 -> 序列
+    };
+
+    static const size_t kShardCount = 64;
+
+    static uint64_t seriesHash(const std::string& stable, const std::string& metric,
+                               const std::map<std::string, std::string>& labels);
+
+    std::chrono::seconds m_lookback{std::chrono::hours(6)};
+    std::array<Shard, kShardCount> m_shards;
+};
@@ -9,10 +9,17 @@
 #include "resource_manager.h"
 #include "bmc_storage.h"
 #include "chassis_controller.h"
+#include "placement_index.h"
 #include "json.hpp"
+#include <atomic>
 #include <string>
 #include <thread>
 #include <memory>
+#include <functional>
+#include <map>
+#include <mutex>
+
+class AlarmRuleEngine;
 
 class HttpServer {
 public:
@@ -47,6 +54,18 @@ public:
      */
     void stop();
 
+    /**
+     * @brief 设置查询类接口的默认截止时间.
+     * @param timeout_ms 毫秒数, <= 0 表示不限时.
+     */
+    void setQueryTimeoutMs(int timeout_ms);
+
+    /**
+     * @brief 设置告警规则引擎, 用于规则回测. 引擎在HTTP服务器启动后创建, 未设置时回测接口返回503.
+     * @param engine 告警规则引擎的共享指针.
+     */
+    void setAlarmRuleEngine(std::shared_ptr<AlarmRuleEngine> engine);
+
 private:
     /**
      * @brief 设置服务器路由.
@@ -95,6 +114,34 @@ private:
      */
     void handle_alarm_rules_delete(const httplib::Request& req, httplib::Response& res);
 
+    /**
+     * @brief 处理 /alarm/rules/backtest 的POST请求 (在历史数据上回测告警规则).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_alarm_rules_backtest(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief 处理 /alarm/rules/preview 的POST请求 (用最新数据立即评估告警规则).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_alarm_rules_preview(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief 处理 /alarm/forecasts 的GET请求 (列出最接近耗尽的磁盘、内存序列).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_alarm_forecasts(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief 处理 /alarm/engine/stats 的GET请求 (评估周期统计和开销最高的规则).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_alarm_engine_stats(const httplib::Request& req, httplib::Response& res);
+
     /**
      * @brief 处理 /alarm/events 的GET请求 (获取所有告警事件).
      * @param req HTTP请求.
@@ -144,6 +191,30 @@ private:
      */
     void handle_node_historical_bmc(const httplib::Request& req, httplib::Response& res);
 
+    /**
+     * @brief 处理 /placement/candidates 的GET请求 (查询满足空闲核数/GPU需求的候选节点).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_placement_candidates(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief 处理 /query/stats 的GET请求 (查询截止时间配置及各接口超时次数).
+     * @param req HTTP请求.
+     * @param res HTTP响应.
+     */
+    void handle_query_stats(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief 在查询截止时间上下文中执行处理函数, 超时则返回504并计数.
+     * @param endpoint 接口路径, 用于超时计数.
+     * @param req HTTP请求, 可通过 timeout_ms 参数缩短截止时间.
+     * @param res HTTP响应.
+     * @param handler 实际的处理函数.
+     */
+    void with_query_deadline(const std::string& endpoint, const httplib::Request& req, httplib::Response& res,
+                             const std::function<void()>& handler);
+
     /**
      * @brief 处理 /chassis/reset 的POST请求 (复位机箱板卡).
      * @param req HTTP请求.
@@ -172,10 +243,16 @@ private:
     std::shared_ptr<ResourceManager> m_resource_manager;
     std::shared_ptr<BMCStorage> m_bmc_storage;
     std::shared_ptr<ChassisController> m_chassis_controller;
+    std::shared_ptr<PlacementIndex> m_placement_index;
+    std::shared_ptr<AlarmRuleEngine> m_alarm_rule_engine;  // 通过 std::atomic_load / std::atomic_store 访问
     httplib::Server m_server;
     std::string m_host;
     int m_port;
     std::thread m_server_thread;
+
+    std::atomic<int> m_query_timeout_ms{10000};  // setQueryTimeoutMs 可在请求处理期间调用
+    std::mutex m_deadline_mutex;
+    std::map<std::string, uint64_t> m_deadline_hits;
 };
 
 #endif // HTTP_SERVER_H
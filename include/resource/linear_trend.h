@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief 单条序列的指数加权线性回归
+ *
+ * 用于磁盘、内存等序列的耗尽预测：add() 以最新样本为时间原点维护加权和（权重、t、x、t²、t·x），
+ * 新样本到来时先把原点平移到新样本并按 exp(-dt/tau) 衰减旧样本的权重，O(1) 且不保存历史样本，
+ * 采样间隔不均匀也不影响。每条序列只保存5个加权和、最近一次样本时间和样本数（56字节），
+ * 时间常数由调用方每次传入。
+ */
+class LinearTrend {
+public:
+    // 计入样本（毫秒时间戳），tau_s 为遗忘时间常数（秒）：早于最新样本 tau_s 秒的样本权重为 1/e；
+    // 时间戳早于上一个样本时按上一个样本的时间处理
+    void add(int64_t timestamp_ms, double value, double tau_s);
+
+    // 最新样本时刻的拟合值和斜率（每秒）；样本数不足或等效时间跨度小于 min_span_s 时返回false
+    bool fit(double min_span_s, double& level, double& slope) const;
+
+    // 等效时间跨度（秒）：加权时间标准差 × √12，均匀采样 L 秒时约为 L，长期运行后约为 3.5·tau
+    double spanSeconds() const;
+
+    uint32_t count() const { return m_count; }
+    int64_t lastTimestamp() const { return m_last_timestamp; }
+
+    // 按拟合结果计算到达 capacity 的剩余秒数：已达到时为0，趋势不增长时返回false
+    static bool timeToReach(double level, double slope, double capacity, double& seconds);
+
+private:
+    double m_sw = 0.0;   // Σw
+    double m_st = 0.0;   // Σw·t，t 为相对最新样本的秒数（≤0）
+    double m_sx = 0.0;   // Σw·x
+    double m_stt = 0.0;  // Σw·t²
+    double m_stx = 0.0;  // Σw·t·x
+    int64_t m_last_timestamp = 0;
+    uint32_t m_count = 0;
+};
@@ -0,0 +1,624 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <taos.h>
+#include "json.hpp"
+#include "resource_storage.h"
+
+/**
+ * @brief 资源超级表的编译期模式注册表
+ *
+ * 每个超级表的 name()（超级表名）、metricType()（API中的指标类型）、tags()（除 host_ip 外的标签列）、
+ * fields()（ts 之外的数值列）以及与之绑定的C++行结构成员只在这里描述一次，
+ * 建表DDL、写入VALUES、查询列表、结果解码和JSON序列化都由同一份描述生成。
+ * 解码时列位置在编译期确定（模板参数中的下标），热路径上不再逐个单元格比较列名。
+ */
+namespace metric_schema {
+
+enum class ColumnType {
+    SMALLINT,
+    INT,
+    BIGINT,
+    DOUBLE,
+    NCHAR
+};
+
+inline std::string sqlType(ColumnType type, int length) {
+    switch (type) {
+        case ColumnType::SMALLINT: return "SMALLINT";
+        case ColumnType::INT: return "INT";
+        case ColumnType::BIGINT: return "BIGINT";
+        case ColumnType::DOUBLE: return "DOUBLE";
+        case ColumnType::NCHAR: return "NCHAR(" + std::to_string(length) + ")";
+    }
+    return "DOUBLE";
+}
+
+// 绑定到行结构成员的列，key 为JSON中使用的字段名
+template <typename Row, typename T>
+struct Column {
+    const char* name;
+    const char* key;
+    ColumnType type;
+    int length;
+    T Row::* member;
+};
+
+// 未绑定成员的标签列，仅在查询结果中作为标签返回
+struct Label {
+    const char* name;
+    const char* key;
+    ColumnType type;
+    int length;
+};
+
+template <typename Row, typename T>
+constexpr Column<Row, T> column(const char* name, ColumnType type, T Row::* member) {
+    return Column<Row, T>{name, name, type, 0, member};
+}
+
+template <typename Row>
+constexpr Column<Row, std::string> nchar(const char* name, int length, std::string Row::* member) {
+    return Column<Row, std::string>{name, name, ColumnType::NCHAR, length, member};
+}
+
+template <typename Row, typename T>
+constexpr Column<Row, T> renamed(const Column<Row, T>& column, const char* key) {
+    return Column<Row, T>{column.name, key, column.type, column.length, column.member};
+}
+
+constexpr Label label(const char* name, ColumnType type, int length = 0) {
+    return Label{name, name, type, length};
+}
+
+// host_ip 标签对所有资源超级表相同，由生成器统一处理
+constexpr const char* kHostTag = "host_ip";
+constexpr int kHostTagLength = 16;
+
+// node 超级表对应的行结构，仅用于写入
+struct NodeAllocationRow {
+    int gpu_allocated = 0;
+    int gpu_num = 0;
+};
+
+struct CpuStable {
+    using Row = NodeResourceData::CpuData;
+    static const char* name() { return "cpu"; }
+    static const char* metricType() { return "cpu"; }
+    static constexpr std::tuple<> tags() { return std::tuple<>(); }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("usage_percent", ColumnType::DOUBLE, &Row::usage_percent),
+            column("load_avg_1m", ColumnType::DOUBLE, &Row::load_avg_1m),
+            column("load_avg_5m", ColumnType::DOUBLE, &Row::load_avg_5m),
+            column("load_avg_15m", ColumnType::DOUBLE, &Row::load_avg_15m),
+            column("core_count", ColumnType::INT, &Row::core_count),
+            column("core_allocated", ColumnType::INT, &Row::core_allocated),
+            column("temperature", ColumnType::DOUBLE, &Row::temperature),
+            column("voltage", ColumnType::DOUBLE, &Row::voltage),
+            column("current", ColumnType::DOUBLE, &Row::current),
+            column("power", ColumnType::DOUBLE, &Row::power));
+    }
+};
+
+struct MemoryStable {
+    using Row = NodeResourceData::MemoryData;
+    static const char* name() { return "memory"; }
+    static const char* metricType() { return "memory"; }
+    static constexpr std::tuple<> tags() { return std::tuple<>(); }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("total", ColumnType::BIGINT, &Row::total),
+            column("used", ColumnType::BIGINT, &Row::used),
+            column("free", ColumnType::BIGINT, &Row::free),
+            column("usage_percent", ColumnType::DOUBLE, &Row::usage_percent));
+    }
+};
+
+struct NetworkStable {
+    using Row = NodeResourceData::NetworkData;
+    static const char* name() { return "network"; }
+    static const char* metricType() { return "network"; }
+    static constexpr auto tags() {
+        return std::make_tuple(nchar("interface", 32, &Row::interface));
+    }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("rx_bytes", ColumnType::BIGINT, &Row::rx_bytes),
+            column("tx_bytes", ColumnType::BIGINT, &Row::tx_bytes),
+            column("rx_packets", ColumnType::BIGINT, &Row::rx_packets),
+            column("tx_packets", ColumnType::BIGINT, &Row::tx_packets),
+            column("rx_errors", ColumnType::BIGINT, &Row::rx_errors),
+            column("tx_errors", ColumnType::BIGINT, &Row::tx_errors),
+            column("rx_rate", ColumnType::BIGINT, &Row::rx_rate),
+            column("tx_rate", ColumnType::BIGINT, &Row::tx_rate),
+            column("rx_packet_rate", ColumnType::DOUBLE, &Row::rx_packet_rate),
+            column("tx_packet_rate", ColumnType::DOUBLE, &Row::tx_packet_rate),
+            column("rx_error_rate", ColumnType::DOUBLE, &Row::rx_error_rate),
+            column("tx_error_rate", ColumnType::DOUBLE, &Row::tx_error_rate));
+    }
+};
+
+struct DiskStable {
+    using Row = NodeResourceData::DiskData;
+    static const char* name() { return "disk"; }
+    static const char* metricType() { return "disk"; }
+    static constexpr auto tags() {
+        return std::make_tuple(
+            nchar("device", 32, &Row::device),
+            nchar("mount_point", 64, &Row::mount_point));
+    }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("total", ColumnType::BIGINT, &Row::total),
+            column("used", ColumnType::BIGINT, &Row::used),
+            column("free", ColumnType::BIGINT, &Row::free),
+            column("usage_percent", ColumnType::DOUBLE, &Row::usage_percent));
+    }
+};
+
+struct GpuStable {
+    using Row = NodeResourceData::GpuData;
+    static const char* name() { return "gpu"; }
+    static const char* metricType() { return "gpu"; }
+    static constexpr auto tags() {
+        return std::make_tuple(
+            renamed(column("gpu_index", ColumnType::INT, &Row::index), "index"),
+            renamed(nchar("gpu_name", 64, &Row::name), "name"));
+    }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("compute_usage", ColumnType::DOUBLE, &Row::compute_usage),
+            column("mem_usage", ColumnType::DOUBLE, &Row::mem_usage),
+            column("mem_used", ColumnType::BIGINT, &Row::mem_used),
+            column("mem_total", ColumnType::BIGINT, &Row::mem_total),
+            column("temperature", ColumnType::DOUBLE, &Row::temperature),
+            column("power", ColumnType::DOUBLE, &Row::power));
+    }
+};
+
+struct NodeStable {
+    using Row = NodeAllocationRow;
+    static const char* name() { return "node"; }
+    static const char* metricType() { return "node"; }
+    static constexpr std::tuple<> tags() { return std::tuple<>(); }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("gpu_allocated", ColumnType::INT, &Row::gpu_allocated),
+            column("gpu_num", ColumnType::INT, &Row::gpu_num));
+    }
+};
+
+struct ContainerStable {
+    using Row = NodeResourceData::ContainerData;
+    static const char* name() { return "container"; }
+    static const char* metricType() { return "container"; }
+    static constexpr std::tuple<> tags() { return std::tuple<>(); }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("container_count", ColumnType::INT, &Row::container_count),
+            column("paused_count", ColumnType::INT, &Row::paused_count),
+            column("running_count", ColumnType::INT, &Row::running_count),
+            column("stopped_count", ColumnType::INT, &Row::stopped_count));
+    }
+};
+
+// BMC传感器超级表由 BMCStorage 建表，这里只描述读取所需的列
+struct SensorStable {
+    using Row = NodeResourceData::SensorData;
+    static const char* name() { return "bmc_sensor_super"; }
+    static const char* metricType() { return "sensor"; }
+    static constexpr auto tags() {
+        return std::make_tuple(
+            column("sensor_seq", ColumnType::SMALLINT, &Row::sequence),
+            column("sensor_type", ColumnType::SMALLINT, &Row::type),
+            nchar("sensor_name", 16, &Row::name),
+            label("box_id", ColumnType::SMALLINT),
+            label("slot_id", ColumnType::SMALLINT));
+    }
+    static constexpr auto fields() {
+        return std::make_tuple(
+            column("sensor_value", ColumnType::INT, &Row::value),
+            column("alarm_type", ColumnType::SMALLINT, &Row::alarm_type));
+    }
+};
+
+// ------------------------------------------------------------------
+// 元组遍历工具
+// ------------------------------------------------------------------
+
+template <typename T>
+struct TypeTag {
+    using type = T;
+};
+
+namespace detail {
+    template <typename Tuple, typename F, size_t... I>
+    void forEach(const Tuple& tuple, F&& f, std::index_sequence<I...>) {
+        using expand = int[];
+        (void)expand{0, (f(std::get<I>(tuple), std::integral_constant<size_t, I>()), 0)...};
+    }
+}
+
+// 依次以 (列描述, 编译期下标) 调用 f
+template <typename Tuple, typename F>
+void forEach(const Tuple& tuple, F&& f) {
+    detail::forEach(tuple, std::forward<F>(f), std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+template <typename S>
+struct StableWidth {
+    static constexpr size_t kTags = std::tuple_size<decltype(S::tags())>::value;
+    static constexpr size_t kFields = std::tuple_size<decltype(S::fields())>::value;
+    static constexpr size_t value = kTags + kFields;
+};
+
+// ------------------------------------------------------------------
+// DDL 与写入
+// ------------------------------------------------------------------
+
+template <typename S>
+std::string createStableSql() {
+    std::ostringstream sql;
+    sql << "CREATE STABLE IF NOT EXISTS " << S::name() << " (ts TIMESTAMP";
+    forEach(S::fields(), [&](const auto& column, auto) {
+        sql << ", " << column.name << " " << sqlType(column.type, column.length);
+    });
+    sql << ") TAGS (" << kHostTag << " " << sqlType(ColumnType::NCHAR, kHostTagLength);
+    forEach(S::tags(), [&](const auto& column, auto) {
+        sql << ", " << column.name << " " << sqlType(column.type, column.length);
+    });
+    sql << ")";
+    return sql.str();
+}
+
+namespace detail {
+    inline void writeValue(std::ostream& os, const std::string& value) {
+        os << "'" << value << "'";
+    }
+
+    // NaN 表示该值不可用，写入 NULL
+    inline void writeValue(std::ostream& os, double value) {
+        if (std::isnan(value)) {
+            os << "NULL";
+        } else {
+            os << value;
+        }
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type writeValue(std::ostream& os, T value) {
+        os << value;
+    }
+}
+
+// 子表的 TAGS 取值列表：('host_ip', tag1, ...)
+template <typename S>
+void appendTagValues(std::ostream& os, const std::string& host_ip, const typename S::Row& row) {
+    os << "('" << host_ip << "'";
+    forEach(S::tags(), [&](const auto& column, auto) {
+        os << ", ";
+        detail::writeValue(os, row.*(column.member));
+    });
+    os << ")";
+}
+
+// 一行的 VALUES 列表：(ts, field1, ...)
+template <typename S>
+void appendValues(std::ostream& os, int64_t timestamp, const typename S::Row& row) {
+    os << "(" << timestamp;
+    forEach(S::fields(), [&](const auto& column, auto) {
+        os << ", ";
+        detail::writeValue(os, row.*(column.member));
+    });
+    os << ")";
+}
+
+// ------------------------------------------------------------------
+// 单元格读取
+// ------------------------------------------------------------------
+
+inline int64_t cellToInt64(const TAOS_FIELD& field, const void* cell) {
+    switch (field.type) {
+        case TSDB_DATA_TYPE_TINYINT: return *static_cast<const int8_t*>(cell);
+        case TSDB_DATA_TYPE_SMALLINT: return *static_cast<const int16_t*>(cell);
+        case TSDB_DATA_TYPE_INT: return *static_cast<const int32_t*>(cell);
+        case TSDB_DATA_TYPE_BIGINT:
+        case TSDB_DATA_TYPE_TIMESTAMP: return *static_cast<const int64_t*>(cell);
+        case TSDB_DATA_TYPE_FLOAT: return static_cast<int64_t>(*static_cast<const float*>(cell));
+        case TSDB_DATA_TYPE_DOUBLE: return static_cast<int64_t>(*static_cast<const double*>(cell));
+        default: return 0;
+    }
+}
+
+inline double cellToDouble(const TAOS_FIELD& field, const void* cell) {
+    switch (field.type) {
+        case TSDB_DATA_TYPE_FLOAT: return *static_cast<const float*>(cell);
+        case TSDB_DATA_TYPE_DOUBLE: return *static_cast<const double*>(cell);
+        default: return static_cast<double>(cellToInt64(field, cell));
+    }
+}
+
+inline std::string cellToString(const TAOS_FIELD& field, const void* cell, int length) {
+    switch (field.type) {
+        case TSDB_DATA_TYPE_NCHAR:
+        case TSDB_DATA_TYPE_BINARY: return std::string(static_cast<const char*>(cell), length);
+        case TSDB_DATA_TYPE_FLOAT: return std::to_string(*static_cast<const float*>(cell));
+        case TSDB_DATA_TYPE_DOUBLE: return std::to_string(*static_cast<const double*>(cell));
+        default: return std::to_string(cellToInt64(field, cell));
+    }
+}
+
+namespace detail {
+    inline void readCell(std::string& out, const TAOS_FIELD& field, const void* cell, int length) {
+        out = cellToString(field, cell, length);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type
+    readCell(T& out, const TAOS_FIELD& field, const void* cell, int) {
+        out = static_cast<T>(cellToInt64(field, cell));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type
+    readCell(T& out, const TAOS_FIELD& field, const void* cell, int) {
+        out = static_cast<T>(cellToDouble(field, cell));
+    }
+
+    template <typename Row, typename T>
+    void readColumn(const Column<Row, T>& column, Row& row, const TAOS_FIELD& field, const void* cell, int length) {
+        readCell(row.*(column.member), field, cell, length);
+    }
+
+    template <typename Row>
+    void readColumn(const Label&, Row&, const TAOS_FIELD&, const void*, int) {
+    }
+}
+
+// ------------------------------------------------------------------
+// 多超级表 UNION ALL 查询布局
+// ------------------------------------------------------------------
+
+enum class SelectMode {
+    LAST_ROW,          // 每个分组的最新一行
+    LAST_ROW_BY_HOST,  // 所有主机每个分组的最新一行，结果末尾追加 host_ip 列
+    RANGE              // 时间范围内的所有行
+};
+
+/**
+ * @brief 多个超级表合并查询的列布局
+ *
+ * 结果列依次为 table_type（超级表在布局中的序号）、ts，之后每个超级表占用
+ * 一段互不重叠的列（先标签后数值列），其他超级表的列以 NULL 填充。
+ * 每个超级表的起始列号在编译期计算，解码时直接按下标读取。
+ * LAST_ROW_BY_HOST 模式在所有超级表的列之后追加 host_ip 列（列号为 columnCount()）。
+ */
+template <typename... Stables>
+struct Layout {
+    static constexpr size_t kTableTypeColumn = 0;
+    static constexpr size_t kTimestampColumn = 1;
+    static constexpr size_t kPrefixColumns = 2;
+
+    template <typename S>
+    static constexpr size_t index() {
+        constexpr bool match[] = {std::is_same<S, Stables>::value...};
+        size_t i = 0;
+        while (i < sizeof...(Stables) && !match[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    template <typename S>
+    static constexpr size_t offset() {
+        constexpr size_t widths[] = {StableWidth<Stables>::value...};
+        size_t column = kPrefixColumns;
+        for (size_t i = 0; i < index<S>(); ++i) {
+            column += widths[i];
+        }
+        return column;
+    }
+
+    static constexpr size_t columnCount() {
+        constexpr size_t widths[] = {StableWidth<Stables>::value...};
+        size_t count = kPrefixColumns;
+        for (size_t i = 0; i < sizeof...(Stables); ++i) {
+            count += widths[i];
+        }
+        return count;
+    }
+
+    // 依次以 TypeTag<S> 调用 f
+    template <typename F>
+    static void forEachStable(F&& f) {
+        using expand = int[];
+        (void)expand{0, (f(TypeTag<Stables>()), 0)...};
+    }
+
+    // 按 table_type 序号调用 f(TypeTag<S>)，序号无效时返回false
+    template <typename F>
+    static bool dispatch(size_t table_index, F&& f) {
+        bool found = false;
+        using expand = int[];
+        (void)expand{0, (table_index == index<Stables>() ? (f(TypeTag<Stables>()), found = true, 0) : 0)...};
+        return found;
+    }
+
+    /**
+     * @brief 生成超级表 S 在此布局下的 SELECT 语句
+     * @param condition WHERE 条件（不含 WHERE 关键字）
+     */
+    template <typename S>
+    static std::string select(SelectMode mode, const std::string& condition) {
+        const bool last_row = mode != SelectMode::RANGE;
+        std::ostringstream sql;
+        sql << "SELECT " << index<S>() << " as table_type, "
+            << (last_row ? "LAST_ROW(ts)" : "ts") << " as ts";
+        forEachStable([&](auto tag) {
+            using T = typename decltype(tag)::type;
+            const bool selected = std::is_same<S, T>::value;
+            forEach(T::tags(), [&](const auto& column, auto) {
+                sql << ", ";
+                if (selected) {
+                    sql << column.name;
+                } else {
+                    sql << "NULL";
+                }
+                sql << " as " << T::metricType() << "_" << column.name;
+            });
+            forEach(T::fields(), [&](const auto& column, auto) {
+                sql << ", ";
+                if (!selected) {
+                    sql << "NULL";
+                } else if (last_row) {
+                    sql << "LAST_ROW(" << column.name << ")";
+                } else {
+                    sql << column.name;
+                }
+                sql << " as " << T::metricType() << "_" << column.name;
+            });
+        });
+        if (mode == SelectMode::LAST_ROW_BY_HOST) {
+            sql << ", " << kHostTag;
+        }
+        sql << " FROM " << S::name();
+        if (!condition.empty()) {
+            sql << " WHERE " << condition;
+        }
+        if (mode == SelectMode::LAST_ROW_BY_HOST) {
+            sql << " GROUP BY " << kHostTag;
+            forEach(S::tags(), [&](const auto& column, auto) {
+                sql << ", " << column.name;
+            });
+        } else if (mode == SelectMode::LAST_ROW && StableWidth<S>::kTags > 0) {
+            sql << " GROUP BY ";
+            forEach(S::tags(), [&](const auto& column, auto index) {
+                if (decltype(index)::value > 0) {
+                    sql << ", ";
+                }
+                sql << column.name;
+            });
+        }
+        return sql.str();
+    }
+
+    // 按编译期列号把一行结果解码到超级表 S 的行结构，NULL 单元格保持默认值
+    template <typename S>
+    static void decode(TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, typename S::Row& out) {
+        constexpr size_t base = offset<S>();
+        forEach(S::tags(), [&](const auto& column, auto index) {
+            constexpr size_t i = base + decltype(index)::value;
+            if (row[i] != nullptr) {
+                detail::readColumn(column, out, fields[i], row[i], lengths[i]);
+            }
+        });
+        forEach(S::fields(), [&](const auto& column, auto index) {
+            constexpr size_t i = base + StableWidth<S>::kTags + decltype(index)::value;
+            if (row[i] != nullptr) {
+                detail::readColumn(column, out, fields[i], row[i], lengths[i]);
+            }
+        });
+    }
+
+    // 按编译期列号把一行结果解码为 QueryResult（标签进入 labels，数值列进入 metrics）
+    template <typename S>
+    static void decode(TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, QueryResult& out) {
+        constexpr size_t base = offset<S>();
+        forEach(S::tags(), [&](const auto& column, auto index) {
+            constexpr size_t i = base + decltype(index)::value;
+            if (row[i] != nullptr) {
+                out.labels[column.name] = cellToString(fields[i], row[i], lengths[i]);
+            }
+        });
+        forEach(S::fields(), [&](const auto& column, auto index) {
+            constexpr size_t i = base + StableWidth<S>::kTags + decltype(index)::value;
+            if (row[i] != nullptr) {
+                out.metrics[column.name] = cellToDouble(fields[i], row[i]);
+            }
+        });
+    }
+
+    static int64_t decodeTimestamp(TAOS_ROW row, const TAOS_FIELD* fields) {
+        if (row[kTimestampColumn] == nullptr) {
+            return 0;
+        }
+        return cellToInt64(fields[kTimestampColumn], row[kTimestampColumn]);
+    }
+
+    // LAST_ROW_BY_HOST 模式下追加的 host_ip 列，为 NULL 时返回空串
+    static std::string decodeHost(TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields) {
+        constexpr size_t i = columnCount();
+        if (row[i] == nullptr) {
+            return std::string();
+        }
+        return cellToString(fields[i], row[i], lengths[i]);
+    }
+
+    static int decodeTableIndex(TAOS_ROW row, const TAOS_FIELD* fields) {
+        if (row[kTableTypeColumn] == nullptr) {
+            return -1;
+        }
+        return static_cast<int>(cellToInt64(fields[kTableTypeColumn], row[kTableTypeColumn]));
+    }
+};
+
+// ------------------------------------------------------------------
+// JSON 序列化
+// ------------------------------------------------------------------
+
+namespace detail {
+    inline std::string labelText(const std::string& value) { return value; }
+
+    template <typename T>
+    std::string labelText(T value) { return std::to_string(value); }
+}
+
+// 把一行写入数据转换为告警引擎使用的样本，标签名与 executeQuerySQL 返回的列名一致，NaN（不可用）的值不输出
+template <typename S>
+MetricSample toSample(const std::string& host_ip, int64_t timestamp, const typename S::Row& row) {
+    MetricSample sample;
+    sample.stable = S::name();
+    sample.data.timestamp = timestamp;
+    sample.data.labels[kHostTag] = host_ip;
+    forEach(S::tags(), [&](const auto& column, auto) {
+        sample.data.labels[column.name] = detail::labelText(row.*(column.member));
+    });
+    forEach(S::fields(), [&](const auto& column, auto) {
+        double value = static_cast<double>(row.*(column.member));
+        if (!std::isnan(value)) {
+            sample.data.metrics[column.name] = value;
+        }
+    });
+    return sample;
+}
+
+// 把 QueryResult 中属于超级表 S 的绑定标签写入 JSON（使用列的 key 作为字段名）
+template <typename S>
+void appendTagsJson(const QueryResult& point, nlohmann::json& out) {
+    forEach(S::tags(), [&](const auto& column, auto) {
+        auto it = point.labels.find(column.name);
+        if (it == point.labels.end()) {
+            return;
+        }
+        if (column.type == ColumnType::NCHAR) {
+            out[column.key] = it->second;
+        } else {
+            out[column.key] = std::stoll(it->second);
+        }
+    });
+}
+
+// 资源超级表：由 ResourceStorage 建表和写入
+using ResourceStables = std::tuple<CpuStable, MemoryStable, NetworkStable, DiskStable, GpuStable, NodeStable, ContainerStable>;
+
+// 节点最新数据与历史数据查询使用的合并布局
+using NodeQueryLayout = Layout<CpuStable, MemoryStable, DiskStable, NetworkStable, GpuStable, ContainerStable, SensorStable>;
+
+}  // namespace metric_schema
@@ -178,6 +178,14 @@ public:
     // 获取配置
     const MySQLPoolConfig& getConfig() const { return config_; }
 
+    /**
+     * @brief 通过专用连接发送 KILL QUERY，中止线程 thread_id 上正在执行的语句
+     *
+     * 专用连接不属于连接池、首次使用时建立，连接池耗尽时也能发送；发送失败时重建一次连接再试。
+     * @return 成功发送返回true
+     */
+    bool killQuery(unsigned long thread_id);
+
 private:
     MySQLPoolConfig config_;
     
@@ -208,6 +216,10 @@ private:
     
     // 关闭超时时间（毫秒）
     int shutdown_timeout_ms_ = 5000;  // 默认5秒
+
+    // KILL QUERY 专用连接，不计入连接池
+    std::mutex kill_mutex_;
+    std::unique_ptr<MySQLConnection> kill_connection_;
     
     // 私有方法
     std::unique_ptr<MySQLConnection> createConnection();
@@ -3,9 +3,12 @@
 
 #include <memory>
 #include <unordered_map>
+#include <set>
+#include <tuple>
 #include <vector>
 #include <string>
 #include <mutex>
+#include <functional>
 #include <chrono>
 #include <cstdint>
 #include "bmc_listener.h"
@@ -61,15 +64,36 @@ struct NodeData {
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NodeData, box_id, slot_id, cpu_id, srio_id, host_ip, hostname, service_port, box_type, board_type, cpu_type, os_type, resource_type, cpu_arch, gpu, component, ipmb_address, module_type, bmc_company, bmc_version, status, last_heartbeat);
 
+// 节点有序索引键：按 box_id, slot_id, cpu_id, host_ip 排序
+struct NodeOrderKey {
+    int box_id = 0;
+    int slot_id = 0;
+    int cpu_id = 0;
+    std::string host_ip;
+
+    bool operator<(const NodeOrderKey& other) const {
+        return std::tie(box_id, slot_id, cpu_id, host_ip) <
+               std::tie(other.box_id, other.slot_id, other.cpu_id, other.host_ip);
+    }
+};
+
 class NodeStorage {
+public:
+    // 节点被删除或转为离线时的回调，参数为 host_ip
+    using NodeUnavailableCallback = std::function<void(const std::string&)>;
+
 private:
     //m_nodes 共享指针
     std::unordered_map<std::string, std::shared_ptr<NodeData>> m_nodes;
+    // 有序索引，保证分页遍历顺序稳定
+    std::set<NodeOrderKey> m_order_index;
     mutable std::mutex m_mutex;
     // 活跃节点判定超时时长（毫秒）
     int64_t m_active_timeout_ms = 10000; // 默认10秒
     // 监控检查周期（毫秒）
     int64_t m_monitor_check_interval_ms = 1000; // 默认1秒
+    // 节点不可用回调列表（受 m_mutex 保护，在锁外依次调用）
+    std::vector<NodeUnavailableCallback> m_unavailable_callbacks;
 
 public:
     NodeStorage();
@@ -118,8 +142,25 @@ public:
     // 获取监控检查周期（毫秒）
     int64_t getMonitorCheckIntervalMs() const;
 
-    // 更新节点状态（线程安全）
+    // 更新节点状态（线程安全），状态变为 offline 时触发节点不可用回调
     void updateNodeStatus(const std::string& host_ip, const std::string& status);
+
+    // 增加节点被删除或转为离线时的回调，可注册多个订阅者，回调在存储锁外按注册顺序调用
+    void addNodeUnavailableCallback(NodeUnavailableCallback callback);
+
+    // 按有序索引 (box_id, slot_id, cpu_id, host_ip) 获取所有节点
+    std::vector<std::shared_ptr<NodeData>> getAllNodesOrdered();
+
+    // 按有序索引从 after 之后（after 为空时从头）遍历节点，visitor 返回false时停止；
+    // visitor 在存储锁内调用，不能查询数据库或回调 NodeStorage
+    void forEachNodeOrdered(const NodeOrderKey* after, const std::function<bool(const std::shared_ptr<NodeData>&)>& visitor);
+
+    // 生成节点的有序索引键
+    static NodeOrderKey makeOrderKey(const NodeData& node);
+
+private:
+    // 节点位置信息变化后更新有序索引（调用方需持有m_mutex）
+    void reindexNode(const NodeOrderKey& old_key, bool existed, const NodeData& node);
 };
 
 #endif // NODE_STORAGE_H
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "node_model.h"
+#include "json.hpp"
+
+// 候选节点排序策略
+enum class PlacementPolicy {
+    BEST_FIT,      // 剩余资源刚好满足需求的节点优先，减少资源碎片
+    LEAST_LOADED   // 剩余资源最多的节点优先，均衡负载
+};
+
+// 放置查询条件
+struct PlacementQuery {
+    int min_free_cores = 0;     // 至少空闲的CPU核数
+    int min_free_gpus = 0;      // 至少空闲的GPU数量
+    std::string cpu_arch;       // 为空表示不限
+    std::string resource_type;  // 为空表示不限
+    PlacementPolicy policy = PlacementPolicy::BEST_FIT;
+    size_t limit = 10;
+};
+
+// 候选节点容量信息
+struct PlacementCandidate {
+    std::string host_ip;
+    int box_id = 0;
+    int slot_id = 0;
+    std::string cpu_arch;
+    std::string resource_type;
+    int core_count = 0;
+    int core_allocated = 0;
+    int free_cores = 0;
+    int gpu_num = 0;
+    int gpu_allocated = 0;
+    int free_gpus = 0;
+    double cpu_usage_percent = 0.0;
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(PlacementCandidate, host_ip, box_id, slot_id, cpu_arch, resource_type,
+                                   core_count, core_allocated, free_cores, gpu_num, gpu_allocated, free_gpus,
+                                   cpu_usage_percent)
+
+/**
+ * @brief 节点空闲容量索引
+ *
+ * 由心跳（节点属性）和资源上报（核数/GPU分配情况）实时更新，按 cpu_arch/resource_type 分区，
+ * 每个分区维护以 (空闲核数, 空闲GPU数) 和 (空闲GPU数, 空闲核数) 排序的两个有序集合，
+ * 放置查询通过 lower_bound 在对数时间内定位主排序资源满足需求的第一个节点。
+ * 次排序资源不单独建索引，从该位置起逐个跳过次资源不足的节点，单个分区的查询为 O(log n + k + skipped)，
+ * skipped 为主资源满足而次资源不足的节点数；未指定 cpu_arch/resource_type 时对每个匹配的分区各查询一次。
+ * 超过超时时长没有更新的节点、离线或被删除的节点从索引中移除，查询不会扫过失效的节点。
+ */
+class PlacementIndex {
+public:
+    PlacementIndex();
+    ~PlacementIndex();
+
+    // 心跳更新节点属性
+    void updateNodeInfo(const node::BoxInfo& box_info);
+
+    // 资源上报更新容量
+    void updateResource(const std::string& host_ip, const node::ResourceData& resource);
+
+    // 删除节点
+    void removeNode(const std::string& host_ip);
+
+    // 查询满足条件的候选节点，按策略排序（先移除已超时的节点）
+    std::vector<PlacementCandidate> findCandidates(const PlacementQuery& query);
+
+    // 已建立容量信息的节点数量
+    size_t size() const;
+
+    // 超过该时长未收到心跳或资源上报的节点不参与放置（毫秒）
+    void setStaleTimeoutMs(int64_t timeout_ms);
+
+    // 解析策略名称 best_fit / least_loaded
+    static bool parsePolicy(const std::string& name, PlacementPolicy& policy);
+
+private:
+    // (主排序资源, 次排序资源, host_ip)
+    using CapacityKey = std::tuple<int, int, std::string>;
+
+    struct Partition {
+        std::string cpu_arch;
+        std::string resource_type;
+        std::set<CapacityKey> by_cores;  // (free_cores, free_gpus, host_ip)
+        std::set<CapacityKey> by_gpus;   // (free_gpus, free_cores, host_ip)
+    };
+
+    struct Entry {
+        PlacementCandidate info;
+        int64_t last_update_ms = 0;  // steady_clock 毫秒
+        bool has_resource = false;   // 收到资源上报后才参与放置
+    };
+
+    static std::string partitionKey(const std::string& cpu_arch, const std::string& resource_type);
+    void indexEntry(const Entry& entry);
+    void unindexEntry(const Entry& entry);
+    // 更新节点的最近更新时间（调用方持有m_mutex）
+    void touchEntry(Entry& entry, int64_t now_ms);
+    // 移除超过超时时长没有更新的节点（调用方持有m_mutex）
+    void evictStale(int64_t now_ms);
+    void eraseEntry(std::unordered_map<std::string, Entry>::iterator it);
+
+    std::unordered_map<std::string, Entry> m_entries;
+    std::map<std::string, Partition> m_partitions;
+    std::set<std::pair<int64_t, std::string>> m_by_update;  // (最近更新时间, host_ip)，按时间淘汰超时节点
+    int64_t m_stale_timeout_ms = 20000;
+    mutable std::mutex m_mutex;
+};
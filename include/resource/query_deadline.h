@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * @brief 查询截止时间
+ *
+ * 未设置截止时间时表示不限时。
+ */
+class QueryDeadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    QueryDeadline() = default;
+
+    // 从当前时刻起 timeout_ms 毫秒后到期，timeout_ms <= 0 表示不限时
+    static QueryDeadline afterMs(int64_t timeout_ms);
+
+    bool isSet() const { return m_set; }
+    bool expired() const;
+    // 剩余毫秒数，未设置时返回-1，已到期返回0
+    int64_t remainingMs() const;
+    Clock::time_point timePoint() const { return m_time_point; }
+
+private:
+    bool m_set = false;
+    Clock::time_point m_time_point;
+};
+
+/**
+ * @brief 查询因超过截止时间被中止
+ */
+class QueryDeadlineExceeded : public std::runtime_error {
+public:
+    explicit QueryDeadlineExceeded(const std::string& message) : std::runtime_error(message) {}
+};
+
+/**
+ * @brief 当前线程的查询截止时间上下文
+ *
+ * HttpServer 在处理请求时创建，ResourceStorage / BMCStorage / AlarmManager 的读查询
+ * 通过 current() 获取截止时间，不需要逐层修改接口参数。查询被中止时调用 markExceeded()，
+ * 即使中间层吞掉了异常，请求处理结束后仍可通过 exceeded() 判断是否超时。
+ */
+class QueryDeadlineScope {
+public:
+    explicit QueryDeadlineScope(const QueryDeadline& deadline);
+    ~QueryDeadlineScope();
+
+    QueryDeadlineScope(const QueryDeadlineScope&) = delete;
+    QueryDeadlineScope& operator=(const QueryDeadlineScope&) = delete;
+
+    bool exceeded() const { return m_exceeded; }
+
+    // 当前线程的截止时间，没有上下文时返回不限时
+    static const QueryDeadline& current();
+
+    // 标记当前线程的请求已超时
+    static void markExceeded();
+
+    // 获取连接池连接的等待时间：不限时返回0（使用连接池默认值），否则为剩余时间
+    static int acquireTimeoutMs();
+
+    // 已超时则标记并抛出 QueryDeadlineExceeded
+    static void throwIfExpired(const std::string& what);
+
+private:
+    QueryDeadline m_deadline;
+    bool m_exceeded = false;
+    QueryDeadlineScope* m_previous = nullptr;
+};
+
+/**
+ * @brief 查询看门狗
+ *
+ * 后台线程在截止时间到达时执行取消回调（taos_kill_query / KILL QUERY），
+ * 使阻塞中的查询尽快返回，连接随后由RAII守卫归还连接池。
+ */
+class QueryWatchdog {
+public:
+    static QueryWatchdog& getInstance();
+
+    ~QueryWatchdog();
+
+    // 注册取消回调，返回注册ID
+    uint64_t arm(QueryDeadline::Clock::time_point deadline, std::function<void()> cancel);
+
+    // 注销回调；若回调已执行（或正在执行，会等待其完成）返回true
+    bool disarm(uint64_t id);
+
+    /**
+     * @brief 在作用域内按当前线程的截止时间注册取消回调
+     */
+    class Guard {
+    public:
+        explicit Guard(std::function<void()> cancel);
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // 注销并返回取消回调是否已触发
+        bool release();
+
+    private:
+        uint64_t m_id = 0;
+        bool m_armed = false;
+        bool m_fired = false;
+    };
+
+private:
+    QueryWatchdog() = default;
+    void run();
+
+    struct Entry {
+        QueryDeadline::Clock::time_point deadline;
+        std::function<void()> cancel;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint64_t, Entry> m_entries;
+    std::multimap<QueryDeadline::Clock::time_point, uint64_t> m_schedule;
+    std::set<uint64_t> m_fired;
+    uint64_t m_next_id = 1;
+    uint64_t m_running_id = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+};
@@ -66,6 +66,10 @@ struct NetworkInfo
     long long tx_packets = 0;
     double tx_rate = 0.0;
     double rx_rate = 0.0;
+    double rx_packet_rate = 0.0;
+    double tx_packet_rate = 0.0;
+    double rx_error_rate = 0.0;
+    double tx_error_rate = 0.0;
     long long timestamp = 0;
 };
 
@@ -183,6 +187,34 @@ struct NodeMetricsDataListPagination
     Pagination pagination;
 };
 
+// 节点指标查询参数（稀疏字段、服务端过滤/排序、游标分页）
+struct NodeMetricsQuery
+{
+    std::string fields;  // 逗号分隔的返回字段，如 host_ip,status,cpu,memory；为空返回全部
+    std::string filter;  // 逗号分隔的过滤条件，如 status=online,box_id=1,cpu.usage_percent>80
+    std::string sort;    // 排序字段，'-'前缀表示降序；为空按有序索引 (box_id, slot_id, cpu_id, host_ip)
+    std::string cursor;  // 上一页返回的 next_cursor
+    int limit = 100;
+};
+
+struct CursorPagination
+{
+    int total_count = 0;  // 过滤后的节点总数
+    int page_size = 0;
+    bool has_next = false;
+    std::string next_cursor;
+};
+
+// 游标分页节点指标查询结果
+struct NodeMetricsCursorResult
+{
+    bool success = false;
+    bool invalid_request = false;  // 参数错误（fields/filter/sort/cursor 无法解析）
+    std::string error_message;
+    nlohmann::json nodes_metrics = nlohmann::json::array();  // 按fields裁剪后的节点指标
+    CursorPagination pagination;
+};
+
 // 历史指标查询请求结构
 struct HistoricalMetricsRequest
 {
@@ -208,8 +240,10 @@ private:
     // 私有方法
     std::pair<bool, std::string> validateRequest(const HistoricalMetricsRequest &request);
 
-    // 辅助方法：构建单个节点的指标数据
-    NodeMetricsData buildNodeMetricsData(const std::shared_ptr<NodeData> &node);
+    // 辅助方法：构建单个节点的指标数据，include_resource为false时不查询TDengine，只填充节点属性和状态
+    NodeMetricsData buildNodeMetricsData(const std::shared_ptr<NodeData> &node, bool include_resource = true);
+    // 用已取回的最新资源数据构建节点的指标数据，不查询TDengine
+    NodeMetricsData buildNodeMetricsData(const std::shared_ptr<NodeData> &node, const NodeResourceData &resourceData);
 
 public:
     ResourceManager(std::shared_ptr<ResourceStorage> resource_storage,
@@ -225,6 +259,9 @@ public:
     // 分页当前指标查询
     NodeMetricsDataListPagination getPaginatedCurrentMetrics(int page, int page_size);
 
+    // 游标分页当前指标查询（支持fields/filter/sort）
+    NodeMetricsCursorResult queryCurrentMetrics(const NodeMetricsQuery &query);
+
     // 历史指标查询
     NodeMetricsRangeDataResult getHistoricalMetrics(const HistoricalMetricsRequest &request);
 
@@ -245,7 +282,7 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(DiskInfo, device, free, mount_point, total, u
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(DiskMetrics, disk_count, disks, timestamp)
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NetworkInfo, interface, rx_bytes, rx_errors, rx_packets, tx_bytes, tx_errors, tx_packets, tx_rate, rx_rate, timestamp)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NetworkInfo, interface, rx_bytes, rx_errors, rx_packets, tx_bytes, tx_errors, tx_packets, tx_rate, rx_rate, rx_packet_rate, tx_packet_rate, rx_error_rate, tx_error_rate, timestamp)
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NetworkMetrics, network_count, networks, timestamp)
 
@@ -267,6 +304,8 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Pagination, total_count, page, page_size, tot
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NodeMetricsDataListPagination, success, error_message, data, pagination)
 
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(CursorPagination, total_count, page_size, has_next, next_cursor)
+
 // 历史指标查询结果
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(QueryResult, labels, metrics, timestamp)
@@ -6,6 +6,9 @@
 #include <map>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <functional>
 #include <taos.h>
 #include "json.hpp"
 #include "node_model.h"
@@ -18,12 +21,18 @@ struct QueryResult {
     int64_t timestamp;  // 毫秒时间戳
 };
 
+// 写入路径上的一条指标样本：stable 为超级表名，data 的标签为 host_ip 及超级表标签，指标为各数值字段
+struct MetricSample {
+    std::string stable;
+    QueryResult data;
+};
+
 // 节点资源数据结构
 struct NodeResourceData {
     std::string host_ip;
     
     // CPU数据
-    struct {
+    struct CpuData {
         double usage_percent = 0.0;
         double load_avg_1m = 0.0;
         double load_avg_5m = 0.0;
@@ -36,17 +45,19 @@ struct NodeResourceData {
         double power = 0.0;
         int64_t timestamp = 0;  // 毫秒时间戳
         bool has_data = false;
-    } cpu;
+    };
+    CpuData cpu;
     
     // Memory数据
-    struct {
+    struct MemoryData {
         int64_t total = 0;
         int64_t used = 0;
         int64_t free = 0;
         double usage_percent = 0.0;
         int64_t timestamp = 0;  // 毫秒时间戳
         bool has_data = false;
-    } memory;
+    };
+    MemoryData memory;
     
     // Disk数据
     struct DiskData {
@@ -67,10 +78,14 @@ struct NodeResourceData {
         int64_t tx_bytes = 0;
         int64_t rx_packets = 0;
         int64_t tx_packets = 0;
-        int rx_errors = 0;
-        int tx_errors = 0;
+        int64_t rx_errors = 0;
+        int64_t tx_errors = 0;
         int64_t rx_rate = 0;
         int64_t tx_rate = 0;
+        double rx_packet_rate = 0.0;  // 接收包速率 (包/秒)，服务端由计数器推导，写入时 NaN 表示无有效值
+        double tx_packet_rate = 0.0;  // 发送包速率 (包/秒)
+        double rx_error_rate = 0.0;   // 接收错误速率 (个/秒)
+        double tx_error_rate = 0.0;   // 发送错误速率 (个/秒)
         int64_t timestamp = 0;  // 毫秒时间戳
     };
     std::vector<NetworkData> networks;
@@ -131,6 +146,9 @@ struct NodeResourceRangeData {
 
 class ResourceStorage {
 public:
+    // 写入样本观察者，由 insertResourceData 在写入数据库前同步调用
+    using SampleObserver = std::function<void(const std::vector<MetricSample>&)>;
+
     ResourceStorage(std::shared_ptr<TDengineConnectionPool> connection_pool);
     ~ResourceStorage();
 
@@ -144,17 +162,62 @@ public:
     // 查询接口
     std::vector<QueryResult> executeQuerySQL(const std::string& sql);
     
+    // 逐行回调的查询接口，结果不在内存中累积，用于大范围的历史数据扫描
+    void scanQuerySQL(const std::string& sql, const std::function<void(QueryResult&)>& on_result);
+    
     // 获取指定节点的所有资源数据
     NodeResourceData getNodeResourceData(const std::string& hostIp);
+    // 一次查询取回多个主机的最新资源数据（每个超级表按 host_ip 分组取 LAST_ROW），host_ips 为空表示所有主机，host_ip -> 数据
+    std::unordered_map<std::string, NodeResourceData> getLatestResourceData(const std::vector<std::string>& host_ips);
     
     // 获取指定节点在某个时间段内的资源数据
     NodeResourceRangeData getNodeResourceRangeData(const std::string& hostIp, 
                                                    const std::string& time_range,
                                                    const std::vector<std::string>& metrics);
+
+    // 设置写入样本观察者（告警引擎流式评估），传入空函数取消
+    void setSampleObserver(SampleObserver observer);
     
 private:
+    // 逐行回调 (行数据, 各列长度, 字段信息, 字段数)
+    using RowCallback = std::function<void(TAOS_ROW, const int*, const TAOS_FIELD*, int)>;
+
+    // 执行查询并逐行回调，executeQuerySQL 与按模式解码的查询共用
+    void executeRawQuery(const std::string& sql, const RowCallback& on_row);
+
+    // 网络接口上一次上报的累计计数器，用于推导每秒速率
+    struct NetworkCounterSample {
+        uint64_t rx_packets = 0;
+        uint64_t tx_packets = 0;
+        uint64_t rx_errors = 0;
+        uint64_t tx_errors = 0;
+        int64_t timestamp = 0;  // 毫秒时间戳
+    };
+
+    // 由计数器推导出的速率，valid为false表示首个样本或时间间隔无效，写入NULL
+    struct NetworkDerivedRates {
+        bool valid = false;
+        double rx_packet_rate = 0.0;
+        double tx_packet_rate = 0.0;
+        double rx_error_rate = 0.0;
+        double tx_error_rate = 0.0;
+    };
+
+    // 根据上一次已写入的样本计算速率，不更新状态（key: host_ip + interface）
+    NetworkDerivedRates deriveNetworkRates(const std::string& key, const NetworkCounterSample& sample);
+
+    // 写入成功后把本次样本记为各接口的上一次样本
+    void commitNetworkCounters(const std::vector<std::pair<std::string, NetworkCounterSample>>& samples);
+
     TDenginePoolConfig m_pool_config;
     std::shared_ptr<TDengineConnectionPool> m_connection_pool;
+
+    std::unordered_map<std::string, NetworkCounterSample> m_network_counters;
+    int64_t m_network_counters_swept_at = 0;  // 上次释放空闲接口计数器的时间（毫秒）
+    std::mutex m_network_counters_mutex;
+
+    SampleObserver m_sample_observer;
+    std::mutex m_sample_observer_mutex;
     
     // 日志辅助方法
     void logInfo(const std::string& message) const;
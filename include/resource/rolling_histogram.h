@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 直方图在时间窗口内的统计
+struct HistogramSummary {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+};
+
+/**
+ * @brief 滚动时间窗口的对数分桶直方图
+ *
+ * 告警规则引擎用它记录每条规则的评估开销（查询耗时、返回行数、状态协调耗时等）。值按2的幂分桶
+ * （桶0为0，桶 i 为 [2^(i-1), 2^i)），窗口按时间分为 kSlots 个槽，记录写入当前时间所在的槽，
+ * 槽过期后清空复用，不保存原始样本，observe() 为 O(1)。分位数取所在桶的上界（不超过窗口内最大值），
+ * 误差在2倍以内，足以区分“几毫秒”和“几秒”。不加锁，由调用方同步。
+ */
+class RollingHistogram {
+public:
+    static const size_t kBuckets = 32;
+    static const size_t kSlots = 5;
+
+    // slot_ms 为每个槽的时长，窗口为 kSlots 个槽
+    explicit RollingHistogram(int64_t slot_ms = 60000);
+
+    // 记录一个值（毫秒时间戳），时间戳早于当前槽时计入当前槽
+    void observe(int64_t now_ms, uint64_t value);
+
+    // now_ms 所在窗口内的统计
+    HistogramSummary summary(int64_t now_ms) const;
+
+    int64_t windowMs() const { return m_slot_ms * static_cast<int64_t>(kSlots); }
+
+private:
+    struct Slot {
+        int64_t epoch = -1;  // now_ms / slot_ms，-1 表示空槽
+        std::array<uint32_t, kBuckets> buckets{};
+        uint32_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+    };
+
+    static size_t bucketOf(uint64_t value);
+
+    int64_t m_slot_ms;
+    int64_t m_last_epoch = -1;
+    std::array<Slot, kSlots> m_slots;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// 窗口聚合函数
+enum class WindowFunc {
+    AVG,
+    MIN,
+    MAX,
+    SUM,
+    RATE,   // 每秒增长率，计数器回绕（值变小）时按 Prometheus rate 的方式把新值计为增量
+    COUNT
+};
+
+/**
+ * @brief 单条序列的滑动时间窗口聚合
+ *
+ * 告警规则引擎在写入路径上为窗口条件的每条序列维护一个实例。add() 追加样本并淘汰窗口外的样本，
+ * avg/sum/count/rate 维护增量的和，min/max 维护单调队列，追加和淘汰均摊 O(1)，value() 为 O(1)，
+ * 不需要重新扫描窗口内的原始数据。
+ */
+class SlidingWindow {
+public:
+    SlidingWindow(WindowFunc func, int64_t window_ms);
+
+    // 追加样本（毫秒时间戳），时间戳早于上一个样本时按上一个样本的时间处理
+    void add(int64_t timestamp_ms, double value);
+
+    // 淘汰 timestamp_ms - window 之前的样本
+    void evict(int64_t timestamp_ms);
+
+    // 当前窗口的聚合值；窗口为空（rate 需要至少两个样本）时返回false
+    bool value(double& result) const;
+
+    bool empty() const;
+    int64_t lastTimestamp() const { return m_last_timestamp; }
+    WindowFunc func() const { return m_func; }
+    int64_t windowMs() const { return m_window_ms; }
+
+    // 解析函数名 avg / min / max / sum / rate / count
+    static bool parseFunc(const std::string& name, WindowFunc& func);
+
+private:
+    struct Point {
+        int64_t timestamp;
+        double value;
+        double increase;  // 相对上一个样本的增量（仅 rate 使用）
+    };
+
+    bool usesExtremes() const { return m_func == WindowFunc::MIN || m_func == WindowFunc::MAX; }
+
+    WindowFunc m_func;
+    int64_t m_window_ms;
+    int64_t m_last_timestamp = 0;
+    std::deque<Point> m_points;    // avg/sum/count/rate：窗口内全部样本
+    std::deque<Point> m_extremes;  // min/max：单调队列，队首为窗口内的极值
+    double m_sum = 0.0;            // avg/sum：窗口内样本值之和
+    double m_increase = 0.0;       // rate：窗口内除首个样本外的增量之和
+};
@@ -12,6 +12,7 @@
 #include <map>
 #include <functional>
 #include <taos.h>
+#include "query_deadline.h"
 
 //=============================================================================
 // TDengine连接池配置结构
@@ -303,4 +304,21 @@ public:
 
 private:
     TAOS_RES* result_;
-};
\ No newline at end of file
+};
+
+//=============================================================================
+// 带截止时间的查询辅助函数
+//=============================================================================
+
+/**
+ * @brief 按当前线程的查询截止时间 (QueryDeadlineScope) 执行查询
+ * 截止时间到达时由看门狗调用 taos_kill_query 中止正在执行的查询，并抛出 QueryDeadlineExceeded；
+ * 其它错误与 taos_query 一致，由调用方通过 taos_errno 检查
+ */
+TAOS_RES* taosQueryWithDeadline(TAOS* taos, const std::string& sql);
+
+/**
+ * @brief 读取结果集时检查截止时间，超时调用 taos_stop_query 并标记当前请求超时
+ * @return true 表示已超时，调用方应释放结果集并停止读取
+ */
+bool taosStopIfDeadlineExceeded(TAOS_RES* res);
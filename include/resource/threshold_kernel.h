@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 阈值比较操作符
+enum class ThresholdOp { GT, LT, GE, LE, EQ, NE };
+
+/**
+ * @brief 列式阈值比较
+ *
+ * 对一列连续的 double 与同一阈值做比较，结果写成位图（第 i 位对应第 i 个值），多个条件依次按位与。
+ * x86 上按CPU能力选择 AVX2 或 SSE2 实现，其他平台使用标量实现；各实现结果一致，
+ * 值或阈值为 NaN（缺失值）时不满足任何条件，包括 !=。
+ */
+namespace threshold_kernel {
+
+// count 个值需要的位图字数
+inline size_t maskWords(size_t count) {
+    return (count + 63) / 64;
+}
+
+// count 个值全部置位的位图
+std::vector<uint64_t> fullMask(size_t count);
+
+// mask &= (values[i] op threshold)
+void compareAnd(const double* values, size_t count, ThresholdOp op, double threshold, uint64_t* mask);
+
+// 当前使用的实现："avx2" / "sse2" / "scalar"
+const char* implementation();
+
+// 指定使用的实现（测试各实现的一致性用）；名称为空时恢复按CPU能力选择，
+// 本平台或CPU不支持该实现时返回false且不改变当前选择
+bool setImplementation(const char* name);
+
+// 依次以置位的下标调用 f
+template <typename F>
+void forEachSetBit(const uint64_t* mask, size_t count, F&& f) {
+    size_t words = maskWords(count);
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t bits = mask[w];
+        while (bits != 0) {
+            f(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+            bits &= bits - 1;
+        }
+    }
+}
+
+}  // namespace threshold_kernel
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 分层时间轮
+ *
+ * 每层 slots 个槽，第 k 层一个槽覆盖 slots^k 个刻度；到期时间较远的定时器放在高层，
+ * 所在槽轮到时再下放到低层。schedule / cancel 为 O(1)，advance 的开销与经过的刻度数和
+ * 到期（或下放）的定时器数成正比，与定时器总数无关。超出最高层范围的定时器先放在最高层，
+ * 轮到时按真实到期时间重新放置。
+ *
+ * 取消只删除登记项，槽中残留的ID在该槽轮到时丢弃。非线程安全，由调用方加锁。
+ */
+template <typename T>
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(100),
+                        size_t slots = 64, size_t levels = 4)
+        : m_tick(tick.count() > 0 ? tick : std::chrono::milliseconds(1)),
+          m_slots(slots > 1 ? slots : 2),
+          m_start(Clock::now()),
+          m_wheels(levels > 0 ? levels : 1, std::vector<std::vector<uint64_t>>(m_slots)) {
+        uint64_t span = 1;
+        for (size_t level = 0; level < m_wheels.size(); ++level) {
+            m_level_spans.push_back(span);
+            span *= m_slots;
+        }
+        m_total_span = span;
+    }
+
+    // 登记定时器，返回非0的定时器ID；已过期的定时器在下一个刻度到期
+    uint64_t schedule(Clock::time_point deadline, T payload) {
+        uint64_t id = m_next_id++;
+        uint64_t deadline_tick = tickOf(deadline);
+        if (deadline_tick <= m_current_tick) {
+            deadline_tick = m_current_tick + 1;
+        }
+        m_entries.emplace(id, Entry{deadline_tick, std::move(payload)});
+        place(id, deadline_tick);
+        return id;
+    }
+
+    // 取消定时器；已到期或不存在返回false
+    bool cancel(uint64_t id) {
+        return m_entries.erase(id) > 0;
+    }
+
+    // 推进到 now，到期的定时器按 (ID, 负载) 追加到 expired
+    void advance(Clock::time_point now, std::vector<std::pair<uint64_t, T>>& expired) {
+        uint64_t target = now > m_start ? static_cast<uint64_t>((now - m_start) / m_tick) : 0;
+
+        while (m_current_tick < target) {
+            if (m_entries.empty()) {
+                m_current_tick = target;
+                break;
+            }
+
+            uint64_t tick = ++m_current_tick;
+
+            // 先把轮到的高层槽下放，再处理第0层当前槽
+            for (size_t level = m_wheels.size() - 1; level > 0; --level) {
+                if (tick % m_level_spans[level] != 0) {
+                    continue;
+                }
+                std::vector<uint64_t> bucket;
+                bucket.swap(m_wheels[level][(tick / m_level_spans[level]) % m_slots]);
+                for (uint64_t id : bucket) {
+                    auto it = m_entries.find(id);
+                    if (it != m_entries.end()) {
+                        place(id, it->second.deadline_tick);
+                    }
+                }
+            }
+
+            std::vector<uint64_t> bucket;
+            bucket.swap(m_wheels[0][tick % m_slots]);
+            for (uint64_t id : bucket) {
+                auto it = m_entries.find(id);
+                if (it == m_entries.end()) {
+                    continue;
+                }
+                if (it->second.deadline_tick <= tick) {
+                    expired.emplace_back(id, std::move(it->second.payload));
+                    m_entries.erase(it);
+                } else {
+                    place(id, it->second.deadline_tick);
+                }
+            }
+        }
+    }
+
+    // 未到期的定时器数
+    size_t size() const { return m_entries.size(); }
+
+    std::chrono::milliseconds tick() const { return std::chrono::duration_cast<std::chrono::milliseconds>(m_tick); }
+
+private:
+    struct Entry {
+        uint64_t deadline_tick;
+        T payload;
+    };
+
+    uint64_t tickOf(Clock::time_point deadline) const {
+        if (deadline <= m_start) {
+            return 0;
+        }
+        auto elapsed = deadline - m_start;
+        uint64_t ticks = static_cast<uint64_t>(elapsed / m_tick);
+        // 向上取整，保证不早于到期时间触发
+        if (elapsed % m_tick != Clock::duration::zero()) {
+            ++ticks;
+        }
+        return ticks;
+    }
+
+    // deadline_tick 不早于当前刻度
+    void place(uint64_t id, uint64_t deadline_tick) {
+        uint64_t delta = deadline_tick - m_current_tick;
+        size_t top = m_wheels.size() - 1;
+
+        for (size_t level = 0; level < top; ++level) {
+            if (delta < m_level_spans[level + 1]) {
+                m_wheels[level][(deadline_tick / m_level_spans[level]) % m_slots].push_back(id);
+                return;
+            }
+        }
+
+        // 超出范围时按最高层能表示的最远刻度放置，轮到时重新放置
+        if (delta >= m_total_span) {
+            deadline_tick = m_current_tick + m_total_span - 1;
+        }
+        m_wheels[top][(deadline_tick / m_level_spans[top]) % m_slots].push_back(id);
+    }
+
+    Clock::duration m_tick;
+    size_t m_slots;
+    Clock::time_point m_start;
+    std::vector<std::vector<std::vector<uint64_t>>> m_wheels;  // [层][槽] -> 定时器ID
+    std::vector<uint64_t> m_level_spans;                      // 第 k 层一个槽覆盖的刻度数
+    uint64_t m_total_span = 0;
+    uint64_t m_current_tick = 0;
+    uint64_t m_next_id = 1;
+    std::unordered_map<uint64_t, Entry> m_entries;
+};
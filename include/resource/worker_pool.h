@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 固定大小的工作线程池
+ *
+ * 告警规则引擎用于并行执行每个评估周期的查询和状态协调，
+ * runAll() 提交一批任务并阻塞到全部完成。
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t thread_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 提交单个任务
+    void submit(std::function<void()> task);
+
+    // 提交一批任务并等待全部完成，任务抛出的异常由任务自身处理
+    void runAll(std::vector<std::function<void()>> tasks);
+
+    size_t size() const { return m_threads.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
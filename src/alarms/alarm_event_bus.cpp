@@ -0,0 +1,195 @@
+#include "alarm_event_bus.h"
+#include "log_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+
+AlarmEventBus::AlarmEventBus(size_t capacity, size_t max_batch, std::chrono::milliseconds max_full_wait)
+    : m_slots([capacity]() {
+          size_t size = 2;
+          while (size < capacity) {
+              size <<= 1;
+          }
+          return size;
+      }()),
+      m_mask(m_slots.size() - 1),
+      m_max_batch(std::max<size_t>(1, max_batch)),
+      m_max_full_wait(std::max(std::chrono::milliseconds(0), max_full_wait)) {
+}
+
+AlarmEventBus::~AlarmEventBus() {
+    stop();
+}
+
+bool AlarmEventBus::addConsumer(const std::string& name, BatchHandler handler) {
+    if (m_running.load() || !handler) {
+        return false;
+    }
+    std::unique_ptr<Consumer> consumer(new Consumer());
+    consumer->name = name;
+    consumer->handler = std::move(handler);
+    consumer->cursor.store(m_claim.load());
+    m_consumers.push_back(std::move(consumer));
+    return true;
+}
+
+void AlarmEventBus::start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_stopping.store(false);
+    for (auto& consumer : m_consumers) {
+        Consumer* c = consumer.get();
+        c->thread = std::thread([this, c]() { consumerLoop(*c); });
+    }
+    LogManager::getLogger()->info("AlarmEventBus: started with {} consumers, capacity {}",
+                                  m_consumers.size(), m_slots.size());
+}
+
+void AlarmEventBus::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+    }
+    m_wait_cv.notify_all();
+    for (auto& consumer : m_consumers) {
+        if (consumer->thread.joinable()) {
+            consumer->thread.join();
+        }
+    }
+    LogManager::getLogger()->info("AlarmEventBus: stopped after {} events", m_claim.load());
+}
+
+bool AlarmEventBus::publish(const AlarmEvent& event) {
+    if (!m_running.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    uint64_t capacity = m_slots.size();
+    uint64_t sequence = m_claim.load(std::memory_order_relaxed);
+    bool waited = false;
+    std::chrono::steady_clock::time_point wait_deadline;
+    while (true) {
+        // 序号 sequence 对应的槽位上一次被 sequence - capacity 使用，所有消费者读过之后才能复用
+        if (sequence - minCursor() >= capacity) {
+            if (!waited) {
+                waited = true;
+                m_full_waits.fetch_add(1, std::memory_order_relaxed);
+                wait_deadline = std::chrono::steady_clock::now() + m_max_full_wait;
+            }
+            bool bounded = m_max_full_wait.count() > 0;
+            if (bounded && (m_overflowing.load(std::memory_order_relaxed) ||
+                            std::chrono::steady_clock::now() >= wait_deadline)) {
+                m_overflowing.store(true, std::memory_order_relaxed);
+                uint64_t dropped = m_dropped.fetch_add(1, std::memory_order_relaxed) + 1;
+                // 按2的幂次记录日志，避免消费者长时间阻塞时刷屏
+                if ((dropped & (dropped - 1)) == 0) {
+                    LogManager::getLogger()->warn("AlarmEventBus: buffer full for {} ms, dropped {} events so far",
+                                                  m_max_full_wait.count(), dropped);
+                }
+                return false;
+            }
+            std::this_thread::yield();
+            sequence = m_claim.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (m_claim.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (m_overflowing.load(std::memory_order_relaxed)) {
+        m_overflowing.store(false, std::memory_order_relaxed);
+    }
+
+    Slot& slot = m_slots[sequence & m_mask];
+    slot.event = event;
+    slot.sequence.store(sequence + 1, std::memory_order_release);
+
+    if (m_waiters.load(std::memory_order_acquire) > 0) {
+        m_wait_cv.notify_all();
+    }
+    return true;
+}
+
+std::vector<AlarmEventConsumerStats> AlarmEventBus::getConsumerStats() const {
+    std::vector<AlarmEventConsumerStats> stats;
+    uint64_t claimed = m_claim.load(std::memory_order_acquire);
+    for (const auto& consumer : m_consumers) {
+        AlarmEventConsumerStats s;
+        s.name = consumer->name;
+        s.delivered = consumer->delivered.load(std::memory_order_relaxed);
+        s.batches = consumer->batches.load(std::memory_order_relaxed);
+        uint64_t cursor = consumer->cursor.load(std::memory_order_acquire);
+        s.lag = claimed > cursor ? claimed - cursor : 0;
+        s.max_lag = consumer->max_lag.load(std::memory_order_relaxed);
+        s.last_batch_us = consumer->last_batch_us.load(std::memory_order_relaxed);
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+uint64_t AlarmEventBus::minCursor() const {
+    uint64_t min_cursor = std::numeric_limits<uint64_t>::max();
+    for (const auto& consumer : m_consumers) {
+        min_cursor = std::min(min_cursor, consumer->cursor.load(std::memory_order_acquire));
+    }
+    return m_consumers.empty() ? m_claim.load(std::memory_order_acquire) : min_cursor;
+}
+
+void AlarmEventBus::consumerLoop(Consumer& consumer) {
+    std::vector<AlarmEvent> batch;
+    batch.reserve(m_max_batch);
+
+    while (true) {
+        uint64_t cursor = consumer.cursor.load(std::memory_order_relaxed);
+        uint64_t next = cursor;
+        while (batch.size() < m_max_batch) {
+            const Slot& slot = m_slots[next & m_mask];
+            if (slot.sequence.load(std::memory_order_acquire) != next + 1) {
+                break;
+            }
+            batch.push_back(slot.event);
+            ++next;
+        }
+
+        if (batch.empty()) {
+            // 停止时已领取的序号都投递完才退出，避免丢弃正在写入的事件
+            if (m_stopping.load(std::memory_order_acquire) &&
+                m_claim.load(std::memory_order_acquire) == cursor) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            m_waiters.fetch_add(1, std::memory_order_acq_rel);
+            m_wait_cv.wait_for(lock, std::chrono::milliseconds(10));
+            m_waiters.fetch_sub(1, std::memory_order_acq_rel);
+            continue;
+        }
+
+        // 先推进游标释放槽位，再在缓冲区之外处理本批事件
+        uint64_t lag = m_claim.load(std::memory_order_acquire) - cursor;
+        if (lag > consumer.max_lag.load(std::memory_order_relaxed)) {
+            consumer.max_lag.store(lag, std::memory_order_relaxed);
+        }
+        consumer.cursor.store(next, std::memory_order_release);
+
+        auto begin = std::chrono::steady_clock::now();
+        try {
+            consumer.handler(batch);
+        } catch (const std::exception& e) {
+            LogManager::getLogger()->error("AlarmEventBus: consumer '{}' failed: {}", consumer.name, e.what());
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin);
+
+        consumer.delivered.fetch_add(batch.size(), std::memory_order_relaxed);
+        consumer.batches.fetch_add(1, std::memory_order_relaxed);
+        consumer.last_batch_us.store(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        batch.clear();
+    }
+}
@@ -0,0 +1,442 @@
+#include "alarm_inhibitor.h"
+#include "alarm_manager.h"
+#include "node_storage.h"
+#include "log_manager.h"
+#include "utils.h"
+
+#include <algorithm>
+
+namespace {
+
+const char* const kChassisUnreachable = "ChassisUnreachable";
+const char* const kBoardAbsent = "BoardAbsent";
+// calculateHostIP 只为1-12号槽位分配地址
+const int kMaxHostSlot = 12;
+const int kMaxBoards = 14;
+
+}  // namespace
+
+AlarmInhibitor::AlarmInhibitor(std::shared_ptr<NodeStorage> node_storage, std::shared_ptr<AlarmManager> alarm_manager,
+                               Publisher publisher)
+    : m_node_storage(std::move(node_storage)), m_alarm_manager(std::move(alarm_manager)),
+      m_publisher(std::move(publisher)) {
+}
+
+AlarmInhibitor::~AlarmInhibitor() {
+    stop();
+}
+
+void AlarmInhibitor::setReleaseDelay(std::chrono::seconds delay) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_release_delay = std::max(std::chrono::milliseconds(0), std::chrono::milliseconds(delay));
+}
+
+void AlarmInhibitor::start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_thread = std::thread(&AlarmInhibitor::run, this);
+    LogManager::getLogger()->info("AlarmInhibitor started.");
+}
+
+void AlarmInhibitor::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+    }
+    m_wait_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    LogManager::getLogger()->info("AlarmInhibitor stopped.");
+}
+
+bool AlarmInhibitor::admit(const AlarmEvent& event) {
+    if (event.fingerprint.empty()) {
+        return true;
+    }
+
+    std::vector<AlarmEvent> out;
+    bool admitted = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (event.status == "resolved") {
+            auto it = m_inhibited.find(event.fingerprint);
+            if (it != m_inhibited.end()) {
+                auto root = m_roots.find(it->second.root);
+                if (root != m_roots.end()) {
+                    root->second.dependents.erase(event.fingerprint);
+                }
+                m_inhibited.erase(it);
+                ++m_resolved_absorbed;
+                admitted = false;
+            }
+        } else {
+            auto host = event.labels.find("host_ip");
+            const HostLocation* location = host != event.labels.end() ? locate(host->second) : nullptr;
+            Root* root = location ? findRoot(host->second, *location, steadyNowMs(), out) : nullptr;
+            if (root) {
+                auto previous = m_inhibited.find(event.fingerprint);
+                if (previous != m_inhibited.end() && previous->second.root != root->info.fingerprint) {
+                    auto old_root = m_roots.find(previous->second.root);
+                    if (old_root != m_roots.end()) {
+                        old_root->second.dependents.erase(event.fingerprint);
+                    }
+                }
+                Inhibited& inhibited = m_inhibited[event.fingerprint];
+                inhibited.root = root->info.fingerprint;
+                inhibited.event = event;
+                root->dependents.insert(event.fingerprint);
+                ++m_events_inhibited;
+                admitted = false;
+                LogManager::getLogger()->debug("AlarmInhibitor: {} inhibited by {}", event.fingerprint,
+                                               root->info.fingerprint);
+            } else {
+                // 根因已恢复、尚未补发时再次 firing：事件照常发布，不再补发吸收的旧事件
+                auto stale = m_inhibited.find(event.fingerprint);
+                if (stale != m_inhibited.end()) {
+                    auto old_root = m_roots.find(stale->second.root);
+                    if (old_root != m_roots.end()) {
+                        old_root->second.dependents.erase(event.fingerprint);
+                    }
+                    m_inhibited.erase(stale);
+                }
+            }
+        }
+    }
+    publishAll(out);
+    return admitted;
+}
+
+void AlarmInhibitor::observeBmc(const UdpInfo& info) {
+    int box_id = static_cast<int>(info.boxid);
+    int64_t now_ms = steadyNowMs();
+
+    uint32_t present = 0;
+    for (int board_index = 0; board_index < kMaxBoards; ++board_index) {
+        if (info.board[board_index].moduletype != 0) {
+            present |= 1u << (board_index + 1);
+        }
+    }
+
+    std::vector<AlarmEvent> out;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Box& box = m_boxes[box_id];
+        uint32_t previous = box.present_slots;
+        box.last_bmc_ms = now_ms;
+        box.present_slots = present;
+
+        // 机箱重新上报，机箱级根因恢复
+        auto chassis = m_chassis_roots.find(box_id);
+        if (chassis != m_chassis_roots.end()) {
+            clearRoot(chassis->second, now_ms, out);
+        }
+
+        for (int slot_id = 1; slot_id <= kMaxHostSlot; ++slot_id) {
+            uint32_t bit = 1u << slot_id;
+            bool was_present = (previous & bit) != 0;
+            bool is_present = (present & bit) != 0;
+            if (!was_present && !is_present) {
+                continue;
+            }
+            std::string host_ip = Utils::calculateHostIP(box_id, slot_id);
+            if (is_present) {
+                indexHost(host_ip, box_id, slot_id);
+                auto board = m_board_roots.find(host_ip);
+                if (board != m_board_roots.end()) {
+                    clearRoot(board->second, now_ms, out);
+                }
+            } else {
+                raiseRoot(kBoardAbsent, box_id, slot_id, host_ip,
+                          "机箱 " + std::to_string(box_id) + " 槽位 " + std::to_string(slot_id) + " 的板卡（" +
+                              host_ip + "）不在位，该节点的告警已合并到本告警。",
+                          out);
+            }
+        }
+    }
+    publishAll(out);
+}
+
+AlarmInhibitionStats AlarmInhibitor::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AlarmInhibitionStats stats;
+    stats.roots_raised = m_roots_raised;
+    stats.events_inhibited = m_events_inhibited;
+    stats.resolved_absorbed = m_resolved_absorbed;
+    stats.events_released = m_events_released;
+    for (const auto& entry : m_roots) {
+        if (entry.second.cleared_ms == 0) {
+            ++stats.active_roots;
+        }
+    }
+    stats.inhibited_alarms = m_inhibited.size();
+    return stats;
+}
+
+std::vector<AlarmInhibitionRoot> AlarmInhibitor::getActiveRoots() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<AlarmInhibitionRoot> roots;
+    for (const auto& entry : m_roots) {
+        if (entry.second.cleared_ms != 0) {
+            continue;
+        }
+        AlarmInhibitionRoot root = entry.second.info;
+        root.dependents = entry.second.dependents.size();
+        roots.push_back(root);
+    }
+    return roots;
+}
+
+void AlarmInhibitor::run() {
+    while (m_running) {
+        // 同步 NodeStorage 中的节点位置（由节点上报的 box_id/slot_id，不依赖BMC）
+        std::vector<std::shared_ptr<const NodeData>> nodes;
+        if (m_node_storage) {
+            nodes = m_node_storage->getAllNodesReadonly();
+        }
+
+        std::vector<AlarmEvent> out;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& node : nodes) {
+                indexHost(node->host_ip, node->box_id, node->slot_id);
+            }
+            tick(steadyNowMs(), out);
+        }
+        publishAll(out);
+
+        auto interval_ms = m_node_storage ? m_node_storage->getMonitorCheckIntervalMs() : 1000;
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wait_cv.wait_for(lock, std::chrono::milliseconds(std::max<int64_t>(100, interval_ms)),
+                           [this]() { return !m_running.load(); });
+    }
+}
+
+void AlarmInhibitor::tick(int64_t now_ms, std::vector<AlarmEvent>& out) {
+    // 节点只恢复了心跳（BMC仍未上报）时机箱级根因同样恢复
+    std::vector<std::string> recovered;
+    for (const auto& entry : m_chassis_roots) {
+        auto box = m_boxes.find(entry.first);
+        if (box == m_boxes.end() || !chassisUnreachable(box->second, now_ms)) {
+            recovered.push_back(entry.second);
+        }
+    }
+    for (const auto& fingerprint : recovered) {
+        clearRoot(fingerprint, now_ms, out);
+    }
+
+    // 恢复超过 release_delay 的根因：仍未恢复的告警补发 firing
+    std::vector<std::string> expired;
+    for (const auto& entry : m_roots) {
+        if (entry.second.cleared_ms != 0 && now_ms - entry.second.cleared_ms >= m_release_delay.count()) {
+            expired.push_back(entry.first);
+        }
+    }
+    for (const auto& fingerprint : expired) {
+        auto it = m_roots.find(fingerprint);
+        const Root& root = it->second;
+        for (const auto& dependent : root.dependents) {
+            auto inhibited = m_inhibited.find(dependent);
+            if (inhibited == m_inhibited.end()) {
+                continue;
+            }
+            out.push_back(inhibited->second.event);
+            m_inhibited.erase(inhibited);
+            ++m_events_released;
+        }
+        if (!root.dependents.empty()) {
+            LogManager::getLogger()->info("AlarmInhibitor: released {} alarms still firing after {} recovered",
+                                          root.dependents.size(), fingerprint);
+        }
+        if (root.info.alert_name == kChassisUnreachable) {
+            m_chassis_roots.erase(root.info.box_id);
+        } else {
+            auto board = m_board_roots.find(root.event.labels.at("host_ip"));
+            if (board != m_board_roots.end() && board->second == fingerprint) {
+                m_board_roots.erase(board);
+            }
+        }
+        m_roots.erase(it);
+    }
+}
+
+const AlarmInhibitor::HostLocation* AlarmInhibitor::locate(const std::string& host_ip) {
+    auto it = m_hosts.find(host_ip);
+    if (it != m_hosts.end()) {
+        return &it->second;
+    }
+    if (!m_node_storage) {
+        return nullptr;
+    }
+    auto node = m_node_storage->getNodeDataReadonly(host_ip);
+    if (!node) {
+        return nullptr;
+    }
+    indexHost(host_ip, node->box_id, node->slot_id);
+    return &m_hosts[host_ip];
+}
+
+void AlarmInhibitor::indexHost(const std::string& host_ip, int box_id, int slot_id) {
+    if (host_ip.empty()) {
+        return;
+    }
+    auto it = m_hosts.find(host_ip);
+    if (it != m_hosts.end()) {
+        if (it->second.box_id == box_id && it->second.slot_id == slot_id) {
+            return;
+        }
+        auto old_box = m_boxes.find(it->second.box_id);
+        if (old_box != m_boxes.end()) {
+            old_box->second.hosts.erase(host_ip);
+        }
+    }
+    HostLocation& location = m_hosts[host_ip];
+    location.box_id = box_id;
+    location.slot_id = slot_id;
+    m_boxes[box_id].hosts.insert(host_ip);
+}
+
+int64_t AlarmInhibitor::lostAfterMs() const {
+    if (!m_node_storage) {
+        return 8000;
+    }
+    return std::max<int64_t>(0, m_node_storage->getActiveTimeoutMs() - 2 * m_node_storage->getMonitorCheckIntervalMs());
+}
+
+bool AlarmInhibitor::hostLost(const std::string& host_ip, int64_t now_ms) const {
+    auto node = m_node_storage ? m_node_storage->getNodeDataReadonly(host_ip) : nullptr;
+    return !node || now_ms - node->last_heartbeat > lostAfterMs();
+}
+
+bool AlarmInhibitor::chassisUnreachable(const Box& box, int64_t now_ms) const {
+    // 从未收到过该机箱的BMC组播时无法区分整箱故障和单板故障
+    if (box.last_bmc_ms == 0 || now_ms - box.last_bmc_ms <= lostAfterMs() || box.hosts.empty()) {
+        return false;
+    }
+    for (const auto& host_ip : box.hosts) {
+        if (!hostLost(host_ip, now_ms)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AlarmInhibitor::Root* AlarmInhibitor::activeRoot(const std::string& fingerprint) {
+    auto it = m_roots.find(fingerprint);
+    return it != m_roots.end() && it->second.cleared_ms == 0 ? &it->second : nullptr;
+}
+
+AlarmInhibitor::Root* AlarmInhibitor::findRoot(const std::string& host_ip, const HostLocation& location,
+                                               int64_t now_ms, std::vector<AlarmEvent>& out) {
+    auto chassis = m_chassis_roots.find(location.box_id);
+    if (chassis != m_chassis_roots.end()) {
+        if (Root* root = activeRoot(chassis->second)) {
+            return root;
+        }
+    }
+    auto board = m_board_roots.find(host_ip);
+    if (board != m_board_roots.end()) {
+        if (Root* root = activeRoot(board->second)) {
+            return root;
+        }
+    }
+
+    // 机箱级根因在第一个依赖告警到达时判定
+    auto box = m_boxes.find(location.box_id);
+    if (box == m_boxes.end() || !chassisUnreachable(box->second, now_ms)) {
+        return nullptr;
+    }
+    raiseRoot(kChassisUnreachable, location.box_id, 0, "",
+              "机箱 " + std::to_string(location.box_id) + " 的BMC组播和全部 " +
+                  std::to_string(box->second.hosts.size()) + " 个节点的心跳均已中断，机箱内节点、组件和资源告警已合并到本告警。",
+              out);
+    return activeRoot(chassisFingerprint(location.box_id));
+}
+
+void AlarmInhibitor::raiseRoot(const std::string& alert_name, int box_id, int slot_id, const std::string& host_ip,
+                               const std::string& description, std::vector<AlarmEvent>& out) {
+    bool chassis = alert_name == kChassisUnreachable;
+    std::string fingerprint = chassis ? chassisFingerprint(box_id) : boardFingerprint(box_id, slot_id);
+    Root& root = m_roots[fingerprint];
+    if (!root.info.fingerprint.empty() && root.cleared_ms == 0) {
+        return;
+    }
+
+    // 新根因，或恢复后尚未补发依赖告警时再次出现（保留已吸收的告警）
+    root.cleared_ms = 0;
+    root.info.fingerprint = fingerprint;
+    root.info.alert_name = alert_name;
+    root.info.box_id = box_id;
+    root.info.slot_id = slot_id;
+    root.info.starts_at = std::chrono::system_clock::now();
+
+    AlarmEvent& event = root.event;
+    event.fingerprint = fingerprint;
+    event.status = "firing";
+    event.starts_at = root.info.starts_at;
+    event.labels = {
+        {"alert_name", alert_name},
+        {"box_id", std::to_string(box_id)},
+        {"severity", "严重"},
+        {"alert_type", "硬件资源"}
+    };
+    if (chassis) {
+        event.annotations = {{"summary", "机箱失联"}, {"description", description}};
+        m_chassis_roots[box_id] = fingerprint;
+    } else {
+        event.labels["slot_id"] = std::to_string(slot_id);
+        event.labels["host_ip"] = host_ip;
+        event.annotations = {{"summary", "板卡不在位"}, {"description", description}};
+        m_board_roots[host_ip] = fingerprint;
+    }
+
+    ++m_roots_raised;
+    out.push_back(event);
+    LogManager::getLogger()->warn("AlarmInhibitor: root cause {} raised", fingerprint);
+}
+
+void AlarmInhibitor::clearRoot(const std::string& fingerprint, int64_t now_ms, std::vector<AlarmEvent>& out) {
+    Root* root = activeRoot(fingerprint);
+    if (!root) {
+        return;
+    }
+    root->cleared_ms = now_ms;
+
+    AlarmEvent event;
+    event.fingerprint = fingerprint;
+    event.status = "resolved";
+    event.labels = root->event.labels;
+    event.starts_at = root->event.starts_at;
+    event.ends_at = std::chrono::system_clock::now();
+    out.push_back(event);
+    LogManager::getLogger()->info("AlarmInhibitor: root cause {} recovered, {} alarms still inhibited", fingerprint,
+                                  root->dependents.size());
+}
+
+std::string AlarmInhibitor::chassisFingerprint(int box_id) const {
+    return m_alarm_manager->calculateFingerprint(kChassisUnreachable, {{"box_id", std::to_string(box_id)}});
+}
+
+std::string AlarmInhibitor::boardFingerprint(int box_id, int slot_id) const {
+    return m_alarm_manager->calculateFingerprint(kBoardAbsent, {
+        {"box_id", std::to_string(box_id)},
+        {"slot_id", std::to_string(slot_id)}
+    });
+}
+
+void AlarmInhibitor::publishAll(const std::vector<AlarmEvent>& events) {
+    if (!m_publisher) {
+        return;
+    }
+    for (const auto& event : events) {
+        m_publisher(event);
+    }
+}
+
+int64_t AlarmInhibitor::steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -1,6 +1,7 @@
 #include "../../include/resource/alarm_manager.h"
 #include "../../include/resource/alarm_rule_engine.h"
 #include "../../include/resource/log_manager.h"
+#include "../../include/resource/query_deadline.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -18,6 +19,39 @@
 #define CR_SERVER_LOST 2013
 #endif
 
+namespace {
+    // 因截止时间耗尽而拿不到连接时同样视为请求超时
+    void markIfDeadlineExpired() {
+        if (QueryDeadlineScope::current().expired()) {
+            QueryDeadlineScope::markExceeded();
+        }
+    }
+
+    // 按当前请求的截止时间执行预处理语句，到期时通过连接池的专用连接 KILL QUERY 中止
+    bool executeStatementWithDeadline(const std::shared_ptr<MySQLConnectionPool>& pool, MYSQL* mysql, MYSQL_STMT* stmt) {
+        if (QueryDeadlineScope::current().expired()) {
+            QueryDeadlineScope::markExceeded();
+            return false;
+        }
+
+        // KILL QUERY 需要通过另一条连接发送；超时往往发生在连接池耗尽时，因此不从连接池获取
+        unsigned long thread_id = mysql_thread_id(mysql);
+        QueryWatchdog::Guard watchdog([pool, thread_id]() {
+            if (!pool->killQuery(thread_id)) {
+                LogManager::getLogger()->error("AlarmManager: failed to kill query on thread {}", thread_id);
+            }
+        });
+
+        bool ok = mysql_stmt_execute(stmt) == 0;
+        if (watchdog.release()) {
+            QueryDeadlineScope::markExceeded();
+            LogManager::getLogger()->warn("AlarmManager: query deadline exceeded, statement killed on thread {}", thread_id);
+            return false;
+        }
+        return ok;
+    }
+}
+
 // 连接池注入构造函数 - 推荐使用
 AlarmManager::AlarmManager(std::shared_ptr<MySQLConnectionPool> connection_pool)
     : m_connection_pool(connection_pool), m_initialized(false) {
@@ -139,6 +173,58 @@ bool AlarmManager::processAlarmEvent(const AlarmEvent& event) {
     }
 }
 
+/*
+ * 批量处理告警事件
+ * 
+ * 一批事件共用一个连接并在同一事务中按顺序写入，减少连接获取和提交次数；
+ * 单个事件失败不影响同批其他事件。返回成功处理的事件数。
+ */
+size_t AlarmManager::processAlarmEvents(const std::vector<AlarmEvent>& events) {
+    if (events.empty()) {
+        return 0;
+    }
+    if (!m_initialized) {
+        logError("AlarmManager not initialized");
+        return 0;
+    }
+    MySQLConnectionGuard guard(m_connection_pool);
+    if (!guard.isValid()) {
+        logError("Failed to get database connection from pool");
+        return 0;
+    }
+    MYSQL* mysql = guard->get();
+
+    if (mysql_query(mysql, "START TRANSACTION") != 0) {
+        logQueryError("START TRANSACTION", mysql_error(mysql));
+        return 0;
+    }
+
+    size_t processed = 0;
+    for (const auto& event : events) {
+        if (!validateAlarmEvent(event)) {
+            continue;
+        }
+        bool ok = false;
+        if (event.status == "firing") {
+            ok = insertAlarmEvent(mysql, event);
+        } else {
+            ok = updateAlarmEventToResolved(mysql, event.fingerprint);
+        }
+        if (ok) {
+            ++processed;
+        }
+    }
+
+    if (mysql_query(mysql, "COMMIT") != 0) {
+        logQueryError("COMMIT", mysql_error(mysql));
+        mysql_query(mysql, "ROLLBACK");
+        return 0;
+    }
+
+    logDebug("Processed " + std::to_string(processed) + "/" + std::to_string(events.size()) + " alarm events in one batch");
+    return processed;
+}
+
 bool AlarmManager::insertAlarmEvent(const AlarmEvent& event) {
     if (!m_initialized) {
         logError("AlarmManager not initialized");
@@ -149,7 +235,10 @@ bool AlarmManager::insertAlarmEvent(const AlarmEvent& event) {
         logError("Failed to get database connection from pool");
         return false;
     }
+    return insertAlarmEvent(guard->get(), event);
+}
 
+bool AlarmManager::insertAlarmEvent(MYSQL* mysql, const AlarmEvent& event) {
     std::string id = generateEventId();
     // 原始字符串，无需再转义，交由参数绑定
     std::string fingerprint = event.fingerprint;
@@ -161,7 +250,6 @@ bool AlarmManager::insertAlarmEvent(const AlarmEvent& event) {
     std::string generator_url = event.generator_url;
 
     const char* sql = "INSERT INTO alarm_events (id, fingerprint, status, labels_json, annotations_json, starts_at, generator_url) VALUES (?, ?, ?, ?, ?, NOW(), ?)";
-    MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
     if (!stmt) {
         logError("Failed to init statement for insertAlarmEvent");
@@ -238,8 +326,11 @@ bool AlarmManager::updateAlarmEventToResolved(const std::string& fingerprint, co
         logError("Failed to get database connection from pool");
         return false;
     }
+    return updateAlarmEventToResolved(guard->get(), fingerprint);
+}
+
+bool AlarmManager::updateAlarmEventToResolved(MYSQL* mysql, const std::string& fingerprint) {
     const char* sql = "UPDATE alarm_events SET status = 'resolved', ends_at = NOW() WHERE fingerprint = ? AND status = 'firing'";
-    MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
     if (!stmt) {
         logError("Failed to init statement for updateAlarmEventToResolved");
@@ -338,8 +429,8 @@ bool AlarmManager::alarmEventExists(const std::string& fingerprint) {
 std::vector<AlarmEventRecord> AlarmManager::getActiveAlarmEvents() {
     std::vector<AlarmEventRecord> events;
     if (!m_initialized) return events;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return events;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return events; }
     const char* sql = "SELECT id, fingerprint, status, labels_json, annotations_json, starts_at, ends_at, generator_url, created_at, updated_at FROM alarm_events WHERE status = 'firing' ORDER BY starts_at DESC";
     MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
@@ -348,7 +439,7 @@ std::vector<AlarmEventRecord> AlarmManager::getActiveAlarmEvents() {
         mysql_stmt_close(stmt);
         return events;
     }
-    if (mysql_stmt_execute(stmt) != 0) {
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, stmt)) {
         mysql_stmt_close(stmt);
         return events;
     }
@@ -404,8 +495,8 @@ std::vector<AlarmEventRecord> AlarmManager::getActiveAlarmEvents() {
 std::vector<AlarmEventRecord> AlarmManager::getRecentAlarmEvents(int limit) {
     std::vector<AlarmEventRecord> events;
     if (!m_initialized) return events;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return events;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return events; }
     const char* sql = "SELECT id, fingerprint, status, labels_json, annotations_json, starts_at, ends_at, generator_url, created_at, updated_at FROM alarm_events ORDER BY created_at DESC LIMIT ?";
     MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
@@ -415,7 +506,7 @@ std::vector<AlarmEventRecord> AlarmManager::getRecentAlarmEvents(int limit) {
     unsigned long limit_len = sizeof(limit_val);
     MYSQL_BIND param{}; memset(&param, 0, sizeof(param)); param.buffer_type = MYSQL_TYPE_LONG; param.buffer = &limit_val; param.length = &limit_len;
     if (mysql_stmt_bind_param(stmt, &param) != 0) { mysql_stmt_close(stmt); return events; }
-    if (mysql_stmt_execute(stmt) != 0) { mysql_stmt_close(stmt); return events; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, stmt)) { mysql_stmt_close(stmt); return events; }
     if (mysql_stmt_store_result(stmt) != 0) { mysql_stmt_close(stmt); return events; }
     // 绑定结果同上
     std::vector<char> id_buf(64), fp_buf(600), status_buf(16), labels_buf(65535), ann_buf(65535), starts_at_buf(32), ends_at_buf(32), gen_url_buf(2048), created_buf(32), updated_buf(32);
@@ -458,8 +549,8 @@ std::vector<AlarmEventRecord> AlarmManager::getRecentAlarmEvents(int limit) {
 AlarmEventRecord AlarmManager::getAlarmEventById(const std::string& id) {
     AlarmEventRecord record;
     if (!m_initialized) return record;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return record;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return record; }
     const char* sql = "SELECT id, fingerprint, status, labels_json, annotations_json, starts_at, ends_at, generator_url, created_at, updated_at FROM alarm_events WHERE id = ?";
     MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
@@ -468,7 +559,7 @@ AlarmEventRecord AlarmManager::getAlarmEventById(const std::string& id) {
     std::string id_copy = id; unsigned long id_len = static_cast<unsigned long>(id_copy.size());
     MYSQL_BIND param{}; memset(&param, 0, sizeof(param)); param.buffer_type = MYSQL_TYPE_STRING; param.buffer = const_cast<char*>(id_copy.c_str()); param.length = &id_len; param.buffer_length = id_len;
     if (mysql_stmt_bind_param(stmt, &param) != 0) { mysql_stmt_close(stmt); return record; }
-    if (mysql_stmt_execute(stmt) != 0) { mysql_stmt_close(stmt); return record; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, stmt)) { mysql_stmt_close(stmt); return record; }
     if (mysql_stmt_store_result(stmt) != 0) { mysql_stmt_close(stmt); return record; }
     std::vector<char> id_buf(64), fp_buf(600), status_buf(16), labels_buf(65535), ann_buf(65535), starts_at_buf(32), ends_at_buf(32), gen_url_buf(2048), created_buf(32), updated_buf(32);
     unsigned long id_len2=0, fp_len=0, status_len=0, labels_len=0, ann_len=0, starts_at_len=0, ends_at_len=0, gen_url_len=0, created_len=0, updated_len=0;
@@ -504,14 +595,14 @@ AlarmEventRecord AlarmManager::getAlarmEventById(const std::string& id) {
 
 int AlarmManager::getActiveAlarmCount() {
     if (!m_initialized) return 0;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return 0;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return 0; }
     const char* sql = "SELECT COUNT(*) FROM alarm_events WHERE status = 'firing'";
     MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
     if (!stmt) return 0;
     if (mysql_stmt_prepare(stmt, sql, static_cast<unsigned long>(strlen(sql))) != 0) { mysql_stmt_close(stmt); return 0; }
-    if (mysql_stmt_execute(stmt) != 0) { mysql_stmt_close(stmt); return 0; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, stmt)) { mysql_stmt_close(stmt); return 0; }
     int count = 0; unsigned long len=0; MYSQL_BIND rb{}; memset(&rb, 0, sizeof(rb)); rb.buffer_type = MYSQL_TYPE_LONG; rb.buffer = &count; rb.length = &len;
     if (mysql_stmt_bind_result(stmt, &rb) != 0) { mysql_stmt_close(stmt); return 0; }
     if (mysql_stmt_fetch(stmt) != 0) { mysql_stmt_close(stmt); return 0; }
@@ -521,14 +612,14 @@ int AlarmManager::getActiveAlarmCount() {
 
 int AlarmManager::getTotalAlarmCount() {
     if (!m_initialized) return 0;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return 0;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return 0; }
     const char* sql = "SELECT COUNT(*) FROM alarm_events";
     MYSQL* mysql = guard->get();
     MYSQL_STMT* stmt = mysql_stmt_init(mysql);
     if (!stmt) return 0;
     if (mysql_stmt_prepare(stmt, sql, static_cast<unsigned long>(strlen(sql))) != 0) { mysql_stmt_close(stmt); return 0; }
-    if (mysql_stmt_execute(stmt) != 0) { mysql_stmt_close(stmt); return 0; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, stmt)) { mysql_stmt_close(stmt); return 0; }
     int count = 0; unsigned long len=0; MYSQL_BIND rb{}; memset(&rb, 0, sizeof(rb)); rb.buffer_type = MYSQL_TYPE_LONG; rb.buffer = &count; rb.length = &len;
     if (mysql_stmt_bind_result(stmt, &rb) != 0) { mysql_stmt_close(stmt); return 0; }
     if (mysql_stmt_fetch(stmt) != 0) { mysql_stmt_close(stmt); return 0; }
@@ -551,8 +642,8 @@ PaginatedAlarmEvents AlarmManager::getPaginatedAlarmEvents(int page, int page_si
     result.page = page;
     result.page_size = page_size;
     if (!m_initialized) return result;
-    MySQLConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) return result;
+    MySQLConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
+    if (!guard.isValid()) { markIfDeadlineExpired(); return result; }
     MYSQL* mysql = guard->get();
     // COUNT 查询（根据是否有status准备不同SQL）
     MYSQL_STMT* count_stmt = mysql_stmt_init(mysql);
@@ -577,7 +668,7 @@ PaginatedAlarmEvents AlarmManager::getPaginatedAlarmEvents(int page, int page_si
             return result;
         }
     }
-    if (mysql_stmt_execute(count_stmt) != 0) { mysql_stmt_close(count_stmt); return result; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, count_stmt)) { mysql_stmt_close(count_stmt); return result; }
     int total_count = 0; unsigned long len=0; MYSQL_BIND rb{}; memset(&rb, 0, sizeof(rb)); rb.buffer_type = MYSQL_TYPE_LONG; rb.buffer = &total_count; rb.length = &len;
     if (mysql_stmt_bind_result(count_stmt, &rb) != 0) { mysql_stmt_close(count_stmt); return result; }
     if (mysql_stmt_fetch(count_stmt) == 0) { result.total_count = total_count; }
@@ -617,7 +708,7 @@ PaginatedAlarmEvents AlarmManager::getPaginatedAlarmEvents(int page, int page_si
     params[idx].buffer_type = MYSQL_TYPE_LONG; params[idx].buffer = &limit_val; params[idx].length = &limit_len; idx++;
     params[idx].buffer_type = MYSQL_TYPE_LONG; params[idx].buffer = &offset_val; params[idx].length = &offset_len;
     if (mysql_stmt_bind_param(data_stmt, params) != 0) { mysql_stmt_close(data_stmt); return result; }
-    if (mysql_stmt_execute(data_stmt) != 0) { mysql_stmt_close(data_stmt); return result; }
+    if (!executeStatementWithDeadline(m_connection_pool, mysql, data_stmt)) { mysql_stmt_close(data_stmt); return result; }
     if (mysql_stmt_store_result(data_stmt) != 0) { mysql_stmt_close(data_stmt); return result; }
     // 绑定结果缓冲
     std::vector<char> id_buf(64), fp_buf(600), status_buf(16), labels_buf(65535), ann_buf(65535), starts_at_buf(32), ends_at_buf(32), gen_url_buf(2048), created_buf(32), updated_buf(32);
@@ -0,0 +1,403 @@
+#include "alarm_notifier.h"
+#include "alarm_rule_engine.h"
+#include "log_manager.h"
+#include "httplib.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <limits>
+
+namespace {
+
+// Alertmanager webhook 的时间格式，未设置的时间为 0001-01-01T00:00:00Z
+std::string formatTime(const std::chrono::system_clock::time_point& tp) {
+    if (tp == std::chrono::system_clock::time_point{}) {
+        return "0001-01-01T00:00:00Z";
+    }
+    std::time_t time = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm_utc;
+    gmtime_r(&time, &tm_utc);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm_utc);
+    return buffer;
+}
+
+// 只保留所有告警取值都相同的标签
+void intersect(std::map<std::string, std::string>& common, const std::map<std::string, std::string>& labels) {
+    for (auto it = common.begin(); it != common.end();) {
+        auto found = labels.find(it->first);
+        if (found == labels.end() || found->second != it->second) {
+            it = common.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// 规则引擎的事件使用 alertname 标签，NodeOffline / ComponentFailed 和抑制根因使用 alert_name，
+// 分组时两者视为同一个标签
+std::map<std::string, std::string>::const_iterator findLabel(const std::map<std::string, std::string>& labels,
+                                                             const std::string& name) {
+    auto it = labels.find(name);
+    if (it != labels.end()) {
+        return it;
+    }
+    if (name == "alert_name") {
+        return labels.find("alertname");
+    }
+    if (name == "alertname") {
+        return labels.find("alert_name");
+    }
+    return labels.end();
+}
+
+}  // namespace
+
+AlarmNotifier::AlarmNotifier(const AlarmNotificationConfig& config) : m_config(config) {
+    for (const auto& receiver_config : m_config.receivers) {
+        std::unique_ptr<Receiver> receiver(new Receiver());
+        receiver->config = receiver_config;
+        receiver->config.queue_capacity = std::max<size_t>(1, receiver_config.queue_capacity);
+
+        // http://host:port/path 拆分为连接地址和请求路径
+        const std::string& url = receiver_config.url;
+        size_t scheme = url.find("://");
+        size_t slash = url.find('/', scheme == std::string::npos ? 0 : scheme + 3);
+        receiver->scheme_host_port = url.substr(0, slash);
+        receiver->path = slash == std::string::npos ? "/" : url.substr(slash);
+        m_receivers.push_back(std::move(receiver));
+    }
+}
+
+AlarmNotifier::~AlarmNotifier() {
+    stop();
+}
+
+void AlarmNotifier::start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_stopping.store(false);
+    for (auto& receiver : m_receivers) {
+        Receiver* r = receiver.get();
+        r->thread = std::thread([this, r]() { deliverLoop(*r); });
+    }
+    m_dispatch_thread = std::thread(&AlarmNotifier::dispatchLoop, this);
+    std::string group_by;
+    for (const auto& label : m_config.group_by) {
+        group_by += (group_by.empty() ? "" : ",") + label;
+    }
+    LogManager::getLogger()->info("AlarmNotifier: started with {} receivers, group_by [{}], group_wait {}s, group_interval {}s",
+                                  m_receivers.size(), group_by, m_config.group_wait.count(), m_config.group_interval.count());
+}
+
+void AlarmNotifier::stop() {
+    if (!m_running.load()) {
+        return;
+    }
+
+    // 先让分组线程通知所有有变化的分组，再让发送线程发送完队列
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping.store(true);
+    }
+    m_cv.notify_all();
+    if (m_dispatch_thread.joinable()) {
+        m_dispatch_thread.join();
+    }
+
+    m_running.store(false);
+    for (auto& receiver : m_receivers) {
+        {
+            std::lock_guard<std::mutex> lock(receiver->mutex);
+        }
+        receiver->cv.notify_all();
+        if (receiver->thread.joinable()) {
+            receiver->thread.join();
+        }
+    }
+    LogManager::getLogger()->info("AlarmNotifier: stopped after {} events, {} notifications", m_events, m_notifications);
+}
+
+void AlarmNotifier::enqueue(const std::vector<AlarmEvent>& events) {
+    if (m_receivers.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t now_ms = steadyNowMs();
+    for (const auto& event : events) {
+        ++m_events;
+
+        std::string key;
+        std::map<std::string, std::string> group_labels;
+        auto known = m_alert_groups.find(event.fingerprint);
+        if (known != m_alert_groups.end()) {
+            key = known->second;
+        } else if (event.status == "resolved" && event.labels.empty()) {
+            // 只有指纹的 resolved 事件（如节点恢复），接收方没有收到过对应的 firing
+            continue;
+        } else {
+            key = groupKey(event.labels, group_labels);
+        }
+
+        auto inserted = m_groups.emplace(key, Group());
+        Group& group = inserted.first->second;
+        if (inserted.second) {
+            group.labels = group_labels;
+            group.next_flush_ms = now_ms + std::chrono::duration_cast<std::chrono::milliseconds>(m_config.group_wait).count();
+        }
+
+        AlertState& alert = group.alerts[event.fingerprint];
+        alert.status = event.status;
+        if (!event.labels.empty()) {
+            alert.labels = event.labels;
+        }
+        if (!event.annotations.empty()) {
+            alert.annotations = event.annotations;
+        }
+        if (event.status == "firing") {
+            alert.starts_at = event.starts_at;
+            alert.ends_at = std::chrono::system_clock::time_point{};
+        } else {
+            if (alert.starts_at == std::chrono::system_clock::time_point{}) {
+                alert.starts_at = event.starts_at;
+            }
+            alert.ends_at = event.ends_at;
+        }
+        m_alert_groups[event.fingerprint] = key;
+
+        if (!group.dirty) {
+            group.dirty = true;
+            if (group.last_flush_ms != 0) {
+                group.next_flush_ms = std::max(now_ms, group.last_flush_ms +
+                    std::chrono::duration_cast<std::chrono::milliseconds>(m_config.group_interval).count());
+            }
+        }
+    }
+    m_cv.notify_one();
+}
+
+AlarmNotificationStats AlarmNotifier::getStats() const {
+    AlarmNotificationStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.events = m_events;
+        stats.notifications = m_notifications;
+        stats.groups = m_groups.size();
+    }
+    for (const auto& receiver : m_receivers) {
+        AlarmReceiverStats receiver_stats;
+        receiver_stats.name = receiver->config.name;
+        receiver_stats.sent = receiver->sent.load();
+        receiver_stats.failed = receiver->failed.load();
+        receiver_stats.retries = receiver->retries.load();
+        receiver_stats.dropped = receiver->dropped.load();
+        receiver_stats.last_latency_ms = receiver->last_latency_ms.load();
+        {
+            std::lock_guard<std::mutex> lock(receiver->mutex);
+            receiver_stats.queued = receiver->queue.size();
+        }
+        stats.receivers.push_back(receiver_stats);
+    }
+    return stats;
+}
+
+void AlarmNotifier::dispatchLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping.load()) {
+        int64_t now_ms = steadyNowMs();
+        flushDue(now_ms, false);
+
+        int64_t next_ms = std::numeric_limits<int64_t>::max();
+        for (const auto& entry : m_groups) {
+            if (entry.second.dirty) {
+                next_ms = std::min(next_ms, entry.second.next_flush_ms);
+            }
+        }
+        if (next_ms == std::numeric_limits<int64_t>::max()) {
+            m_cv.wait(lock);
+        } else if (next_ms > now_ms) {
+            m_cv.wait_for(lock, std::chrono::milliseconds(next_ms - now_ms));
+        }
+    }
+    flushDue(steadyNowMs(), true);
+}
+
+void AlarmNotifier::flushDue(int64_t now_ms, bool all) {
+    int64_t interval_ms = std::chrono::duration_cast<std::chrono::milliseconds>(m_config.group_interval).count();
+    for (auto it = m_groups.begin(); it != m_groups.end();) {
+        Group& group = it->second;
+        if (!group.dirty || (!all && group.next_flush_ms > now_ms)) {
+            ++it;
+            continue;
+        }
+
+        for (auto& receiver : m_receivers) {
+            push(*receiver, buildMessage(it->first, group, receiver->config.name));
+            ++m_notifications;
+        }
+        group.dirty = false;
+        group.last_flush_ms = now_ms;
+        group.next_flush_ms = now_ms + interval_ms;
+
+        // 已通知的 resolved 告警移出分组，分组为空时删除
+        for (auto alert = group.alerts.begin(); alert != group.alerts.end();) {
+            if (alert->second.status == "resolved") {
+                m_alert_groups.erase(alert->first);
+                alert = group.alerts.erase(alert);
+            } else {
+                ++alert;
+            }
+        }
+        if (group.alerts.empty()) {
+            it = m_groups.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::string AlarmNotifier::buildMessage(const std::string& group_key, const Group& group,
+                                        const std::string& receiver) const {
+    nlohmann::json alerts = nlohmann::json::array();
+    std::map<std::string, std::string> common_labels;
+    std::map<std::string, std::string> common_annotations;
+    bool firing = false;
+    size_t included = 0;
+
+    for (const auto& entry : group.alerts) {
+        const AlertState& alert = entry.second;
+        if (included == 0) {
+            common_labels = alert.labels;
+            common_annotations = alert.annotations;
+        } else {
+            intersect(common_labels, alert.labels);
+            intersect(common_annotations, alert.annotations);
+        }
+        firing = firing || alert.status == "firing";
+
+        if (m_config.max_alerts_per_message == 0 || included < m_config.max_alerts_per_message) {
+            alerts.push_back({
+                {"status", alert.status},
+                {"labels", alert.labels},
+                {"annotations", alert.annotations},
+                {"startsAt", formatTime(alert.starts_at)},
+                {"endsAt", formatTime(alert.ends_at)},
+                {"generatorURL", ""},
+                {"fingerprint", entry.first}
+            });
+        }
+        ++included;
+    }
+
+    nlohmann::json message = {
+        {"version", "4"},
+        {"groupKey", group_key},
+        {"truncatedAlerts", included - alerts.size()},
+        {"status", firing ? "firing" : "resolved"},
+        {"receiver", receiver},
+        {"groupLabels", group.labels},
+        {"commonLabels", common_labels},
+        {"commonAnnotations", common_annotations},
+        {"externalURL", ""},
+        {"alerts", alerts}
+    };
+    return message.dump();
+}
+
+std::string AlarmNotifier::groupKey(const std::map<std::string, std::string>& labels,
+                                    std::map<std::string, std::string>& group_labels) const {
+    std::string key;
+    for (const auto& name : m_config.group_by) {
+        auto it = findLabel(labels, name);
+        const std::string value = it != labels.end() ? it->second : "";
+        group_labels[name] = value;
+        if (!key.empty()) {
+            key += ",";
+        }
+        key += name + "=" + value;
+    }
+    return "{" + key + "}";
+}
+
+void AlarmNotifier::push(Receiver& receiver, std::string body) {
+    {
+        std::lock_guard<std::mutex> lock(receiver.mutex);
+        if (receiver.queue.size() >= receiver.config.queue_capacity) {
+            receiver.queue.pop_front();
+            receiver.dropped.fetch_add(1);
+            LogManager::getLogger()->warn("AlarmNotifier: receiver {} queue full, dropped oldest notification",
+                                          receiver.config.name);
+        }
+        receiver.queue.push_back(std::move(body));
+    }
+    receiver.cv.notify_one();
+}
+
+void AlarmNotifier::deliverLoop(Receiver& receiver) {
+    // 每个接收方一个客户端，连接在请求之间保持
+    httplib::Client client(receiver.scheme_host_port);
+    if (!client.is_valid()) {
+        LogManager::getLogger()->error("AlarmNotifier: invalid receiver url {} ({})", receiver.config.url,
+                                       receiver.config.name);
+    }
+    client.set_keep_alive(true);
+    client.set_connection_timeout(receiver.config.timeout);
+    client.set_read_timeout(receiver.config.timeout);
+    client.set_write_timeout(receiver.config.timeout);
+
+    while (true) {
+        std::string body;
+        {
+            std::unique_lock<std::mutex> lock(receiver.mutex);
+            receiver.cv.wait(lock, [&]() { return !receiver.queue.empty() || !m_running.load(); });
+            if (receiver.queue.empty()) {
+                break;
+            }
+            body = std::move(receiver.queue.front());
+            receiver.queue.pop_front();
+        }
+
+        int64_t started_ms = steadyNowMs();
+        std::string error;
+        bool delivered = false;
+        for (int attempt = 0;; ++attempt) {
+            auto result = client.Post(receiver.path, body, "application/json");
+            if (result && result->status >= 200 && result->status < 300) {
+                delivered = true;
+                break;
+            }
+            error = result ? "HTTP " + std::to_string(result->status) : httplib::to_string(result.error());
+            bool retryable = !result || result->status >= 500 || result->status == 429;
+            if (!retryable || attempt >= receiver.config.max_retries || !m_running.load()) {
+                break;
+            }
+            receiver.retries.fetch_add(1);
+            std::unique_lock<std::mutex> lock(receiver.mutex);
+            receiver.cv.wait_for(lock, receiver.config.retry_backoff * (1 << std::min(attempt, 16)),
+                                 [this]() { return !m_running.load(); });
+        }
+
+        if (delivered) {
+            receiver.sent.fetch_add(1);
+            receiver.last_latency_ms.store(static_cast<uint64_t>(steadyNowMs() - started_ms));
+            continue;
+        }
+        receiver.failed.fetch_add(1);
+        LogManager::getLogger()->warn("AlarmNotifier: failed to deliver notification to {}: {}", receiver.config.name, error);
+
+        // 停止过程中接收方不可用时放弃剩余通知，避免逐条等待超时
+        if (!m_running.load()) {
+            std::lock_guard<std::mutex> lock(receiver.mutex);
+            receiver.failed.fetch_add(receiver.queue.size());
+            receiver.queue.clear();
+        }
+    }
+}
+
+int64_t AlarmNotifier::steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -1,17 +1,138 @@
 #include "alarm_rule_engine.h"
 #include "resource_storage.h"
+#include "metric_schema.h"
+#include "query_deadline.h"
 #include "log_manager.h"
 #include <iostream>
 #include <sstream>
 #include <regex>
 #include <algorithm>
 #include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <unordered_set>
 #include <taos.h>
 
+namespace {
+    // 流式序列的有效窗口，与SQL评估的 ts > NOW() - 10s 一致
+    const std::chrono::seconds kStreamSeriesWindow(10);
+    // 异常检测基线在序列停止上报超过该时长后释放，短暂中断（重启、网络抖动）后不需要重新预热
+    const std::chrono::minutes kAnomalyBaselineIdle(30);
+    // 异常检测规则没有 conditions 时的默认条件：偏离分数大于3（3σ）
+    const double kDefaultAnomalyScore = 3.0;
+    // 没有规则引用时也计入趋势索引的序列（超级表, 指标），供耗尽预测接口使用
+    const std::pair<const char*, const char*> kDefaultForecastTargets[] = {
+        {"disk", "usage_percent"},
+        {"memory", "usage_percent"},
+    };
+    // 评估线程释放趋势索引中空闲序列的间隔
+    const std::chrono::seconds kForecastSweepInterval(60);
+    // 组合条件规则可按机箱关联，BMC超级表以 box_id 标识机箱
+    const char* const kBoxTag = "box_id";
+    const char* const kBmcFanStable = "bmc_fan_super";
+    // 组合条件 all / any 的最大嵌套层数
+    const int kMaxJoinDepth = 8;
+    // 评估线程检查评估间隔和一致性校验周期的唤醒间隔
+    const std::chrono::seconds kEvaluationTickInterval(1);
+    // 检查规则表签名的间隔，发现绕过本进程对规则表的修改
+    const std::chrono::seconds kRuleSignatureCheckInterval(30);
+    // 64位 FNV-1a 参数
+    const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+    const uint64_t kFnvPrime = 1099511628211ULL;
+    
+    // 实例状态快照文件格式：文件头 (魔数, 版本, 写入时间毫秒, 记录数) + 记录，整数按本机字节序
+    const uint32_t kSnapshotMagic = 0x53415759;  // "YWAS"
+    const uint32_t kSnapshotVersion = 3;  // 版本2在实例之后追加缺失数据规则的序列索引，版本3再追加趋势索引
+    const uint32_t kSnapshotMaxString = 1 << 20;
+    // 恢复的流式实例在该序列键下等待第一个样本，与真实序列一起按 kStreamSeriesWindow 过期
+    const uint64_t kRestoredSeriesKey = 0;
+    
+    template <typename T>
+    void writePod(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    
+    template <typename T>
+    bool readPod(std::istream& in, T& value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+    
+    void writeString(std::ostream& out, const std::string& value) {
+        writePod(out, static_cast<uint32_t>(value.size()));
+        out.write(value.data(), value.size());
+    }
+    
+    bool readString(std::istream& in, std::string& value) {
+        uint32_t size = 0;
+        if (!readPod(in, size) || size > kSnapshotMaxString) {
+            return false;
+        }
+        value.resize(size);
+        return size == 0 || static_cast<bool>(in.read(&value[0], size));
+    }
+    
+    void writeStringMap(std::ostream& out, const std::map<std::string, std::string>& values) {
+        writePod(out, static_cast<uint32_t>(values.size()));
+        for (const auto& pair : values) {
+            writeString(out, pair.first);
+            writeString(out, pair.second);
+        }
+    }
+    
+    bool readStringMap(std::istream& in, std::map<std::string, std::string>& values) {
+        uint32_t count = 0;
+        if (!readPod(in, count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string key;
+            std::string value;
+            if (!readString(in, key) || !readString(in, value)) {
+                return false;
+            }
+            values[key] = value;
+        }
+        return true;
+    }
+    
+    int64_t toEpochMs(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+    }
+    
+    std::chrono::system_clock::time_point fromEpochMs(int64_t ms) {
+        return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+    }
+    
+    int64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    
+    // 剩余时间的展示形式，如 2d3h、5h42m、12m
+    std::string formatRemaining(double seconds) {
+        int64_t minutes = static_cast<int64_t>(seconds / 60.0);
+        int64_t days = minutes / 1440;
+        int64_t hours = minutes % 1440 / 60;
+        if (days > 0) {
+            return std::to_string(days) + "d" + std::to_string(hours) + "h";
+        }
+        if (hours > 0) {
+            return std::to_string(hours) + "h" + std::to_string(minutes % 60) + "m";
+        }
+        return std::to_string(minutes) + "m";
+    }
+}
+
 AlarmRuleEngine::AlarmRuleEngine(std::shared_ptr<AlarmRuleStorage> rule_storage,
                                std::shared_ptr<ResourceStorage> resource_storage)
     : m_rule_storage(rule_storage), m_resource_storage(resource_storage),
-      m_running(false), m_evaluation_interval(std::chrono::seconds(30)) {
+      m_running(false), m_evaluation_interval(std::chrono::seconds(30)),
+      m_evaluation_mode(AlarmEvaluationMode::STREAMING), m_sweep_interval(std::chrono::seconds(60)),
+      m_worker_threads(4), m_snapshot_interval(std::chrono::seconds(10)),
+      m_flap_window(std::chrono::seconds(600)), m_flap_threshold(6), m_suppressed_events(0),
+      m_rule_cost_budget(500), m_rules_loaded(false), m_loaded_rule_version(0) {
 }
 
 AlarmRuleEngine::~AlarmRuleEngine() {
@@ -25,10 +146,24 @@ bool AlarmRuleEngine::start() {
     
     logInfo("Starting alarm rule engine...");
     
-    loadRulesFromDatabase();
+    loadRulesFromDatabase(true);
+    
+    if (!m_state_file.empty()) {
+        size_t restored = restoreSnapshot();
+        if (restored > 0) {
+            logInfo("Restored " + std::to_string(restored) + " alarm instances from " + m_state_file);
+        }
+    }
+    
+    m_worker_pool.reset(new WorkerPool(m_worker_threads));
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_evaluation_stats.worker_threads = m_worker_pool->size();
+    }
     
     m_running = true;
     m_evaluation_thread = std::thread(&AlarmRuleEngine::evaluationLoop, this);
+    m_timer_thread = std::thread(&AlarmRuleEngine::timerLoop, this);
     
     logInfo("Alarm rule engine started");
     return true;
@@ -42,9 +177,21 @@ void AlarmRuleEngine::stop() {
     logInfo("Stopping alarm rule engine...");
     
     m_running = false;
+    {
+        std::lock_guard<std::mutex> lock(m_timer_mutex);
+    }
+    m_timer_cv.notify_all();
     if (m_evaluation_thread.joinable()) {
         m_evaluation_thread.join();
     }
+    if (m_timer_thread.joinable()) {
+        m_timer_thread.join();
+    }
+    m_worker_pool.reset();
+    
+    if (!m_state_file.empty()) {
+        saveSnapshot();
+    }
     
     logInfo("Alarm rule engine stopped");
 }
@@ -53,288 +200,2837 @@ void AlarmRuleEngine::setEvaluationInterval(std::chrono::seconds interval) {
     m_evaluation_interval = interval;
 }
 
+void AlarmRuleEngine::setWorkerThreads(size_t thread_count) {
+    m_worker_threads = thread_count;
+}
+
+void AlarmRuleEngine::setEvaluationMode(AlarmEvaluationMode mode) {
+    m_evaluation_mode = mode;
+}
+
+void AlarmRuleEngine::setSweepInterval(std::chrono::seconds interval) {
+    m_sweep_interval = interval;
+}
+
+void AlarmRuleEngine::setStateFile(const std::string& path) {
+    m_state_file = path;
+}
+
+void AlarmRuleEngine::setFlapDetection(std::chrono::seconds window, size_t threshold) {
+    m_flap_window = window;
+    m_flap_threshold = window.count() > 0 ? threshold : 0;
+}
+
+void AlarmRuleEngine::setSnapshotInterval(std::chrono::seconds interval) {
+    m_snapshot_interval = interval;
+}
+
+void AlarmRuleEngine::setForecastLookback(std::chrono::seconds lookback) {
+    m_forecasts.setLookback(lookback);
+}
+
+void AlarmRuleEngine::setRuleCostBudget(std::chrono::milliseconds budget) {
+    m_rule_cost_budget = budget.count() > 0 ? budget : std::chrono::milliseconds(0);
+}
+
+void AlarmRuleEngine::setHostLocator(std::function<bool(const std::string& host_ip, int& box_id)> locator) {
+    m_host_locator = std::move(locator);
+}
+
+std::vector<SeriesForecast> AlarmRuleEngine::getForecasts(const std::string& stable, const std::string& metric,
+                                                          double capacity, double within_s, size_t limit,
+                                                          size_t& tracked) const {
+    return m_forecasts.closest(stable, metric, capacity, within_s, limit, tracked);
+}
+
 std::vector<AlarmInstance> AlarmRuleEngine::getCurrentAlarmInstances() const {
-    std::lock_guard<std::mutex> lock(m_instances_mutex);
     std::vector<AlarmInstance> instances;
-    instances.reserve(m_alarm_instances.size());
     
-    for (const auto& pair : m_alarm_instances) {
-        instances.push_back(pair.second);
+    for (const auto& shard : allShards()) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& pair : shard->instances) {
+            instances.push_back(pair.second);
+            auto flap_it = shard->flap_states.find(pair.first);
+            instances.back().flapping = flap_it != shard->flap_states.end() && flap_it->second.detector.flapping();
+        }
     }
     
     return instances;
 }
 
+std::shared_ptr<AlarmRuleEngine::InstanceShard> AlarmRuleEngine::shardFor(const std::string& alert_name) {
+    std::lock_guard<std::mutex> lock(m_instances_mutex);
+    auto& shard = m_instance_shards[alert_name];
+    if (!shard) {
+        shard = std::make_shared<InstanceShard>();
+        shard->alert_name = alert_name;
+    }
+    return shard;
+}
+
+std::shared_ptr<AlarmRuleEngine::InstanceShard> AlarmRuleEngine::findShard(const std::string& alert_name) const {
+    std::lock_guard<std::mutex> lock(m_instances_mutex);
+    auto it = m_instance_shards.find(alert_name);
+    return it != m_instance_shards.end() ? it->second : nullptr;
+}
+
+std::vector<std::shared_ptr<AlarmRuleEngine::InstanceShard>> AlarmRuleEngine::allShards() const {
+    std::lock_guard<std::mutex> lock(m_instances_mutex);
+    std::vector<std::shared_ptr<InstanceShard>> shards;
+    shards.reserve(m_instance_shards.size());
+    for (const auto& pair : m_instance_shards) {
+        shards.push_back(pair.second);
+    }
+    return shards;
+}
+
+AlarmEvaluationStats AlarmRuleEngine::getEvaluationStats() const {
+    AlarmEvaluationStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        stats = m_evaluation_stats;
+    }
+    stats.suppressed_events = m_suppressed_events.load();
+    stats.rule_cost_budget_ms = m_rule_cost_budget.count();
+    
+    // 只统计当前规则集中的规则，已删除规则的分片不计入
+    auto rule_set = currentRuleSet();
+    if (rule_set) {
+        for (const auto& compiled : rule_set->rules) {
+            auto shard = findShard(compiled->rule.alert_name);
+            if (!shard) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            if (shard->profile.over_budget) {
+                stats.slow_rules++;
+            }
+        }
+    }
+    return stats;
+}
+
+std::vector<AlarmRuleProfile> AlarmRuleEngine::getRuleProfiles(int64_t& window_ms) const {
+    std::vector<AlarmRuleProfile> profiles;
+    window_ms = RollingHistogram().windowMs();
+    auto rule_set = currentRuleSet();
+    if (!rule_set) {
+        return profiles;
+    }
+    
+    int64_t now_ms = toEpochMs(std::chrono::system_clock::now());
+    profiles.reserve(rule_set->rules.size());
+    for (const auto& compiled : rule_set->rules) {
+        AlarmRuleProfile profile;
+        profile.alert_name = compiled->rule.alert_name;
+        if (!compiled->join_on.empty()) {
+            profile.kind = "join";
+        } else if (compiled->windowed || compiled->anomaly || compiled->predict_full_within.count() > 0 ||
+                   compiled->absent_for.count() > 0) {
+            profile.kind = "stream";
+        } else {
+            profile.kind = "sql";
+        }
+        
+        auto shard = findShard(profile.alert_name);
+        if (shard) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            const RuleProfile& recorded = shard->profile;
+            profile.evaluations = recorded.evaluations;
+            profile.query_us = recorded.query_us.summary(now_ms);
+            profile.rows = recorded.rows.summary(now_ms);
+            profile.reconcile_us = recorded.reconcile_us.summary(now_ms);
+            profile.cost_us = recorded.cost_us.summary(now_ms);
+            profile.instances = recorded.instances.summary(now_ms);
+            profile.events = recorded.events.summary(now_ms);
+            profile.events_total = recorded.events_total;
+            profile.current_instances = shard->instances.size();
+            profile.over_budget = recorded.over_budget;
+        }
+        profiles.push_back(std::move(profile));
+    }
+    return profiles;
+}
+
 void AlarmRuleEngine::setAlarmEventCallback(std::function<void(const AlarmEvent&)> callback) {
     m_alarm_event_callback = callback;
 }
 
+/*
+ * 评估循环
+ * 
+ * 每个评估间隔重新加载规则并执行SQL评估。流式模式下推送规则的SQL评估只在一致性校验周期执行，
+ * 其余时间由 ingestSamples 在写入路径上评估。for 时长和流式序列过期由定时器线程处理。
+ */
 void AlarmRuleEngine::evaluationLoop() {
+    auto next_evaluation = std::chrono::steady_clock::now();
+    auto next_sweep = next_evaluation;
+    auto next_snapshot = next_evaluation + m_snapshot_interval;
+    auto next_forecast_sweep = next_evaluation + kForecastSweepInterval;
+    
     while (m_running) {
+        auto now = std::chrono::steady_clock::now();
+        bool streaming = m_evaluation_mode == AlarmEvaluationMode::STREAMING;
+        
+        if (now >= next_evaluation) {
+            bool sweep = !streaming || now >= next_sweep;
+            try {
+                loadRulesFromDatabase(false);
+                evaluateRules(sweep);
+            } catch (const std::exception& e) {
+                logError("Error in evaluation loop: " + std::string(e.what()));
+            }
+            if (sweep) {
+                next_sweep = now + m_sweep_interval;
+            }
+            next_evaluation = now + m_evaluation_interval;
+        }
+        
+        if (!m_state_file.empty() && now >= next_snapshot) {
+            saveSnapshot();
+            next_snapshot = now + m_snapshot_interval;
+        }
+        
+        // 停止上报超过回溯时间的序列，其趋势权重已衰减到 1/e 以下
+        if (now >= next_forecast_sweep) {
+            int64_t now_ms = toEpochMs(std::chrono::system_clock::now());
+            m_forecasts.evictIdle(now_ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                m_forecasts.lookback()).count());
+            next_forecast_sweep = now + kForecastSweepInterval;
+        }
+        
+        std::this_thread::sleep_for(std::min(kEvaluationTickInterval, m_evaluation_interval));
+    }
+}
+
+/*
+ * 加载规则
+ * 
+ * 只在规则集变化时重新读取并编译：本进程通过 AlarmRuleStorage 修改规则会增加其版本号（无需查询），
+ * 绕过本进程直接修改规则表的情况每 kRuleSignatureCheckInterval 通过 COUNT(*) / MAX(updated_at) 检查一次。
+ * 规则未变化的评估周期不读取MySQL、不解析表达式。
+ */
+void AlarmRuleEngine::loadRulesFromDatabase(bool force) {
+    try {
+        auto now = std::chrono::steady_clock::now();
+        uint64_t version = m_rule_storage->getRuleVersion();
+        bool changed = force || !m_rules_loaded || version != m_loaded_rule_version;
+        
+        std::string signature;
+        bool has_signature = false;
+        if (changed || now >= m_next_signature_check) {
+            has_signature = m_rule_storage->getRuleSetSignature(signature);
+            m_next_signature_check = now + kRuleSignatureCheckInterval;
+            if (has_signature && signature != m_loaded_rule_signature) {
+                changed = true;
+            }
+        }
+        
+        if (!changed) {
+            return;
+        }
+        
+        std::vector<AlarmRule> rules = m_rule_storage->getEnabledAlarmRules();
+        std::atomic_store(&m_rule_set, compileRuleSet(rules));
+        
+        m_rules_loaded = true;
+        m_loaded_rule_version = version;
+        if (has_signature) {
+            m_loaded_rule_signature = signature;
+        }
+        logInfo("Loaded and compiled " + std::to_string(rules.size()) + " alarm rules from database");
+    } catch (const std::exception& e) {
+        logError("Failed to load rules from database: " + std::string(e.what()));
+    }
+}
+
+std::shared_ptr<const AlarmRuleEngine::CompiledRuleSet> AlarmRuleEngine::currentRuleSet() const {
+    return std::atomic_load(&m_rule_set);
+}
+
+/*
+ * 编译规则集：编译每条规则，按超级表和标签过滤分组并预生成查询语句，建立流式规则索引
+ */
+std::shared_ptr<const AlarmRuleEngine::CompiledRuleSet> AlarmRuleEngine::compileRuleSet(const std::vector<AlarmRule>& rules) {
+    auto rule_set = std::make_shared<CompiledRuleSet>();
+    std::map<std::string, RuleGroup> groups;
+    for (const auto& target : kDefaultForecastTargets) {
+        rule_set->forecast_targets[target.first].insert(target.second);
+    }
+    
+    for (const auto& rule : rules) {
+        auto compiled = compileRule(rule);
+        if (!compiled) {
+            continue;
+        }
+        rule_set->rules.push_back(compiled);
+        rule_set->by_name[compiled->rule.alert_name] = compiled;
+        
+        if (compiled->predict_full_within.count() > 0) {
+            rule_set->forecast_targets[compiled->stable].insert(compiled->metric);
+        }
+        
+        // 组合条件规则不分组，各项引用的超级表合并为每个超级表一次查询
+        if (!compiled->join_on.empty()) {
+            rule_set->join_rules.push_back(compiled);
+            bool box_join = compiled->join_on == kBoxTag;
+            std::set<std::string> stables;
+            for (const auto& term : compiled->join_terms) {
+                JoinFetch& fetch = rule_set->join_fetches[term.stable];
+                fetch.stable = term.stable;
+                if (stables.insert(term.stable).second) {
+                    ++fetch.rules;
+                }
+                fetch.metrics.insert(term.metric);
+                for (const auto& tag : term.tags) {
+                    fetch.labels.insert(tag.first);
+                }
+                if (stableHasLabel(term.stable, compiled->join_on)) {
+                    fetch.labels.insert(compiled->join_on);
+                } else {
+                    fetch.labels.insert(metric_schema::kHostTag);
+                }
+                fetch.box_join = fetch.box_join || box_join;
+            }
+            continue;
+        }
+        
+        // 窗口条件、异常检测、耗尽预测和缺失数据规则只在写入路径上评估，不参与SQL查询
+        if (compiled->windowed || compiled->anomaly || compiled->predict_full_within.count() > 0 ||
+            compiled->absent_for.count() > 0) {
+            rule_set->stream_index[compiled->stable].push_back(compiled);
+            continue;
+        }
+        
+        auto tags = compiled->tags;
+        std::sort(tags.begin(), tags.end());
+        std::string group_key = compiled->stable;
+        for (const auto& tag : tags) {
+            group_key += "|" + tag.first + "=" + tag.second;
+        }
+        
+        RuleGroup& group = groups[group_key];
+        if (group.rules.empty()) {
+            group.stable = compiled->stable;
+            group.tags = tags;
+            group.streamed = isStreamedStable(compiled->stable);
+        }
+        group.metrics.insert(compiled->metric);
+        group.rules.push_back(compiled);
+        
+        // 只收录引用资源超级表（由 insertResourceData 推送样本）的规则，BMC等其他超级表的规则仍按评估间隔执行SQL
+        if (group.streamed) {
+            rule_set->stream_index[compiled->stable].push_back(compiled);
+        }
+    }
+    
+    rule_set->groups.reserve(groups.size());
+    for (auto& pair : groups) {
+        pair.second.sql = convertGroupToSQL(pair.second);
+        rule_set->groups.push_back(std::move(pair.second));
+    }
+    for (auto& pair : rule_set->join_fetches) {
+        pair.second.sql = convertJoinFetchToSQL(pair.second);
+    }
+    
+    return rule_set;
+}
+
+std::shared_ptr<const AlarmRuleEngine::CompiledRule> AlarmRuleEngine::compileRule(const AlarmRule& rule) {
+    nlohmann::json expression;
+    try {
+        expression = nlohmann::json::parse(rule.expression_json);
+    } catch (const std::exception& e) {
+        logError("Failed to parse rule expression for " + rule.alert_name + ": " + std::string(e.what()));
+        return nullptr;
+    }
+    
+    if (expression.contains("all") || expression.contains("any")) {
+        auto compiled = std::make_shared<CompiledRule>();
         try {
-            loadRulesFromDatabase();
-            evaluateRules();
+            compiled->rule = rule;
+            compiled->for_duration = parseDuration(rule.for_duration);
+            compiled->description_template = compileTemplate(rule.description);
+            if (expression.contains("keep_firing_for")) {
+                compiled->keep_firing_for = parseDuration(expression["keep_firing_for"].get<std::string>());
+            }
+            if (!compileJoinRule(rule, expression, *compiled)) {
+                return nullptr;
+            }
         } catch (const std::exception& e) {
-            logError("Error in evaluation loop: " + std::string(e.what()));
+            logError("Invalid rule expression for " + rule.alert_name + ": " + std::string(e.what()));
+            return nullptr;
+        }
+        return compiled;
+    }
+    
+    if (!expression.contains("stable") || !expression.contains("metric")) {
+        logError("Rule " + rule.alert_name + " missing required fields: stable or metric");
+        return nullptr;
+    }
+    
+    auto compiled = std::make_shared<CompiledRule>();
+    try {
+        compiled->rule = rule;
+        compiled->stable = expression["stable"].get<std::string>();
+        compiled->metric = expression["metric"].get<std::string>();
+        compiled->for_duration = parseDuration(rule.for_duration);
+        compiled->description_template = compileTemplate(rule.description);
+        
+        if (expression.contains("tags") && expression["tags"].is_array()) {
+            for (const auto& tag_condition : expression["tags"]) {
+                for (auto it = tag_condition.begin(); it != tag_condition.end(); ++it) {
+                    compiled->tags.emplace_back(it.key(), it.value().get<std::string>());
+                }
+            }
+        }
+        
+        if (!compileConditions(rule, expression, compiled->conditions, compiled->hold_conditions)) {
+            return nullptr;
+        }
+        
+        if (expression.contains("keep_firing_for")) {
+            compiled->keep_firing_for = parseDuration(expression["keep_firing_for"].get<std::string>());
+        }
+        
+        if (expression.contains("func") || expression.contains("window")) {
+            std::string func_name = expression.value("func", "");
+            if (!SlidingWindow::parseFunc(func_name, compiled->window_func)) {
+                logError("Rule " + rule.alert_name + " has unsupported window func: " + func_name);
+                return nullptr;
+            }
+            auto window = parseDuration(expression.value("window", ""));
+            if (window.count() <= 0) {
+                logError("Rule " + rule.alert_name + " has invalid window: " + expression.value("window", ""));
+                return nullptr;
+            }
+            if (!isStreamedStable(compiled->stable)) {
+                logError("Rule " + rule.alert_name + " uses a window on " + compiled->stable +
+                         ", which has no ingest stream");
+                return nullptr;
+            }
+            compiled->windowed = true;
+            compiled->window_ms = std::chrono::duration_cast<std::chrono::milliseconds>(window).count();
+        }
+        
+        if (expression.contains("anomaly")) {
+            const auto& anomaly = expression["anomaly"];
+            EwmaParams& params = compiled->anomaly_params;
+            params.alpha = anomaly.value("alpha", params.alpha);
+            params.warmup = anomaly.value("warmup", params.warmup);
+            params.min_stddev = anomaly.value("min_stddev", params.min_stddev);
+            params.clip = anomaly.value("clip", params.clip);
+            std::string direction = anomaly.value("direction", std::string("both"));
+            if (!EwmaBaseline::parseDirection(direction, params.direction)) {
+                logError("Rule " + rule.alert_name + " has unsupported anomaly direction: " + direction);
+                return nullptr;
+            }
+            if (!(params.alpha > 0.0 && params.alpha <= 1.0) || params.warmup < 2 || params.min_stddev < 0.0 ||
+                params.clip < 0.0) {
+                logError("Rule " + rule.alert_name + " has invalid anomaly parameters: " + anomaly.dump());
+                return nullptr;
+            }
+            if (!isStreamedStable(compiled->stable)) {
+                logError("Rule " + rule.alert_name + " uses anomaly detection on " + compiled->stable +
+                         ", which has no ingest stream");
+                return nullptr;
+            }
+            compiled->anomaly = true;
+            // conditions 比较的是偏离分数
+            if (compiled->conditions.empty()) {
+                compiled->conditions.emplace_back(CompareOp::GT, kDefaultAnomalyScore);
+            }
+        }
+        
+        if (expression.contains("predict_full_within")) {
+            compiled->predict_full_within = parseDuration(expression["predict_full_within"].get<std::string>());
+            compiled->capacity = expression.value("capacity", compiled->capacity);
+            if (compiled->predict_full_within.count() <= 0) {
+                logError("Rule " + rule.alert_name + " has invalid predict_full_within: " +
+                         expression["predict_full_within"].dump());
+                return nullptr;
+            }
+            if (compiled->windowed || compiled->anomaly) {
+                logError("Rule " + rule.alert_name + " combines predict_full_within with a window or anomaly detection");
+                return nullptr;
+            }
+            if (!isStreamedStable(compiled->stable)) {
+                logError("Rule " + rule.alert_name + " uses predict_full_within on " + compiled->stable +
+                         ", which has no ingest stream");
+                return nullptr;
+            }
         }
         
-        std::this_thread::sleep_for(m_evaluation_interval);
+        if (expression.contains("absent_for")) {
+            compiled->absent_for = parseDuration(expression["absent_for"].get<std::string>());
+            if (compiled->absent_for.count() <= 0) {
+                logError("Rule " + rule.alert_name + " has invalid absent_for: " + expression["absent_for"].dump());
+                return nullptr;
+            }
+            if (compiled->windowed || compiled->anomaly || compiled->predict_full_within.count() > 0 ||
+                !compiled->conditions.empty()) {
+                logError("Rule " + rule.alert_name + " combines absent_for with conditions, a window, anomaly detection "
+                         "or predict_full_within");
+                return nullptr;
+            }
+            if (!isStreamedStable(compiled->stable)) {
+                logError("Rule " + rule.alert_name + " uses absent_for on " + compiled->stable +
+                         ", which has no ingest stream");
+                return nullptr;
+            }
+        }
+    } catch (const std::exception& e) {
+        logError("Invalid rule expression for " + rule.alert_name + ": " + std::string(e.what()));
+        return nullptr;
+    }
+    
+    return compiled;
+}
+
+/*
+ * 解析表达式的 conditions：hold_conditions 为按 resolve_threshold 生成的恢复条件，没有回差时为空
+ */
+bool AlarmRuleEngine::compileConditions(const AlarmRule& rule, const nlohmann::json& expression,
+                                        std::vector<std::pair<CompareOp, double>>& conditions,
+                                        std::vector<std::pair<CompareOp, double>>& hold_conditions) {
+    bool hysteresis = false;
+    if (expression.contains("conditions") && expression["conditions"].is_array()) {
+        for (const auto& condition : expression["conditions"]) {
+            if (condition.contains("operator") && condition.contains("threshold")) {
+                std::string op_name = condition["operator"].get<std::string>();
+                CompareOp op;
+                if (!parseCompareOp(op_name, op)) {
+                    logError("Rule " + rule.alert_name + " has unsupported operator: " + op_name);
+                    return false;
+                }
+                double threshold = condition["threshold"].get<double>();
+                conditions.emplace_back(op, threshold);
+                
+                // 回差：> / >= 的恢复阈值不高于触发阈值，< / <= 的不低于触发阈值
+                double resolve_threshold = condition.value("resolve_threshold", threshold);
+                bool lower = op == CompareOp::GT || op == CompareOp::GE;
+                bool upper = op == CompareOp::LT || op == CompareOp::LE;
+                if (resolve_threshold != threshold &&
+                    !((lower && resolve_threshold < threshold) || (upper && resolve_threshold > threshold))) {
+                    logError("Rule " + rule.alert_name + " has invalid resolve_threshold " +
+                             std::to_string(resolve_threshold) + " for " + op_name + " " + std::to_string(threshold));
+                    return false;
+                }
+                hysteresis = hysteresis || resolve_threshold != threshold;
+                hold_conditions.emplace_back(op, resolve_threshold);
+            }
+        }
+    }
+    if (!hysteresis) {
+        hold_conditions.clear();
+    }
+    return true;
+}
+
+/*
+ * 编译组合条件规则
+ * 
+ * expression 顶层为 all / any（可嵌套），叶子与单指标规则的表达式相同（stable、metric、tags、conditions），
+ * join 为关联标签，默认 host_ip。叶子不支持窗口、异常检测、耗尽预测和缺失数据。
+ */
+bool AlarmRuleEngine::compileJoinRule(const AlarmRule& rule, const nlohmann::json& expression, CompiledRule& compiled) {
+    static const char* const kSingleMetricFields[] = {
+        "stable", "metric", "func", "window", "anomaly", "predict_full_within", "absent_for", "conditions"};
+    for (const char* field : kSingleMetricFields) {
+        if (expression.contains(field)) {
+            logError("Rule " + rule.alert_name + " combines all/any with " + field + " at the top level");
+            return false;
+        }
+    }
+    
+    compiled.join_on = expression.value("join", std::string(metric_schema::kHostTag));
+    if (compiled.join_on != metric_schema::kHostTag && compiled.join_on != kBoxTag) {
+        logError("Rule " + rule.alert_name + " has unsupported join: " + compiled.join_on);
+        return false;
+    }
+    if (!compileJoinNode(rule, expression, 0, compiled, compiled.join_tree)) {
+        return false;
+    }
+    
+    for (const auto& term : compiled.join_terms) {
+        // 按 box_id 关联时没有 box_id 标签的超级表按 host_ip 查找机箱
+        if (!stableHasLabel(term.stable, compiled.join_on) &&
+            !(compiled.join_on == kBoxTag && stableHasLabel(term.stable, metric_schema::kHostTag))) {
+            logError("Rule " + rule.alert_name + " joins on " + compiled.join_on + ", which " + term.stable +
+                     " does not carry");
+            return false;
+        }
+        compiled.join_hysteresis = compiled.join_hysteresis || !term.hold_conditions.empty();
+    }
+    return true;
+}
+
+bool AlarmRuleEngine::compileJoinNode(const AlarmRule& rule, const nlohmann::json& node, int depth,
+                                      CompiledRule& compiled, JoinNode& result) {
+    if (depth > kMaxJoinDepth || !node.is_object()) {
+        logError("Rule " + rule.alert_name + " has an invalid all/any expression: " + node.dump());
+        return false;
+    }
+    
+    bool all = node.contains("all");
+    bool any = node.contains("any");
+    if (all || any) {
+        const auto& children = all ? node["all"] : node["any"];
+        if ((all && any) || !children.is_array() || children.empty()) {
+            logError("Rule " + rule.alert_name + " has an invalid all/any expression: " + node.dump());
+            return false;
+        }
+        result.all = all;
+        for (const auto& child : children) {
+            result.children.emplace_back();
+            if (!compileJoinNode(rule, child, depth + 1, compiled, result.children.back())) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    if (!node.contains("stable") || !node.contains("metric")) {
+        logError("Rule " + rule.alert_name + " has an all/any term without stable or metric: " + node.dump());
+        return false;
+    }
+    for (const char* field : {"func", "window", "anomaly", "predict_full_within", "absent_for"}) {
+        if (node.contains(field)) {
+            logError("Rule " + rule.alert_name + " uses " + field + " inside all/any");
+            return false;
+        }
+    }
+    JoinTerm term;
+    term.stable = node["stable"].get<std::string>();
+    term.metric = node["metric"].get<std::string>();
+    if (node.contains("tags") && node["tags"].is_array()) {
+        for (const auto& tag_condition : node["tags"]) {
+            for (auto it = tag_condition.begin(); it != tag_condition.end(); ++it) {
+                term.tags.emplace_back(it.key(), it.value().get<std::string>());
+            }
+        }
+    }
+    if (!compileConditions(rule, node, term.conditions, term.hold_conditions)) {
+        return false;
+    }
+    result.term = static_cast<int>(compiled.join_terms.size());
+    compiled.join_terms.push_back(std::move(term));
+    return true;
+}
+
+bool AlarmRuleEngine::parseCompareOp(const std::string& op, CompareOp& result) {
+    if (op == ">") result = CompareOp::GT;
+    else if (op == "<") result = CompareOp::LT;
+    else if (op == ">=") result = CompareOp::GE;
+    else if (op == "<=") result = CompareOp::LE;
+    else if (op == "=") result = CompareOp::EQ;
+    else if (op == "!=") result = CompareOp::NE;
+    else return false;
+    return true;
+}
+
+/*
+ * 执行一个SQL评估周期
+ * 
+ * 超级表和标签过滤相同的规则分为一组，每组执行一次查询取回所需指标的最新值，
+ * 组内各规则的条件在内存中评估。include_streamed 为false时跳过由写入路径推送评估的规则。
+ * 组合条件规则引用的每个超级表再查询一次，得到本周期的共享快照，全部查询完成后各组合条件规则在快照上评估，
+ * 规则和项的数量不增加查询次数。各组、各查询和各组合条件规则在工作线程池中并行执行，本函数等待全部完成后记录周期耗时。
+ */
+void AlarmRuleEngine::evaluateRules(bool include_streamed) {
+    auto cycle_start = std::chrono::steady_clock::now();
+    
+    auto rule_set = currentRuleSet();
+    if (!rule_set) {
+        return;
+    }
+    
+    std::vector<const RuleGroup*> groups;
+    size_t rule_count = 0;
+    for (const auto& group : rule_set->groups) {
+        if (!include_streamed && group.streamed) {
+            continue;
+        }
+        groups.push_back(&group);
+        rule_count += group.rules.size();
+    }
+    
+    // 快照表的结构在任务开始前建好，各任务只写入自己的快照
+    std::map<std::string, JoinSnapshot> snapshots;
+    for (const auto& pair : rule_set->join_fetches) {
+        snapshots[pair.first];
+    }
+    size_t query_count = groups.size() + snapshots.size();
+    rule_count += rule_set->join_rules.size();
+    
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(query_count);
+    for (const RuleGroup* group : groups) {
+        tasks.push_back([this, group]() {
+            try {
+                evaluateRuleGroup(*group);
+            } catch (const std::exception& e) {
+                logError("Failed to evaluate rule group on " + group->stable + ": " + std::string(e.what()));
+            }
+        });
+    }
+    for (const auto& pair : rule_set->join_fetches) {
+        const JoinFetch* fetch = &pair.second;
+        JoinSnapshot* snapshot = &snapshots[pair.first];
+        tasks.push_back([this, fetch, snapshot]() {
+            try {
+                fetchJoinSnapshot(*fetch, *snapshot);
+            } catch (const std::exception& e) {
+                logError("Failed to query " + fetch->stable + " for all/any rules: " + std::string(e.what()));
+            }
+        });
+    }
+    
+    auto run = [this](std::vector<std::function<void()>>& batch) {
+        if (m_worker_pool) {
+            m_worker_pool->runAll(std::move(batch));
+        } else {
+            for (auto& task : batch) {
+                task();
+            }
+        }
+    };
+    run(tasks);
+    
+    std::vector<std::function<void()>> join_tasks;
+    join_tasks.reserve(rule_set->join_rules.size());
+    for (const auto& compiled : rule_set->join_rules) {
+        join_tasks.push_back([this, &compiled, &snapshots]() {
+            try {
+                evaluateJoinRule(compiled, snapshots);
+            } catch (const std::exception& e) {
+                logError("Failed to evaluate rule " + compiled->rule.alert_name + ": " + std::string(e.what()));
+            }
+        });
+    }
+    run(join_tasks);
+    
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - cycle_start).count();
+    bool overrun = duration_ms > std::chrono::duration_cast<std::chrono::milliseconds>(m_evaluation_interval).count();
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_evaluation_stats.cycles++;
+        m_evaluation_stats.total_queries += query_count;
+        m_evaluation_stats.last_cycle_rules = rule_count;
+        m_evaluation_stats.last_cycle_queries = query_count;
+        m_evaluation_stats.last_cycle_duration_ms = duration_ms;
+        m_evaluation_stats.max_cycle_duration_ms = std::max(m_evaluation_stats.max_cycle_duration_ms, duration_ms);
+        if (overrun) {
+            m_evaluation_stats.overruns++;
+        }
+    }
+    if (overrun) {
+        LogManager::getLogger()->warn("Alarm evaluation cycle took {} ms, longer than the {} s evaluation interval",
+                                      duration_ms, m_evaluation_interval.count());
+    }
+    logDebug("Evaluated " + std::to_string(rule_count) + " rules with " + std::to_string(query_count) +
+             " queries in " + std::to_string(duration_ms) + " ms");
+}
+
+void AlarmRuleEngine::evaluateRuleGroup(const RuleGroup& group) {
+    auto query_start = std::chrono::steady_clock::now();
+    std::vector<QueryResult> rows = executeQuery(group.sql);
+    MetricColumns columns = buildMetricColumns(group.metrics, rows);
+    // 组内规则共用一次查询，查询耗时按规则数平分
+    int64_t query_share_us = elapsedUs(query_start) / static_cast<int64_t>(std::max<size_t>(group.rules.size(), 1));
+    
+    for (const auto& compiled : group.rules) {
+        auto rule_start = std::chrono::steady_clock::now();
+        try {
+            evaluateGroupedRule(compiled, rows, columns);
+        } catch (const std::exception& e) {
+            logError("Failed to evaluate rule " + compiled->rule.alert_name + ": " + std::string(e.what()));
+        }
+        recordRuleCost(compiled->rule.alert_name, query_share_us, rows.size(), elapsedUs(rule_start));
+    }
+}
+
+/*
+ * 记录规则一次SQL评估的开销
+ * 
+ * 开销为分摊的查询耗时加上条件评估与状态协调耗时。窗口内平均开销超过预算时标记为慢规则并记录警告，
+ * 回到预算以内时清除标记。用平均值而不是分位数判断：分位数按2的幂分桶，误差可达2倍。
+ * 事件数取两次评估之间 events_total 的增量，包含定时器触发的事件。
+ */
+void AlarmRuleEngine::recordRuleCost(const std::string& alert_name, int64_t query_us, size_t rows,
+                                     int64_t reconcile_us) {
+    auto shard = shardFor(alert_name);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    RuleProfile& profile = shard->profile;
+    
+    int64_t now_ms = toEpochMs(std::chrono::system_clock::now());
+    uint64_t cost_us = static_cast<uint64_t>(std::max<int64_t>(query_us, 0) + std::max<int64_t>(reconcile_us, 0));
+    profile.evaluations++;
+    profile.query_us.observe(now_ms, static_cast<uint64_t>(std::max<int64_t>(query_us, 0)));
+    profile.rows.observe(now_ms, rows);
+    profile.reconcile_us.observe(now_ms, static_cast<uint64_t>(std::max<int64_t>(reconcile_us, 0)));
+    profile.cost_us.observe(now_ms, cost_us);
+    profile.instances.observe(now_ms, shard->instances.size());
+    profile.events.observe(now_ms, profile.events_total - profile.events_recorded);
+    profile.events_recorded = profile.events_total;
+    
+    int64_t budget_us = std::chrono::duration_cast<std::chrono::microseconds>(m_rule_cost_budget).count();
+    if (budget_us <= 0) {
+        profile.over_budget = false;
+        return;
+    }
+    HistogramSummary cost = profile.cost_us.summary(now_ms);
+    uint64_t mean_us = cost.count > 0 ? cost.sum / cost.count : 0;
+    bool over_budget = mean_us > static_cast<uint64_t>(budget_us);
+    if (over_budget && !profile.over_budget) {
+        LogManager::getLogger()->warn("Alarm rule {} is over the evaluation cost budget: mean {} us over {} evaluations, "
+                                      "budget {} ms", alert_name, mean_us, cost.count, m_rule_cost_budget.count());
+    } else if (!over_budget && profile.over_budget) {
+        logInfo("Alarm rule " + alert_name + " is back within the evaluation cost budget");
+    }
+    profile.over_budget = over_budget;
+}
+
+/*
+ * 把分组查询结果转换为列式快照
+ * 
+ * 每行的指标只查找一次，组内所有规则共用同一份快照，条件评估不再逐行查 std::map。
+ */
+AlarmRuleEngine::MetricColumns AlarmRuleEngine::buildMetricColumns(const std::set<std::string>& metrics,
+                                                                   const std::vector<QueryResult>& rows) {
+    MetricColumns snapshot;
+    snapshot.rows = rows.size();
+    for (const auto& metric : metrics) {
+        snapshot.columns.emplace(metric, std::vector<double>(rows.size(), std::numeric_limits<double>::quiet_NaN()));
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (const auto& metric : rows[i].metrics) {
+            auto column_it = snapshot.columns.find(metric.first);
+            if (column_it != snapshot.columns.end()) {
+                column_it->second[i] = metric.second;
+            }
+        }
+    }
+    return snapshot;
+}
+
+/*
+ * 用分组查询的结果评估一条规则
+ * 
+ * 条件在规则指标的列上按列比较（threshold_kernel，SIMD），多个条件的位图按位与，
+ * 只为置位的行生成告警候选。每行是一条序列（子表）的最新值，实例标签为 host_ip 和规则中的标签，
+ * 同一实例下任一序列满足条件即为活动，取第一条满足条件的序列的值。
+ */
+void AlarmRuleEngine::evaluateGroupedRule(const std::shared_ptr<const CompiledRule>& compiled_rule, 
+                                        const std::vector<QueryResult>& rows,
+                                        const MetricColumns& columns) {
+    const CompiledRule& compiled = *compiled_rule;
+    std::unordered_map<FingerprintHash, QueryResult> active_from_db;
+    std::unordered_map<FingerprintHash, QueryResult> held_from_db;
+    
+    auto column_it = columns.columns.find(compiled.metric);
+    if (column_it == columns.columns.end()) {
+        reconcileAlarmStates(compiled_rule, active_from_db, held_from_db);
+        return;
+    }
+    const std::vector<double>& values = column_it->second;
+    
+    std::vector<uint64_t> mask = threshold_kernel::fullMask(values.size());
+    for (const auto& condition : compiled.conditions) {
+        threshold_kernel::compareAnd(values.data(), values.size(), condition.first, condition.second, mask.data());
+    }
+    
+    // 有回差的规则再按恢复阈值生成一个位图，只满足恢复阈值的行不创建新实例，只让已触发的实例保持活动
+    std::vector<uint64_t> hold_mask;
+    if (!compiled.hold_conditions.empty()) {
+        hold_mask = threshold_kernel::fullMask(values.size());
+        for (const auto& condition : compiled.hold_conditions) {
+            threshold_kernel::compareAnd(values.data(), values.size(), condition.first, condition.second, hold_mask.data());
+        }
+        for (size_t w = 0; w < hold_mask.size(); ++w) {
+            hold_mask[w] &= ~mask[w];
+        }
+    }
+    
+    auto collect = [&](std::unordered_map<FingerprintHash, QueryResult>& target, size_t i) {
+        double value = values[i];
+        // 没有条件的规则全部置位，缺失指标的行在这里排除
+        if (std::isnan(value)) {
+            return;
+        }
+        const QueryResult& row = rows[i];
+        
+        QueryResult result;
+        auto host_it = row.labels.find(metric_schema::kHostTag);
+        if (host_it != row.labels.end()) {
+            result.labels[host_it->first] = host_it->second;
+        }
+        for (const auto& tag : compiled.tags) {
+            result.labels[tag.first] = tag.second;
+        }
+        result.metrics[compiled.metric] = value;
+        result.timestamp = row.timestamp;
+        
+        // 每行只计算一次指纹哈希，同一实例保留第一条满足条件的序列
+        FingerprintHash key = hashFingerprint(compiled.rule.alert_name, result.labels);
+        target.emplace(key, std::move(result));
+    };
+    threshold_kernel::forEachSetBit(mask.data(), values.size(), [&](size_t i) { collect(active_from_db, i); });
+    if (!hold_mask.empty()) {
+        threshold_kernel::forEachSetBit(hold_mask.data(), values.size(), [&](size_t i) { collect(held_from_db, i); });
+    }
+    
+    reconcileAlarmStates(compiled_rule, active_from_db, held_from_db);
+}
+
+std::string AlarmRuleEngine::convertGroupToSQL(const RuleGroup& group) {
+    std::ostringstream sql;
+    
+    sql << "SELECT ";
+    for (const auto& metric : group.metrics) {
+        sql << "LAST(" << metric << ") AS " << metric << ", ";
+    }
+    sql << "host_ip FROM " << group.stable;
+    
+    std::vector<std::string> where_conditions;
+    for (const auto& tag : group.tags) {
+        where_conditions.push_back(tag.first + " = '" + tag.second + "'");
+    }
+    where_conditions.push_back("ts > NOW() - 10s");
+    
+    sql << " WHERE ";
+    for (size_t i = 0; i < where_conditions.size(); ++i) {
+        if (i > 0) sql << " AND ";
+        sql << "(" << where_conditions[i] << ")";
+    }
+    
+    // 按子表分组，同一主机的多条序列（多块磁盘、多个网卡）分别取最新值
+    sql << " GROUP BY tbname, host_ip";
+    
+    return sql.str();
+}
+
+
+/*
+ * 组合条件的共享查询：每条序列（子表）一行，取回该超级表上所有组合条件规则引用的指标和标签列，
+ * 标签过滤在内存中按项执行，同一超级表上不同的标签过滤不增加查询
+ */
+std::string AlarmRuleEngine::convertJoinFetchToSQL(const JoinFetch& fetch) {
+    std::ostringstream sql;
+    sql << "SELECT ";
+    for (const auto& metric : fetch.metrics) {
+        sql << "LAST(" << metric << ") AS " << metric << ", ";
+    }
+    for (auto it = fetch.labels.begin(); it != fetch.labels.end(); ++it) {
+        sql << (it == fetch.labels.begin() ? "" : ", ") << *it;
+    }
+    sql << " FROM " << fetch.stable << " WHERE (ts > NOW() - 10s) GROUP BY tbname";
+    for (const auto& label : fetch.labels) {
+        sql << ", " << label;
+    }
+    return sql.str();
+}
+
+// 资源超级表和 bmc_sensor_super 带 host_ip 标签，BMC超级表带 box_id 标签
+bool AlarmRuleEngine::stableHasLabel(const std::string& stable, const std::string& label) {
+    bool bmc_sensor = stable == metric_schema::SensorStable::name();
+    if (label == metric_schema::kHostTag) {
+        return bmc_sensor || isStreamedStable(stable);
+    }
+    if (label == kBoxTag) {
+        return bmc_sensor || stable == kBmcFanStable;
+    }
+    return false;
+}
+
+void AlarmRuleEngine::fetchJoinSnapshot(const JoinFetch& fetch, JoinSnapshot& snapshot) {
+    auto query_start = std::chrono::steady_clock::now();
+    snapshot.rows = executeQuery(fetch.sql);
+    snapshot.columns = buildMetricColumns(fetch.metrics, snapshot.rows);
+    
+    if (fetch.box_join) {
+        snapshot.box_ids.resize(snapshot.rows.size());
+        std::unordered_map<std::string, std::string> located;  // host_ip -> box_id，同一主机的多条序列只查找一次
+        for (size_t i = 0; i < snapshot.rows.size(); ++i) {
+            const auto& labels = snapshot.rows[i].labels;
+            auto box_it = labels.find(kBoxTag);
+            if (box_it != labels.end()) {
+                snapshot.box_ids[i] = box_it->second;
+                continue;
+            }
+            auto host_it = labels.find(metric_schema::kHostTag);
+            if (host_it == labels.end() || !m_host_locator) {
+                continue;
+            }
+            auto cached = located.find(host_it->second);
+            if (cached == located.end()) {
+                int box_id = 0;
+                bool found = m_host_locator(host_it->second, box_id);
+                cached = located.emplace(host_it->second, found ? std::to_string(box_id) : std::string()).first;
+            }
+            snapshot.box_ids[i] = cached->second;
+        }
+    }
+    snapshot.query_share_us = elapsedUs(query_start) / static_cast<int64_t>(std::max<size_t>(fetch.rules, 1));
+    snapshot.ok = true;
+}
+
+/*
+ * 在本周期的共享快照上评估一条组合条件规则
+ * 
+ * 每项按列比较得到满足条件的关联键，all 取交集、any 取并集，实例标签只有关联键，各项的值放入指标。
+ * 有回差的规则再按恢复条件求一次，只满足恢复条件的关联键只让已触发的实例保持活动。
+ */
+void AlarmRuleEngine::evaluateJoinRule(const std::shared_ptr<const CompiledRule>& compiled_rule,
+                                       const std::map<std::string, JoinSnapshot>& snapshots) {
+    const CompiledRule& compiled = *compiled_rule;
+    auto rule_start = std::chrono::steady_clock::now();
+    // 任一项的超级表查询失败时本周期不评估，实例保持原状态；开销按引用的各超级表累计
+    std::set<std::string> stables;
+    int64_t query_us = 0;
+    size_t row_count = 0;
+    for (const auto& term : compiled.join_terms) {
+        auto it = snapshots.find(term.stable);
+        if (it == snapshots.end() || !it->second.ok) {
+            return;
+        }
+        if (stables.insert(term.stable).second) {
+            query_us += it->second.query_share_us;
+            row_count += it->second.rows.size();
+        }
+    }
+    
+    auto collect = [&](const JoinMatches& matches, const JoinMatches* exclude,
+                       std::unordered_map<FingerprintHash, QueryResult>& target) {
+        for (const auto& match : matches) {
+            if (exclude && exclude->count(match.first) > 0) {
+                continue;
+            }
+            QueryResult result;
+            result.labels[compiled.join_on] = match.first;
+            for (const auto& term_value : match.second) {
+                const JoinTerm& term = compiled.join_terms[term_value.first];
+                result.metrics.emplace(term.stable + "." + term.metric, term_value.second);
+            }
+            FingerprintHash key = hashFingerprint(compiled.rule.alert_name, result.labels);
+            target.emplace(key, std::move(result));
+        }
+    };
+    
+    std::unordered_map<FingerprintHash, QueryResult> active_from_db;
+    std::unordered_map<FingerprintHash, QueryResult> held_from_db;
+    JoinMatches active = evaluateJoinNode(compiled, compiled.join_tree, snapshots, false);
+    collect(active, nullptr, active_from_db);
+    if (compiled.join_hysteresis) {
+        collect(evaluateJoinNode(compiled, compiled.join_tree, snapshots, true), &active, held_from_db);
+    }
+    
+    reconcileAlarmStates(compiled_rule, active_from_db, held_from_db);
+    recordRuleCost(compiled.rule.alert_name, query_us, row_count, elapsedUs(rule_start));
+}
+
+AlarmRuleEngine::JoinMatches AlarmRuleEngine::evaluateJoinNode(const CompiledRule& compiled, const JoinNode& node,
+                                                               const std::map<std::string, JoinSnapshot>& snapshots,
+                                                               bool hold) {
+    JoinMatches result;
+    if (node.term >= 0) {
+        size_t term_index = static_cast<size_t>(node.term);
+        matchJoinTerm(compiled, term_index, snapshots.at(compiled.join_terms[term_index].stable), hold, result);
+        return result;
+    }
+    
+    for (size_t i = 0; i < node.children.size(); ++i) {
+        JoinMatches child = evaluateJoinNode(compiled, node.children[i], snapshots, hold);
+        if (i == 0) {
+            result = std::move(child);
+        } else if (node.all) {
+            for (auto it = result.begin(); it != result.end();) {
+                auto child_it = child.find(it->first);
+                if (child_it == child.end()) {
+                    it = result.erase(it);
+                } else {
+                    it->second.insert(child_it->second.begin(), child_it->second.end());
+                    ++it;
+                }
+            }
+        } else {
+            for (auto& pair : child) {
+                result[pair.first].insert(pair.second.begin(), pair.second.end());
+            }
+        }
+        // all 的交集已为空时不再评估其余子节点
+        if (node.all && result.empty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+void AlarmRuleEngine::matchJoinTerm(const CompiledRule& compiled, size_t term_index, const JoinSnapshot& snapshot,
+                                    bool hold, JoinMatches& matches) {
+    const JoinTerm& term = compiled.join_terms[term_index];
+    auto column_it = snapshot.columns.columns.find(term.metric);
+    if (column_it == snapshot.columns.columns.end()) {
+        return;
+    }
+    const std::vector<double>& values = column_it->second;
+    
+    const auto& conditions = hold && !term.hold_conditions.empty() ? term.hold_conditions : term.conditions;
+    std::vector<uint64_t> mask = threshold_kernel::fullMask(values.size());
+    for (const auto& condition : conditions) {
+        threshold_kernel::compareAnd(values.data(), values.size(), condition.first, condition.second, mask.data());
+    }
+    
+    bool box_join = compiled.join_on == kBoxTag;
+    threshold_kernel::forEachSetBit(mask.data(), values.size(), [&](size_t i) {
+        double value = values[i];
+        if (std::isnan(value)) {
+            return;
+        }
+        const QueryResult& row = snapshot.rows[i];
+        for (const auto& tag : term.tags) {
+            auto tag_it = row.labels.find(tag.first);
+            if (tag_it == row.labels.end() || tag_it->second != tag.second) {
+                return;
+            }
+        }
+        
+        const std::string* key = nullptr;
+        if (box_join) {
+            key = &snapshot.box_ids[i];
+        } else {
+            auto host_it = row.labels.find(metric_schema::kHostTag);
+            key = host_it == row.labels.end() ? nullptr : &host_it->second;
+        }
+        if (key == nullptr || key->empty()) {
+            return;
+        }
+        // 同一关联键下保留该项第一条满足条件的序列
+        matches[*key].emplace(term_index, value);
+    });
+}
+
+/*
+ * 状态协调：active_from_db 为满足条件的实例，held_from_db 为只满足恢复阈值（回差）的实例，
+ * 后者不创建新实例，只让已处于 FIRING 的实例保持活动。
+ */
+void AlarmRuleEngine::reconcileAlarmStates(const std::shared_ptr<const CompiledRule>& compiled, 
+                                         const std::unordered_map<FingerprintHash, QueryResult>& active_from_db,
+                                         const std::unordered_map<FingerprintHash, QueryResult>& held_from_db) {
+    const AlarmRule& rule = compiled->rule;
+    auto shard = shardFor(rule.alert_name);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    
+    auto now = std::chrono::system_clock::now();
+    
+    for (const auto& active : active_from_db) {
+        auto it = shard->instances.find(active.first);
+        if (it == shard->instances.end()) {
+            createNewAlarmInstance(shard, active.first, compiled, active.second, now);
+        } else {
+            cancelKeepFiring(*shard, active.first);
+            updateExistingAlarmInstance(it->second, active.second);
+        }
+    }
+    
+    std::unordered_set<FingerprintHash> held;
+    for (const auto& hold : held_from_db) {
+        auto it = shard->instances.find(hold.first);
+        if (it != shard->instances.end() && it->second.state == AlarmInstanceState::FIRING &&
+            active_from_db.find(hold.first) == active_from_db.end()) {
+            cancelKeepFiring(*shard, hold.first);
+            updateExistingAlarmInstance(it->second, hold.second);
+            held.insert(hold.first);
+        }
+    }
+    
+    // 处理已恢复的告警（在previous_state_map中但不在active_from_db中），分片内只有当前规则的实例
+    std::vector<FingerprintHash> to_remove;
+    
+    for (auto& pair : shard->instances) {
+        FingerprintHash key = pair.first;
+        
+        // 如果不在active_from_db中，说明已恢复
+        // 流式评估仍在跟踪的实例以写入路径为准（样本可能尚未落库）
+        if (active_from_db.find(key) == active_from_db.end() && held.count(key) == 0 &&
+            shard->stream_states.find(key) == shard->stream_states.end()) {
+            QueryResult empty_result;
+            // 为空结果添加一个默认指标
+            empty_result.metrics["resolved"] = 0.0;
+            handleResolvedAlarm(*shard, key, pair.second, compiled, empty_result, now);
+            if (pair.second.state == AlarmInstanceState::INACTIVE) {
+                to_remove.push_back(key);
+            }
+        }
+    }
+    
+    for (FingerprintHash key : to_remove) {
+        cancelPendingInstance(*shard, key);
+        shard->instances.erase(key);
+    }
+}
+
+void AlarmRuleEngine::createNewAlarmInstance(const std::shared_ptr<InstanceShard>& shard,
+                                           FingerprintHash key, 
+                                           const std::shared_ptr<const CompiledRule>& compiled, 
+                                           const QueryResult& result, 
+                                           std::chrono::system_clock::time_point now,
+                                           const std::map<std::string, std::string>& extra_labels) {
+    const AlarmRule& rule = compiled->rule;
+    AlarmInstance instance;
+    instance.fingerprint = generateFingerprint(rule.alert_name, result.labels);
+    instance.alert_name = rule.alert_name;
+    instance.state = AlarmInstanceState::PENDING;
+    instance.state_changed_at = now;
+    instance.pending_start_at = now;
+    instance.labels = result.labels;
+    instance.labels["alertname"] = rule.alert_name;
+    instance.labels["severity"] = rule.severity;
+    instance.labels["alert_type"] = rule.alert_type;
+    // 从 metrics map 中获取第一个（通常也是唯一的）指标
+    std::string metric_name = result.metrics.empty() ? "unknown" : result.metrics.begin()->first;
+    double metric_value = result.metrics.empty() ? 0.0 : result.metrics.begin()->second;
+    
+    instance.labels["value"] = std::to_string(metric_value);
+    instance.labels["metrics"] = metric_name;
+    instance.value = metric_value;
+    // 组合条件规则各项的值（超级表.指标）也作为标签，供描述模板使用
+    if (!compiled->join_on.empty()) {
+        for (const auto& metric : result.metrics) {
+            instance.labels[metric.first] = std::to_string(metric.second);
+        }
+    }
+    // 附加标签（如异常检测的样本值和基线）只用于展示和模板，不参与指纹
+    for (const auto& label : extra_labels) {
+        instance.labels[label.first] = label.second;
+    }
+    
+    instance.annotations["summary"] = rule.summary;
+    instance.annotations["description"] = renderTemplate(compiled->description_template, instance.labels);
+    
+    shard->instances[key] = instance;
+    
+    logInfo("Created new alarm instance: " + instance.fingerprint + " (PENDING)" + " " + metric_name + " " + std::to_string(metric_value));
+    
+    schedulePendingInstance(shard, key, compiled, now);
+}
+
+// PENDING 到 FIRING 的转换由时间轮定时器完成，这里只更新当前值
+void AlarmRuleEngine::updateExistingAlarmInstance(AlarmInstance& instance, const QueryResult& result) {
+    // 更新当前值 - 从 metrics map 中获取第一个指标
+    double metric_value = result.metrics.empty() ? 0.0 : result.metrics.begin()->second;
+    instance.value = metric_value;
+    instance.labels["value"] = std::to_string(metric_value);
+    // 组合条件规则创建实例时写入的各项值
+    for (const auto& metric : result.metrics) {
+        auto label_it = instance.labels.find(metric.first);
+        if (label_it != instance.labels.end()) {
+            label_it->second = std::to_string(metric.second);
+        }
+    }
+}
+
+/*
+ * 为新的 PENDING 实例登记触发定时器（调用方持有分片锁）
+ * 
+ * for 为0的规则立即触发，其余在 pending_start_at + for 时刻由定时器线程触发，与评估间隔无关。
+ */
+void AlarmRuleEngine::schedulePendingInstance(const std::shared_ptr<InstanceShard>& shard, 
+                                            FingerprintHash key, 
+                                            const std::shared_ptr<const CompiledRule>& compiled, 
+                                            std::chrono::system_clock::time_point now) {
+    if (compiled->for_duration <= std::chrono::seconds(0)) {
+        fireInstance(*shard, key, compiled->rule, now);
+        return;
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + compiled->for_duration;
+    shard->fire_timers[key] = scheduleTimer(deadline, InstanceTimer{InstanceTimer::Kind::FIRE, shard, key, compiled});
+}
+
+// 条件不再满足时取消尚未到期的触发定时器（调用方持有分片锁）
+void AlarmRuleEngine::cancelPendingInstance(InstanceShard& shard, FingerprintHash key) {
+    auto it = shard.fire_timers.find(key);
+    if (it == shard.fire_timers.end()) {
+        return;
+    }
+    cancelTimer(it->second);
+    shard.fire_timers.erase(it);
+}
+
+void AlarmRuleEngine::fireInstance(InstanceShard& shard, 
+                                 FingerprintHash key, 
+                                 const AlarmRule& rule, 
+                                 std::chrono::system_clock::time_point now) {
+    auto it = shard.instances.find(key);
+    if (it == shard.instances.end() || it->second.state != AlarmInstanceState::PENDING) {
+        return;
+    }
+    
+    AlarmInstance& instance = it->second;
+    instance.state = AlarmInstanceState::FIRING;
+    instance.state_changed_at = now;
+    generateAlarmEvent(shard, key, instance, rule, "firing");
+    logInfo("Alarm instance " + instance.fingerprint + " transitioned to FIRING");
+}
+
+uint64_t AlarmRuleEngine::scheduleTimer(std::chrono::steady_clock::time_point deadline, InstanceTimer timer) {
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    return m_timer_wheel.schedule(deadline, std::move(timer));
+}
+
+void AlarmRuleEngine::cancelTimer(uint64_t timer_id) {
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    m_timer_wheel.cancel(timer_id);
+}
+
+/*
+ * 定时器线程
+ * 
+ * 每个时间轮刻度推进一次，只处理到期的定时器。到期定时器在释放 m_timer_mutex 后逐个处理，
+ * 处理时在分片锁内核对定时器ID，已被取消或替换的定时器直接忽略。
+ */
+void AlarmRuleEngine::timerLoop() {
+    std::vector<std::pair<uint64_t, InstanceTimer>> expired;
+    
+    while (m_running) {
+        {
+            std::unique_lock<std::mutex> lock(m_timer_mutex);
+            m_timer_cv.wait_for(lock, m_timer_wheel.tick(), [this] { return !m_running; });
+            if (!m_running) {
+                break;
+            }
+            m_timer_wheel.advance(std::chrono::steady_clock::now(), expired);
+        }
+        
+        for (const auto& entry : expired) {
+            try {
+                if (entry.second.kind == InstanceTimer::Kind::FIRE) {
+                    onFireTimer(entry.second, entry.first);
+                } else if (entry.second.kind == InstanceTimer::Kind::EXPIRE) {
+                    onExpireTimer(entry.second, entry.first);
+                } else if (entry.second.kind == InstanceTimer::Kind::ABSENT) {
+                    onAbsentTimer(entry.second, entry.first);
+                } else if (entry.second.kind == InstanceTimer::Kind::KEEP_FIRING) {
+                    onKeepFiringTimer(entry.second, entry.first);
+                } else if (entry.second.kind == InstanceTimer::Kind::FLAP) {
+                    onFlapTimer(entry.second, entry.first);
+                } else if (entry.second.kind == InstanceTimer::Kind::BASELINE) {
+                    onBaselineTimer(entry.second);
+                } else {
+                    onWindowTimer(entry.second);
+                }
+            } catch (const std::exception& e) {
+                logError("Error handling alarm timer: " + std::string(e.what()));
+            }
+        }
+        expired.clear();
+    }
+}
+
+void AlarmRuleEngine::onFireTimer(const InstanceTimer& timer, uint64_t timer_id) {
+    std::lock_guard<std::mutex> lock(timer.shard->mutex);
+    
+    auto it = timer.shard->fire_timers.find(timer.key);
+    if (it == timer.shard->fire_timers.end() || it->second != timer_id) {
+        return;
+    }
+    timer.shard->fire_timers.erase(it);
+    
+    fireInstance(*timer.shard, timer.key, timer.rule->rule, std::chrono::system_clock::now());
+}
+
+/*
+ * 条件不再满足
+ * 
+ * 规则设置了 keep_firing_for 时，FIRING 实例先登记保持定时器并继续保持 FIRING，期间条件重新满足则取消定时器，
+ * 定时器到期（登记值置0）后才真正恢复。
+ */
+void AlarmRuleEngine::handleResolvedAlarm(InstanceShard& shard, 
+                                        FingerprintHash key, 
+                                        AlarmInstance& instance, 
+                                        const std::shared_ptr<const CompiledRule>& compiled, 
+                                        const QueryResult& result,
+                                        std::chrono::system_clock::time_point now) {
+    if (instance.state == AlarmInstanceState::FIRING && compiled->keep_firing_for.count() > 0) {
+        auto keep_it = shard.keep_firing_timers.find(key);
+        if (keep_it == shard.keep_firing_timers.end()) {
+            shard.keep_firing_timers[key] = scheduleTimer(
+                std::chrono::steady_clock::now() + compiled->keep_firing_for,
+                InstanceTimer{InstanceTimer::Kind::KEEP_FIRING, shard.shared_from_this(), key, compiled});
+            return;
+        }
+        if (keep_it->second != 0) {
+            return;
+        }
+        shard.keep_firing_timers.erase(keep_it);
+    }
+    
+    if (instance.state == AlarmInstanceState::FIRING) {
+        instance.state = AlarmInstanceState::RESOLVED;
+        instance.state_changed_at = now;
+        generateAlarmEvent(shard, key, instance, compiled->rule, "resolved");
+        logInfo("Alarm instance " + instance.fingerprint + " RESOLVED");
+        
+        instance.state = AlarmInstanceState::INACTIVE;
+    } else if (instance.state == AlarmInstanceState::PENDING) {
+        instance.state = AlarmInstanceState::INACTIVE;
+        instance.state_changed_at = now;
+        logInfo("Alarm instance " + instance.fingerprint + " transitioned from PENDING to INACTIVE");
+    }
+}
+
+/*
+ * 生成告警事件
+ * 
+ * 开启抖动检测时每个事件先计入实例的状态变化窗口；实例处于抖动状态时事件被抑制，
+ * 抖动结束时由 onFlapTimer 按实例当时的状态补发一个事件，使外部看到的状态与实例一致。
+ */
+void AlarmRuleEngine::generateAlarmEvent(InstanceShard& shard, 
+                                       FingerprintHash key, 
+                                       const AlarmInstance& instance, 
+                                       const AlarmRule& rule, 
+                                       const std::string& status) {
+    AlarmEvent event = makeAlarmEvent(instance, status);
+    
+    if (m_flap_threshold > 0) {
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        auto flap_it = shard.flap_states.find(key);
+        if (flap_it == shard.flap_states.end()) {
+            int64_t window_ms = std::chrono::duration_cast<std::chrono::milliseconds>(m_flap_window).count();
+            flap_it = shard.flap_states.emplace(key, FlapState(FlapDetector(window_ms, m_flap_threshold))).first;
+        }
+        FlapState& flap = flap_it->second;
+        bool was_flapping = flap.detector.flapping();
+        bool flapping = flap.detector.record(now_ms);
+        if (flap.timer == 0) {
+            flap.timer = scheduleTimer(std::chrono::steady_clock::now() + m_flap_window,
+                                       InstanceTimer{InstanceTimer::Kind::FLAP, shard.shared_from_this(), key, nullptr});
+        }
+        if (flapping) {
+            if (!was_flapping) {
+                logInfo("Alarm instance " + instance.fingerprint + " is flapping, suppressing events");
+            }
+            m_suppressed_events.fetch_add(1);
+            return;
+        }
+        flap.last_event = event;
+        flap.has_last_event = true;
+    }
+    
+    shard.profile.events_total++;
+    publishAlarmEvent(event);
+}
+
+AlarmEvent AlarmRuleEngine::makeAlarmEvent(const AlarmInstance& instance, const std::string& status) {
+    AlarmEvent event;
+    event.fingerprint = instance.fingerprint;
+    event.status = status;
+    event.labels = instance.labels;
+    event.annotations = instance.annotations;
+    event.starts_at = instance.pending_start_at;
+    
+    if (status == "resolved") {
+        event.ends_at = instance.state_changed_at;
+    }
+    return event;
+}
+
+void AlarmRuleEngine::publishAlarmEvent(const AlarmEvent& event) {
+    logInfo("Generated alarm event: " + event.toJson());
+    
+    if (m_alarm_event_callback) {
+        m_alarm_event_callback(event);
+    }
+}
+
+bool AlarmRuleEngine::isStreamedStable(const std::string& stable) {
+    static const std::set<std::string> streamed = [] {
+        std::set<std::string> names;
+        metric_schema::forEach(metric_schema::ResourceStables(), [&](auto stable_schema, auto) {
+            names.insert(decltype(stable_schema)::name());
+        });
+        return names;
+    }();
+    return streamed.count(stable) > 0;
+}
+
+/*
+ * 写入路径推送的样本
+ * 
+ * 先把趋势索引关注的指标计入各序列的趋势，再按超级表找到引用它的规则并在进程内评估条件，不执行SQL。
+ * 轮询模式下只评估窗口条件、异常检测、耗尽预测和缺失数据规则，其余规则由SQL评估。
+ */
+void AlarmRuleEngine::ingestSamples(const std::vector<MetricSample>& samples) {
+    if (!m_running) {
+        return;
+    }
+    bool streaming = m_evaluation_mode == AlarmEvaluationMode::STREAMING;
+    
+    auto rule_set = currentRuleSet();
+    if (!rule_set) {
+        return;
+    }
+    const StreamRuleIndex& index = rule_set->stream_index;
+    
+    auto now = std::chrono::system_clock::now();
+    int64_t now_ms = toEpochMs(now);
+    std::vector<std::pair<const std::string*, LinearTrend>> trends;
+    
+    for (const auto& sample : samples) {
+        // 趋势按到达时间计入，与窗口聚合一致
+        trends.clear();
+        auto target_it = rule_set->forecast_targets.find(sample.stable);
+        if (target_it != rule_set->forecast_targets.end()) {
+            for (const auto& metric : target_it->second) {
+                auto metric_it = sample.data.metrics.find(metric);
+                if (metric_it != sample.data.metrics.end()) {
+                    trends.emplace_back(&metric, m_forecasts.observe(sample.stable, metric, sample.data.labels,
+                                                                     now_ms, metric_it->second));
+                }
+            }
+        }
+        
+        auto it = index.find(sample.stable);
+        if (it == index.end()) {
+            continue;
+        }
+        for (const auto& stream_rule : it->second) {
+            bool absent = stream_rule->absent_for.count() > 0;
+            bool forecast = stream_rule->predict_full_within.count() > 0;
+            if (!streaming && !stream_rule->windowed && !stream_rule->anomaly && !forecast && !absent) {
+                continue;
+            }
+            try {
+                if (absent) {
+                    observeAbsentSeries(stream_rule, sample, now);
+                } else {
+                    const LinearTrend* trend = nullptr;
+                    for (const auto& entry : trends) {
+                        if (*entry.first == stream_rule->metric) {
+                            trend = &entry.second;
+                        }
+                    }
+                    if (forecast && !trend) {
+                        continue;
+                    }
+                    evaluateStreamSample(stream_rule, sample, now, trend);
+                }
+            } catch (const std::exception& e) {
+                logError("Failed to evaluate sample for rule " + stream_rule->rule.alert_name + ": " + std::string(e.what()));
+            }
+        }
+    }
+}
+
+/*
+ * 评估一条样本
+ * 
+ * 实例标签与SQL评估的 GROUP BY 一致（host_ip + 规则中的标签），同一实例下可能有多条序列（如多块磁盘），
+ * 任一序列满足条件即保持活动，全部序列不再满足时恢复。
+ */
+void AlarmRuleEngine::evaluateStreamSample(const std::shared_ptr<const CompiledRule>& stream_rule, 
+                                         const MetricSample& sample, 
+                                         std::chrono::system_clock::time_point now,
+                                         const LinearTrend* trend) {
+    const auto& sample_labels = sample.data.labels;
+    auto metric_it = sample.data.metrics.find(stream_rule->metric);
+    if (metric_it == sample.data.metrics.end()) {
+        return;
+    }
+    
+    std::map<std::string, std::string> labels;
+    auto host_it = sample_labels.find(metric_schema::kHostTag);
+    if (host_it != sample_labels.end()) {
+        labels[host_it->first] = host_it->second;
+    }
+    for (const auto& tag : stream_rule->tags) {
+        auto it = sample_labels.find(tag.first);
+        if (it == sample_labels.end() || it->second != tag.second) {
+            return;
+        }
+        labels[tag.first] = it->second;
+    }
+    
+    const AlarmRule& rule = stream_rule->rule;
+    FingerprintHash key = hashFingerprint(rule.alert_name, labels);
+    FingerprintHash series_key = hashFingerprint(stream_rule->metric, sample_labels);
+    
+    auto shard = shardFor(rule.alert_name);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    
+    // 窗口条件比较的是序列在窗口内的聚合值，窗口内样本不足时（如 rate 只有一个样本）不改变实例状态
+    double value = metric_it->second;
+    if (stream_rule->windowed && !aggregateWindow(shard, series_key, stream_rule, value)) {
+        return;
+    }
+    // 异常检测比较的是（窗口聚合后的）值相对基线的偏离分数，基线预热期内同样不改变实例状态
+    std::map<std::string, std::string> extra_labels;
+    if (stream_rule->anomaly && !scoreAnomaly(shard, series_key, stream_rule, value, extra_labels)) {
+        return;
+    }
+    // 耗尽预测与 conditions 同时满足才算满足，conditions 仍比较当前值；趋势样本不足时不改变实例状态
+    bool predicted = true;
+    if (stream_rule->predict_full_within.count() > 0) {
+        double seconds = 0.0;
+        double level = 0.0;
+        double slope = 0.0;
+        if (!trend || !trend->fit(m_forecasts.minSpanSeconds(), level, slope)) {
+            return;
+        }
+        predicted = predictExhaustion(*stream_rule, level, slope, seconds);
+        if (predicted) {
+            extra_labels["time_to_full"] = formatRemaining(seconds);
+            extra_labels["predicted_full_at"] = formatTimestamp(
+                now + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(seconds)));
+        }
+    }
+    
+    bool matched = predicted && evaluateConditions(stream_rule->conditions, value);
+    auto state_it = shard->stream_states.find(key);
+    
+    // 回差：FIRING 实例中已活动的序列只要满足恢复阈值就保持活动，PENDING 实例仍需持续满足触发阈值
+    if (!matched && !stream_rule->hold_conditions.empty() && state_it != shard->stream_states.end() &&
+        state_it->second.series.count(series_key) > 0) {
+        auto instance_it = shard->instances.find(key);
+        if (instance_it != shard->instances.end() && instance_it->second.state == AlarmInstanceState::FIRING) {
+            matched = predicted && evaluateConditions(stream_rule->hold_conditions, value);
+        }
+    }
+    
+    if (!matched) {
+        if (state_it != shard->stream_states.end()) {
+            state_it->second.series.erase(series_key);
+            if (!state_it->second.series.empty()) {
+                return;
+            }
+            cancelTimer(state_it->second.expiry_timer);
+            shard->stream_states.erase(state_it);
+        }
+        resolveStreamInstance(*shard, key, stream_rule, now);
+        return;
+    }
+    
+    StreamInstanceState& state = shard->stream_states[key];
+    state.rule = stream_rule;
+    state.series[series_key] = now;
+    if (state.expiry_timer == 0) {
+        state.expiry_timer = scheduleTimer(std::chrono::steady_clock::now() + kStreamSeriesWindow,
+                                           InstanceTimer{InstanceTimer::Kind::EXPIRE, shard, key, stream_rule});
+    }
+    
+    auto instance_it = shard->instances.find(key);
+    if (instance_it == shard->instances.end()) {
+        QueryResult result;
+        result.labels = labels;
+        result.metrics[stream_rule->metric] = value;
+        result.timestamp = sample.data.timestamp;
+        createNewAlarmInstance(shard, key, stream_rule, result, now, extra_labels);
+    } else {
+        cancelKeepFiring(*shard, key);
+        instance_it->second.value = value;
+        instance_it->second.labels["value"] = std::to_string(value);
+        for (const auto& label : extra_labels) {
+            instance_it->second.labels[label.first] = label.second;
+        }
+    }
+}
+
+void AlarmRuleEngine::resolveStreamInstance(InstanceShard& shard,
+                                          FingerprintHash key, 
+                                          const std::shared_ptr<const CompiledRule>& compiled, 
+                                          std::chrono::system_clock::time_point now) {
+    auto it = shard.instances.find(key);
+    if (it == shard.instances.end()) {
+        return;
+    }
+    
+    QueryResult empty_result;
+    empty_result.metrics["resolved"] = 0.0;
+    handleResolvedAlarm(shard, key, it->second, compiled, empty_result, now);
+    if (it->second.state == AlarmInstanceState::INACTIVE) {
+        cancelPendingInstance(shard, key);
+        shard.instances.erase(it);
+    }
+}
+
+/*
+ * 流式实例的过期定时器
+ * 
+ * 每个流式实例只有一个定时器，指向最早一条序列的过期时间；写入新样本只刷新序列时间，不重新登记。
+ * 到期时删除超过窗口未再满足条件的序列（主机停止上报等），全部过期则实例恢复，否则按剩余序列中最早的时间重新登记。
+ */
+void AlarmRuleEngine::onExpireTimer(const InstanceTimer& timer, uint64_t timer_id) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.stream_states.find(timer.key);
+    if (it == shard.stream_states.end() || it->second.expiry_timer != timer_id) {
+        return;
+    }
+    
+    auto now = std::chrono::system_clock::now();
+    auto cutoff = now - kStreamSeriesWindow;
+    auto& series = it->second.series;
+    auto earliest = now;
+    for (auto series_it = series.begin(); series_it != series.end();) {
+        if (series_it->second < cutoff) {
+            series_it = series.erase(series_it);
+        } else {
+            earliest = std::min(earliest, series_it->second);
+            ++series_it;
+        }
+    }
+    
+    if (series.empty()) {
+        std::shared_ptr<const CompiledRule> stream_rule = it->second.rule;
+        shard.stream_states.erase(it);
+        resolveStreamInstance(shard, timer.key, stream_rule, now);
+        return;
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + (earliest + kStreamSeriesWindow - now);
+    it->second.expiry_timer = scheduleTimer(deadline, timer);
+}
+
+/*
+ * 窗口聚合
+ * 
+ * 样本按到达时间加入序列的滑动窗口（与流式序列的过期窗口一致，不受上报端时钟偏差影响）。
+ * 新建窗口时登记一个回收定时器，序列停止上报超过窗口长度后释放其聚合状态。
+ */
+bool AlarmRuleEngine::aggregateWindow(const std::shared_ptr<InstanceShard>& shard, 
+                                    FingerprintHash series_key, 
+                                    const std::shared_ptr<const CompiledRule>& compiled, 
+                                    double& value) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    auto it = shard->windows.find(series_key);
+    if (it == shard->windows.end()) {
+        it = shard->windows.emplace(series_key, SlidingWindow(compiled->window_func, compiled->window_ms)).first;
+        scheduleTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(compiled->window_ms),
+                      InstanceTimer{InstanceTimer::Kind::WINDOW, shard, series_key, compiled});
+    } else if (it->second.func() != compiled->window_func || it->second.windowMs() != compiled->window_ms) {
+        // 规则修改了窗口函数或长度，重新累计
+        it->second = SlidingWindow(compiled->window_func, compiled->window_ms);
+    }
+    
+    it->second.add(now_ms, value);
+    return it->second.value(value);
+}
+
+void AlarmRuleEngine::onWindowTimer(const InstanceTimer& timer) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.windows.find(timer.key);
+    if (it == shard.windows.end()) {
+        return;
+    }
+    
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t idle_deadline_ms = it->second.lastTimestamp() + timer.rule->window_ms;
+    if (now_ms >= idle_deadline_ms) {
+        shard.windows.erase(it);
+        return;
+    }
+    
+    scheduleTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(idle_deadline_ms - now_ms), timer);
+}
+
+/*
+ * 异常检测
+ * 
+ * 每条序列一个 EWMA 均值/方差基线（ewma_baseline.h），样本按到达时间计入，先用计入前的基线计算偏离分数。
+ * 新建基线时登记一个回收定时器，序列停止上报超过 kAnomalyBaselineIdle 后释放。
+ * baseline_labels 输出样本值（observed）和基线均值（baseline），供描述模板使用。
+ */
+bool AlarmRuleEngine::scoreAnomaly(const std::shared_ptr<InstanceShard>& shard, 
+                                 FingerprintHash series_key, 
+                                 const std::shared_ptr<const CompiledRule>& compiled, 
+                                 double& value, 
+                                 std::map<std::string, std::string>& baseline_labels) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    auto it = shard->baselines.find(series_key);
+    if (it == shard->baselines.end()) {
+        it = shard->baselines.emplace(series_key, EwmaBaseline()).first;
+        scheduleTimer(std::chrono::steady_clock::now() + kAnomalyBaselineIdle,
+                      InstanceTimer{InstanceTimer::Kind::BASELINE, shard, series_key, compiled});
+    }
+    
+    double observed = value;
+    double baseline = it->second.mean();
+    if (!it->second.update(compiled->anomaly_params, now_ms, observed, value)) {
+        return false;
+    }
+    baseline_labels["observed"] = std::to_string(observed);
+    baseline_labels["baseline"] = std::to_string(baseline);
+    return true;
+}
+
+bool AlarmRuleEngine::predictExhaustion(const CompiledRule& compiled, double level, double slope, double& seconds) {
+    return LinearTrend::timeToReach(level, slope, compiled.capacity, seconds) &&
+           seconds <= static_cast<double>(compiled.predict_full_within.count());
+}
+
+void AlarmRuleEngine::onBaselineTimer(const InstanceTimer& timer) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.baselines.find(timer.key);
+    if (it == shard.baselines.end()) {
+        return;
+    }
+    
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t idle_deadline_ms = it->second.lastTimestamp() +
+        std::chrono::duration_cast<std::chrono::milliseconds>(kAnomalyBaselineIdle).count();
+    if (now_ms >= idle_deadline_ms) {
+        shard.baselines.erase(it);
+        return;
+    }
+    
+    scheduleTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(idle_deadline_ms - now_ms), timer);
+}
+
+/*
+ * 缺失数据规则：记录序列最近一次样本的到达时间
+ * 
+ * 实例标签为序列的全部标签（host_ip 与超级表标签），缺失的是哪块磁盘、哪个网卡即哪个实例。
+ * 序列第一次出现时登记 last_seen + absent_for 的定时器，之后的样本只刷新 last_seen，不重新登记；
+ * 已缺失的序列重新出现时登记新的定时器，实例恢复。
+ */
+void AlarmRuleEngine::observeAbsentSeries(const std::shared_ptr<const CompiledRule>& absent_rule, 
+                                        const MetricSample& sample, 
+                                        std::chrono::system_clock::time_point now) {
+    const auto& sample_labels = sample.data.labels;
+    auto metric_it = sample.data.metrics.find(absent_rule->metric);
+    if (metric_it == sample.data.metrics.end()) {
+        return;
+    }
+    for (const auto& tag : absent_rule->tags) {
+        auto it = sample_labels.find(tag.first);
+        if (it == sample_labels.end() || it->second != tag.second) {
+            return;
+        }
+    }
+    
+    const AlarmRule& rule = absent_rule->rule;
+    FingerprintHash key = hashFingerprint(rule.alert_name, sample_labels);
+    
+    auto shard = shardFor(rule.alert_name);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    
+    AbsentSeries& series = shard->absent_series[key];
+    if (series.labels.empty()) {
+        series.labels = sample_labels;
+    }
+    series.last_seen = now;
+    series.last_value = metric_it->second;
+    if (series.timer == 0) {
+        series.timer = scheduleTimer(std::chrono::steady_clock::now() + absent_rule->absent_for,
+                                     InstanceTimer{InstanceTimer::Kind::ABSENT, shard, key, absent_rule});
+    }
+    resolveStreamInstance(*shard, key, absent_rule, now);
+}
+
+/*
+ * 缺失数据规则的定时器
+ * 
+ * 到期时序列若在此期间有过样本，按 last_seen + absent_for 重新登记；否则序列已缺失，创建实例（之后按 for 时长触发），
+ * 定时器不再登记，直到序列重新出现。规则已删除或不再是缺失数据规则时丢弃序列。
+ */
+void AlarmRuleEngine::onAbsentTimer(const InstanceTimer& timer, uint64_t timer_id) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    auto it = shard.absent_series.find(timer.key);
+    if (it == shard.absent_series.end() || it->second.timer != timer_id) {
+        return;
+    }
+    
+    std::shared_ptr<const CompiledRule> absent_rule;
+    if (auto rule_set = currentRuleSet()) {
+        auto rule_it = rule_set->by_name.find(timer.rule->rule.alert_name);
+        if (rule_it != rule_set->by_name.end() && rule_it->second->absent_for.count() > 0) {
+            absent_rule = rule_it->second;
+        }
+    }
+    if (!absent_rule) {
+        shard.absent_series.erase(it);
+        return;
+    }
+    
+    AbsentSeries& series = it->second;
+    auto now = std::chrono::system_clock::now();
+    auto deadline = series.last_seen + absent_rule->absent_for;
+    if (deadline > now) {
+        series.timer = scheduleTimer(std::chrono::steady_clock::now() + (deadline - now),
+                                     InstanceTimer{InstanceTimer::Kind::ABSENT, timer.shard, timer.key, absent_rule});
+        return;
+    }
+    
+    series.timer = 0;
+    cancelKeepFiring(shard, timer.key);
+    if (shard.instances.count(timer.key) == 0) {
+        QueryResult result;
+        result.labels = series.labels;
+        result.metrics[absent_rule->metric] = series.last_value;
+        logInfo("No " + absent_rule->metric + " data for " + std::to_string(absent_rule->absent_for.count()) +
+                "s: " + generateFingerprint(absent_rule->rule.alert_name, series.labels));
+        createNewAlarmInstance(timer.shard, timer.key, absent_rule, result, now);
     }
 }
 
-void AlarmRuleEngine::loadRulesFromDatabase() {
-    try {
-        std::lock_guard<std::mutex> lock(m_rules_mutex);
-        m_rules = m_rule_storage->getEnabledAlarmRules();
-        logDebug("Loaded " + std::to_string(m_rules.size()) + " alarm rules from database");
-    } catch (const std::exception& e) {
-        logError("Failed to load rules from database: " + std::string(e.what()));
+// 条件重新满足，取消 keep_firing_for 保持（调用方持有分片锁）
+void AlarmRuleEngine::cancelKeepFiring(InstanceShard& shard, FingerprintHash key) {
+    auto it = shard.keep_firing_timers.find(key);
+    if (it == shard.keep_firing_timers.end()) {
+        return;
     }
+    if (it->second != 0) {
+        cancelTimer(it->second);
+    }
+    shard.keep_firing_timers.erase(it);
 }
 
-void AlarmRuleEngine::evaluateRules() {
-    std::lock_guard<std::mutex> lock(m_rules_mutex);
+void AlarmRuleEngine::onKeepFiringTimer(const InstanceTimer& timer, uint64_t timer_id) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    for (const auto& rule : m_rules) {
-        try {
-            evaluateRule(rule);
-        } catch (const std::exception& e) {
-            logError("Failed to evaluate rule " + rule.alert_name + ": " + std::string(e.what()));
-        }
+    auto keep_it = shard.keep_firing_timers.find(timer.key);
+    if (keep_it == shard.keep_firing_timers.end() || keep_it->second != timer_id) {
+        return;
+    }
+    keep_it->second = 0;
+    
+    auto it = shard.instances.find(timer.key);
+    if (it == shard.instances.end()) {
+        shard.keep_firing_timers.erase(keep_it);
+        return;
+    }
+    QueryResult empty_result;
+    empty_result.metrics["resolved"] = 0.0;
+    handleResolvedAlarm(shard, timer.key, it->second, timer.rule, empty_result, std::chrono::system_clock::now());
+    if (it->second.state == AlarmInstanceState::INACTIVE) {
+        cancelPendingInstance(shard, timer.key);
+        shard.instances.erase(it);
     }
 }
 
-void AlarmRuleEngine::evaluateRule(const AlarmRule& rule) {
-    logDebug("Evaluating rule: " + rule.alert_name);
+/*
+ * 抖动检测窗口结束
+ * 
+ * 最近一次状态变化之后一个完整窗口内没有新的变化时回收抖动状态。实例处于抖动状态时，
+ * 按实例当前状态与最近一次实际发送的事件补发 firing 或 resolved，之后的事件照常发送。
+ */
+void AlarmRuleEngine::onFlapTimer(const InstanceTimer& timer, uint64_t timer_id) {
+    InstanceShard& shard = *timer.shard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    nlohmann::json expression;
-    try {
-        expression = nlohmann::json::parse(rule.expression_json);
-    } catch (const std::exception& e) {
-        logError("Failed to parse rule expression for " + rule.alert_name + ": " + std::string(e.what()));
+    auto flap_it = shard.flap_states.find(timer.key);
+    if (flap_it == shard.flap_states.end() || flap_it->second.timer != timer_id) {
         return;
     }
+    FlapState& flap = flap_it->second;
     
-    if (!expression.contains("stable") || !expression.contains("metric")) {
-        logError("Rule " + rule.alert_name + " missing required fields: stable or metric");
+    auto now = std::chrono::system_clock::now();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    if (!flap.detector.quiet(now_ms)) {
+        flap.timer = scheduleTimer(std::chrono::steady_clock::now() +
+                                   std::chrono::milliseconds(flap.detector.quietAt() - now_ms), timer);
         return;
     }
     
-    std::string stable = expression["stable"];
-    std::string metric = expression["metric"];
+    if (flap.detector.flapping()) {
+        auto it = shard.instances.find(timer.key);
+        bool firing = it != shard.instances.end() && it->second.state == AlarmInstanceState::FIRING;
+        bool notified_firing = flap.has_last_event && flap.last_event.status == "firing";
+        if (notified_firing && !firing) {
+            AlarmEvent event = flap.last_event;
+            event.status = "resolved";
+            event.ends_at = now;
+            shard.profile.events_total++;
+            publishAlarmEvent(event);
+        } else if (firing && !notified_firing) {
+            shard.profile.events_total++;
+            publishAlarmEvent(makeAlarmEvent(it->second, "firing"));
+        }
+        logInfo("Alarm instance " + (flap.has_last_event ? flap.last_event.fingerprint : std::string()) +
+                " stopped flapping (" + (firing ? "firing" : "resolved") + ")");
+    }
+    shard.flap_states.erase(flap_it);
+}
+
+/*
+ * 规则回测
+ * 
+ * 按主机把历史数据划分为互不相关的分区（实例标签总是包含 host_ip），各分区在临时线程池中并行回放，
+ * 每个分区按时间顺序逐行扫描查询结果，不在内存中累积原始样本。回放与写入路径的流式评估使用相同的
+ * 状态机：条件满足进入 PENDING，到达 for 时长转为 FIRING，序列不再满足（回差规则为不再满足恢复阈值）或超过10秒
+ * 没有满足条件的样本时恢复，keep_firing_for 和抖动抑制与运行中的引擎一致；
+ * 时钟取样本时间戳，定时器的到期在处理下一行之前结算。窗口条件从 start_ms - window 开始预热窗口。
+ * 线程池中的分区任务继承调用线程的查询截止时间，任一分区超时则标记调用线程的截止时间上下文并返回失败。
+ */
+bool AlarmRuleEngine::backtestRule(const AlarmRule& rule, int64_t start_ms, int64_t end_ms, size_t max_events,
+                                   AlarmBacktestResult& result, std::string& error) {
+    auto begin = std::chrono::steady_clock::now();
+    result = AlarmBacktestResult();
     
-    std::string sql = convertRuleToSQL(expression, stable, metric);
-    if (sql.empty()) {
-        logError("Failed to convert rule to SQL for " + rule.alert_name);
-        return;
+    if (end_ms <= start_ms) {
+        error = "end must be later than start";
+        return false;
+    }
+    auto compiled = compileRule(rule);
+    if (!compiled) {
+        error = "Invalid rule expression";
+        return false;
+    }
+    if (compiled->absent_for.count() > 0) {
+        error = "absent_for rules cannot be backtested";
+        return false;
+    }
+    if (!compiled->join_on.empty()) {
+        error = "all/any rules cannot be backtested";
+        return false;
+    }
+    
+    // 分区：超级表中满足标签过滤的主机
+    std::ostringstream hosts_sql;
+    hosts_sql << "SELECT DISTINCT " << metric_schema::kHostTag << " FROM " << compiled->stable;
+    for (size_t i = 0; i < compiled->tags.size(); ++i) {
+        hosts_sql << (i == 0 ? " WHERE " : " AND ")
+                  << "(" << compiled->tags[i].first << " = '" << compiled->tags[i].second << "')";
+    }
+    std::vector<std::string> hosts;
+    try {
+        for (const auto& row : m_resource_storage->executeQuerySQL(hosts_sql.str())) {
+            auto host_it = row.labels.find(metric_schema::kHostTag);
+            if (host_it != row.labels.end()) {
+                hosts.push_back(host_it->second);
+            }
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Failed to list hosts: ") + e.what();
+        return false;
     }
     
-    logDebug("Generated SQL for rule " + rule.alert_name + ": " + sql);
+    // 窗口条件和耗尽预测从区间开始前一个窗口 / 回溯时间起读取，区间开始时窗口和趋势已经建立
+    int64_t query_start_ms = start_ms;
+    if (compiled->windowed) {
+        query_start_ms = start_ms - compiled->window_ms;
+    } else if (compiled->predict_full_within.count() > 0) {
+        query_start_ms = start_ms - std::chrono::duration_cast<std::chrono::milliseconds>(m_forecasts.lookback()).count();
+    }
+    std::vector<AlarmBacktestResult> partitions(hosts.size());
+    std::vector<std::string> errors(hosts.size());
+    std::vector<char> deadline_hits(hosts.size(), 0);
+    // 截止时间上下文是线程局部的，分区任务在池线程中重新安装调用线程的截止时间
+    const QueryDeadline deadline = QueryDeadlineScope::current();
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(hosts.size());
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        tasks.push_back([&, i]() {
+            QueryDeadlineScope scope(deadline);
+            try {
+                replayBacktestPartition(*compiled, convertBacktestToSQL(*compiled, hosts[i], query_start_ms, end_ms),
+                                        start_ms, end_ms, partitions[i]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+            deadline_hits[i] = scope.exceeded() ? 1 : 0;
+        });
+    }
+    if (!tasks.empty()) {
+        WorkerPool pool(std::min(tasks.size(), std::max<size_t>(1, m_worker_threads)));
+        pool.runAll(std::move(tasks));
+    }
     
-    std::vector<QueryResult> results = executeQuery(sql);
+    if (std::find(deadline_hits.begin(), deadline_hits.end(), 1) != deadline_hits.end()) {
+        QueryDeadlineScope::markExceeded();
+        error = "Query deadline exceeded";
+        return false;
+    }
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        if (!errors[i].empty()) {
+            error = "Backtest failed for " + hosts[i] + ": " + errors[i];
+            return false;
+        }
+        AlarmBacktestResult& partition = partitions[i];
+        result.rows += partition.rows;
+        result.firing_events += partition.firing_events;
+        result.resolved_events += partition.resolved_events;
+        result.pending_cleared += partition.pending_cleared;
+        result.suppressed_events += partition.suppressed_events;
+        result.firing_at_end += partition.firing_at_end;
+        result.firing_duration_ms += partition.firing_duration_ms;
+        std::move(partition.events.begin(), partition.events.end(), std::back_inserter(result.events));
+    }
+    result.partitions = hosts.size();
     
-    std::set<std::string> active_from_db;
-    for (const auto& result : results) {
-        std::string fingerprint = generateFingerprint(rule.alert_name, result.labels);
-        active_from_db.insert(fingerprint);
+    std::stable_sort(result.events.begin(), result.events.end(),
+                     [](const AlarmBacktestEvent& a, const AlarmBacktestEvent& b) { return a.timestamp < b.timestamp; });
+    if (result.events.size() > max_events) {
+        result.events.resize(max_events);
+        result.truncated = true;
     }
     
-    reconcileAlarmStates(rule, active_from_db, results);
+    result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    logInfo("Backtest of " + rule.alert_name + ": " + std::to_string(result.rows) + " rows in " +
+            std::to_string(result.partitions) + " partitions, " + std::to_string(result.firing_events) +
+            " firing / " + std::to_string(result.resolved_events) + " resolved / " +
+            std::to_string(result.suppressed_events) + " suppressed, " +
+            std::to_string(result.elapsed_ms) + "ms");
+    return true;
 }
 
-std::string AlarmRuleEngine::convertRuleToSQL(const nlohmann::json& expression, 
-                                            const std::string& stable, 
-                                            const std::string& metric) {
-    std::ostringstream sql;
+/*
+ * 规则预览
+ * 
+ * 编译提交的规则后执行一次查询取回每条序列的最新值（窗口条件为窗口内的聚合值），条件在列上按位图评估，
+ * 与SQL评估周期使用同一套内核。只读：不创建实例、不调度定时器、不产生事件，同名规则正在运行时
+ * 只读取其实例状态用于标注。
+ */
+bool AlarmRuleEngine::previewRule(const AlarmRule& rule, size_t max_matches, AlarmPreviewResult& result,
+                                  std::string& error) {
+    auto begin = std::chrono::steady_clock::now();
+    result = AlarmPreviewResult();
     
-    sql << "SELECT LAST(" << metric << ") AS " << metric << ", host_ip, ";
+    auto compiled = compileRule(rule);
+    if (!compiled) {
+        error = "Invalid rule expression";
+        return false;
+    }
+    if (compiled->absent_for.count() > 0) {
+        error = "absent_for rules cannot be previewed";
+        return false;
+    }
+    if (compiled->anomaly) {
+        error = "anomaly rules cannot be previewed";
+        return false;
+    }
+    if (compiled->predict_full_within.count() > 0) {
+        error = "predict_full_within rules cannot be previewed";
+        return false;
+    }
+    if (!compiled->join_on.empty()) {
+        error = "all/any rules cannot be previewed";
+        return false;
+    }
     
-    std::vector<std::string> used_tag_fields;
-    std::vector<std::string> where_conditions;
+    result.sql = convertPreviewToSQL(*compiled);
+    std::vector<QueryResult> rows;
+    try {
+        rows = executeQuery(result.sql);
+    } catch (const std::exception& e) {
+        error = std::string("Preview query failed: ") + e.what();
+        return false;
+    }
+    result.query_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    result.series = rows.size();
     
-    if (expression.contains("tags") && expression["tags"].is_array()) {
-        for (const auto& tag_condition : expression["tags"]) {
-            for (auto it = tag_condition.begin(); it != tag_condition.end(); ++it) {
-                std::string tag_key = it.key();
-                std::string tag_value = it.value().get<std::string>();
-                
-                used_tag_fields.push_back(tag_key);
-                where_conditions.push_back(tag_key + " = '" + tag_value + "'");
-            }
+    std::vector<double> values(rows.size(), std::numeric_limits<double>::quiet_NaN());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        auto metric_it = rows[i].metrics.find(compiled->metric);
+        if (metric_it != rows[i].metrics.end()) {
+            values[i] = metric_it->second;
         }
     }
-    
-    for (const auto& tag : used_tag_fields) {
-        sql << tag << ", ";
+    std::vector<uint64_t> mask = threshold_kernel::fullMask(values.size());
+    for (const auto& condition : compiled->conditions) {
+        threshold_kernel::compareAnd(values.data(), values.size(), condition.first, condition.second, mask.data());
     }
     
-    sql << "ts FROM " << stable;
-    
-    if (expression.contains("conditions") && expression["conditions"].is_array()) {
-        for (const auto& condition : expression["conditions"]) {
-            if (condition.contains("operator") && condition.contains("threshold")) {
-                std::string op = condition["operator"];
-                double threshold = condition["threshold"];
-                where_conditions.push_back(metric + " " + op + " " + std::to_string(threshold));
-            }
+    // 同名规则正在运行时取其实例分片，不为预览创建分片
+    std::shared_ptr<InstanceShard> shard;
+    {
+        std::lock_guard<std::mutex> lock(m_instances_mutex);
+        auto shard_it = m_instance_shards.find(compiled->rule.alert_name);
+        if (shard_it != m_instance_shards.end()) {
+            shard = shard_it->second;
         }
     }
+    std::unique_lock<std::mutex> shard_lock;
+    if (shard) {
+        shard_lock = std::unique_lock<std::mutex>(shard->mutex);
+    }
     
-    where_conditions.push_back("ts > NOW() - 10s");
+    std::set<std::string> hosts;
+    std::set<FingerprintHash> instances;
+    threshold_kernel::forEachSetBit(mask.data(), values.size(), [&](size_t i) {
+        if (std::isnan(values[i])) {
+            return;
+        }
+        const QueryResult& row = rows[i];
+        
+        // 实例标签与 evaluateGroupedRule 相同：host_ip 和规则中的标签
+        std::map<std::string, std::string> instance_labels;
+        auto host_it = row.labels.find(metric_schema::kHostTag);
+        if (host_it != row.labels.end()) {
+            instance_labels[host_it->first] = host_it->second;
+            hosts.insert(host_it->second);
+        }
+        for (const auto& tag : compiled->tags) {
+            instance_labels[tag.first] = tag.second;
+        }
+        FingerprintHash key = hashFingerprint(compiled->rule.alert_name, instance_labels);
+        instances.insert(key);
+        ++result.matched_series;
+        
+        if (result.matches.size() >= max_matches) {
+            result.truncated = true;
+            return;
+        }
+        AlarmPreviewMatch match;
+        match.fingerprint = generateFingerprint(compiled->rule.alert_name, instance_labels);
+        match.labels = row.labels;
+        match.value = values[i];
+        match.timestamp = row.timestamp;
+        if (shard) {
+            auto instance_it = shard->instances.find(key);
+            if (instance_it != shard->instances.end()) {
+                match.state = instance_it->second.state == AlarmInstanceState::FIRING ? "firing" : "pending";
+            }
+        }
+        result.matches.push_back(std::move(match));
+    });
+    result.matched_hosts = hosts.size();
+    result.instances = instances.size();
     
-    if (!where_conditions.empty()) {
-        sql << " WHERE ";
-        for (size_t i = 0; i < where_conditions.size(); ++i) {
-            if (i > 0) sql << " AND ";
-            sql << "(" << where_conditions[i] << ")";
+    result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    logDebug("Preview of " + rule.alert_name + ": " + std::to_string(result.matched_series) + " of " +
+             std::to_string(result.series) + " series match, " + std::to_string(result.elapsed_ms) + "ms");
+    return true;
+}
+
+// 超级表的标签列（host_ip 及资源超级表定义的标签），回测查询取回这些列用于区分序列
+std::vector<std::string> AlarmRuleEngine::stableLabelColumns(const std::string& stable) {
+    std::vector<std::string> columns{metric_schema::kHostTag};
+    metric_schema::forEach(metric_schema::ResourceStables(), [&](auto stable_schema, auto) {
+        using S = decltype(stable_schema);
+        if (stable == S::name()) {
+            metric_schema::forEach(S::tags(), [&](const auto& column, auto) {
+                columns.push_back(column.name);
+            });
+        }
+    });
+    return columns;
+}
+
+std::string AlarmRuleEngine::convertBacktestToSQL(const CompiledRule& compiled, const std::string& host_ip,
+                                                  int64_t start_ms, int64_t end_ms) {
+    std::ostringstream sql;
+    sql << "SELECT ts, " << compiled.metric;
+    for (const auto& column : stableLabelColumns(compiled.stable)) {
+        sql << ", " << column;
+    }
+    sql << " FROM " << compiled.stable
+        << " WHERE (" << metric_schema::kHostTag << " = '" << host_ip << "')";
+    for (const auto& tag : compiled.tags) {
+        sql << " AND (" << tag.first << " = '" << tag.second << "')";
+    }
+    sql << " AND (ts >= " << start_ms << ") AND (ts < " << end_ms << ") ORDER BY ts";
+    return sql.str();
+}
+
+/*
+ * 预览查询：每条序列（子表）一行，取回超级表的全部标签列
+ * 
+ * 普通条件取最新值，新鲜度与SQL评估相同；窗口条件在窗口内聚合，rate 按首尾样本计算，不处理计数器回绕。
+ */
+std::string AlarmRuleEngine::convertPreviewToSQL(const CompiledRule& compiled) {
+    const std::string& metric = compiled.metric;
+    std::ostringstream sql;
+    sql << "SELECT ";
+    if (!compiled.windowed) {
+        sql << "LAST(" << metric << ")";
+    } else {
+        switch (compiled.window_func) {
+            case WindowFunc::AVG: sql << "AVG(" << metric << ")"; break;
+            case WindowFunc::MIN: sql << "MIN(" << metric << ")"; break;
+            case WindowFunc::MAX: sql << "MAX(" << metric << ")"; break;
+            case WindowFunc::SUM: sql << "SUM(" << metric << ")"; break;
+            case WindowFunc::COUNT: sql << "COUNT(" << metric << ")"; break;
+            case WindowFunc::RATE:
+                sql << "(LAST(" << metric << ") - FIRST(" << metric << ")) * 1000 / "
+                    << "(CAST(LAST(ts) AS BIGINT) - CAST(FIRST(ts) AS BIGINT))";
+                break;
         }
     }
+    sql << " AS " << metric << ", LAST(ts) AS ts";
     
-    sql << " GROUP BY host_ip";
-    for (const auto& tag : used_tag_fields) {
-        sql << ", " << tag;
+    std::vector<std::string> columns = stableLabelColumns(compiled.stable);
+    for (const auto& column : columns) {
+        sql << ", " << column;
+    }
+    sql << " FROM " << compiled.stable << " WHERE ";
+    for (const auto& tag : compiled.tags) {
+        sql << "(" << tag.first << " = '" << tag.second << "') AND ";
+    }
+    if (compiled.windowed) {
+        sql << "(ts > NOW() - " << compiled.window_ms / 1000 << "s)";
+    } else {
+        sql << "(ts > NOW() - 10s)";
     }
     
+    sql << " GROUP BY tbname";
+    for (const auto& column : columns) {
+        sql << ", " << column;
+    }
     return sql.str();
 }
 
-
-void AlarmRuleEngine::reconcileAlarmStates(const AlarmRule& rule, 
-                                         const std::set<std::string>& active_from_db,
-                                         const std::vector<QueryResult>& results) {
-    std::lock_guard<std::mutex> lock(m_instances_mutex);
+/*
+ * 回放一个主机分区
+ * 
+ * 与 evaluateStreamSample（样本）、onFireTimer（到达 for 时长）和 onExpireTimer（序列过期）对应，
+ * 以样本时间戳代替系统时钟。next_due 为所有实例中最早的到期时间，未到期时处理一行不遍历实例。
+ */
+void AlarmRuleEngine::replayBacktestPartition(const CompiledRule& compiled, const std::string& sql,
+                                              int64_t start_ms, int64_t end_ms, AlarmBacktestResult& result) {
+    struct ReplayInstance {
+        AlarmInstanceState state = AlarmInstanceState::PENDING;
+        int64_t pending_start = 0;
+        int64_t fired_at = 0;
+        int64_t keep_until = 0;  // 条件不再满足后按 keep_firing_for 保持到该时刻，0 表示未在保持中
+        double value = 0.0;
+        std::map<std::string, std::string> labels;
+        std::unordered_map<FingerprintHash, int64_t> series;  // 序列标签哈希 -> 最近一次满足条件的时间
+    };
     
-    auto now = std::chrono::system_clock::now();
-    std::map<std::string, QueryResult> result_map;
+    struct ReplayFlap {
+        FlapDetector detector;
+        AlarmBacktestEvent last_event;  // 最近一次实际产生的事件
+        bool has_last_event = false;
+        
+        explicit ReplayFlap(const FlapDetector& d) : detector(d) {}
+    };
     
-    for (const auto& result : results) {
-        std::string fingerprint = generateFingerprint(rule.alert_name, result.labels);
-        result_map[fingerprint] = result;
-    }
+    const int64_t kNever = std::numeric_limits<int64_t>::max();
+    const int64_t for_ms = std::chrono::duration_cast<std::chrono::milliseconds>(compiled.for_duration).count();
+    const int64_t keep_ms = std::chrono::duration_cast<std::chrono::milliseconds>(compiled.keep_firing_for).count();
+    const int64_t flap_window_ms = std::chrono::duration_cast<std::chrono::milliseconds>(m_flap_window).count();
+    const int64_t series_window_ms = std::chrono::duration_cast<std::chrono::milliseconds>(kStreamSeriesWindow).count();
+    const std::string& alert_name = compiled.rule.alert_name;
     
-    for (const auto& fingerprint : active_from_db) {
-        auto it = m_alarm_instances.find(fingerprint);
-        if (it == m_alarm_instances.end()) {
-            createNewAlarmInstance(fingerprint, rule, result_map[fingerprint], now);
+    std::unordered_map<FingerprintHash, ReplayInstance> instances;
+    std::unordered_map<FingerprintHash, ReplayFlap> flaps;
+    std::unordered_map<FingerprintHash, SlidingWindow> windows;
+    std::unordered_map<FingerprintHash, EwmaBaseline> baselines;
+    std::unordered_map<FingerprintHash, LinearTrend> trends;
+    const double lookback_s = static_cast<double>(m_forecasts.lookback().count());
+    int64_t next_due = kNever;
+    
+    auto makeEvent = [](const ReplayInstance& instance, const char* status, int64_t timestamp) {
+        AlarmBacktestEvent event;
+        event.status = status;
+        event.timestamp = timestamp;
+        event.starts_at = instance.pending_start;
+        event.value = instance.value;
+        event.labels = instance.labels;
+        return event;
+    };
+    auto push = [&](AlarmBacktestEvent event) {
+        ++(event.status == "firing" ? result.firing_events : result.resolved_events);
+        result.events.push_back(std::move(event));
+    };
+    // 与 generateAlarmEvent 相同，事件先计入抖动检测，抖动期间的事件被抑制
+    auto emit = [&](FingerprintHash key, const ReplayInstance& instance, const char* status, int64_t timestamp) {
+        AlarmBacktestEvent event = makeEvent(instance, status, timestamp);
+        if (m_flap_threshold > 0) {
+            auto flap_it = flaps.find(key);
+            if (flap_it == flaps.end()) {
+                flap_it = flaps.emplace(key, ReplayFlap(FlapDetector(flap_window_ms, m_flap_threshold))).first;
+            }
+            bool flapping = flap_it->second.detector.record(timestamp);
+            next_due = std::min(next_due, flap_it->second.detector.quietAt());
+            if (flapping) {
+                ++result.suppressed_events;
+                return;
+            }
+            flap_it->second.last_event = event;
+            flap_it->second.has_last_event = true;
+        }
+        push(std::move(event));
+    };
+    auto fire = [&](FingerprintHash key, ReplayInstance& instance, int64_t at) {
+        instance.state = AlarmInstanceState::FIRING;
+        instance.fired_at = at;
+        emit(key, instance, "firing", at);
+    };
+    auto resolve = [&](FingerprintHash key, ReplayInstance& instance, int64_t at) {
+        if (instance.state == AlarmInstanceState::FIRING) {
+            result.firing_duration_ms += at - instance.fired_at;
+            emit(key, instance, "resolved", at);
         } else {
-            updateExistingAlarmInstance(it->second, rule, result_map[fingerprint], now);
+            ++result.pending_cleared;
         }
-    }
+    };
+    // 条件不再满足：与 handleResolvedAlarm 相同，FIRING 实例按 keep_firing_for 继续保持；返回实例是否已恢复
+    auto release = [&](FingerprintHash key, ReplayInstance& instance, int64_t at) {
+        if (instance.state == AlarmInstanceState::FIRING && keep_ms > 0) {
+            if (instance.keep_until == 0) {
+                instance.keep_until = at + keep_ms;
+                next_due = std::min(next_due, instance.keep_until);
+            }
+            return false;
+        }
+        resolve(key, instance, at);
+        return true;
+    };
     
-    // 处理已恢复的告警（在previous_state_map中但不在active_from_db中）
-    std::string alert_prefix = "alertname=" + rule.alert_name + ",";
-    std::vector<std::string> to_remove;
+    // 结算 now 之前到期的抖动窗口、触发、序列过期和 keep_firing_for，同一时刻先触发再过期
+    auto advance = [&](int64_t now) {
+        if (now < next_due) {
+            return;
+        }
+        next_due = kNever;
+        for (auto flap_it = flaps.begin(); flap_it != flaps.end();) {
+            ReplayFlap& flap = flap_it->second;
+            int64_t quiet_at = flap.detector.quietAt();
+            if (quiet_at > now) {
+                next_due = std::min(next_due, quiet_at);
+                ++flap_it;
+                continue;
+            }
+            if (flap.detector.flapping()) {
+                auto instance_it = instances.find(flap_it->first);
+                bool firing = instance_it != instances.end() && instance_it->second.state == AlarmInstanceState::FIRING;
+                bool notified_firing = flap.has_last_event && flap.last_event.status == "firing";
+                if (notified_firing && !firing) {
+                    AlarmBacktestEvent event = flap.last_event;
+                    event.status = "resolved";
+                    event.timestamp = quiet_at;
+                    push(std::move(event));
+                } else if (firing && !notified_firing) {
+                    push(makeEvent(instance_it->second, "firing", quiet_at));
+                }
+            }
+            flap_it = flaps.erase(flap_it);
+        }
+        for (auto it = instances.begin(); it != instances.end();) {
+            ReplayInstance& instance = it->second;
+            bool resolved = false;
+            while (true) {
+                int64_t fire_at = instance.state == AlarmInstanceState::PENDING ? instance.pending_start + for_ms : kNever;
+                // 与 onExpireTimer 相同，序列在最近一次满足条件超过窗口（严格大于）后过期
+                int64_t expire_at = kNever;
+                for (const auto& series : instance.series) {
+                    expire_at = std::min(expire_at, series.second + series_window_ms + 1);
+                }
+                int64_t keep_at = instance.keep_until != 0 ? instance.keep_until : kNever;
+                int64_t due = std::min(std::min(fire_at, expire_at), keep_at);
+                if (due > now) {
+                    next_due = std::min(next_due, due);
+                    break;
+                }
+                if (fire_at == due) {
+                    fire(it->first, instance, fire_at);
+                    continue;
+                }
+                if (keep_at == due) {
+                    resolve(it->first, instance, keep_at);
+                    resolved = true;
+                    break;
+                }
+                for (auto series_it = instance.series.begin(); series_it != instance.series.end();) {
+                    if (series_it->second + series_window_ms < expire_at) {
+                        series_it = instance.series.erase(series_it);
+                    } else {
+                        ++series_it;
+                    }
+                }
+                if (instance.series.empty() && release(it->first, instance, expire_at)) {
+                    resolved = true;
+                    break;
+                }
+            }
+            it = resolved ? instances.erase(it) : std::next(it);
+        }
+    };
     
-    for (auto& pair : m_alarm_instances) {
-        const std::string& fingerprint = pair.first;
+    m_resource_storage->scanQuerySQL(sql, [&](QueryResult& row) {
+        auto metric_it = row.metrics.find(compiled.metric);
+        if (metric_it == row.metrics.end()) {
+            return;
+        }
+        int64_t now = row.timestamp;
+        double value = metric_it->second;
+        FingerprintHash series_key = hashFingerprint(compiled.metric, row.labels);
+        
+        if (compiled.windowed) {
+            auto window_it = windows.find(series_key);
+            if (window_it == windows.end()) {
+                window_it = windows.emplace(series_key, SlidingWindow(compiled.window_func, compiled.window_ms)).first;
+            }
+            window_it->second.add(now, value);
+            if (now < start_ms) {
+                return;
+            }
+            ++result.rows;
+            advance(now);
+            if (!window_it->second.value(value)) {
+                return;
+            }
+        } else if (compiled.predict_full_within.count() > 0) {
+            LinearTrend& trend = trends[series_key];
+            trend.add(now, value, lookback_s);
+            if (now < start_ms) {
+                return;
+            }
+            ++result.rows;
+            advance(now);
+        } else {
+            ++result.rows;
+            advance(now);
+        }
+        // 基线从区间内的第一个样本开始预热
+        if (compiled.anomaly && !baselines[series_key].update(compiled.anomaly_params, now, value, value)) {
+            return;
+        }
+        
+        std::map<std::string, std::string> labels;
+        auto host_it = row.labels.find(metric_schema::kHostTag);
+        if (host_it != row.labels.end()) {
+            labels[host_it->first] = host_it->second;
+        }
+        for (const auto& tag : compiled.tags) {
+            auto it = row.labels.find(tag.first);
+            if (it == row.labels.end() || it->second != tag.second) {
+                return;
+            }
+            labels[tag.first] = it->second;
+        }
+        
+        // 与 evaluateStreamSample 相同，趋势样本不足时不改变实例状态
+        bool predicted = true;
+        if (compiled.predict_full_within.count() > 0) {
+            double level = 0.0;
+            double slope = 0.0;
+            double seconds = 0.0;
+            if (!trends[series_key].fit(m_forecasts.minSpanSeconds(), level, slope)) {
+                return;
+            }
+            predicted = predictExhaustion(compiled, level, slope, seconds);
+        }
         
-        // 只处理属于当前规则的实例
-        if (fingerprint.find(alert_prefix) == 0) {
-            // 如果不在active_from_db中，说明已恢复
-            if (active_from_db.find(fingerprint) == active_from_db.end()) {
-                QueryResult empty_result;
-                // 为空结果添加一个默认指标
-                empty_result.metrics["resolved"] = 0.0;
-                handleResolvedAlarm(pair.second, rule, empty_result, now);
-                if (pair.second.state == AlarmInstanceState::INACTIVE) {
-                    to_remove.push_back(fingerprint);
+        FingerprintHash key = hashFingerprint(alert_name, labels);
+        auto instance_it = instances.find(key);
+        bool matched = predicted && evaluateConditions(compiled.conditions, value);
+        // 回差：FIRING 实例中已活动的序列只要满足恢复阈值就保持活动
+        if (!matched && !compiled.hold_conditions.empty() && instance_it != instances.end() &&
+            instance_it->second.state == AlarmInstanceState::FIRING && instance_it->second.series.count(series_key) > 0) {
+            matched = predicted && evaluateConditions(compiled.hold_conditions, value);
+        }
+        if (!matched) {
+            if (instance_it != instances.end()) {
+                instance_it->second.series.erase(series_key);
+                if (instance_it->second.series.empty() && release(key, instance_it->second, now)) {
+                    instances.erase(instance_it);
                 }
             }
+            return;
         }
-    }
+        
+        if (instance_it == instances.end()) {
+            ReplayInstance instance;
+            instance.pending_start = now;
+            instance.labels = std::move(labels);
+            instance.value = value;
+            instance_it = instances.emplace(key, std::move(instance)).first;
+            if (for_ms <= 0) {
+                fire(key, instance_it->second, now);
+            } else {
+                next_due = std::min(next_due, now + for_ms);
+            }
+        }
+        instance_it->second.keep_until = 0;
+        instance_it->second.value = value;
+        instance_it->second.series[series_key] = now;
+        next_due = std::min(next_due, now + series_window_ms);
+    });
     
-    for (const auto& fingerprint : to_remove) {
-        m_alarm_instances.erase(fingerprint);
+    // 区间为左闭右开，恰好在 end_ms 到期的触发和过期不计入
+    advance(end_ms - 1);
+    for (const auto& pair : instances) {
+        if (pair.second.state == AlarmInstanceState::FIRING) {
+            ++result.firing_at_end;
+            result.firing_duration_ms += end_ms - pair.second.fired_at;
+        }
     }
 }
 
-void AlarmRuleEngine::createNewAlarmInstance(const std::string& fingerprint, 
-                                           const AlarmRule& rule, 
-                                           const QueryResult& result, 
-                                           std::chrono::system_clock::time_point now) {
-    AlarmInstance instance;
-    instance.fingerprint = fingerprint;
-    instance.alert_name = rule.alert_name;
-    instance.state = AlarmInstanceState::PENDING;
-    instance.state_changed_at = now;
-    instance.pending_start_at = now;
-    instance.labels = result.labels;
-    instance.labels["alertname"] = rule.alert_name;
-    instance.labels["severity"] = rule.severity;
-    instance.labels["alert_type"] = rule.alert_type;
-    // 从 metrics map 中获取第一个（通常也是唯一的）指标
-    std::string metric_name = result.metrics.empty() ? "unknown" : result.metrics.begin()->first;
-    double metric_value = result.metrics.empty() ? 0.0 : result.metrics.begin()->second;
-    
-    instance.labels["value"] = std::to_string(metric_value);
-    instance.labels["metrics"] = metric_name;
-    instance.value = metric_value;
+/*
+ * 写入实例状态快照
+ * 
+ * 只保存 PENDING / FIRING 实例，以及缺失数据规则的序列索引。各分片在锁内序列化到内存缓冲，文件读写不持有分片锁；
+ * 先写临时文件再 rename，进程在写入过程中退出也不会留下不完整的快照。
+ */
+bool AlarmRuleEngine::saveSnapshot() {
+    std::ostringstream records;
+    uint32_t count = 0;
     
-    instance.annotations["summary"] = rule.summary;
-    instance.annotations["description"] = replaceTemplate(rule.description, instance.labels);
+    for (const auto& shard : allShards()) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& pair : shard->instances) {
+            const AlarmInstance& instance = pair.second;
+            if (instance.state != AlarmInstanceState::PENDING && instance.state != AlarmInstanceState::FIRING) {
+                continue;
+            }
+            writeString(records, instance.alert_name);
+            writePod(records, pair.first);
+            writePod(records, static_cast<uint8_t>(instance.state));
+            writePod(records, toEpochMs(instance.pending_start_at));
+            writePod(records, toEpochMs(instance.state_changed_at));
+            writePod(records, instance.value);
+            writeString(records, instance.fingerprint);
+            writeStringMap(records, instance.labels);
+            writeStringMap(records, instance.annotations);
+            ++count;
+        }
+    }
     
-    m_alarm_instances[fingerprint] = instance;
+    // 缺失数据规则的序列索引：重启后仍能发现重启前上报过、之后再没有样本的序列
+    std::ostringstream absent_records;
+    uint32_t absent_count = 0;
+    for (const auto& shard : allShards()) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& pair : shard->absent_series) {
+            if (pair.second.labels.empty()) {
+                continue;
+            }
+            writeString(absent_records, shard->alert_name);
+            writePod(absent_records, pair.first);
+            writePod(absent_records, pair.second.last_value);
+            writeStringMap(absent_records, pair.second.labels);
+            ++absent_count;
+        }
+    }
     
-    logInfo("Created new alarm instance: " + fingerprint + " (PENDING)" + " " + metric_name + " " + std::to_string(metric_value));
-}
-
-void AlarmRuleEngine::updateExistingAlarmInstance(AlarmInstance& instance, 
-                                                const AlarmRule& rule, 
-                                                const QueryResult& result, 
-                                                std::chrono::system_clock::time_point now) {
-    // 更新当前值 - 从 metrics map 中获取第一个指标
-    double metric_value = result.metrics.empty() ? 0.0 : result.metrics.begin()->second;
-    instance.value = metric_value;
-    instance.labels["value"] = std::to_string(metric_value);
+    // 趋势索引：重启后耗尽预测不需要重新积累样本，停机时长按样本间隔计入衰减
+    std::ostringstream forecast_records;
+    uint32_t forecast_count = 0;
+    m_forecasts.forEach([&](const std::string& stable, const std::string& metric,
+                            const std::map<std::string, std::string>& labels, const LinearTrend& trend,
+                            double last_value) {
+        writeString(forecast_records, stable);
+        writeString(forecast_records, metric);
+        writeStringMap(forecast_records, labels);
+        writePod(forecast_records, trend);
+        writePod(forecast_records, last_value);
+        ++forecast_count;
+    });
     
-    if (instance.state == AlarmInstanceState::PENDING) {
-        auto for_duration = parseDuration(rule.for_duration);
-        if (now - instance.pending_start_at >= for_duration) {
-            instance.state = AlarmInstanceState::FIRING;
-            instance.state_changed_at = now;
-            generateAlarmEvent(instance, rule, "firing");
-            logInfo("Alarm instance " + instance.fingerprint + " transitioned to FIRING");
+    std::string tmp_file = m_state_file + ".tmp";
+    {
+        std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            logError("Failed to open alarm state file " + tmp_file);
+            return false;
+        }
+        writePod(out, kSnapshotMagic);
+        writePod(out, kSnapshotVersion);
+        writePod(out, toEpochMs(std::chrono::system_clock::now()));
+        writePod(out, count);
+        const std::string body = records.str();
+        out.write(body.data(), body.size());
+        writePod(out, absent_count);
+        const std::string absent_body = absent_records.str();
+        out.write(absent_body.data(), absent_body.size());
+        writePod(out, forecast_count);
+        const std::string forecast_body = forecast_records.str();
+        out.write(forecast_body.data(), forecast_body.size());
+        out.flush();
+        if (!out) {
+            logError("Failed to write alarm state file " + tmp_file);
+            return false;
         }
     }
+    
+    if (std::rename(tmp_file.c_str(), m_state_file.c_str()) != 0) {
+        logError("Failed to replace alarm state file " + m_state_file);
+        return false;
+    }
+    
+    logDebug("Saved " + std::to_string(count) + " alarm instances to " + m_state_file);
+    return true;
 }
 
-void AlarmRuleEngine::handleResolvedAlarm(AlarmInstance& instance, 
-                                        const AlarmRule& rule, 
-                                        const QueryResult& result,
-                                        std::chrono::system_clock::time_point now) {
-    if (instance.state == AlarmInstanceState::FIRING) {
-        instance.state = AlarmInstanceState::RESOLVED;
-        instance.state_changed_at = now;
-        generateAlarmEvent(instance, rule, "resolved");
-        logInfo("Alarm instance " + instance.fingerprint + " RESOLVED");
+/*
+ * 从快照恢复实例状态（start 中、评估线程启动前调用）
+ * 
+ * FIRING 实例直接恢复，不再发送 firing 事件；PENDING 实例保留 pending_start_at，按剩余的 for 时长重新登记触发定时器。
+ * 规则已删除的实例丢弃。之后的评估照常协调：SQL评估的规则在第一个评估周期确认，已不满足条件的实例发送 resolved 事件；
+ * 流式评估的规则在 kStreamSeriesWindow 内没有满足条件的样本即恢复。
+ * 缺失数据规则的序列索引一并恢复，各序列从恢复时刻起重新计算 absent_for；趋势索引原样恢复。
+ */
+size_t AlarmRuleEngine::restoreSnapshot() {
+    std::ifstream in(m_state_file, std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+    
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    int64_t saved_at_ms = 0;
+    uint32_t count = 0;
+    if (!readPod(in, magic) || !readPod(in, version) || !readPod(in, saved_at_ms) || !readPod(in, count) ||
+        magic != kSnapshotMagic || version < 1 || version > kSnapshotVersion) {
+        logError("Ignoring unrecognized alarm state file " + m_state_file);
+        return 0;
+    }
+    
+    std::unordered_map<std::string, std::shared_ptr<const CompiledRule>> rules_by_name;
+    if (auto rule_set = currentRuleSet()) {
+        rules_by_name = rule_set->by_name;
+    }
+    
+    bool streaming = m_evaluation_mode == AlarmEvaluationMode::STREAMING;
+    auto now = std::chrono::system_clock::now();
+    auto steady_now = std::chrono::steady_clock::now();
+    size_t restored = 0;
+    size_t dropped = 0;
+    bool truncated = false;
+    
+    // 缺失数据规则的序列从恢复时刻重新计时，停机期间收不到的样本不算作缺失（调用方持有分片锁）
+    auto restoreAbsentSeries = [&](const std::shared_ptr<InstanceShard>& shard, FingerprintHash key,
+                                   const std::shared_ptr<const CompiledRule>& compiled) -> AbsentSeries& {
+        AbsentSeries& series = shard->absent_series[key];
+        if (series.timer == 0) {
+            series.last_seen = now;
+            series.timer = scheduleTimer(steady_now + compiled->absent_for,
+                                         InstanceTimer{InstanceTimer::Kind::ABSENT, shard, key, compiled});
+        }
+        return series;
+    };
+    
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string alert_name;
+        FingerprintHash key = 0;
+        uint8_t state = 0;
+        int64_t pending_start_ms = 0;
+        int64_t state_changed_ms = 0;
+        AlarmInstance instance;
+        if (!readString(in, alert_name) || !readPod(in, key) || !readPod(in, state) ||
+            !readPod(in, pending_start_ms) || !readPod(in, state_changed_ms) || !readPod(in, instance.value) ||
+            !readString(in, instance.fingerprint) || !readStringMap(in, instance.labels) ||
+            !readStringMap(in, instance.annotations)) {
+            logError("Alarm state file " + m_state_file + " is truncated, restored " + std::to_string(restored) + " instances");
+            truncated = true;
+            break;
+        }
         
-        instance.state = AlarmInstanceState::INACTIVE;
-    } else if (instance.state == AlarmInstanceState::PENDING) {
-        instance.state = AlarmInstanceState::INACTIVE;
-        instance.state_changed_at = now;
-        logInfo("Alarm instance " + instance.fingerprint + " transitioned from PENDING to INACTIVE");
+        instance.alert_name = alert_name;
+        instance.state = static_cast<AlarmInstanceState>(state);
+        instance.pending_start_at = fromEpochMs(pending_start_ms);
+        instance.state_changed_at = fromEpochMs(state_changed_ms);
+        
+        auto rule_it = rules_by_name.find(alert_name);
+        if (rule_it == rules_by_name.end() ||
+            (instance.state != AlarmInstanceState::PENDING && instance.state != AlarmInstanceState::FIRING)) {
+            ++dropped;
+            continue;
+        }
+        const auto& compiled = rule_it->second;
+        
+        auto shard = shardFor(alert_name);
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (!shard->instances.emplace(key, instance).second) {
+            continue;
+        }
+        
+        if (instance.state == AlarmInstanceState::PENDING) {
+            auto remaining = instance.pending_start_at + compiled->for_duration - now;
+            if (remaining < std::chrono::system_clock::duration::zero()) {
+                remaining = std::chrono::system_clock::duration::zero();
+            }
+            shard->fire_timers[key] = scheduleTimer(
+                steady_now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining),
+                InstanceTimer{InstanceTimer::Kind::FIRE, shard, key, compiled});
+        }
+        
+        if (compiled->absent_for.count() > 0) {
+            restoreAbsentSeries(shard, key, compiled);
+        } else if (compiled->windowed || compiled->anomaly || compiled->predict_full_within.count() > 0 ||
+                   (streaming && isStreamedStable(compiled->stable))) {
+            StreamInstanceState& stream_state = shard->stream_states[key];
+            stream_state.rule = compiled;
+            stream_state.series[kRestoredSeriesKey] = now;
+            stream_state.expiry_timer = scheduleTimer(steady_now + kStreamSeriesWindow,
+                                                      InstanceTimer{InstanceTimer::Kind::EXPIRE, shard, key, compiled});
+        }
+        ++restored;
     }
-}
-
-void AlarmRuleEngine::generateAlarmEvent(const AlarmInstance& instance, 
-                                       const AlarmRule& rule, 
-                                       const std::string& status) {
-    AlarmEvent event;
-    event.fingerprint = instance.fingerprint;
-    event.status = status;
-    event.labels = instance.labels;
-    event.annotations = instance.annotations;
-    event.starts_at = instance.pending_start_at;
     
-    if (status == "resolved") {
-        event.ends_at = instance.state_changed_at;
+    if (dropped > 0) {
+        logInfo("Dropped " + std::to_string(dropped) + " saved alarm instances whose rules no longer exist");
     }
     
-    logInfo("Generated alarm event: " + event.toJson());
+    uint32_t absent_count = 0;
+    if (truncated || version < 2 || !readPod(in, absent_count)) {
+        return restored;
+    }
+    size_t absent_restored = 0;
+    for (uint32_t i = 0; i < absent_count; ++i) {
+        std::string alert_name;
+        FingerprintHash key = 0;
+        double last_value = 0.0;
+        std::map<std::string, std::string> labels;
+        if (!readString(in, alert_name) || !readPod(in, key) || !readPod(in, last_value) ||
+            !readStringMap(in, labels)) {
+            logError("Alarm state file " + m_state_file + " is truncated, restored " +
+                     std::to_string(absent_restored) + " absent-data series");
+            truncated = true;
+            break;
+        }
+        auto rule_it = rules_by_name.find(alert_name);
+        if (rule_it == rules_by_name.end() || rule_it->second->absent_for.count() <= 0) {
+            continue;
+        }
+        auto shard = shardFor(alert_name);
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        AbsentSeries& series = restoreAbsentSeries(shard, key, rule_it->second);
+        series.labels = std::move(labels);
+        series.last_value = last_value;
+        ++absent_restored;
+    }
+    if (absent_restored > 0) {
+        logInfo("Restored " + std::to_string(absent_restored) + " absent-data series from " + m_state_file);
+    }
     
-    if (m_alarm_event_callback) {
-        m_alarm_event_callback(event);
+    uint32_t forecast_count = 0;
+    if (truncated || version < 3 || !readPod(in, forecast_count)) {
+        return restored;
+    }
+    uint32_t forecast_restored = 0;
+    for (; forecast_restored < forecast_count; ++forecast_restored) {
+        std::string stable;
+        std::string metric;
+        std::map<std::string, std::string> labels;
+        LinearTrend trend;
+        double last_value = 0.0;
+        if (!readString(in, stable) || !readString(in, metric) || !readStringMap(in, labels) ||
+            !readPod(in, trend) || !readPod(in, last_value)) {
+            logError("Alarm state file " + m_state_file + " is truncated, restored " +
+                     std::to_string(forecast_restored) + " forecast series");
+            break;
+        }
+        m_forecasts.restore(stable, metric, labels, trend, last_value);
+    }
+    if (forecast_restored > 0) {
+        logInfo("Restored " + std::to_string(forecast_restored) + " forecast series from " + m_state_file);
     }
+    return restored;
 }
 
 std::vector<QueryResult> AlarmRuleEngine::executeQuery(const std::string& sql) {
@@ -348,33 +3044,63 @@ std::vector<QueryResult> AlarmRuleEngine::executeQuery(const std::string& sql) {
     return std::vector<QueryResult>();
 }
 
-bool AlarmRuleEngine::evaluateCondition(double value, const std::string& op, double threshold) {
-    if (op == ">") return value > threshold;
-    if (op == "<") return value < threshold;
-    if (op == ">=") return value >= threshold;
-    if (op == "<=") return value <= threshold;
-    if (op == "=") return value == threshold;
-    if (op == "!=") return value != threshold;
+bool AlarmRuleEngine::evaluateConditions(const std::vector<std::pair<CompareOp, double>>& conditions, double value) {
+    for (const auto& condition : conditions) {
+        if (!evaluateCondition(value, condition.first, condition.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AlarmRuleEngine::evaluateCondition(double value, CompareOp op, double threshold) {
+    switch (op) {
+        case CompareOp::GT: return value > threshold;
+        case CompareOp::LT: return value < threshold;
+        case CompareOp::GE: return value >= threshold;
+        case CompareOp::LE: return value <= threshold;
+        case CompareOp::EQ: return value == threshold;
+        case CompareOp::NE: return value != threshold;
+    }
     return false;
 }
 
-std::string AlarmRuleEngine::generateFingerprint(const std::string& alert_name, 
-                                               const std::map<std::string, std::string>& labels) {
-    std::ostringstream fingerprint;
-    fingerprint << "alertname=" << alert_name;
-    
-    std::vector<std::pair<std::string, std::string>> sorted_labels(labels.begin(), labels.end());
-    std::sort(sorted_labels.begin(), sorted_labels.end());
+/*
+ * 指纹哈希：对 alert_name 和按键有序的标签做 FNV-1a，不生成中间字符串
+ * 
+ * 各字段后追加分隔字节，避免 ("ab","c") 与 ("a","bc") 这类拼接歧义。
+ */
+AlarmRuleEngine::FingerprintHash AlarmRuleEngine::hashFingerprint(const std::string& alert_name, 
+                                                                  const std::map<std::string, std::string>& labels) {
+    FingerprintHash hash = kFnvOffsetBasis;
+    auto mix = [&hash](const std::string& text) {
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * kFnvPrime;
+        }
+        hash = (hash ^ 0xffu) * kFnvPrime;
+    };
     
-    for (const auto& label : sorted_labels) {
-        fingerprint << "," << label.first << "=" << label.second;
+    mix(alert_name);
+    for (const auto& label : labels) {
+        mix(label.first);
+        mix(label.second);
     }
     
-    return fingerprint.str();
+    return hash;
+}
+
+// 展示用的字符串指纹，std::map 已按标签名有序
+std::string AlarmRuleEngine::generateFingerprint(const std::string& alert_name, 
+                                               const std::map<std::string, std::string>& labels) {
+    std::string fingerprint = "alertname=" + alert_name;
+    for (const auto& label : labels) {
+        fingerprint += "," + label.first + "=" + label.second;
+    }
+    return fingerprint;
 }
 
 std::chrono::seconds AlarmRuleEngine::parseDuration(const std::string& duration) {
-    std::regex duration_regex(R"((\d+)([smhd]))");
+    static const std::regex duration_regex(R"((\d+)([smhd]))");
     std::smatch match;
     
     if (std::regex_match(duration, match, duration_regex)) {
@@ -401,16 +3127,45 @@ std::string AlarmRuleEngine::formatTimestamp(const std::chrono::system_clock::ti
     return oss.str();
 }
 
-std::string AlarmRuleEngine::replaceTemplate(const std::string& template_str, 
-                                           const std::map<std::string, std::string>& values) {
-    std::string result = template_str;
+/*
+ * 把模板拆分为文本片段和 {{标签名}} 占位符，规则编译时执行一次
+ */
+std::vector<AlarmRuleEngine::TemplateSegment> AlarmRuleEngine::compileTemplate(const std::string& template_str) {
+    std::vector<TemplateSegment> segments;
+    size_t pos = 0;
+    
+    while (pos < template_str.size()) {
+        size_t open = template_str.find("{{", pos);
+        size_t close = open == std::string::npos ? std::string::npos : template_str.find("}}", open + 2);
+        if (close == std::string::npos) {
+            segments.push_back(TemplateSegment{false, template_str.substr(pos)});
+            break;
+        }
+        if (open > pos) {
+            segments.push_back(TemplateSegment{false, template_str.substr(pos, open - pos)});
+        }
+        segments.push_back(TemplateSegment{true, template_str.substr(open + 2, close - open - 2)});
+        pos = close + 2;
+    }
+    
+    return segments;
+}
+
+// 没有对应标签的占位符原样保留
+std::string AlarmRuleEngine::renderTemplate(const std::vector<TemplateSegment>& segments, 
+                                          const std::map<std::string, std::string>& values) {
+    std::string result;
     
-    for (const auto& pair : values) {
-        std::string placeholder = "{{" + pair.first + "}}";
-        size_t pos = 0;
-        while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-            result.replace(pos, placeholder.length(), pair.second);
-            pos += pair.second.length();
+    for (const auto& segment : segments) {
+        if (!segment.placeholder) {
+            result += segment.text;
+            continue;
+        }
+        auto it = values.find(segment.text);
+        if (it != values.end()) {
+            result += it->second;
+        } else {
+            result += "{{" + segment.text + "}}";
         }
     }
     
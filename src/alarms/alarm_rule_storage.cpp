@@ -8,7 +8,7 @@
 
 // 连接池注入构造函数 - 推荐使用
 AlarmRuleStorage::AlarmRuleStorage(std::shared_ptr<MySQLConnectionPool> connection_pool)
-    : m_connection_pool(connection_pool), m_initialized(false), m_owns_connection_pool(false) {
+    : m_connection_pool(connection_pool), m_initialized(false), m_owns_connection_pool(false), m_rule_version(1) {
     if (!m_connection_pool) {
         logError("Injected connection pool is null");
     }
@@ -16,14 +16,14 @@ AlarmRuleStorage::AlarmRuleStorage(std::shared_ptr<MySQLConnectionPool> connecti
 
 // 新的连接池构造函数
 AlarmRuleStorage::AlarmRuleStorage(const MySQLPoolConfig& pool_config)
-    : m_pool_config(pool_config), m_initialized(false), m_owns_connection_pool(true) {
+    : m_pool_config(pool_config), m_initialized(false), m_owns_connection_pool(true), m_rule_version(1) {
     m_connection_pool = std::make_shared<MySQLConnectionPool>(m_pool_config);
 }
 
 // 兼容性构造函数 - 将旧参数转换为连接池配置
 AlarmRuleStorage::AlarmRuleStorage(const std::string& host, int port, const std::string& user, 
                                  const std::string& password, const std::string& database)
-    : m_initialized(false), m_owns_connection_pool(true) {
+    : m_initialized(false), m_owns_connection_pool(true), m_rule_version(1) {
     m_pool_config = createDefaultPoolConfig();
     m_pool_config.host = host;
     m_pool_config.port = port;
@@ -159,6 +159,7 @@ std::string AlarmRuleStorage::insertAlarmRule(const std::string& alert_name,
         << (enabled ? "TRUE" : "FALSE") << ")";
 
     if (executeQuery(oss.str())) {
+        ++m_rule_version;
         return id;
     }
     return "";
@@ -192,7 +193,11 @@ bool AlarmRuleStorage::updateAlarmRule(const std::string& id,
         << "enabled = " << (enabled ? "TRUE" : "FALSE") << " "
         << "WHERE id = '" << escapeString(id) << "'";
 
-    return executeQuery(oss.str());
+    if (!executeQuery(oss.str())) {
+        return false;
+    }
+    ++m_rule_version;
+    return true;
 }
 
 bool AlarmRuleStorage::deleteAlarmRule(const std::string& id) {
@@ -202,7 +207,11 @@ bool AlarmRuleStorage::deleteAlarmRule(const std::string& id) {
     }
 
     std::string sql = "DELETE FROM alarm_rules WHERE id = '" + escapeString(id) + "'";
-    return executeQuery(sql);
+    if (!executeQuery(sql)) {
+        return false;
+    }
+    ++m_rule_version;
+    return true;
 }
 
 AlarmRule AlarmRuleStorage::getAlarmRule(const std::string& id) {
@@ -277,6 +286,26 @@ std::vector<AlarmRule> AlarmRuleStorage::getEnabledAlarmRules() {
     return rules;
 }
 
+bool AlarmRuleStorage::getRuleSetSignature(std::string& signature) {
+    if (!m_initialized) {
+        return false;
+    }
+
+    MYSQL_RES* raw_result = executeSelectQuery("SELECT COUNT(*), MAX(updated_at) FROM alarm_rules");
+    if (!raw_result) {
+        return false;
+    }
+
+    MySQLResultRAII result(raw_result);
+    MYSQL_ROW row = mysql_fetch_row(result.get());
+    if (row == nullptr) {
+        return false;
+    }
+
+    signature = std::string(row[0] ? row[0] : "0") + "|" + (row[1] ? row[1] : "");
+    return true;
+}
+
 bool AlarmRuleStorage::executeQuery(const std::string& query) {
     if (!m_initialized) {
         logError("AlarmRuleStorage not initialized");
@@ -0,0 +1,161 @@
+#include "forecast_index.h"
+
+#include <algorithm>
+
+namespace {
+    // 序列出现后至少积累这么长时间的样本才开始预测（回溯时间更短时取回溯时间）
+    const std::chrono::minutes kMinForecastSpan(15);
+    // 64位 FNV-1a 参数
+    const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+    const uint64_t kFnvPrime = 1099511628211ULL;
+
+    void fnvAppend(uint64_t& hash, const std::string& text) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= kFnvPrime;
+        }
+        // 分隔符，避免 "ab"+"c" 与 "a"+"bc" 相同
+        hash ^= 0xff;
+        hash *= kFnvPrime;
+    }
+}
+
+void ForecastIndex::setLookback(std::chrono::seconds lookback) {
+    m_lookback = lookback.count() > 0 ? lookback : std::chrono::hours(6);
+}
+
+double ForecastIndex::minSpanSeconds() const {
+    return static_cast<double>(std::min<int64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(kMinForecastSpan).count(), m_lookback.count()));
+}
+
+uint64_t ForecastIndex::seriesHash(const std::string& stable, const std::string& metric,
+                                   const std::map<std::string, std::string>& labels) {
+    uint64_t hash = kFnvOffsetBasis;
+    fnvAppend(hash, stable);
+    fnvAppend(hash, metric);
+    for (const auto& label : labels) {
+        fnvAppend(hash, label.first);
+        fnvAppend(hash, label.second);
+    }
+    return hash;
+}
+
+LinearTrend ForecastIndex::observe(const std::string& stable, const std::string& metric,
+                                   const std::map<std::string, std::string>& labels, int64_t timestamp_ms,
+                                   double value) {
+    uint64_t hash = seriesHash(stable, metric, labels);
+    Shard& shard = m_shards[hash % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.series.find(hash);
+    if (it == shard.series.end()) {
+        Series series;
+        series.stable = stable;
+        series.metric = metric;
+        series.labels = labels;
+        it = shard.series.emplace(hash, std::move(series)).first;
+    }
+    it->second.trend.add(timestamp_ms, value, static_cast<double>(m_lookback.count()));
+    it->second.last_value = value;
+    return it->second.trend;
+}
+
+std::vector<SeriesForecast> ForecastIndex::closest(const std::string& stable, const std::string& metric,
+                                                   double capacity, double within_s, size_t limit,
+                                                   size_t& tracked) const {
+    std::vector<SeriesForecast> result;
+    tracked = 0;
+    double min_span = minSpanSeconds();
+
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& pair : shard.series) {
+            const Series& series = pair.second;
+            if ((!stable.empty() && series.stable != stable) || (!metric.empty() && series.metric != metric)) {
+                continue;
+            }
+            ++tracked;
+
+            double level = 0.0;
+            double slope = 0.0;
+            double seconds = 0.0;
+            if (!series.trend.fit(min_span, level, slope) ||
+                !LinearTrend::timeToReach(level, slope, capacity, seconds) ||
+                (within_s > 0.0 && seconds > within_s)) {
+                continue;
+            }
+
+            SeriesForecast forecast;
+            forecast.stable = series.stable;
+            forecast.metric = series.metric;
+            forecast.labels = series.labels;
+            forecast.value = series.last_value;
+            forecast.level = level;
+            forecast.slope_per_hour = slope * 3600.0;
+            forecast.time_to_full_s = seconds;
+            forecast.updated_at = series.trend.lastTimestamp();
+            forecast.samples = series.trend.count();
+            result.push_back(std::move(forecast));
+        }
+    }
+
+    auto by_time = [](const SeriesForecast& a, const SeriesForecast& b) { return a.time_to_full_s < b.time_to_full_s; };
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), by_time);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), by_time);
+    }
+    return result;
+}
+
+size_t ForecastIndex::evictIdle(int64_t now_ms, int64_t idle_ms) {
+    size_t evicted = 0;
+    for (Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.series.begin(); it != shard.series.end();) {
+            if (now_ms - it->second.trend.lastTimestamp() >= idle_ms) {
+                it = shard.series.erase(it);
+                ++evicted;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return evicted;
+}
+
+size_t ForecastIndex::size() const {
+    size_t total = 0;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.series.size();
+    }
+    return total;
+}
+
+void ForecastIndex::forEach(const SeriesVisitor& visitor) const {
+    for (const Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& pair : shard.series) {
+            visitor(pair.second.stable, pair.second.metric, pair.second.labels, pair.second.trend,
+                    pair.second.last_value);
+        }
+    }
+}
+
+void ForecastIndex::restore(const std::string& stable, const std::string& metric,
+                            const std::map<std::string, std::string>& labels, const LinearTrend& trend,
+                            double last_value) {
+    uint64_t hash = seriesHash(stable, metric, labels);
+    Shard& shard = m_shards[hash % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Series& series = shard.series[hash];
+    series.stable = stable;
+    series.metric = metric;
+    series.labels = labels;
+    series.trend = trend;
+    series.last_value = last_value;
+}
@@ -10,6 +10,9 @@
 #include "alarm_rule_storage.h"
 #include "alarm_rule_engine.h"
 #include "alarm_manager.h"
+#include "alarm_event_bus.h"
+#include "alarm_inhibitor.h"
+#include "alarm_notifier.h"
 #include "bmc_listener.h"
 #include "bmc_storage.h"
 #include "websocket_server.h"
@@ -26,6 +29,7 @@
 #include <signal.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 // 全局实例指针，用于信号处理
 AlarmSystem* AlarmSystem::s_instance = nullptr;
@@ -109,15 +113,33 @@ void AlarmSystem::stop() {
     if (http_server_) {
         http_server_->stop();
     }
+    if (resource_storage_) {
+        resource_storage_->setSampleObserver(nullptr);
+    }
     if (alarm_rule_engine_) {
         alarm_rule_engine_->stop();
     }
+    if (component_status_monitor_) {
+        component_status_monitor_->stop();
+    }
+    // 停止BMC监听器，BMC告警也是事件总线的生产者
+    bmc_listener_stop();
+    if (alarm_inhibitor_) {
+        alarm_inhibitor_->stop();
+    }
+    // 生产者都已停止，投递完剩余事件后再关闭WebSocket
+    if (alarm_event_bus_) {
+        alarm_event_bus_->stop();
+    }
+    // 通知有变化的分组并发送完队列
+    if (alarm_notifier_) {
+        alarm_notifier_->stop();
+    }
     if (websocket_server_) {
         websocket_server_->stop();
     }
     
-    // 停止BMC监听器
-    bmc_listener_stop();
+    // 释放BMC监听器资源
     bmc_listener_cleanup();
     
     
@@ -147,6 +169,17 @@ void AlarmSystem::run() {
     auto stats = getStats();
     LogManager::getLogger()->info("  - 活跃告警: {}", stats.active_alarms);
     LogManager::getLogger()->info("  - 总告警数: {}", stats.total_alarms);
+    LogManager::getLogger()->info("  - 告警评估: {}条规则 / {}次查询 / {}ms，超时周期 {}，慢规则 {}条", 
+                                  stats.alarm_eval_rules, stats.alarm_eval_queries, stats.alarm_eval_cycle_ms,
+                                  stats.alarm_eval_overruns, stats.alarm_eval_slow_rules);
+    LogManager::getLogger()->info("  - 告警事件: 最大积压 {}，缓冲区满等待 {}次，等待超时丢弃 {}个，抖动抑制 {}个",
+                                  stats.alarm_event_lag, stats.alarm_event_full_waits, stats.alarm_events_dropped,
+                                  stats.alarm_events_suppressed);
+    LogManager::getLogger()->info("  - 拓扑抑制: 活动根因 {}个，吸收事件 {}个",
+                                  stats.alarm_inhibition_roots, stats.alarm_events_inhibited);
+    LogManager::getLogger()->info("  - 分组通知: 已发送 {}，失败 {}，队列满丢弃 {}",
+                                  stats.alarm_notifications_sent, stats.alarm_notifications_failed,
+                                  stats.alarm_notifications_dropped);
     
     LogManager::getLogger()->info("✅ 告警系统已完全退出");
 }
@@ -172,6 +205,35 @@ AlarmSystemStats AlarmSystem::getStats() const {
     
     if (alarm_rule_engine_) {
         stats.alarm_instances = alarm_rule_engine_->getCurrentAlarmInstances().size();
+        AlarmEvaluationStats evaluation = alarm_rule_engine_->getEvaluationStats();
+        stats.alarm_eval_rules = static_cast<int>(evaluation.last_cycle_rules);
+        stats.alarm_eval_queries = static_cast<int>(evaluation.last_cycle_queries);
+        stats.alarm_eval_cycle_ms = evaluation.last_cycle_duration_ms;
+        stats.alarm_eval_overruns = static_cast<int64_t>(evaluation.overruns);
+        stats.alarm_eval_slow_rules = static_cast<int>(evaluation.slow_rules);
+        stats.alarm_events_suppressed = static_cast<int64_t>(evaluation.suppressed_events);
+    }
+    
+    if (alarm_event_bus_) {
+        for (const auto& consumer : alarm_event_bus_->getConsumerStats()) {
+            stats.alarm_event_lag = std::max(stats.alarm_event_lag, static_cast<int64_t>(consumer.lag));
+        }
+        stats.alarm_event_full_waits = static_cast<int64_t>(alarm_event_bus_->fullWaitCount());
+        stats.alarm_events_dropped = static_cast<int64_t>(alarm_event_bus_->droppedCount());
+    }
+    
+    if (alarm_inhibitor_) {
+        AlarmInhibitionStats inhibition = alarm_inhibitor_->getStats();
+        stats.alarm_events_inhibited = static_cast<int64_t>(inhibition.events_inhibited + inhibition.resolved_absorbed);
+        stats.alarm_inhibition_roots = static_cast<int>(inhibition.active_roots);
+    }
+    
+    if (alarm_notifier_) {
+        for (const auto& receiver : alarm_notifier_->getStats().receivers) {
+            stats.alarm_notifications_sent += static_cast<int64_t>(receiver.sent);
+            stats.alarm_notifications_failed += static_cast<int64_t>(receiver.failed);
+            stats.alarm_notifications_dropped += static_cast<int64_t>(receiver.dropped);
+        }
     }
     
     return stats;
@@ -391,6 +453,83 @@ bool AlarmSystem::initializeDatabase() {
     }
 }
 
+void AlarmSystem::initializeEventBus() {
+    alarm_event_bus_ = std::make_shared<AlarmEventBus>(
+        static_cast<size_t>(std::max(1, config_.alarm_event_bus_capacity)),
+        static_cast<size_t>(std::max(1, config_.alarm_event_batch_size)),
+        config_.alarm_event_full_wait);
+    
+    // 持久化：一批事件在同一事务中写入MySQL
+    alarm_event_bus_->addConsumer("persistence", [this](const std::vector<AlarmEvent>& events) {
+        if (alarm_manager_) {
+            alarm_manager_->processAlarmEvents(events);
+        }
+    });
+    
+    // WebSocket推送
+    alarm_event_bus_->addConsumer("websocket", [this](const std::vector<AlarmEvent>& events) {
+        broadcastAlarmEvents(events);
+    });
+    
+    // 分组后批量通知外部接收方（webhook）
+    if (!config_.alarm_notification.receivers.empty()) {
+        alarm_notifier_ = std::make_shared<AlarmNotifier>(config_.alarm_notification);
+        alarm_notifier_->start();
+        alarm_event_bus_->addConsumer("notification", [this](const std::vector<AlarmEvent>& events) {
+            alarm_notifier_->enqueue(events);
+        });
+    }
+    
+    // 用户设置的回调函数
+    alarm_event_bus_->addConsumer("callback", [this](const std::vector<AlarmEvent>& events) {
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        if (!alarm_event_callback_) {
+            return;
+        }
+        for (const auto& event : events) {
+            alarm_event_callback_(event);
+        }
+    });
+    
+    alarm_event_bus_->start();
+}
+
+void AlarmSystem::publishAlarmEvent(const AlarmEvent& event) {
+    // 依赖于活动根因（机箱失联、板卡不在位）的事件由抑制器吸收
+    if (alarm_inhibitor_ && !alarm_inhibitor_->admit(event)) {
+        return;
+    }
+    alarm_event_bus_->publish(event);
+}
+
+void AlarmSystem::broadcastAlarmEvents(const std::vector<AlarmEvent>& events) {
+    if (!websocket_server_) {
+        return;
+    }
+    for (const auto& event : events) {
+        try {
+            // 将告警事件转换为JSON格式
+            nlohmann::json alarm_json = {
+                {"fingerprint", event.fingerprint},
+                {"status", event.status},
+                {"labels", event.labels},
+                {"annotations", event.annotations},
+                {"starts_at", formatTimestamp(event.starts_at)},
+                {"ends_at", formatTimestamp(event.ends_at)}
+            };
+            
+            // 广播告警事件
+            websocket_server_->broadcast(alarm_json.dump());
+            
+            // 从labels中获取告警名称用于日志
+            std::string alert_name = event.labels.count("alertname") ? event.labels.at("alertname") : "unknown";
+            LogManager::getLogger()->debug("告警事件已通过WebSocket广播: {}", alert_name);
+        } catch (const std::exception& e) {
+            LogManager::getLogger()->error("WebSocket广播告警失败: {}", e.what());
+        }
+    }
+}
+
 bool AlarmSystem::initializeServices() {
     try {
         // 1. 初始化组播发送器
@@ -412,6 +551,7 @@ bool AlarmSystem::initializeServices() {
         // 3. 启动HTTP服务器
         LogManager::getLogger()->info("🌐 启动HTTP服务器...");
         http_server_ = std::make_shared<HttpServer>(resource_storage_, alarm_rule_storage_, alarm_manager_, node_storage_, resource_manager_, bmc_storage_);
+        http_server_->setQueryTimeoutMs(config_.http_query_timeout_ms);
         if (!http_server_->start()) {
             std::lock_guard<std::mutex> lock(error_mutex_);
             last_error_ = "HTTP服务器启动失败";
@@ -424,46 +564,54 @@ bool AlarmSystem::initializeServices() {
         alarm_rule_engine_ = std::make_shared<AlarmRuleEngine>(
             alarm_rule_storage_, resource_storage_);
         
-        // 5. 设置告警事件回调
+        // 5. 设置告警事件回调：只发布到事件总线，持久化和推送由总线的消费者异步完成
+        initializeEventBus();
+        if (config_.alarm_inhibition_enabled) {
+            // 根因告警由抑制器直接发布到总线
+            alarm_inhibitor_ = std::make_shared<AlarmInhibitor>(node_storage_, alarm_manager_, [this](const AlarmEvent& event) {
+                alarm_event_bus_->publish(event);
+            });
+            alarm_inhibitor_->setReleaseDelay(config_.alarm_inhibition_release_delay);
+            alarm_inhibitor_->start();
+        }
         alarm_rule_engine_->setAlarmEventCallback([this](const AlarmEvent& event) {
-            // 处理告警事件到 AlarmManager
-            if (alarm_manager_) {
-                alarm_manager_->processAlarmEvent(event);
-            }
-            
-            // 通过WebSocket广播告警事件
-            if (websocket_server_) {
-                try {
-                    // 将告警事件转换为JSON格式
-                    nlohmann::json alarm_json = {
-                        {"fingerprint", event.fingerprint},
-                        {"status", event.status},
-                        {"labels", event.labels},
-                        {"annotations", event.annotations},
-                        {"starts_at", formatTimestamp(event.starts_at)},
-                        {"ends_at", formatTimestamp(event.ends_at)}
-                    };
-                    
-                    // 广播告警事件
-                    websocket_server_->broadcast(alarm_json.dump());
-                    
-                    // 从labels中获取告警名称用于日志
-                    std::string alert_name = event.labels.count("alertname") ? event.labels.at("alertname") : "unknown";
-                    LogManager::getLogger()->debug("告警事件已通过WebSocket广播: {}", alert_name);
-                } catch (const std::exception& e) {
-                    LogManager::getLogger()->error("WebSocket广播告警失败: {}", e.what());
-                }
-            }
-            
-            // 调用用户设置的回调函数
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            if (alarm_event_callback_) {
-                alarm_event_callback_(event);
-            }
+            publishAlarmEvent(event);
         });
         
         // 设置评估间隔
         alarm_rule_engine_->setEvaluationInterval(config_.evaluation_interval);
+        alarm_rule_engine_->setEvaluationMode(config_.alarm_streaming_evaluation
+            ? AlarmEvaluationMode::STREAMING : AlarmEvaluationMode::POLLING);
+        alarm_rule_engine_->setSweepInterval(config_.alarm_sweep_interval);
+        alarm_rule_engine_->setWorkerThreads(static_cast<size_t>(std::max(1, config_.alarm_worker_threads)));
+        alarm_rule_engine_->setStateFile(config_.alarm_state_file);
+        alarm_rule_engine_->setSnapshotInterval(config_.alarm_snapshot_interval);
+        alarm_rule_engine_->setFlapDetection(config_.alarm_flap_window,
+                                             static_cast<size_t>(std::max(0, config_.alarm_flap_threshold)));
+        alarm_rule_engine_->setForecastLookback(config_.alarm_forecast_lookback);
+        alarm_rule_engine_->setRuleCostBudget(config_.alarm_rule_cost_budget);
+        {
+            std::weak_ptr<NodeStorage> weak_nodes = node_storage_;
+            alarm_rule_engine_->setHostLocator([weak_nodes](const std::string& host_ip, int& box_id) {
+                auto nodes = weak_nodes.lock();
+                auto node = nodes ? nodes->getNodeDataReadonly(host_ip) : nullptr;
+                if (!node) {
+                    return false;
+                }
+                box_id = node->box_id;
+                return true;
+            });
+        }
+        
+        // 资源数据写入时把样本推送给告警引擎（轮询模式下只用于窗口、异常检测、缺失和耗尽预测规则）
+        {
+            std::weak_ptr<AlarmRuleEngine> weak_engine = alarm_rule_engine_;
+            resource_storage_->setSampleObserver([weak_engine](const std::vector<MetricSample>& samples) {
+                if (auto engine = weak_engine.lock()) {
+                    engine->ingestSamples(samples);
+                }
+            });
+        }
         
         // 6. 启动告警引擎
         if (!alarm_rule_engine_->start()) {
@@ -472,6 +620,7 @@ bool AlarmSystem::initializeServices() {
             return false;
         }
         LogManager::getLogger()->info("✅ 告警规则引擎启动成功");
+        http_server_->setAlarmRuleEngine(alarm_rule_engine_);
         
         // 7. 初始化节点状态监控器
         LogManager::getLogger()->info("👁️ 初始化节点状态监控器...");
@@ -483,7 +632,7 @@ bool AlarmSystem::initializeServices() {
             });
 
             if (new_status == "offline") {
-                // 1) 直接构造 AlarmEvent 并提交给 AlarmManager
+                // 构造 AlarmEvent 并发布到事件总线（持久化与WebSocket广播）
                 AlarmEvent event;
                 event.fingerprint = fingerprint;
                 event.status = "firing";
@@ -498,16 +647,7 @@ bool AlarmSystem::initializeServices() {
                     {"summary", "节点离线"},
                     {"description", std::string("与节点 ") + host_ip + " 失联。"}
                 };
-                alarm_manager_->processAlarmEvent(event);
-
-                // 2) 仍保留原有的WebSocket广播
-                nlohmann::json labels_json = event.labels;
-                nlohmann::json annotations = event.annotations;
-                nlohmann::json alarm_json = {
-                    {"labels", labels_json},
-                    {"annotations", annotations}
-                };
-                websocket_server_->broadcast(alarm_json.dump());
+                publishAlarmEvent(event);
 
                 LogManager::getLogger()->warn("Node '{}' is offline.", host_ip);
             } else if (new_status == "online") {
@@ -516,7 +656,7 @@ bool AlarmSystem::initializeServices() {
                 event.fingerprint = fingerprint;
                 event.status = "resolved";
                 event.ends_at = std::chrono::system_clock::now();
-                alarm_manager_->processAlarmEvent(event);
+                publishAlarmEvent(event);
 
                 LogManager::getLogger()->info("Node '{}' is back online.", host_ip);
             }
@@ -555,7 +695,7 @@ bool AlarmSystem::initializeServices() {
                     websocket_server_->broadcast(msg.dump());
                 }
 
-                // 即刻写数据库（进入FAILED -> firing；FAILED恢复 -> resolved）
+                // 发布告警事件（进入FAILED -> firing；FAILED恢复 -> resolved）
                 if (!alarm_manager_) return;
                 std::map<std::string, std::string> labels = {
                     {"host_ip", host_ip},
@@ -577,13 +717,13 @@ bool AlarmSystem::initializeServices() {
                         {"summary", "组件进入FAILED状态"},
                         {"description", "组件 (" + instance_id + "/" + uuid + ") 在主机 " + host_ip + " 进入FAILED状态"}
                     };
-                    alarm_manager_->processAlarmEvent(event);
+                    publishAlarmEvent(event);
                 } else if (old_state == "FAILED" && new_state != "FAILED") {
                     AlarmEvent event;
                     event.fingerprint = fingerprint;
                     event.status = "resolved";
                     event.ends_at = std::chrono::system_clock::now();
-                    alarm_manager_->processAlarmEvent(event);
+                    publishAlarmEvent(event);
                 }
             } catch (const std::exception& e) {
                 LogManager::getLogger()->error("Component status change callback error: {}", e.what());
@@ -604,6 +744,11 @@ bool AlarmSystem::initializeServices() {
         bmc_listener_set_callback([this](const UdpInfo& data) {
             LogManager::getLogger()->debug("收到BMC数据");
             
+            // 先更新抑制器的机箱上报时间，再刷新节点心跳
+            if (alarm_inhibitor_) {
+                alarm_inhibitor_->observeBmc(data);
+            }
+            
             // 直接存储BMC数据到数据库
             if (bmc_storage_) {
                 if (!bmc_storage_->storeBMCData(data)) {
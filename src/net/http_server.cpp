@@ -1,6 +1,8 @@
 #include "http_server.h"
+#include "alarm_rule_engine.h"
 #include "node_model.h"
 #include "log_manager.h"
+#include "query_deadline.h"
 #include "json.hpp"
 #include <iostream>
 #include <regex>
@@ -898,8 +900,19 @@ HttpServer::HttpServer(std::shared_ptr<ResourceStorage> resource_storage,
     : m_resource_storage(resource_storage), m_alarm_rule_storage(alarm_rule_storage),
       m_alarm_manager(alarm_manager), m_node_storage(node_storage),
       m_resource_manager(resource_manager), m_bmc_storage(bmc_storage),
-      m_chassis_controller(chassis_controller), m_host(host), m_port(port)
+      m_chassis_controller(chassis_controller), m_placement_index(std::make_shared<PlacementIndex>()),
+      m_host(host), m_port(port)
 {
+    if (m_node_storage)
+    {
+        // 节点被删除或离线时从放置索引中移除，放置查询不再扫过不可用的节点
+        std::weak_ptr<PlacementIndex> weak_index = m_placement_index;
+        m_node_storage->addNodeUnavailableCallback([weak_index](const std::string &host_ip)
+                                                   {
+            if (auto index = weak_index.lock()) {
+                index->removeNode(host_ip);
+            } });
+    }
     setup_routes();
 }
 
@@ -947,6 +960,55 @@ void HttpServer::stop()
     }
 }
 
+void HttpServer::setQueryTimeoutMs(int timeout_ms)
+{
+    m_query_timeout_ms.store(timeout_ms);
+}
+
+void HttpServer::setAlarmRuleEngine(std::shared_ptr<AlarmRuleEngine> engine)
+{
+    std::atomic_store(&m_alarm_rule_engine, std::move(engine));
+}
+
+void HttpServer::with_query_deadline(const std::string &endpoint, const httplib::Request &req, httplib::Response &res,
+                                     const std::function<void()> &handler)
+{
+    // 请求方可以通过 timeout_ms 缩短截止时间，但不能超过服务端配置
+    int64_t timeout_ms = m_query_timeout_ms.load();
+    std::string timeout_str = req.get_param_value("timeout_ms");
+    if (!timeout_str.empty())
+    {
+        try
+        {
+            int64_t requested = std::stoll(timeout_str);
+            if (requested > 0 && (timeout_ms <= 0 || requested < timeout_ms))
+            {
+                timeout_ms = requested;
+            }
+        }
+        catch (const std::exception &)
+        {
+            res.set_content("{\"error\":\"Invalid timeout_ms parameter\"}", "application/json");
+            res.status = 400;
+            return;
+        }
+    }
+
+    QueryDeadlineScope scope(QueryDeadline::afterMs(timeout_ms));
+    handler();
+
+    if (scope.exceeded())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_deadline_mutex);
+            m_deadline_hits[endpoint]++;
+        }
+        res.set_content("{\"error\":\"Query deadline exceeded\"}", "application/json");
+        res.status = 504;
+        LogManager::getLogger()->warn("Query deadline of {} ms exceeded for {}", timeout_ms, endpoint);
+    }
+}
+
 void HttpServer::setup_routes()
 {
     m_server.Get("/", [this](const httplib::Request &, httplib::Response &res)
@@ -966,14 +1028,22 @@ void HttpServer::setup_routes()
 
     // 节点指标查询路由
     m_server.Get("/node/metrics", [this](const httplib::Request &req, httplib::Response &res)
-                 { this->handle_node_metrics(req, res); });
+                 { this->with_query_deadline("/node/metrics", req, res, [&]() { this->handle_node_metrics(req, res); }); });
 
     // 节点历史指标查询路由
     m_server.Get("/node/historical-metrics", [this](const httplib::Request &req, httplib::Response &res)
-                 { this->handle_node_historical_metrics(req, res); });
+                 { this->with_query_deadline("/node/historical-metrics", req, res, [&]() { this->handle_node_historical_metrics(req, res); }); });
 
     m_server.Get("/node/historical-bmc", [this](const httplib::Request &req, httplib::Response &res)
-                 { this->handle_node_historical_bmc(req, res); });
+                 { this->with_query_deadline("/node/historical-bmc", req, res, [&]() { this->handle_node_historical_bmc(req, res); }); });
+
+    // 放置候选节点查询路由
+    m_server.Get("/placement/candidates", [this](const httplib::Request &req, httplib::Response &res)
+                 { this->handle_placement_candidates(req, res); });
+
+    // 查询截止时间统计路由
+    m_server.Get("/query/stats", [this](const httplib::Request &req, httplib::Response &res)
+                 { this->handle_query_stats(req, res); });
 
     // 告警规则相关路由
     m_server.Post("/alarm/rules", [this](const httplib::Request &req, httplib::Response &res)
@@ -982,6 +1052,18 @@ void HttpServer::setup_routes()
     m_server.Get("/alarm/rules", [this](const httplib::Request &req, httplib::Response &res)
                  { this->handle_alarm_rules_list(req, res); });
 
+    m_server.Post("/alarm/rules/backtest", [this](const httplib::Request &req, httplib::Response &res)
+                  { this->with_query_deadline("/alarm/rules/backtest", req, res, [&]() { this->handle_alarm_rules_backtest(req, res); }); });
+
+    m_server.Post("/alarm/rules/preview", [this](const httplib::Request &req, httplib::Response &res)
+                  { this->with_query_deadline("/alarm/rules/preview", req, res, [&]() { this->handle_alarm_rules_preview(req, res); }); });
+
+    m_server.Get("/alarm/forecasts", [this](const httplib::Request &req, httplib::Response &res)
+                 { this->handle_alarm_forecasts(req, res); });
+
+    m_server.Get("/alarm/engine/stats", [this](const httplib::Request &req, httplib::Response &res)
+                 { this->handle_alarm_engine_stats(req, res); });
+
     m_server.Get(R"(/alarm/rules/([^/]+))", [this](const httplib::Request &req, httplib::Response &res)
                  { this->handle_alarm_rules_get(req, res); });
 
@@ -993,10 +1075,10 @@ void HttpServer::setup_routes()
 
     // 告警事件相关路由
     m_server.Get("/alarm/events", [this](const httplib::Request &req, httplib::Response &res)
-                 { this->handle_alarm_events_list(req, res); });
+                 { this->with_query_deadline("/alarm/events", req, res, [&]() { this->handle_alarm_events_list(req, res); }); });
 
     m_server.Get("/alarm/events/count", [this](const httplib::Request &req, httplib::Response &res)
-                 { this->handle_alarm_events_count(req, res); });
+                 { this->with_query_deadline("/alarm/events/count", req, res, [&]() { this->handle_alarm_events_count(req, res); }); });
 
     // 机箱控制相关路由
     m_server.Post("/chassis/reset", [this](const httplib::Request &req, httplib::Response &res)
@@ -1317,6 +1399,423 @@ void HttpServer::handle_alarm_rules_delete(const httplib::Request &req, httplib:
     }
 }
 
+/*
+ * 规则回测
+ * 
+ * 请求体提供 rule_id（回测已有规则）或 expression / for（回测尚未保存的规则），
+ * start / end 为毫秒时间戳，end 缺省为当前时间，区间不超过31天；max_events 限制返回的事件条数。
+ * 回放不影响运行中的告警实例，也不产生告警事件。
+ */
+void HttpServer::handle_alarm_rules_backtest(const httplib::Request &req, httplib::Response &res)
+{
+    const int64_t kMaxRangeMs = 31LL * 24 * 3600 * 1000;
+    const size_t kDefaultMaxEvents = 1000;
+    const size_t kMaxEventsLimit = 100000;
+
+    try
+    {
+        auto engine = std::atomic_load(&m_alarm_rule_engine);
+        if (!engine)
+        {
+            res.set_content("{\"error\":\"Alarm rule engine not available\"}", "application/json");
+            res.status = 503;
+            return;
+        }
+
+        json body = json::parse(req.body);
+
+        AlarmRule rule;
+        if (body.contains("rule_id"))
+        {
+            rule = m_alarm_rule_storage->getAlarmRule(body["rule_id"].get<std::string>());
+            if (rule.id.empty())
+            {
+                res.set_content("{\"error\":\"Alarm rule not found\"}", "application/json");
+                res.status = 404;
+                return;
+            }
+        }
+        else
+        {
+            if (!body.contains("expression"))
+            {
+                res.set_content("{\"error\":\"Missing rule_id or expression\"}", "application/json");
+                res.status = 400;
+                return;
+            }
+            rule.alert_name = body.value("alert_name", std::string("backtest"));
+            rule.expression_json = body["expression"].dump();
+            rule.for_duration = body.value("for", std::string("0s"));
+        }
+
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+        int64_t end_ms = body.value("end", now_ms);
+        int64_t start_ms = body.value("start", int64_t(0));
+        if (!body.contains("start") || start_ms >= end_ms || end_ms - start_ms > kMaxRangeMs)
+        {
+            res.set_content("{\"error\":\"Invalid time range, start and end are millisecond timestamps within 31 days\"}", "application/json");
+            res.status = 400;
+            return;
+        }
+        size_t max_events = std::min(body.value("max_events", kDefaultMaxEvents), kMaxEventsLimit);
+
+        AlarmBacktestResult result;
+        std::string error;
+        if (!engine->backtestRule(rule, start_ms, end_ms, max_events, result, error))
+        {
+            json error_json = {{"error", error}};
+            res.set_content(error_json.dump(), "application/json");
+            res.status = error == "Invalid rule expression" || error.find("cannot be backtested") != std::string::npos ? 400 : 500;
+            LogManager::getLogger()->error("Alarm rule backtest failed: {}", error);
+            return;
+        }
+
+        json events = json::array();
+        for (const auto &event : result.events)
+        {
+            events.push_back({{"status", event.status},
+                              {"timestamp", event.timestamp},
+                              {"starts_at", event.starts_at},
+                              {"value", event.value},
+                              {"labels", event.labels}});
+        }
+
+        json data = {
+            {"alert_name", rule.alert_name},
+            {"start", start_ms},
+            {"end", end_ms},
+            {"partitions", result.partitions},
+            {"rows", result.rows},
+            {"firing_events", result.firing_events},
+            {"resolved_events", result.resolved_events},
+            {"pending_cleared", result.pending_cleared},
+            {"suppressed_events", result.suppressed_events},
+            {"firing_at_end", result.firing_at_end},
+            {"firing_duration_ms", result.firing_duration_ms},
+            {"elapsed_ms", result.elapsed_ms},
+            {"truncated", result.truncated},
+            {"events", events}};
+
+        json response = {
+            {"api_version", 1},
+            {"status", "success"},
+            {"data", data}};
+
+        res.set_content(response.dump(2), "application/json");
+        res.status = 200;
+        LogManager::getLogger()->info("Backtested alarm rule {}: {} firing events over {} rows",
+                                      rule.alert_name, result.firing_events, result.rows);
+    }
+    catch (const json::exception &e)
+    {
+        res.set_content("{\"error\":\"Invalid JSON format\"}", "application/json");
+        res.status = 400;
+        LogManager::getLogger()->error("Exception in handle_alarm_rules_backtest: {}", e.what());
+    }
+    catch (const std::exception &e)
+    {
+        res.set_content("{\"error\":\"An unexpected error occurred\"}", "application/json");
+        res.status = 500;
+        LogManager::getLogger()->error("Exception in handle_alarm_rules_backtest: {}", e.what());
+    }
+}
+
+/*
+ * 规则预览
+ * 
+ * 请求体与回测相同，提供 rule_id 或 expression / for；max_matches 限制返回的序列条数。
+ * 用最新数据立即评估一次，不创建告警实例，也不产生告警事件。
+ */
+void HttpServer::handle_alarm_rules_preview(const httplib::Request &req, httplib::Response &res)
+{
+    const size_t kDefaultMaxMatches = 1000;
+    const size_t kMaxMatchesLimit = 100000;
+
+    try
+    {
+        auto engine = std::atomic_load(&m_alarm_rule_engine);
+        if (!engine)
+        {
+            res.set_content("{\"error\":\"Alarm rule engine not available\"}", "application/json");
+            res.status = 503;
+            return;
+        }
+
+        json body = json::parse(req.body);
+
+        AlarmRule rule;
+        if (body.contains("rule_id"))
+        {
+            rule = m_alarm_rule_storage->getAlarmRule(body["rule_id"].get<std::string>());
+            if (rule.id.empty())
+            {
+                res.set_content("{\"error\":\"Alarm rule not found\"}", "application/json");
+                res.status = 404;
+                return;
+            }
+        }
+        else
+        {
+            if (!body.contains("expression"))
+            {
+                res.set_content("{\"error\":\"Missing rule_id or expression\"}", "application/json");
+                res.status = 400;
+                return;
+            }
+            rule.alert_name = body.value("alert_name", std::string("preview"));
+            rule.expression_json = body["expression"].dump();
+            rule.for_duration = body.value("for", std::string("0s"));
+        }
+        size_t max_matches = std::min(body.value("max_matches", kDefaultMaxMatches), kMaxMatchesLimit);
+
+        AlarmPreviewResult result;
+        std::string error;
+        if (!engine->previewRule(rule, max_matches, result, error))
+        {
+            json error_json = {{"error", error}};
+            res.set_content(error_json.dump(), "application/json");
+            res.status = error == "Invalid rule expression" || error.find("cannot be previewed") != std::string::npos ? 400 : 500;
+            LogManager::getLogger()->error("Alarm rule preview failed: {}", error);
+            return;
+        }
+
+        json matches = json::array();
+        for (const auto &match : result.matches)
+        {
+            matches.push_back({{"fingerprint", match.fingerprint},
+                               {"labels", match.labels},
+                               {"value", match.value},
+                               {"timestamp", match.timestamp},
+                               {"state", match.state}});
+        }
+
+        json data = {
+            {"alert_name", rule.alert_name},
+            {"sql", result.sql},
+            {"series", result.series},
+            {"matched_series", result.matched_series},
+            {"matched_hosts", result.matched_hosts},
+            {"instances", result.instances},
+            {"query_ms", result.query_ms},
+            {"elapsed_ms", result.elapsed_ms},
+            {"truncated", result.truncated},
+            {"matches", matches}};
+
+        json response = {
+            {"api_version", 1},
+            {"status", "success"},
+            {"data", data}};
+
+        res.set_content(response.dump(2), "application/json");
+        res.status = 200;
+    }
+    catch (const json::exception &e)
+    {
+        res.set_content("{\"error\":\"Invalid JSON format\"}", "application/json");
+        res.status = 400;
+        LogManager::getLogger()->error("Exception in handle_alarm_rules_preview: {}", e.what());
+    }
+    catch (const std::exception &e)
+    {
+        res.set_content("{\"error\":\"An unexpected error occurred\"}", "application/json");
+        res.status = 500;
+        LogManager::getLogger()->error("Exception in handle_alarm_rules_preview: {}", e.what());
+    }
+}
+
+void HttpServer::handle_alarm_forecasts(const httplib::Request &req, httplib::Response &res)
+{
+    const size_t kDefaultLimit = 100;
+    const int kMaxLimit = 10000;
+
+    try
+    {
+        auto engine = std::atomic_load(&m_alarm_rule_engine);
+        if (!engine)
+        {
+            res.set_content("{\"error\":\"Alarm rule engine not available\"}", "application/json");
+            res.status = 503;
+            return;
+        }
+
+        std::string stable = req.get_param_value("stable");
+        std::string metric = req.get_param_value("metric");
+        std::string capacity_str = req.get_param_value("capacity");
+        std::string within_str = req.get_param_value("within");
+        std::string limit_str = req.get_param_value("limit");
+        double capacity = capacity_str.empty() ? 100.0 : std::stod(capacity_str);
+        size_t limit = limit_str.empty() ? kDefaultLimit : static_cast<size_t>(std::max(1, std::min(kMaxLimit, std::stoi(limit_str))));
+
+        double within_s = 0.0;
+        if (!within_str.empty())
+        {
+            within_s = static_cast<double>(AlarmRuleEngine::parseDuration(within_str).count());
+            if (within_s <= 0.0)
+            {
+                res.set_content("{\"error\":\"Invalid within, expected a duration such as 24h\"}", "application/json");
+                res.status = 400;
+                return;
+            }
+        }
+
+        size_t tracked = 0;
+        auto forecasts = engine->getForecasts(stable, metric, capacity, within_s, limit, tracked);
+
+        json items = json::array();
+        for (const auto &forecast : forecasts)
+        {
+            items.push_back({{"stable", forecast.stable},
+                             {"metric", forecast.metric},
+                             {"labels", forecast.labels},
+                             {"value", forecast.value},
+                             {"level", forecast.level},
+                             {"slope_per_hour", forecast.slope_per_hour},
+                             {"time_to_full_s", forecast.time_to_full_s},
+                             {"predicted_full_at", forecast.updated_at + static_cast<int64_t>(forecast.time_to_full_s * 1000.0)},
+                             {"updated_at", forecast.updated_at},
+                             {"samples", forecast.samples}});
+        }
+
+        json response = {
+            {"api_version", 1},
+            {"status", "success"},
+            {"data", {
+                {"capacity", capacity},
+                {"tracked", tracked},
+                {"count", items.size()},
+                {"forecasts", items}
+            }}};
+
+        res.set_content(response.dump(2), "application/json");
+        res.status = 200;
+    }
+    catch (const std::invalid_argument &e)
+    {
+        res.set_content("{\"error\":\"Invalid numeric parameter\"}", "application/json");
+        res.status = 400;
+        LogManager::getLogger()->warn("Invalid parameter in handle_alarm_forecasts: {}", e.what());
+    }
+    catch (const std::exception &e)
+    {
+        res.set_content("{\"error\":\"Failed to query forecasts\"}", "application/json");
+        res.status = 500;
+        LogManager::getLogger()->error("Exception in handle_alarm_forecasts: {}", e.what());
+    }
+}
+
+void HttpServer::handle_alarm_engine_stats(const httplib::Request &req, httplib::Response &res)
+{
+    const size_t kDefaultTop = 10;
+    const int kMaxTop = 1000;
+
+    try
+    {
+        auto engine = std::atomic_load(&m_alarm_rule_engine);
+        if (!engine)
+        {
+            res.set_content("{\"error\":\"Alarm rule engine not available\"}", "application/json");
+            res.status = 503;
+            return;
+        }
+
+        std::string top_str = req.get_param_value("top");
+        size_t top = top_str.empty() ? kDefaultTop : static_cast<size_t>(std::max(1, std::min(kMaxTop, std::stoi(top_str))));
+
+        AlarmEvaluationStats stats = engine->getEvaluationStats();
+        int64_t window_ms = 0;
+        std::vector<AlarmRuleProfile> profiles = engine->getRuleProfiles(window_ms);
+
+        // 窗口内没有评估记录的规则（只在写入路径上评估、或尚未评估）不参与排序
+        std::vector<const AlarmRuleProfile *> ranked;
+        json slow_rules = json::array();
+        for (const auto &profile : profiles)
+        {
+            if (profile.cost_us.count > 0)
+            {
+                ranked.push_back(&profile);
+            }
+            if (profile.over_budget)
+            {
+                slow_rules.push_back(profile.alert_name);
+            }
+        }
+        // 按窗口内开销总和排序：评估频繁的规则与单次开销大的规则同样占用评估周期
+        auto by_cost = [](const AlarmRuleProfile *a, const AlarmRuleProfile *b) { return a->cost_us.sum > b->cost_us.sum; };
+        if (ranked.size() > top)
+        {
+            std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(), by_cost);
+            ranked.resize(top);
+        }
+        else
+        {
+            std::sort(ranked.begin(), ranked.end(), by_cost);
+        }
+
+        auto summary_json = [](const HistogramSummary &summary) {
+            return json{{"count", summary.count},
+                        {"mean", summary.count > 0 ? static_cast<double>(summary.sum) / static_cast<double>(summary.count) : 0.0},
+                        {"p50", summary.p50},
+                        {"p90", summary.p90},
+                        {"p99", summary.p99},
+                        {"max", summary.max}};
+        };
+
+        json top_rules = json::array();
+        for (const AlarmRuleProfile *profile : ranked)
+        {
+            top_rules.push_back({{"alert_name", profile->alert_name},
+                                 {"kind", profile->kind},
+                                 {"evaluations", profile->evaluations},
+                                 {"cost_us", summary_json(profile->cost_us)},
+                                 {"query_us", summary_json(profile->query_us)},
+                                 {"reconcile_us", summary_json(profile->reconcile_us)},
+                                 {"rows", summary_json(profile->rows)},
+                                 {"instances", summary_json(profile->instances)},
+                                 {"events", summary_json(profile->events)},
+                                 {"current_instances", profile->current_instances},
+                                 {"events_total", profile->events_total},
+                                 {"over_budget", profile->over_budget}});
+        }
+
+        json response = {
+            {"api_version", 1},
+            {"status", "success"},
+            {"data", {
+                {"cycles", stats.cycles},
+                {"total_queries", stats.total_queries},
+                {"last_cycle_rules", stats.last_cycle_rules},
+                {"last_cycle_queries", stats.last_cycle_queries},
+                {"last_cycle_duration_ms", stats.last_cycle_duration_ms},
+                {"max_cycle_duration_ms", stats.max_cycle_duration_ms},
+                {"overruns", stats.overruns},
+                {"worker_threads", stats.worker_threads},
+                {"suppressed_events", stats.suppressed_events},
+                {"rule_cost_budget_ms", stats.rule_cost_budget_ms},
+                {"window_s", window_ms / 1000},
+                {"rules", profiles.size()},
+                {"slow_rules", slow_rules},
+                {"top_rules", top_rules}
+            }}};
+
+        res.set_content(response.dump(2), "application/json");
+        res.status = 200;
+    }
+    catch (const std::invalid_argument &e)
+    {
+        res.set_content("{\"error\":\"Invalid numeric parameter\"}", "application/json");
+        res.status = 400;
+        LogManager::getLogger()->warn("Invalid parameter in handle_alarm_engine_stats: {}", e.what());
+    }
+    catch (const std::exception &e)
+    {
+        res.set_content("{\"error\":\"Failed to query alarm engine stats\"}", "application/json");
+        res.status = 500;
+        LogManager::getLogger()->error("Exception in handle_alarm_engine_stats: {}", e.what());
+    }
+}
+
 void HttpServer::handle_resource(const httplib::Request &req, httplib::Response &res)
 {
     try
@@ -1361,6 +1860,9 @@ void HttpServer::handle_resource(const httplib::Request &req, httplib::Response
 
         if (m_resource_storage->insertResourceData(resource_info.host_ip, resource_info))
         {
+            // 写入成功后再更新放置容量索引，避免索引领先于存储
+            m_placement_index->updateResource(resource_info.host_ip, resource_info.resource);
+
             json response = {
                 {"api_version", 1},
                 {"status", "success"},
@@ -1596,6 +2098,9 @@ void HttpServer::handle_heart(const httplib::Request &req, httplib::Response &re
 
         if (m_node_storage->storeBoxInfo(node_info))
         {
+            // 写入成功后再更新放置容量索引，避免索引领先于存储
+            m_placement_index->updateNodeInfo(node_info);
+
             json response = {
                 {"api_version", 1},
                 {"status", "success"},
@@ -1701,11 +2206,75 @@ void HttpServer::handle_node_metrics(const httplib::Request &req, httplib::Respo
 {
     try
     {
+        // 带有 fields/filter/sort/cursor 参数时使用游标分页查询
+        if (req.has_param("fields") || req.has_param("filter") || req.has_param("sort") || req.has_param("cursor"))
+        {
+            NodeMetricsQuery query;
+            query.fields = req.get_param_value("fields");
+            query.filter = req.get_param_value("filter");
+            query.sort = req.get_param_value("sort");
+            query.cursor = req.get_param_value("cursor");
+            std::string page_size_str = req.get_param_value("page_size");
+            if (!page_size_str.empty())
+            {
+                try
+                {
+                    query.limit = std::stoi(page_size_str);
+                }
+                catch (const std::exception &)
+                {
+                    res.set_content("{\"error\":\"Invalid page_size parameter\"}", "application/json");
+                    res.status = 400;
+                    return;
+                }
+            }
+
+            auto query_result = m_resource_manager->queryCurrentMetrics(query);
+            if (query_result.success)
+            {
+                json response = {
+                    {"api_version", 1},
+                    {"data", {{"nodes_metrics", query_result.nodes_metrics}}},
+                    {"pagination", query_result.pagination},
+                    {"status", "success"}};
+
+                res.set_header("X-Page-Size", std::to_string(query_result.pagination.page_size));
+                res.set_header("X-Total-Count", std::to_string(query_result.pagination.total_count));
+                res.set_header("X-Has-Next", query_result.pagination.has_next ? "true" : "false");
+                if (!query_result.pagination.next_cursor.empty())
+                {
+                    res.set_header("X-Next-Cursor", query_result.pagination.next_cursor);
+                }
+
+                res.set_content(response.dump(2), "application/json");
+                res.status = 200;
+            }
+            else
+            {
+                json error_response = {{"error", query_result.error_message}};
+                res.set_content(error_response.dump(), "application/json");
+                res.status = query_result.invalid_request ? 400 : 500;
+                LogManager::getLogger()->error("ResourceManager failed to query node metrics: {}", query_result.error_message);
+            }
+            return;
+        }
+
         std::string page_str = req.get_param_value("page");
         std::string page_size_str = req.get_param_value("page_size");
 
-        int page = page_str.empty() ? 1 : std::stoi(page_str);
-        int page_size = page_size_str.empty() ? 1000 : std::stoi(page_size_str);
+        int page = 1;
+        int page_size = 1000;
+        try
+        {
+            page = page_str.empty() ? 1 : std::stoi(page_str);
+            page_size = page_size_str.empty() ? 1000 : std::stoi(page_size_str);
+        }
+        catch (const std::exception &)
+        {
+            res.set_content("{\"error\":\"Invalid page or page_size parameter\"}", "application/json");
+            res.status = 400;
+            return;
+        }
 
         auto paginated_result = m_resource_manager->getPaginatedCurrentMetrics(page, page_size);
 
@@ -1853,6 +2422,82 @@ void HttpServer::handle_node_historical_bmc(const httplib::Request &req, httplib
     }
 }
 
+void HttpServer::handle_placement_candidates(const httplib::Request &req, httplib::Response &res)
+{
+    try
+    {
+        PlacementQuery query;
+        std::string cores_str = req.get_param_value("cores");
+        std::string gpus_str = req.get_param_value("gpus");
+        std::string limit_str = req.get_param_value("limit");
+        query.min_free_cores = cores_str.empty() ? 0 : std::stoi(cores_str);
+        query.min_free_gpus = gpus_str.empty() ? 0 : std::stoi(gpus_str);
+        query.cpu_arch = req.get_param_value("cpu_arch");
+        query.resource_type = req.get_param_value("resource_type");
+        query.limit = limit_str.empty() ? 10 : static_cast<size_t>(std::max(1, std::min(1000, std::stoi(limit_str))));
+
+        std::string policy = req.get_param_value("policy");
+        if (!PlacementIndex::parsePolicy(policy, query.policy))
+        {
+            res.set_content("{\"error\":\"Invalid policy, expected best_fit or least_loaded\"}", "application/json");
+            res.status = 400;
+            return;
+        }
+
+        auto candidates = m_placement_index->findCandidates(query);
+
+        json response = {
+            {"api_version", 1},
+            {"status", "success"},
+            {"data", {
+                {"policy", policy.empty() ? "best_fit" : policy},
+                {"count", candidates.size()},
+                {"candidates", candidates}
+            }}};
+
+        res.set_content(response.dump(2), "application/json");
+        res.status = 200;
+    }
+    catch (const std::invalid_argument &e)
+    {
+        res.set_content("{\"error\":\"Invalid numeric parameter\"}", "application/json");
+        res.status = 400;
+        LogManager::getLogger()->warn("Invalid parameter in handle_placement_candidates: {}", e.what());
+    }
+    catch (const std::exception &e)
+    {
+        res.set_content("{\"error\":\"Failed to query placement candidates\"}", "application/json");
+        res.status = 500;
+        LogManager::getLogger()->error("Exception in handle_placement_candidates: {}", e.what());
+    }
+}
+
+void HttpServer::handle_query_stats(const httplib::Request &, httplib::Response &res)
+{
+    json hits = json::object();
+    uint64_t total = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_deadline_mutex);
+        for (const auto &entry : m_deadline_hits)
+        {
+            hits[entry.first] = entry.second;
+            total += entry.second;
+        }
+    }
+
+    json response = {
+        {"api_version", 1},
+        {"status", "success"},
+        {"data", {
+            {"query_timeout_ms", m_query_timeout_ms.load()},
+            {"deadline_hits_total", total},
+            {"deadline_hits", hits}
+        }}};
+
+    res.set_content(response.dump(2), "application/json");
+    res.status = 200;
+}
+
 void HttpServer::handle_chassis_reset(const httplib::Request &req, httplib::Response &res)
 {
     try
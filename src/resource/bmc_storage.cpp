@@ -484,15 +484,28 @@ vector<BMCQueryResult> BMCStorage::executeBMCQuerySQL(const string& sql) {
     
     logDebug("BMCStorage: 执行查询: " + sql);
     
-    TDengineConnectionGuard guard(m_connection_pool);
+    // 连接等待时间受当前请求的截止时间约束
+    TDengineConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
     if (!guard.isValid()) {
+        if (QueryDeadlineScope::current().expired()) {
+            QueryDeadlineScope::markExceeded();
+            last_error_ = "Query deadline exceeded";
+            return results;
+        }
         last_error_ = "Failed to get database connection from pool";
         logError("Failed to get database connection from pool");
         return results;
     }
     
     TAOS* taos = guard->get();
-    TAOS_RES* res = taos_query(taos, sql.c_str());
+    TAOS_RES* res = nullptr;
+    try {
+        res = taosQueryWithDeadline(taos, sql);
+    } catch (const QueryDeadlineExceeded& e) {
+        last_error_ = e.what();
+        logError("BMCStorage: " + string(e.what()) + " - SQL: " + sql);
+        return results;
+    }
     int code = taos_errno(res);
     
     if (code != 0) {
@@ -513,7 +526,14 @@ vector<BMCQueryResult> BMCStorage::executeBMCQuerySQL(const string& sql) {
     
     // 处理查询结果
     TAOS_ROW row;
+    size_t row_count = 0;
     while ((row = taos_fetch_row(res))) {
+        // 每读取一批行检查一次截止时间，超时则中止查询
+        if (++row_count % 256 == 0 && taosStopIfDeadlineExceeded(res)) {
+            last_error_ = "Query deadline exceeded while fetching rows";
+            results.clear();
+            break;
+        }
         int* lengths = taos_fetch_lengths(res);
         
         BMCQueryResult result;
@@ -10,6 +10,7 @@ NodeStorage::NodeStorage() {
 NodeStorage::~NodeStorage() {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_nodes.clear();
+    m_order_index.clear();
     LogManager::getLogger()->info("NodeStorage destroyed");
 }
 
@@ -23,10 +24,13 @@ bool NodeStorage::storeBoxInfo(const node::BoxInfo& node_info) {
         // 检查是否已存在该host_ip的节点数据
         auto it = m_nodes.find(host_ip);
         std::shared_ptr<NodeData> node;
+        bool existed = it != m_nodes.end();
+        NodeOrderKey old_key;
         
         if (it != m_nodes.end()) {
             // 如果已存在，则更新现有数据
             node = it->second;
+            old_key = makeOrderKey(*node);
             LogManager::getLogger()->debug("Updating existing node info for host: {}", host_ip);
         } else {
             // 如果不存在，则创建新的节点数据
@@ -67,6 +71,7 @@ bool NodeStorage::storeBoxInfo(const node::BoxInfo& node_info) {
         
         // 存储或更新节点数据
         m_nodes[host_ip] = node;
+        reindexNode(old_key, existed, *node);
         
         LogManager::getLogger()->debug("Node info {} for host: {}", 
                                      (it != m_nodes.end() ? "updated" : "stored"), host_ip);
@@ -107,10 +112,13 @@ bool NodeStorage::storeUDPInfo(const UdpInfo& udp_info) {
             // 检查是否已存在该host_ip的节点数据
             auto it = m_nodes.find(host_ip);
             std::shared_ptr<NodeData> node;
+            bool existed = it != m_nodes.end();
+            NodeOrderKey old_key;
             
             if (it != m_nodes.end()) {
                 // 如果已存在，则更新现有数据
                 node = it->second;
+                old_key = makeOrderKey(*node);
                 LogManager::getLogger()->debug("Updating existing node with UDP info for host: {} (box_id={}, slot_id={})", 
                                              host_ip, box_id, slot_id);
             } else {
@@ -146,6 +154,7 @@ bool NodeStorage::storeUDPInfo(const UdpInfo& udp_info) {
             
             // 存储或更新节点数据
             m_nodes[host_ip] = node;
+            reindexNode(old_key, existed, *node);
             
             LogManager::getLogger()->debug("Updated BMC info for host {}: ipmb={}, module={}, company={}, version={}", 
                                          host_ip, node->ipmb_address, node->module_type, node->bmc_company, node->bmc_version);
@@ -272,17 +281,25 @@ std::vector<std::shared_ptr<const NodeData>> NodeStorage::getActiveNodesReadonly
 }
 
 bool NodeStorage::removeNode(const std::string& host_ip) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    auto it = m_nodes.find(host_ip);
-    if (it != m_nodes.end()) {
+    std::vector<NodeUnavailableCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_nodes.find(host_ip);
+        if (it == m_nodes.end()) {
+            LogManager::getLogger()->warn("Node not found for removal: {}", host_ip);
+            return false;
+        }
+        m_order_index.erase(makeOrderKey(*it->second));
         m_nodes.erase(it);
-        LogManager::getLogger()->info("Node removed: {}", host_ip);
-        return true;
+        callbacks = m_unavailable_callbacks;
     }
-    
-    LogManager::getLogger()->warn("Node not found for removal: {}", host_ip);
-    return false;
+
+    LogManager::getLogger()->info("Node removed: {}", host_ip);
+    for (const auto& callback : callbacks) {
+        callback(host_ip);
+    }
+    return true;
 }
 
 size_t NodeStorage::getNodeCount() {
@@ -332,9 +349,70 @@ int64_t NodeStorage::getMonitorCheckIntervalMs() const {
 }
 
 void NodeStorage::updateNodeStatus(const std::string& host_ip, const std::string& status) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    auto it = m_nodes.find(host_ip);
-    if (it != m_nodes.end()) {
+    std::vector<NodeUnavailableCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_nodes.find(host_ip);
+        if (it == m_nodes.end()) {
+            return;
+        }
+        if (status == "offline" && it->second->status != "offline") {
+            callbacks = m_unavailable_callbacks;
+        }
         it->second->status = status;
     }
-}
\ No newline at end of file
+
+    for (const auto& callback : callbacks) {
+        callback(host_ip);
+    }
+}
+
+void NodeStorage::addNodeUnavailableCallback(NodeUnavailableCallback callback) {
+    if (!callback) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_unavailable_callbacks.push_back(std::move(callback));
+}
+
+std::vector<std::shared_ptr<NodeData>> NodeStorage::getAllNodesOrdered() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::shared_ptr<NodeData>> node_list;
+    node_list.reserve(m_order_index.size());
+
+    for (const auto& key : m_order_index) {
+        auto it = m_nodes.find(key.host_ip);
+        if (it != m_nodes.end()) {
+            node_list.push_back(it->second);
+        }
+    }
+    return node_list;
+}
+
+void NodeStorage::forEachNodeOrdered(const NodeOrderKey* after,
+                                     const std::function<bool(const std::shared_ptr<NodeData>&)>& visitor) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto key_it = after ? m_order_index.upper_bound(*after) : m_order_index.begin();
+    for (; key_it != m_order_index.end(); ++key_it) {
+        auto it = m_nodes.find(key_it->host_ip);
+        if (it != m_nodes.end() && !visitor(it->second)) {
+            break;
+        }
+    }
+}
+
+NodeOrderKey NodeStorage::makeOrderKey(const NodeData& node) {
+    NodeOrderKey key;
+    key.box_id = node.box_id;
+    key.slot_id = node.slot_id;
+    key.cpu_id = node.cpu_id;
+    key.host_ip = node.host_ip;
+    return key;
+}
+
+void NodeStorage::reindexNode(const NodeOrderKey& old_key, bool existed, const NodeData& node) {
+    if (existed) {
+        m_order_index.erase(old_key);
+    }
+    m_order_index.insert(makeOrderKey(node));
+}
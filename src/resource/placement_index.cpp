@@ -0,0 +1,241 @@
+#include "placement_index.h"
+#include "log_manager.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    int64_t steadyNowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    using RankKey = std::tuple<int, int, const std::string&>;
+
+    // 候选节点在分区有序集合中的键，与 by_cores / by_gpus 的 (主资源, 次资源, host_ip) 排序相同
+    RankKey rankKey(const PlacementCandidate& c, bool primary_gpus) {
+        return primary_gpus ? RankKey(c.free_gpus, c.free_cores, c.host_ip)
+                            : RankKey(c.free_cores, c.free_gpus, c.host_ip);
+    }
+
+    // 按策略比较两个候选节点，primary_gpus表示以GPU为主排序资源。
+    // 与分区内的遍历使用同一顺序：BEST_FIT 沿有序集合正向，LEAST_LOADED 反向（容量相同时 host_ip 大的在前），
+    // 因此合并各分区时的排序与每个分区取前 limit 个的结果一致
+    bool rankBefore(const PlacementCandidate& a, const PlacementCandidate& b,
+                    PlacementPolicy policy, bool primary_gpus) {
+        return policy == PlacementPolicy::BEST_FIT ? rankKey(a, primary_gpus) < rankKey(b, primary_gpus)
+                                                   : rankKey(b, primary_gpus) < rankKey(a, primary_gpus);
+    }
+}
+
+PlacementIndex::PlacementIndex() {
+}
+
+PlacementIndex::~PlacementIndex() {
+}
+
+void PlacementIndex::updateNodeInfo(const node::BoxInfo& box_info) {
+    if (box_info.host_ip.empty()) {
+        return;
+    }
+
+    const int64_t now_ms = steadyNowMs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evictStale(now_ms);
+    Entry& entry = m_entries[box_info.host_ip];
+    unindexEntry(entry);
+
+    entry.info.host_ip = box_info.host_ip;
+    entry.info.box_id = box_info.box_id;
+    entry.info.slot_id = box_info.slot_id;
+    entry.info.cpu_arch = box_info.cpu_arch;
+    entry.info.resource_type = box_info.resource_type;
+    touchEntry(entry, now_ms);
+
+    indexEntry(entry);
+}
+
+void PlacementIndex::updateResource(const std::string& host_ip, const node::ResourceData& resource) {
+    if (host_ip.empty()) {
+        return;
+    }
+
+    const int64_t now_ms = steadyNowMs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evictStale(now_ms);
+    Entry& entry = m_entries[host_ip];
+    unindexEntry(entry);
+
+    entry.info.host_ip = host_ip;
+    entry.info.core_count = resource.cpu.core_count;
+    entry.info.core_allocated = resource.cpu.core_allocated;
+    entry.info.free_cores = std::max(0, resource.cpu.core_count - resource.cpu.core_allocated);
+    entry.info.gpu_num = resource.gpu_num;
+    entry.info.gpu_allocated = resource.gpu_allocated;
+    entry.info.free_gpus = std::max(0, resource.gpu_num - resource.gpu_allocated);
+    entry.info.cpu_usage_percent = resource.cpu.usage_percent;
+    touchEntry(entry, now_ms);
+    entry.has_resource = true;
+
+    indexEntry(entry);
+}
+
+void PlacementIndex::removeNode(const std::string& host_ip) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(host_ip);
+    if (it != m_entries.end()) {
+        eraseEntry(it);
+    }
+}
+
+std::vector<PlacementCandidate> PlacementIndex::findCandidates(const PlacementQuery& query) {
+    std::vector<PlacementCandidate> candidates;
+    if (query.limit == 0) {
+        return candidates;
+    }
+
+    const int min_cores = std::max(0, query.min_free_cores);
+    const int min_gpus = std::max(0, query.min_free_gpus);
+    // 需要GPU时以GPU为主排序资源（GPU更稀缺），否则以CPU核数为主
+    const bool primary_gpus = min_gpus > 0;
+    const int primary_min = primary_gpus ? min_gpus : min_cores;
+    const int secondary_min = primary_gpus ? min_cores : min_gpus;
+    const int64_t now_ms = steadyNowMs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evictStale(now_ms);
+
+    // 索引中只有未超时的节点，只需检查次排序资源
+    auto accept = [&](const CapacityKey& key) -> bool {
+        if (std::get<1>(key) < secondary_min) {
+            return false;
+        }
+        auto it = m_entries.find(std::get<2>(key));
+        if (it == m_entries.end()) {
+            return false;
+        }
+        candidates.push_back(it->second.info);
+        return true;
+    };
+
+    for (const auto& item : m_partitions) {
+        const Partition& partition = item.second;
+        if (!query.cpu_arch.empty() && partition.cpu_arch != query.cpu_arch) {
+            continue;
+        }
+        if (!query.resource_type.empty() && partition.resource_type != query.resource_type) {
+            continue;
+        }
+
+        const std::set<CapacityKey>& ordered = primary_gpus ? partition.by_gpus : partition.by_cores;
+        auto lower = ordered.lower_bound(CapacityKey(primary_min, secondary_min, std::string()));
+        size_t taken = 0;
+
+        if (query.policy == PlacementPolicy::BEST_FIT) {
+            // 从刚好满足需求的位置向后取
+            for (auto it = lower; it != ordered.end() && taken < query.limit; ++it) {
+                if (accept(*it)) ++taken;
+            }
+        } else {
+            // 从剩余资源最多的一端向前取
+            for (auto it = ordered.rbegin(); it != std::set<CapacityKey>::const_reverse_iterator(lower) && taken < query.limit; ++it) {
+                if (accept(*it)) ++taken;
+            }
+        }
+    }
+
+    // 合并各分区结果
+    std::sort(candidates.begin(), candidates.end(), [&](const PlacementCandidate& a, const PlacementCandidate& b) {
+        return rankBefore(a, b, query.policy, primary_gpus);
+    });
+    if (candidates.size() > query.limit) {
+        candidates.resize(query.limit);
+    }
+
+    LogManager::getLogger()->debug("PlacementIndex: {} candidates for cores>={}, gpus>={}, cpu_arch='{}', resource_type='{}'",
+                                   candidates.size(), min_cores, min_gpus, query.cpu_arch, query.resource_type);
+    return candidates;
+}
+
+void PlacementIndex::touchEntry(Entry& entry, int64_t now_ms) {
+    if (entry.last_update_ms != 0) {
+        m_by_update.erase(std::make_pair(entry.last_update_ms, entry.info.host_ip));
+    }
+    entry.last_update_ms = now_ms;
+    m_by_update.insert(std::make_pair(now_ms, entry.info.host_ip));
+}
+
+void PlacementIndex::evictStale(int64_t now_ms) {
+    while (!m_by_update.empty() && now_ms - m_by_update.begin()->first > m_stale_timeout_ms) {
+        auto it = m_entries.find(m_by_update.begin()->second);
+        if (it == m_entries.end()) {
+            m_by_update.erase(m_by_update.begin());
+            continue;
+        }
+        LogManager::getLogger()->debug("PlacementIndex: evicting stale node {}", it->first);
+        eraseEntry(it);
+    }
+}
+
+void PlacementIndex::eraseEntry(std::unordered_map<std::string, Entry>::iterator it) {
+    unindexEntry(it->second);
+    if (it->second.last_update_ms != 0) {
+        m_by_update.erase(std::make_pair(it->second.last_update_ms, it->first));
+    }
+    m_entries.erase(it);
+}
+
+size_t PlacementIndex::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = 0;
+    for (const auto& item : m_entries) {
+        if (item.second.has_resource) ++count;
+    }
+    return count;
+}
+
+void PlacementIndex::setStaleTimeoutMs(int64_t timeout_ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stale_timeout_ms = timeout_ms;
+}
+
+bool PlacementIndex::parsePolicy(const std::string& name, PlacementPolicy& policy) {
+    if (name.empty() || name == "best_fit") {
+        policy = PlacementPolicy::BEST_FIT;
+        return true;
+    }
+    if (name == "least_loaded") {
+        policy = PlacementPolicy::LEAST_LOADED;
+        return true;
+    }
+    return false;
+}
+
+std::string PlacementIndex::partitionKey(const std::string& cpu_arch, const std::string& resource_type) {
+    return cpu_arch + "|" + resource_type;
+}
+
+void PlacementIndex::indexEntry(const Entry& entry) {
+    if (!entry.has_resource) {
+        return;
+    }
+    Partition& partition = m_partitions[partitionKey(entry.info.cpu_arch, entry.info.resource_type)];
+    partition.cpu_arch = entry.info.cpu_arch;
+    partition.resource_type = entry.info.resource_type;
+    partition.by_cores.insert(CapacityKey(entry.info.free_cores, entry.info.free_gpus, entry.info.host_ip));
+    partition.by_gpus.insert(CapacityKey(entry.info.free_gpus, entry.info.free_cores, entry.info.host_ip));
+}
+
+void PlacementIndex::unindexEntry(const Entry& entry) {
+    if (!entry.has_resource) {
+        return;
+    }
+    auto it = m_partitions.find(partitionKey(entry.info.cpu_arch, entry.info.resource_type));
+    if (it == m_partitions.end()) {
+        return;
+    }
+    it->second.by_cores.erase(CapacityKey(entry.info.free_cores, entry.info.free_gpus, entry.info.host_ip));
+    it->second.by_gpus.erase(CapacityKey(entry.info.free_gpus, entry.info.free_cores, entry.info.host_ip));
+    if (it->second.by_cores.empty()) {
+        m_partitions.erase(it);
+    }
+}
@@ -2,9 +2,243 @@
 #include "log_manager.h"
 #include <sstream>
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
 
 using json = nlohmann::json;
 
+namespace {
+    // 节点指标字段访问器，needs_resource表示该字段依赖TDengine中的最新指标
+    struct FieldAccessor {
+        bool needs_resource;
+        std::function<json(const NodeMetricsData&)> get;
+    };
+
+    template <typename Container, typename Getter>
+    double maxOf(const Container& items, Getter getter) {
+        double result = 0.0;
+        for (const auto& item : items) {
+            result = std::max(result, static_cast<double>(getter(item)));
+        }
+        return result;
+    }
+
+    template <typename Container, typename Getter>
+    double sumOf(const Container& items, Getter getter) {
+        double result = 0.0;
+        for (const auto& item : items) {
+            result += static_cast<double>(getter(item));
+        }
+        return result;
+    }
+
+    // 可用于filter/sort的字段；disk/gpu取最大值，network取所有接口之和
+    const std::map<std::string, FieldAccessor>& fieldAccessors() {
+        static const std::map<std::string, FieldAccessor> accessors = {
+            {"host_ip", {false, [](const NodeMetricsData& n) { return json(n.host_ip); }}},
+            {"hostname", {false, [](const NodeMetricsData& n) { return json(n.hostname); }}},
+            {"status", {false, [](const NodeMetricsData& n) { return json(n.status); }}},
+            {"box_id", {false, [](const NodeMetricsData& n) { return json(n.box_id); }}},
+            {"slot_id", {false, [](const NodeMetricsData& n) { return json(n.slot_id); }}},
+            {"cpu_id", {false, [](const NodeMetricsData& n) { return json(n.cpu_id); }}},
+            {"srio_id", {false, [](const NodeMetricsData& n) { return json(n.srio_id); }}},
+            {"board_type", {false, [](const NodeMetricsData& n) { return json(n.board_type); }}},
+            {"box_type", {false, [](const NodeMetricsData& n) { return json(n.box_type); }}},
+            {"cpu_arch", {false, [](const NodeMetricsData& n) { return json(n.cpu_arch); }}},
+            {"cpu_type", {false, [](const NodeMetricsData& n) { return json(n.cpu_type); }}},
+            {"os_type", {false, [](const NodeMetricsData& n) { return json(n.os_type); }}},
+            {"resource_type", {false, [](const NodeMetricsData& n) { return json(n.resource_type); }}},
+            {"updated_at", {false, [](const NodeMetricsData& n) { return json(n.updated_at); }}},
+            {"cpu.usage_percent", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.usage_percent); }}},
+            {"cpu.load_avg_1m", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.load_avg_1m); }}},
+            {"cpu.load_avg_5m", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.load_avg_5m); }}},
+            {"cpu.load_avg_15m", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.load_avg_15m); }}},
+            {"cpu.temperature", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.temperature); }}},
+            {"cpu.power", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.power); }}},
+            {"cpu.core_count", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.core_count); }}},
+            {"cpu.core_allocated", {true, [](const NodeMetricsData& n) { return json(n.latest_cpu_metrics.core_allocated); }}},
+            {"memory.usage_percent", {true, [](const NodeMetricsData& n) { return json(n.latest_memory_metrics.usage_percent); }}},
+            {"memory.total", {true, [](const NodeMetricsData& n) { return json(n.latest_memory_metrics.total); }}},
+            {"memory.used", {true, [](const NodeMetricsData& n) { return json(n.latest_memory_metrics.used); }}},
+            {"memory.free", {true, [](const NodeMetricsData& n) { return json(n.latest_memory_metrics.free); }}},
+            {"disk.usage_percent", {true, [](const NodeMetricsData& n) {
+                return json(maxOf(n.latest_disk_metrics.disks, [](const DiskInfo& d) { return d.usage_percent; })); }}},
+            {"gpu.compute_usage", {true, [](const NodeMetricsData& n) {
+                return json(maxOf(n.latest_gpu_metrics.gpus, [](const GPUInfo& g) { return g.compute_usage; })); }}},
+            {"gpu.mem_usage", {true, [](const NodeMetricsData& n) {
+                return json(maxOf(n.latest_gpu_metrics.gpus, [](const GPUInfo& g) { return g.mem_usage; })); }}},
+            {"gpu.temperature", {true, [](const NodeMetricsData& n) {
+                return json(maxOf(n.latest_gpu_metrics.gpus, [](const GPUInfo& g) { return g.temperature; })); }}},
+            {"network.rx_rate", {true, [](const NodeMetricsData& n) {
+                return json(sumOf(n.latest_network_metrics.networks, [](const NetworkInfo& i) { return i.rx_rate; })); }}},
+            {"network.tx_rate", {true, [](const NodeMetricsData& n) {
+                return json(sumOf(n.latest_network_metrics.networks, [](const NetworkInfo& i) { return i.tx_rate; })); }}},
+            {"network.rx_error_rate", {true, [](const NodeMetricsData& n) {
+                return json(sumOf(n.latest_network_metrics.networks, [](const NetworkInfo& i) { return i.rx_error_rate; })); }}},
+            {"network.tx_error_rate", {true, [](const NodeMetricsData& n) {
+                return json(sumOf(n.latest_network_metrics.networks, [](const NetworkInfo& i) { return i.tx_error_rate; })); }}},
+            {"container.running_count", {true, [](const NodeMetricsData& n) { return json(n.latest_container_metrics.running_count); }}},
+            {"container.stopped_count", {true, [](const NodeMetricsData& n) { return json(n.latest_container_metrics.stopped_count); }}},
+        };
+        return accessors;
+    }
+
+    // fields参数中的简写，如 cpu -> latest_cpu_metrics
+    std::string resolveFieldAlias(const std::string& field) {
+        static const std::map<std::string, std::string> aliases = {
+            {"cpu", "latest_cpu_metrics"},
+            {"memory", "latest_memory_metrics"},
+            {"disk", "latest_disk_metrics"},
+            {"network", "latest_network_metrics"},
+            {"gpu", "latest_gpu_metrics"},
+            {"container", "latest_container_metrics"},
+            {"sensor", "latest_sensor_metrics"},
+        };
+        auto it = aliases.find(field);
+        return it != aliases.end() ? it->second : field;
+    }
+
+    std::vector<std::string> splitAndTrim(const std::string& input, char delimiter) {
+        std::vector<std::string> parts;
+        std::stringstream ss(input);
+        std::string part;
+        while (std::getline(ss, part, delimiter)) {
+            part.erase(0, part.find_first_not_of(" \t"));
+            part.erase(part.find_last_not_of(" \t") + 1);
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    // 过滤条件：field op value，value中可用'|'分隔多个候选值（仅用于 = 和 !=）
+    struct FilterClause {
+        std::string field;
+        std::string op;
+        std::vector<std::string> values;
+    };
+
+    std::vector<FilterClause> parseFilter(const std::string& filter) {
+        static const std::vector<std::string> operators = {"!=", ">=", "<=", "=", ":", ">", "<"};
+        std::vector<FilterClause> clauses;
+
+        for (const auto& expr : splitAndTrim(filter, ',')) {
+            FilterClause clause;
+            size_t pos = std::string::npos;
+            for (const auto& op : operators) {
+                size_t found = expr.find(op);
+                if (found != std::string::npos && found > 0 && (pos == std::string::npos || found < pos)) {
+                    pos = found;
+                    clause.op = op;
+                }
+            }
+            if (pos == std::string::npos) {
+                throw std::invalid_argument("Invalid filter expression: " + expr);
+            }
+            clause.field = expr.substr(0, pos);
+            clause.field.erase(clause.field.find_last_not_of(" \t") + 1);
+            if (clause.op == ":") {
+                clause.op = "=";
+            }
+            if (fieldAccessors().count(clause.field) == 0) {
+                throw std::invalid_argument("Unknown filter field: " + clause.field);
+            }
+            clause.values = splitAndTrim(expr.substr(pos + clause.op.size()), '|');
+            if (clause.values.empty()) {
+                throw std::invalid_argument("Missing filter value: " + expr);
+            }
+            clauses.push_back(clause);
+        }
+        return clauses;
+    }
+
+    bool matchClause(const json& actual, const FilterClause& clause) {
+        for (const auto& raw : clause.values) {
+            int cmp = 0;
+            if (actual.is_number()) {
+                double expected = 0.0;
+                try {
+                    expected = std::stod(raw);
+                } catch (const std::exception&) {
+                    throw std::invalid_argument("Filter value for " + clause.field + " must be numeric: " + raw);
+                }
+                double value = actual.get<double>();
+                cmp = value < expected ? -1 : (value > expected ? 1 : 0);
+            } else {
+                std::string value = actual.is_string() ? actual.get<std::string>() : actual.dump();
+                cmp = value.compare(raw);
+            }
+
+            if (clause.op == "=" && cmp == 0) return true;
+            if (clause.op == "!=" && cmp == 0) return false;
+            if (clause.op == ">" && cmp > 0) return true;
+            if (clause.op == ">=" && cmp >= 0) return true;
+            if (clause.op == "<" && cmp < 0) return true;
+            if (clause.op == "<=" && cmp <= 0) return true;
+        }
+        return clause.op == "!=";
+    }
+
+    const std::string kBase64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    std::string base64UrlEncode(const std::string& input) {
+        std::string output;
+        int val = 0;
+        int bits = -6;
+        for (unsigned char c : input) {
+            val = (val << 8) + c;
+            bits += 8;
+            while (bits >= 0) {
+                output.push_back(kBase64Chars[(val >> bits) & 0x3F]);
+                bits -= 6;
+            }
+        }
+        if (bits > -6) {
+            output.push_back(kBase64Chars[((val << 8) >> (bits + 8)) & 0x3F]);
+        }
+        return output;
+    }
+
+    std::string base64UrlDecode(const std::string& input) {
+        std::string output;
+        int val = 0;
+        int bits = -8;
+        for (unsigned char c : input) {
+            size_t index = kBase64Chars.find(c);
+            if (index == std::string::npos) {
+                throw std::invalid_argument("Invalid cursor");
+            }
+            val = (val << 6) + static_cast<int>(index);
+            bits += 6;
+            if (bits >= 0) {
+                output.push_back(static_cast<char>((val >> bits) & 0xFF));
+                bits -= 8;
+            }
+        }
+        return output;
+    }
+
+    // 已过滤节点在排序结果中的位置：排序值 + 有序索引键（保证唯一且稳定）
+    struct MetricsRow {
+        json sort_value;
+        NodeOrderKey key;
+        std::shared_ptr<NodeData> node;
+        NodeMetricsData data;
+    };
+
+    bool rowBefore(const json& lhs_value, const NodeOrderKey& lhs_key,
+                   const json& rhs_value, const NodeOrderKey& rhs_key, bool descending) {
+        if (lhs_value != rhs_value) {
+            return descending ? rhs_value < lhs_value : lhs_value < rhs_value;
+        }
+        return lhs_key < rhs_key;
+    }
+}
+
 ResourceManager::ResourceManager(std::shared_ptr<ResourceStorage> resource_storage, 
                                  std::shared_ptr<NodeStorage> node_storage,
                                  std::shared_ptr<BMCStorage> bmc_storage)
@@ -207,15 +441,22 @@ std::pair<bool, std::string> ResourceManager::validateRequest(const HistoricalMe
     return {true, ""};
 }
 
-NodeMetricsData ResourceManager::buildNodeMetricsData(const std::shared_ptr<NodeData>& node) {
-    std::string host_ip = node->host_ip;
+NodeMetricsData ResourceManager::buildNodeMetricsData(const std::shared_ptr<NodeData>& node, bool include_resource) {
+    // 使用 getNodeResourceData 方法获取所有资源数据
+    NodeResourceData resourceData;
+    resourceData.host_ip = node->host_ip;
+    if (include_resource) {
+        resourceData = m_resource_storage->getNodeResourceData(node->host_ip);
+    }
+    return buildNodeMetricsData(node, resourceData);
+}
+
+NodeMetricsData ResourceManager::buildNodeMetricsData(const std::shared_ptr<NodeData>& node,
+                                                      const NodeResourceData& resourceData) {
     auto current_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
     auto steady_now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now().time_since_epoch()).count();
-    
-    // 使用 getNodeResourceData 方法获取所有资源数据
-    auto resourceData = m_resource_storage->getNodeResourceData(host_ip);
 
     // 构建CPU指标
     CPUMetrics cpu_metrics;
@@ -280,6 +521,10 @@ NodeMetricsData ResourceManager::buildNodeMetricsData(const std::shared_ptr<Node
         network_info.tx_packets = network.tx_packets;
         network_info.tx_rate = network.tx_rate;
         network_info.rx_rate = network.rx_rate;
+        network_info.rx_packet_rate = network.rx_packet_rate;
+        network_info.tx_packet_rate = network.tx_packet_rate;
+        network_info.rx_error_rate = network.rx_error_rate;
+        network_info.tx_error_rate = network.tx_error_rate;
         network_info.timestamp = network.timestamp / 1000;
         network_metrics.networks.push_back(network_info);
     }
@@ -395,7 +640,8 @@ NodeMetricsDataListPagination ResourceManager::getPaginatedCurrentMetrics(int pa
     response.pagination.page_size = page_size;
     
     try {
-        auto node_list = m_node_storage->getAllNodes();
+        // 按有序索引遍历，保证相同数据下各页内容稳定
+        auto node_list = m_node_storage->getAllNodesOrdered();
         response.pagination.total_count = node_list.size();
         
         // 计算总页数
@@ -440,6 +686,223 @@ NodeMetricsDataListPagination ResourceManager::getPaginatedCurrentMetrics(int pa
     return response;
 }
 
+NodeMetricsCursorResult ResourceManager::queryCurrentMetrics(const NodeMetricsQuery& query) {
+    NodeMetricsCursorResult response;
+    int limit = query.limit;
+    if (limit < 1) limit = 100;
+    if (limit > 1000) limit = 1000; // 限制最大页面大小
+    response.pagination.page_size = limit;
+
+    if (!m_node_storage || !m_resource_storage) {
+        response.error_message = "Storage components not available";
+        LogManager::getLogger()->error("ResourceManager: Storage components not available for current metrics query");
+        return response;
+    }
+
+    // 1. 解析参数
+    static const json kNodeFields = NodeMetricsData{};
+    std::set<std::string> fields;
+    std::vector<FilterClause> clauses;
+    std::string sort_field = query.sort;
+    bool descending = false;
+    json cursor_value;
+    NodeOrderKey cursor_key;
+    bool has_cursor = !query.cursor.empty();
+
+    try {
+        for (const auto& field : splitAndTrim(query.fields, ',')) {
+            std::string resolved = resolveFieldAlias(field);
+            if (!kNodeFields.contains(resolved)) {
+                throw std::invalid_argument("Unknown field: " + field);
+            }
+            fields.insert(resolved);
+        }
+        if (!fields.empty()) {
+            fields.insert("host_ip");
+        }
+
+        clauses = parseFilter(query.filter);
+
+        if (!sort_field.empty() && sort_field[0] == '-') {
+            descending = true;
+            sort_field = sort_field.substr(1);
+        }
+        if (!sort_field.empty() && fieldAccessors().count(sort_field) == 0) {
+            throw std::invalid_argument("Unknown sort field: " + sort_field);
+        }
+
+        if (has_cursor) {
+            json cursor = json::parse(base64UrlDecode(query.cursor));
+            if (cursor.value("s", "") != query.sort || cursor.value("f", "") != query.filter) {
+                throw std::invalid_argument("Cursor does not match current filter/sort");
+            }
+            cursor_value = cursor.at("v");
+            const json& key = cursor.at("k");
+            cursor_key.box_id = key.at(0).get<int>();
+            cursor_key.slot_id = key.at(1).get<int>();
+            cursor_key.cpu_id = key.at(2).get<int>();
+            cursor_key.host_ip = key.at(3).get<std::string>();
+        }
+    } catch (const std::exception& e) {
+        response.invalid_request = true;
+        response.error_message = e.what();
+        return response;
+    }
+
+    bool fields_need_resource = fields.empty();
+    for (const auto& field : fields) {
+        if (field.compare(0, 7, "latest_") == 0) {
+            fields_need_resource = true;
+        }
+    }
+    bool filter_need_resource = !sort_field.empty() && fieldAccessors().at(sort_field).needs_resource;
+    for (const auto& clause : clauses) {
+        if (fieldAccessors().at(clause.field).needs_resource) {
+            filter_need_resource = true;
+        }
+    }
+
+    try {
+        std::vector<MetricsRow> rows;  // 本页的行
+        bool has_next = false;
+        auto matches = [&](const NodeMetricsData& data) {
+            for (const auto& clause : clauses) {
+                if (!matchClause(fieldAccessors().at(clause.field).get(data), clause)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        if (filter_need_resource || !sort_field.empty()) {
+            // 2a. 过滤/排序依赖指标或不按索引顺序：整个机群的最新指标一次查询取回（不逐节点查询），在内存中过滤排序
+            std::unordered_map<std::string, NodeResourceData> latest;
+            if (filter_need_resource) {
+                latest = m_resource_storage->getLatestResourceData({});
+            }
+            std::vector<MetricsRow> matched;
+            for (const auto& node : m_node_storage->getAllNodesOrdered()) {
+                MetricsRow row;
+                row.node = node;
+                row.key = NodeStorage::makeOrderKey(*node);
+                auto latest_it = latest.find(node->host_ip);
+                row.data = latest_it != latest.end() ? buildNodeMetricsData(node, latest_it->second)
+                                                     : buildNodeMetricsData(node, false);
+                if (!matches(row.data)) {
+                    continue;
+                }
+                if (!sort_field.empty()) {
+                    row.sort_value = fieldAccessors().at(sort_field).get(row.data);
+                }
+                matched.push_back(std::move(row));
+            }
+
+            if (!sort_field.empty()) {
+                std::stable_sort(matched.begin(), matched.end(), [descending](const MetricsRow& a, const MetricsRow& b) {
+                    return rowBefore(a.sort_value, a.key, b.sort_value, b.key, descending);
+                });
+            }
+            response.pagination.total_count = static_cast<int>(matched.size());
+
+            // 定位游标之后的第一条记录
+            auto begin = matched.begin();
+            if (has_cursor) {
+                begin = std::upper_bound(matched.begin(), matched.end(), 0,
+                    [&](int, const MetricsRow& row) {
+                        return rowBefore(cursor_value, cursor_key, row.sort_value, row.key, descending);
+                    });
+            }
+            auto end = begin + std::min<std::ptrdiff_t>(limit, matched.end() - begin);
+            has_next = end != matched.end();
+            rows.assign(std::make_move_iterator(begin), std::make_move_iterator(end));
+        } else {
+            // 2b. 按有序索引顺序：只按节点属性过滤（不查询指标）。无过滤条件时从游标处开始遍历，取满一页即停止
+            // （多看一条判断是否有下一页），总数即节点数；有过滤条件时从头遍历整个索引统计过滤后的总数，
+            // 只收集游标之后的一页
+            const bool count_matches = !clauses.empty();
+            int matched_count = 0;
+            m_node_storage->forEachNodeOrdered((has_cursor && !count_matches) ? &cursor_key : nullptr,
+                                               [&](const std::shared_ptr<NodeData>& node) {
+                NodeMetricsData data = buildNodeMetricsData(node, false);
+                if (!matches(data)) {
+                    return true;
+                }
+                ++matched_count;
+                NodeOrderKey key = NodeStorage::makeOrderKey(*node);
+                if (has_cursor && !(cursor_key < key)) {
+                    return true;
+                }
+                if (rows.size() == static_cast<size_t>(limit)) {
+                    has_next = true;
+                    return count_matches;
+                }
+                MetricsRow row;
+                row.node = node;
+                row.key = std::move(key);
+                row.data = std::move(data);
+                rows.push_back(std::move(row));
+                return true;
+            });
+            response.pagination.total_count = count_matches ? matched_count
+                                                            : static_cast<int>(m_node_storage->getNodeCount());
+        }
+
+        // 3. 本页需要指标而过滤时没有取回：本页主机一次查询
+        if (fields_need_resource && !filter_need_resource && !rows.empty()) {
+            std::vector<std::string> host_ips;
+            host_ips.reserve(rows.size());
+            for (const auto& row : rows) {
+                host_ips.push_back(row.node->host_ip);
+            }
+            auto latest = m_resource_storage->getLatestResourceData(host_ips);
+            for (auto& row : rows) {
+                auto latest_it = latest.find(row.node->host_ip);
+                if (latest_it != latest.end()) {
+                    row.data = buildNodeMetricsData(row.node, latest_it->second);
+                }
+            }
+        }
+
+        // 4. 按fields裁剪
+        for (const auto& row : rows) {
+            json node_json = row.data;
+            if (fields.empty()) {
+                response.nodes_metrics.push_back(node_json);
+            } else {
+                json projected = json::object();
+                for (const auto& field : fields) {
+                    projected[field] = node_json[field];
+                }
+                response.nodes_metrics.push_back(projected);
+            }
+        }
+
+        response.pagination.has_next = has_next;
+        if (has_next && !rows.empty()) {
+            const MetricsRow& last = rows.back();
+            json cursor = {
+                {"s", query.sort},
+                {"f", query.filter},
+                {"v", last.sort_value},
+                {"k", {last.key.box_id, last.key.slot_id, last.key.cpu_id, last.key.host_ip}}};
+            response.pagination.next_cursor = base64UrlEncode(cursor.dump());
+        }
+        response.success = true;
+
+        LogManager::getLogger()->debug("ResourceManager: Current metrics query returned {} of {} matched nodes (filter='{}', sort='{}')",
+                                     response.nodes_metrics.size(), response.pagination.total_count, query.filter, query.sort);
+
+    } catch (const std::invalid_argument& e) {
+        response.invalid_request = true;
+        response.error_message = e.what();
+    } catch (const std::exception& e) {
+        response.error_message = "Failed to query current metrics: " + std::string(e.what());
+        LogManager::getLogger()->error("ResourceManager: Exception in queryCurrentMetrics: {}", e.what());
+    }
+
+    return response;
+}
+
 std::vector<std::shared_ptr<NodeData>> ResourceManager::getNodesList() {
     if (!m_node_storage) {
         LogManager::getLogger()->error("ResourceManager: Node storage not available for nodes list request");
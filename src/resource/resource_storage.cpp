@@ -1,4 +1,5 @@
 #include "resource_storage.h"
+#include "metric_schema.h"
 #include "log_manager.h"
 #include <iostream>
 #include <sstream>
@@ -6,6 +7,8 @@
 #include <algorithm>
 #include <numeric>
 #include <cctype>
+#include <limits>
+#include <unordered_set>
 
 namespace {
     // Helper function to clean strings for use as table names
@@ -18,6 +21,119 @@ namespace {
         std::replace(cleaned.begin(), cleaned.end(), ' ', '_');
         return cleaned;
     }
+
+    // 网络接口计数器超过该时长没有上报即释放（容器 veth 频繁创建销毁、主机下线）
+    const int64_t kNetworkCounterIdleMs = 10 * 60 * 1000;
+    // 释放空闲接口计数器的检查间隔
+    const int64_t kNetworkCounterSweepMs = 60 * 1000;
+
+    // 计算累计计数器的增量
+    // Linux 接口计数器为64位，当前值小于上一次值只可能是agent重启或计数器清零，增量取当前值；
+    // 不按32位回绕推算，否则从高位清零会得到约 2^32 的虚假增量，误触发错误率告警
+    uint64_t counterDelta(uint64_t previous, uint64_t current) {
+        if (current >= previous) {
+            return current - previous;
+        }
+        return current;
+    }
+
+    // 执行通用查询时作为标签返回的列
+    const std::unordered_set<std::string>& labelColumns() {
+        static const std::unordered_set<std::string> columns = {
+            "host_ip", "mount_point", "device", "interface", "gpu_name", "gpu_index",
+            "sensor_seq", "sensor_type", "sensor_name", "value", "table_type"
+        };
+        return columns;
+    }
+
+    // 以下函数把上报数据转换为模式注册表中绑定的行结构
+    NodeResourceData::CpuData toRow(const node::CpuInfo& cpu) {
+        NodeResourceData::CpuData row;
+        row.usage_percent = cpu.usage_percent;
+        row.load_avg_1m = cpu.load_avg_1m;
+        row.load_avg_5m = cpu.load_avg_5m;
+        row.load_avg_15m = cpu.load_avg_15m;
+        row.core_count = cpu.core_count;
+        row.core_allocated = cpu.core_allocated;
+        row.temperature = cpu.temperature;
+        row.voltage = cpu.voltage;
+        row.current = cpu.current;
+        row.power = cpu.power;
+        return row;
+    }
+
+    NodeResourceData::MemoryData toRow(const node::MemoryInfo& memory) {
+        NodeResourceData::MemoryData row;
+        row.total = static_cast<int64_t>(memory.total);
+        row.used = static_cast<int64_t>(memory.used);
+        row.free = static_cast<int64_t>(memory.free);
+        row.usage_percent = memory.usage_percent;
+        return row;
+    }
+
+    NodeResourceData::DiskData toRow(const node::DiskInfo& disk) {
+        NodeResourceData::DiskData row;
+        row.device = disk.device;
+        row.mount_point = disk.mount_point;
+        row.total = static_cast<int64_t>(disk.total);
+        row.used = static_cast<int64_t>(disk.used);
+        row.free = static_cast<int64_t>(disk.free);
+        row.usage_percent = disk.usage_percent;
+        return row;
+    }
+
+    NodeResourceData::GpuData toRow(const node::GpuResourceInfo& gpu) {
+        NodeResourceData::GpuData row;
+        row.index = gpu.index;
+        row.name = gpu.name;
+        row.compute_usage = gpu.compute_usage;
+        row.mem_usage = gpu.mem_usage;
+        row.mem_used = static_cast<int64_t>(gpu.mem_used);
+        row.mem_total = static_cast<int64_t>(gpu.mem_total);
+        row.temperature = gpu.temperature;
+        row.power = gpu.power;
+        return row;
+    }
+
+    // 以下函数返回最新数据查询中一行结果应解码到的目标，并设置标签缺失时的默认值
+    NodeResourceData::CpuData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::CpuStable>) {
+        data.cpu.has_data = true;
+        return data.cpu;
+    }
+
+    NodeResourceData::MemoryData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::MemoryStable>) {
+        data.memory.has_data = true;
+        return data.memory;
+    }
+
+    NodeResourceData::DiskData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::DiskStable>) {
+        data.disks.emplace_back();
+        data.disks.back().device = "unknown";
+        data.disks.back().mount_point = "/";
+        return data.disks.back();
+    }
+
+    NodeResourceData::NetworkData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::NetworkStable>) {
+        data.networks.emplace_back();
+        data.networks.back().interface = "unknown";
+        return data.networks.back();
+    }
+
+    NodeResourceData::GpuData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::GpuStable>) {
+        data.gpus.emplace_back();
+        data.gpus.back().name = "Unknown GPU";
+        return data.gpus.back();
+    }
+
+    NodeResourceData::ContainerData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::ContainerStable>) {
+        return data.container;
+    }
+
+    NodeResourceData::SensorData& latestRow(NodeResourceData& data, metric_schema::TypeTag<metric_schema::SensorStable>) {
+        data.sensors.emplace_back();
+        data.sensors.back().name = "Unknown Sensor";
+        return data.sensors.back();
+    }
 }
 
 ResourceStorage::ResourceStorage(std::shared_ptr<TDengineConnectionPool> connection_pool)
@@ -75,74 +191,12 @@ bool ResourceStorage::createResourceTable() {
     
     TAOS* taos = guard->get();
     
-    // 定义所有CREATE STABLE语句
-    std::vector<std::pair<std::string, std::string>> tables = {
-        {"cpu", "CREATE STABLE IF NOT EXISTS cpu ("
-        "ts TIMESTAMP, "
-        "usage_percent DOUBLE, "
-        "load_avg_1m DOUBLE, "
-        "load_avg_5m DOUBLE, "
-        "load_avg_15m DOUBLE, "
-        "core_count INT, "
-        "core_allocated INT, "
-        "temperature DOUBLE, "
-        "voltage DOUBLE, "
-        "current DOUBLE, "
-        "power DOUBLE"
-            ") TAGS (host_ip NCHAR(16))"},
-
-        {"memory", "CREATE STABLE IF NOT EXISTS memory ("
-        "ts TIMESTAMP, "
-        "total BIGINT, "
-        "used BIGINT, "
-        "free BIGINT, "
-        "usage_percent DOUBLE"
-            ") TAGS (host_ip NCHAR(16))"},
-
-        {"network", "CREATE STABLE IF NOT EXISTS network ("
-        "ts TIMESTAMP, "
-        "rx_bytes BIGINT, "
-        "tx_bytes BIGINT, "
-        "rx_packets BIGINT, "
-        "tx_packets BIGINT, "
-        "rx_errors BIGINT, "
-        "tx_errors BIGINT, "
-        "rx_rate BIGINT, "
-        "tx_rate BIGINT"
-            ") TAGS (host_ip NCHAR(16), interface NCHAR(32))"},
-
-        {"disk", "CREATE STABLE IF NOT EXISTS disk ("
-        "ts TIMESTAMP, "
-        "total BIGINT, "
-        "used BIGINT, "
-        "free BIGINT, "
-        "usage_percent DOUBLE"
-            ") TAGS (host_ip NCHAR(16), device NCHAR(32), mount_point NCHAR(64))"},
-
-        {"gpu", "CREATE STABLE IF NOT EXISTS gpu ("
-        "ts TIMESTAMP, "
-        "compute_usage DOUBLE, "
-        "mem_usage DOUBLE, "
-        "mem_used BIGINT, "
-        "mem_total BIGINT, "
-        "temperature DOUBLE, "
-        "power DOUBLE"
-            ") TAGS (host_ip NCHAR(16), gpu_index INT, gpu_name NCHAR(64))"},
-
-        {"node", "CREATE STABLE IF NOT EXISTS node ("
-        "ts TIMESTAMP, "
-        "gpu_allocated INT, "
-        "gpu_num INT"
-            ") TAGS (host_ip NCHAR(16))"},
-
-        {"container", "CREATE STABLE IF NOT EXISTS container ("
-        "ts TIMESTAMP, "
-        "container_count INT, "
-        "paused_count INT, "
-        "running_count INT, "
-        "stopped_count INT"
-            ") TAGS (host_ip NCHAR(16))"}
-    };
+    // 由模式注册表生成所有CREATE STABLE语句
+    std::vector<std::pair<std::string, std::string>> tables;
+    metric_schema::forEach(metric_schema::ResourceStables(), [&](const auto& stable, auto) {
+        using S = typename std::decay<decltype(stable)>::type;
+        tables.emplace_back(S::name(), metric_schema::createStableSql<S>());
+    });
     
     std::vector<std::string> failed_tables;
     for (const auto& table : tables) {
@@ -168,6 +222,52 @@ bool ResourceStorage::createResourceTable() {
         logError("Failed to create stable tables: " + failed_list);
         return false;
     }
+
+    // 已存在的超级表补充模式中新增的数值列
+    bool altered = true;
+    metric_schema::forEach(metric_schema::ResourceStables(), [&](const auto& stable, auto) {
+        using S = typename std::decay<decltype(stable)>::type;
+        if (!altered) {
+            return;
+        }
+
+        std::vector<std::string> existing_columns;
+        std::string describe_sql = std::string("DESCRIBE ") + S::name();
+        TAOS_RES* describe_result = taos_query(taos, describe_sql.c_str());
+        if (taos_errno(describe_result) == 0) {
+            TAOS_ROW row;
+            while ((row = taos_fetch_row(describe_result))) {
+                int* lengths = taos_fetch_lengths(describe_result);
+                if (row[0] != nullptr) {
+                    existing_columns.push_back(std::string((char*)row[0], lengths[0]));
+                }
+            }
+        } else {
+            logError("Failed to describe stable " + std::string(S::name()) + ": " + std::string(taos_errstr(describe_result)));
+        }
+        taos_free_result(describe_result);
+
+        metric_schema::forEach(S::fields(), [&](const auto& column, auto) {
+            if (!altered || existing_columns.empty() ||
+                std::find(existing_columns.begin(), existing_columns.end(), column.name) != existing_columns.end()) {
+                return;
+            }
+            std::string alter_sql = std::string("ALTER STABLE ") + S::name() + " ADD COLUMN " + column.name + " " +
+                                    metric_schema::sqlType(column.type, column.length);
+            TAOS_RES* alter_result = taos_query(taos, alter_sql.c_str());
+            if (taos_errno(alter_result) != 0) {
+                logError("Failed to add column " + std::string(column.name) + " to stable " + S::name() + ": " +
+                         std::string(taos_errstr(alter_result)));
+                altered = false;
+            } else {
+                logInfo("Added column " + std::string(column.name) + " to stable " + S::name());
+            }
+            taos_free_result(alter_result);
+        });
+    });
+    if (!altered) {
+        return false;
+    }
     
     logInfo("All resource stable tables created successfully");
     return true;
@@ -182,161 +282,127 @@ bool ResourceStorage::createResourceTable() {
  */
 bool ResourceStorage::insertResourceData(const std::string& hostIp, const node::ResourceInfo& resourceData) {
 
-    TDengineConnectionGuard guard(m_connection_pool);
-    if (!guard.isValid()) {
-        logError("Failed to get database connection from pool");
-        return false;
-    }
-
-    TAOS* taos = guard->get();
     std::string cleanTableName = cleanForTableName(hostIp);
     
     // 获取当前时间戳
     auto now = std::chrono::system_clock::now();
     auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 
-    // 1. 先批量创建所有需要的子表
+    // 子表建表语句与批量INSERT语句（TDengine多表插入语法）由模式注册表生成
     std::vector<std::string> createTableStatements;
-    
-    // CPU表
-    createTableStatements.push_back("CREATE TABLE IF NOT EXISTS cpu_" + cleanTableName + " USING cpu TAGS ('" + hostIp + "')");
-    
-    // Memory表  
-    createTableStatements.push_back("CREATE TABLE IF NOT EXISTS memory_" + cleanTableName + " USING memory TAGS ('" + hostIp + "')");
-    
-    // Node表
-    createTableStatements.push_back("CREATE TABLE IF NOT EXISTS node_" + cleanTableName + " USING node TAGS ('" + hostIp + "')");
-    
-    // Container表
-    createTableStatements.push_back("CREATE TABLE IF NOT EXISTS container_" + cleanTableName + " USING container TAGS ('" + hostIp + "')");
-
-    // Network表（多个接口）
-    for (const auto& interface : resourceData.resource.network) {
-        std::string interfaceName = interface.interface;
-        std::string interfaceTableName = cleanForTableName(interfaceName);
-        std::string tableName = "network_" + cleanTableName + "_" + interfaceTableName;
-        createTableStatements.push_back("CREATE TABLE IF NOT EXISTS " + tableName + " USING network TAGS ('" + hostIp + "', '" + interfaceName + "')");
-    }
-
-    // Disk表（多个磁盘）
-    for (const auto& disk : resourceData.resource.disk) {
-        std::string device = disk.device;
-        std::string mountPoint = disk.mount_point;
-        std::string deviceTableName = cleanForTableName(device);
-        std::string tableName = "disk_" + cleanTableName + "_" + deviceTableName;
-        createTableStatements.push_back("CREATE TABLE IF NOT EXISTS " + tableName + " USING disk TAGS ('" + hostIp + "', '" + device + "', '" + mountPoint + "')");
-    }
-
-    // GPU表（多个GPU）
-    for (const auto& gpu : resourceData.resource.gpu) {
-        int gpuIndex = gpu.index;
-        std::string gpuName = gpu.name;
-        std::string tableName = "gpu_" + cleanTableName + "_" + std::to_string(gpuIndex);
-        createTableStatements.push_back("CREATE TABLE IF NOT EXISTS " + tableName + " USING gpu TAGS ('" + hostIp + "', " + std::to_string(gpuIndex) + ", '" + gpuName + "')");
-    }
-
-    // 执行所有CREATE TABLE语句
-    for (const auto& createSql : createTableStatements) {
-        TAOS_RES* result = taos_query(taos, createSql.c_str());
-        if (taos_errno(result) != 0) {
-            logError("Failed to create table: " + std::string(taos_errstr(result)));
-            logError("SQL: " + createSql);
-            taos_free_result(result);
-            return false;
-        }
-        taos_free_result(result);
-    }
-
-    // 2. 构建批量INSERT语句（TDengine多表插入语法）
     std::ostringstream batchInsertSql;
     batchInsertSql << "INSERT INTO ";
+    std::vector<MetricSample> samples;
+
+    auto addRow = [&](const std::string& tableName, auto stable, const auto& row) {
+        using S = decltype(stable);
+        samples.push_back(metric_schema::toSample<S>(hostIp, timestamp, row));
+
+        std::ostringstream createSql;
+        createSql << "CREATE TABLE IF NOT EXISTS " << tableName << " USING " << S::name() << " TAGS ";
+        metric_schema::appendTagValues<S>(createSql, hostIp, row);
+        createTableStatements.push_back(createSql.str());
 
-    // CPU数据
-    batchInsertSql << "cpu_" << cleanTableName << " VALUES ("
-                   << timestamp << ", "
-                   << resourceData.resource.cpu.usage_percent << ", "
-                   << resourceData.resource.cpu.load_avg_1m << ", "
-                   << resourceData.resource.cpu.load_avg_5m << ", "
-                   << resourceData.resource.cpu.load_avg_15m << ", "
-                   << resourceData.resource.cpu.core_count << ", "
-                   << resourceData.resource.cpu.core_allocated << ", "
-                   << resourceData.resource.cpu.temperature << ", "
-                   << resourceData.resource.cpu.voltage << ", "
-                   << resourceData.resource.cpu.current << ", "
-                   << resourceData.resource.cpu.power << ") ";
+        batchInsertSql << tableName << " VALUES ";
+        metric_schema::appendValues<S>(batchInsertSql, timestamp, row);
+        batchInsertSql << " ";
+    };
 
-    // Memory数据
-    batchInsertSql << "memory_" << cleanTableName << " VALUES ("
-                   << timestamp << ", "
-                   << resourceData.resource.memory.total << ", "
-                   << resourceData.resource.memory.used << ", "
-                   << resourceData.resource.memory.free << ", "
-                   << resourceData.resource.memory.usage_percent << ") ";
+    // CPU、内存数据
+    addRow("cpu_" + cleanTableName, metric_schema::CpuStable(), toRow(resourceData.resource.cpu));
+    addRow("memory_" + cleanTableName, metric_schema::MemoryStable(), toRow(resourceData.resource.memory));
 
     // Node数据
-    batchInsertSql << "node_" << cleanTableName << " VALUES ("
-                   << timestamp << ", "
-                   << resourceData.resource.gpu_allocated << ", "
-                   << resourceData.resource.gpu_num << ") ";
+    metric_schema::NodeAllocationRow nodeRow;
+    nodeRow.gpu_allocated = resourceData.resource.gpu_allocated;
+    nodeRow.gpu_num = resourceData.resource.gpu_num;
+    addRow("node_" + cleanTableName, metric_schema::NodeStable(), nodeRow);
 
     // Container数据
-    int container_count = resourceData.component.size();
-    int paused_count = 0, running_count = 0, stopped_count = 0;
+    NodeResourceData::ContainerData containerRow;
+    containerRow.container_count = resourceData.component.size();
     for (const auto& container : resourceData.component) {
-        if (container.state == "RUNNING") running_count++;
-        else if (container.state == "PAUSED") paused_count++;
-        else if (container.state == "STOPPED") stopped_count++;
+        if (container.state == "RUNNING") containerRow.running_count++;
+        else if (container.state == "PAUSED") containerRow.paused_count++;
+        else if (container.state == "STOPPED") containerRow.stopped_count++;
     }
-    
-    batchInsertSql << "container_" << cleanTableName << " VALUES ("
-                   << timestamp << ", "
-                   << container_count << ", "
-                   << paused_count << ", "
-                   << running_count << ", "
-                   << stopped_count << ") ";
+    addRow("container_" + cleanTableName, metric_schema::ContainerStable(), containerRow);
 
-    // Network数据（多个接口）
+    // Network数据（多个接口），首个样本没有速率，写入NULL
+    // 计数器样本在批量插入成功后才记为上一次样本，写入失败时下一次仍相对已落库的样本计算增量
+    std::vector<std::pair<std::string, NetworkCounterSample>> counterSamples;
     for (const auto& interface : resourceData.resource.network) {
-        std::string interfaceTableName = cleanForTableName(interface.interface);
-        std::string tableName = "network_" + cleanTableName + "_" + interfaceTableName;
-        
-        batchInsertSql << tableName << " VALUES ("
-                       << timestamp << ", "
-                       << interface.rx_bytes << ", "
-                       << interface.tx_bytes << ", "
-                       << interface.rx_packets << ", "
-                       << interface.tx_packets << ", "
-                       << interface.rx_errors << ", "
-                       << interface.tx_errors << ", "
-                       << interface.rx_rate << ", "
-                       << interface.tx_rate << ") ";
+        NetworkCounterSample counterSample;
+        counterSample.rx_packets = interface.rx_packets;
+        counterSample.tx_packets = interface.tx_packets;
+        counterSample.rx_errors = interface.rx_errors;
+        counterSample.tx_errors = interface.tx_errors;
+        counterSample.timestamp = timestamp;
+        std::string counterKey = hostIp + "|" + interface.interface;
+        NetworkDerivedRates rates = deriveNetworkRates(counterKey, counterSample);
+        counterSamples.emplace_back(std::move(counterKey), counterSample);
+        const double unavailable = std::numeric_limits<double>::quiet_NaN();
+
+        NodeResourceData::NetworkData networkRow;
+        networkRow.interface = interface.interface;
+        networkRow.rx_bytes = static_cast<int64_t>(interface.rx_bytes);
+        networkRow.tx_bytes = static_cast<int64_t>(interface.tx_bytes);
+        networkRow.rx_packets = static_cast<int64_t>(interface.rx_packets);
+        networkRow.tx_packets = static_cast<int64_t>(interface.tx_packets);
+        networkRow.rx_errors = static_cast<int64_t>(interface.rx_errors);
+        networkRow.tx_errors = static_cast<int64_t>(interface.tx_errors);
+        networkRow.rx_rate = static_cast<int64_t>(interface.rx_rate);
+        networkRow.tx_rate = static_cast<int64_t>(interface.tx_rate);
+        networkRow.rx_packet_rate = rates.valid ? rates.rx_packet_rate : unavailable;
+        networkRow.tx_packet_rate = rates.valid ? rates.tx_packet_rate : unavailable;
+        networkRow.rx_error_rate = rates.valid ? rates.rx_error_rate : unavailable;
+        networkRow.tx_error_rate = rates.valid ? rates.tx_error_rate : unavailable;
+
+        addRow("network_" + cleanTableName + "_" + cleanForTableName(interface.interface),
+               metric_schema::NetworkStable(), networkRow);
     }
 
     // Disk数据（多个磁盘）
     for (const auto& disk : resourceData.resource.disk) {
-        std::string deviceTableName = cleanForTableName(disk.device);
-        std::string tableName = "disk_" + cleanTableName + "_" + deviceTableName;
-        
-        batchInsertSql << tableName << " VALUES ("
-                       << timestamp << ", "
-                       << disk.total << ", "
-                       << disk.used << ", "
-                       << disk.free << ", "
-                       << disk.usage_percent << ") ";
+        addRow("disk_" + cleanTableName + "_" + cleanForTableName(disk.device), metric_schema::DiskStable(), toRow(disk));
     }
 
     // GPU数据（多个GPU）
     for (const auto& gpu : resourceData.resource.gpu) {
-        std::string tableName = "gpu_" + cleanTableName + "_" + std::to_string(gpu.index);
-        
-        batchInsertSql << tableName << " VALUES ("
-                       << timestamp << ", "
-                       << gpu.compute_usage << ", "
-                       << gpu.mem_usage << ", "
-                       << gpu.mem_used << ", "
-                       << gpu.mem_total << ", "
-                       << gpu.temperature << ", "
-                       << gpu.power << ") ";
+        addRow("gpu_" + cleanTableName + "_" + std::to_string(gpu.index), metric_schema::GpuStable(), toRow(gpu));
+    }
+
+    // 先把样本交给观察者，数据库不可用时告警评估不受影响
+    SampleObserver observer;
+    {
+        std::lock_guard<std::mutex> lock(m_sample_observer_mutex);
+        observer = m_sample_observer;
+    }
+    if (observer) {
+        try {
+            observer(samples);
+        } catch (const std::exception& e) {
+            logError("Sample observer failed: " + std::string(e.what()));
+        }
+    }
+
+    TDengineConnectionGuard guard(m_connection_pool);
+    if (!guard.isValid()) {
+        logError("Failed to get database connection from pool");
+        return false;
+    }
+    TAOS* taos = guard->get();
+
+    // 执行所有CREATE TABLE语句
+    for (const auto& createSql : createTableStatements) {
+        TAOS_RES* result = taos_query(taos, createSql.c_str());
+        if (taos_errno(result) != 0) {
+            logError("Failed to create table: " + std::string(taos_errstr(result)));
+            logError("SQL: " + createSql);
+            taos_free_result(result);
+            return false;
+        }
+        taos_free_result(result);
     }
 
     // 执行批量插入
@@ -352,34 +418,112 @@ bool ResourceStorage::insertResourceData(const std::string& hostIp, const node::
     }
     
     taos_free_result(result);
+    commitNetworkCounters(counterSamples);
     logDebug("Batch insert completed successfully for host: " + hostIp);
     return true;
 }
 
 /*
- * 执行查询SQL
+ * 由网络接口累计计数器推导每秒速率
+ * 
+ * 参数：
+ * - key: 接口唯一标识 (host_ip|interface)
+ * - sample: 本次上报的接口计数器和写入的毫秒时间戳
+ * 
+ * 首个样本或时间间隔非正时返回 valid=false；计数器重置由 counterDelta 处理。
+ * 只读取上一次已写入的样本，本次样本由 commitNetworkCounters 在写入成功后记录
+ */
+ResourceStorage::NetworkDerivedRates ResourceStorage::deriveNetworkRates(const std::string& key,
+                                                                         const NetworkCounterSample& sample) {
+    NetworkDerivedRates rates;
+
+    std::lock_guard<std::mutex> lock(m_network_counters_mutex);
+    auto it = m_network_counters.find(key);
+    if (it == m_network_counters.end()) {
+        return rates;
+    }
+
+    const NetworkCounterSample& previous = it->second;
+    int64_t elapsed_ms = sample.timestamp - previous.timestamp;
+    if (elapsed_ms > 0) {
+        double seconds = elapsed_ms / 1000.0;
+        rates.rx_packet_rate = counterDelta(previous.rx_packets, sample.rx_packets) / seconds;
+        rates.tx_packet_rate = counterDelta(previous.tx_packets, sample.tx_packets) / seconds;
+        rates.rx_error_rate = counterDelta(previous.rx_errors, sample.rx_errors) / seconds;
+        rates.tx_error_rate = counterDelta(previous.tx_errors, sample.tx_errors) / seconds;
+        rates.valid = true;
+    }
+    return rates;
+}
+
+/*
+ * 记录已写入的网络接口计数器样本
+ * 
+ * 参数：
+ * - samples: (接口唯一标识, 样本) 列表
+ * 
+ * 并发写入同一主机时不用较早的样本覆盖较新的样本。
+ * 每分钟最多一次释放超过10分钟没有上报的接口，已下线主机和已销毁的容器接口不会一直占用内存
+ */
+void ResourceStorage::commitNetworkCounters(const std::vector<std::pair<std::string, NetworkCounterSample>>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    const int64_t timestamp = samples.front().second.timestamp;
+
+    std::lock_guard<std::mutex> lock(m_network_counters_mutex);
+    if (timestamp - m_network_counters_swept_at >= kNetworkCounterSweepMs) {
+        for (auto idle_it = m_network_counters.begin(); idle_it != m_network_counters.end();) {
+            if (timestamp - idle_it->second.timestamp >= kNetworkCounterIdleMs) {
+                idle_it = m_network_counters.erase(idle_it);
+            } else {
+                ++idle_it;
+            }
+        }
+        m_network_counters_swept_at = timestamp;
+    }
+
+    for (const auto& item : samples) {
+        auto inserted = m_network_counters.emplace(item.first, item.second);
+        if (!inserted.second && inserted.first->second.timestamp <= item.second.timestamp) {
+            inserted.first->second = item.second;
+        }
+    }
+}
+
+void ResourceStorage::setSampleObserver(SampleObserver observer) {
+    std::lock_guard<std::mutex> lock(m_sample_observer_mutex);
+    m_sample_observer = std::move(observer);
+}
+
+/*
+ * 执行查询并逐行回调
  * 
  * 参数：
  * - sql: 查询SQL语句
+ * - on_row: 行回调 (行数据, 各列长度, 字段信息, 字段数)
+ * 
+ * 查询失败时抛出异常，超过当前请求的截止时间时抛出 QueryDeadlineExceeded
  */
-std::vector<QueryResult> ResourceStorage::executeQuerySQL(const std::string& sql) {
-    std::vector<QueryResult> results;
-    
+void ResourceStorage::executeRawQuery(const std::string& sql, const RowCallback& on_row) {
     logDebug("Executing query: " + sql);
     
-    TDengineConnectionGuard guard(m_connection_pool);
+    // 连接等待时间受当前请求的截止时间约束
+    TDengineConnectionGuard guard(m_connection_pool, QueryDeadlineScope::acquireTimeoutMs());
     if (!guard.isValid()) {
+        QueryDeadlineScope::throwIfExpired("waiting for TDengine connection");
         logError("Failed to get database connection from pool");
-        return results;
+        return;
     }
     
     TAOS* taos = guard->get();
-    TAOS_RES* res = taos_query(taos, sql.c_str());
+    TAOS_RES* res = taosQueryWithDeadline(taos, sql);
     if (taos_errno(res) != 0) {
-        logError("Query failed: " + std::string(taos_errstr(res)));
+        std::string error = taos_errstr(res);
+        logError("Query failed: " + error);
         logError("SQL: " + sql);
         taos_free_result(res);
-        throw std::runtime_error("ResourceStorage: Query failed: " + std::string(taos_errstr(res)));
+        throw std::runtime_error("ResourceStorage: Query failed: " + error);
     }
     
     // 获取字段信息
@@ -388,310 +532,118 @@ std::vector<QueryResult> ResourceStorage::executeQuerySQL(const std::string& sql
     
     if (field_count == 0) {
         taos_free_result(res);
-        return results;
+        return;
     }
     
-    // 处理查询结果
     TAOS_ROW row;
+    size_t row_count = 0;
     while ((row = taos_fetch_row(res))) {
-        int* lengths = taos_fetch_lengths(res);
+        // 每读取一批行检查一次截止时间，超时则中止查询
+        if (++row_count % 256 == 0 && taosStopIfDeadlineExceeded(res)) {
+            taos_free_result(res);
+            throw QueryDeadlineExceeded("ResourceStorage: Query deadline exceeded while fetching rows");
+        }
+        on_row(row, taos_fetch_lengths(res), fields, field_count);
+    }
+    
+    taos_free_result(res);
+    LogManager::getLogger()->debug("ResourceStorage: Query returned {} rows", row_count);
+}
+
+/*
+ * 执行查询SQL
+ * 
+ * 参数：
+ * - sql: 查询SQL语句
+ */
+std::vector<QueryResult> ResourceStorage::executeQuerySQL(const std::string& sql) {
+    std::vector<QueryResult> results;
+    scanQuerySQL(sql, [&results](QueryResult& result) {
+        results.push_back(std::move(result));
+    });
+    return results;
+}
+
+/*
+ * 执行查询SQL并逐行回调
+ * 
+ * 参数：
+ * - sql: 查询SQL语句
+ * - on_result: 每行解码后的回调，回调可以移走 QueryResult 的内容
+ * 
+ * 列名到标签/数值的划分在读取第一行时确定一次，逐单元格只做下标访问
+ */
+void ResourceStorage::scanQuerySQL(const std::string& sql, const std::function<void(QueryResult&)>& on_result) {
+    std::vector<std::string> names;
+    std::vector<int> roles;  // 0: ts, 1: 标签, 2: 数值
+    
+    executeRawQuery(sql, [&](TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, int field_count) {
+        if (roles.empty()) {
+            const auto& labels = labelColumns();
+            for (int i = 0; i < field_count; i++) {
+                names.emplace_back(fields[i].name);
+                if (names.back() == "ts") {
+                    roles.push_back(0);
+                } else if (labels.count(names.back())) {
+                    roles.push_back(1);
+                } else {
+                    roles.push_back(2);
+                }
+            }
+        }
         
         QueryResult result;
         result.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
         
-        // 一次遍历：收集所有字段信息
         for (int i = 0; i < field_count; i++) {
             if (row[i] == nullptr) continue;
             
-            std::string field_name = fields[i].name;
-            
-            if (field_name == "ts") {
+            if (roles[i] == 0) {
                 // 时间戳字段 - TDengine 通常返回毫秒精度
                 if (fields[i].type == TSDB_DATA_TYPE_TIMESTAMP) {
                     result.timestamp = *(int64_t*)row[i];
                 }
-            } else if (field_name == "host_ip" || field_name == "mount_point" || field_name == "device" || 
-                      field_name == "interface" || field_name == "gpu_name" || field_name == "gpu_index" || 
-                      field_name == "sensor_seq" || field_name == "sensor_type" || field_name == "sensor_name" ||
-                      field_name == "value" || field_name == "table_type") {
-                // 标签字段
-                if (fields[i].type == TSDB_DATA_TYPE_NCHAR || fields[i].type == TSDB_DATA_TYPE_BINARY) {
-                    result.labels[field_name] = std::string((char*)row[i], lengths[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_INT) {
-                    result.labels[field_name] = std::to_string(*(int*)row[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_BIGINT) {
-                    result.labels[field_name] = std::to_string(*(int64_t*)row[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_SMALLINT) {
-                    result.labels[field_name] = std::to_string(*(int16_t*)row[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_TINYINT) {
-                    result.labels[field_name] = std::to_string(*(int8_t*)row[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_FLOAT) {
-                    result.labels[field_name] = std::to_string(*(float*)row[i]);
-                } else if (fields[i].type == TSDB_DATA_TYPE_DOUBLE) {
-                    result.labels[field_name] = std::to_string(*(double*)row[i]);
-                }
+            } else if (roles[i] == 1) {
+                result.labels[names[i]] = metric_schema::cellToString(fields[i], row[i], lengths[i]);
             } else {
-                // 数值字段 - 存储到 metrics map 中
-                double value = 0.0;
-                if (fields[i].type == TSDB_DATA_TYPE_FLOAT) {
-                    value = *(float*)row[i];
-                } else if (fields[i].type == TSDB_DATA_TYPE_DOUBLE) {
-                    value = *(double*)row[i];
-                } else if (fields[i].type == TSDB_DATA_TYPE_INT) {
-                    value = *(int*)row[i];
-                } else if (fields[i].type == TSDB_DATA_TYPE_BIGINT) {
-                    value = *(int64_t*)row[i];
-                } else if (fields[i].type == TSDB_DATA_TYPE_SMALLINT) {
-                    value = *(int16_t*)row[i];
-                } else if (fields[i].type == TSDB_DATA_TYPE_TINYINT) {
-                    value = *(int8_t*)row[i];
-                }
-                result.metrics[field_name] = value;
+                result.metrics[names[i]] = metric_schema::cellToDouble(fields[i], row[i]);
             }
         }
         
-        results.push_back(result);
-    }
-    
-    taos_free_result(res);
-    
-    LogManager::getLogger()->debug("ResourceStorage: Query returned {} rows", results.size());
-    return results;
+        on_result(result);
+    });
 }
 
 NodeResourceData ResourceStorage::getNodeResourceData(const std::string& hostIp) {
+    using Layout = metric_schema::NodeQueryLayout;
     NodeResourceData nodeData;
     nodeData.host_ip = hostIp;
     
     try {
-        // 合并所有查询为一个UNION ALL语句，使用table_type字段标识数据来源
-        std::string combinedSql = 
-            // CPU数据
-            "SELECT 'cpu' as table_type, LAST_ROW(ts) as ts, "
-            "LAST_ROW(usage_percent) as usage_percent, LAST_ROW(load_avg_1m) as load_avg_1m, "
-            "LAST_ROW(load_avg_5m) as load_avg_5m, LAST_ROW(load_avg_15m) as load_avg_15m, "
-            "LAST_ROW(core_count) as core_count, LAST_ROW(core_allocated) as core_allocated, "
-            "LAST_ROW(temperature) as temperature, LAST_ROW(voltage) as voltage, "
-            "LAST_ROW(current) as current, LAST_ROW(power) as power, "
-            "NULL as device, NULL as mount_point, NULL as interface, "
-            "NULL as gpu_index, NULL as gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "NULL as total, NULL as used, NULL as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM cpu WHERE host_ip = '" + hostIp + "' "
-            
-            "UNION ALL "
-            
-            // Memory数据
-            "SELECT 'memory' as table_type, LAST_ROW(ts) as ts, "
-            "LAST_ROW(usage_percent) as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "NULL as temperature, NULL as voltage, "
-            "NULL as current, NULL as power, "
-            "NULL as device, NULL as mount_point, NULL as interface, "
-            "NULL as gpu_index, NULL as gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "LAST_ROW(total) as total, LAST_ROW(used) as used, LAST_ROW(free) as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM memory WHERE host_ip = '" + hostIp + "' "
-            
-            "UNION ALL "
-            
-            // Disk数据
-            "SELECT 'disk' as table_type, LAST_ROW(ts) as ts, "
-            "LAST_ROW(usage_percent) as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "NULL as temperature, NULL as voltage, "
-            "NULL as current, NULL as power, "
-            "device, mount_point, NULL as interface, "
-            "NULL as gpu_index, NULL as gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "LAST_ROW(total) as total, LAST_ROW(used) as used, LAST_ROW(free) as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM disk WHERE host_ip = '" + hostIp + "' GROUP BY device, mount_point "
-            
-            "UNION ALL "
-            
-            // Network数据
-            "SELECT 'network' as table_type, LAST_ROW(ts) as ts, "
-            "NULL as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "NULL as temperature, NULL as voltage, "
-            "NULL as current, NULL as power, "
-            "NULL as device, NULL as mount_point, interface, "
-            "NULL as gpu_index, NULL as gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "NULL as total, NULL as used, NULL as free, "
-            "LAST_ROW(rx_bytes) as rx_bytes, LAST_ROW(tx_bytes) as tx_bytes, LAST_ROW(rx_packets) as rx_packets, LAST_ROW(tx_packets) as tx_packets, "
-            "LAST_ROW(rx_errors) as rx_errors, LAST_ROW(tx_errors) as tx_errors, LAST_ROW(rx_rate) as rx_rate, LAST_ROW(tx_rate) as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM network WHERE host_ip = '" + hostIp + "' GROUP BY interface "
-            
-            "UNION ALL "
-            
-            // GPU数据
-            "SELECT 'gpu' as table_type, LAST_ROW(ts) as ts, "
-            "NULL as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "LAST_ROW(temperature) as temperature, NULL as voltage, "
-            "NULL as current, LAST_ROW(power) as power, "
-            "NULL as device, NULL as mount_point, NULL as interface, "
-            "gpu_index, gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "NULL as total, NULL as used, NULL as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "LAST_ROW(compute_usage) as compute_usage, LAST_ROW(mem_usage) as mem_usage, LAST_ROW(mem_used) as mem_used, LAST_ROW(mem_total) as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM gpu WHERE host_ip = '" + hostIp + "' GROUP BY gpu_index, gpu_name "
-            
-            "UNION ALL "
-            
-            // Container数据
-            "SELECT 'container' as table_type, LAST_ROW(ts) as ts, "
-            "NULL as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "NULL as temperature, NULL as voltage, "
-            "NULL as current, NULL as power, "
-            "NULL as device, NULL as mount_point, NULL as interface, "
-            "NULL as gpu_index, NULL as gpu_name, NULL as sensor_seq, NULL as sensor_type, NULL as sensor_name, "
-            "NULL as total, NULL as used, NULL as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "LAST_ROW(container_count) as container_count, LAST_ROW(paused_count) as paused_count, LAST_ROW(running_count) as running_count, LAST_ROW(stopped_count) as stopped_count, "
-            "NULL as sensor_value, NULL as alarm_type "
-            "FROM container WHERE host_ip = '" + hostIp + "' "
-            
-            "UNION ALL "
-            
-            // Sensor数据
-            "SELECT 'sensor' as table_type, LAST_ROW(ts) as ts, "
-            "NULL as usage_percent, NULL as load_avg_1m, "
-            "NULL as load_avg_5m, NULL as load_avg_15m, "
-            "NULL as core_count, NULL as core_allocated, "
-            "NULL as temperature, NULL as voltage, "
-            "NULL as current, NULL as power, "
-            "NULL as device, NULL as mount_point, NULL as interface, "
-            "NULL as gpu_index, NULL as gpu_name, sensor_seq, sensor_type, sensor_name, "
-            "NULL as total, NULL as used, NULL as free, "
-            "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-            "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-            "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-            "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-            "LAST_ROW(sensor_value) as sensor_value, LAST_ROW(alarm_type) as alarm_type "
-            "FROM bmc_sensor_super WHERE host_ip = '" + hostIp + "' GROUP BY sensor_seq, sensor_type, sensor_name";
-        
-        auto allResults = executeQuerySQL(combinedSql);
-        
-        // 根据table_type处理不同类型的数据
-        for (const auto& result : allResults) {
-            std::string tableType = result.labels.count("table_type") ? result.labels.at("table_type") : "";
-            
-            if (tableType == "cpu") {
-                nodeData.cpu.has_data = true;
-                nodeData.cpu.timestamp = result.timestamp;
-                const auto& metrics = result.metrics;
-                
-                nodeData.cpu.usage_percent = metrics.count("usage_percent") ? metrics.at("usage_percent") : 0.0;
-                nodeData.cpu.load_avg_1m = metrics.count("load_avg_1m") ? metrics.at("load_avg_1m") : 0.0;
-                nodeData.cpu.load_avg_5m = metrics.count("load_avg_5m") ? metrics.at("load_avg_5m") : 0.0;
-                nodeData.cpu.load_avg_15m = metrics.count("load_avg_15m") ? metrics.at("load_avg_15m") : 0.0;
-                nodeData.cpu.core_count = static_cast<int>(metrics.count("core_count") ? metrics.at("core_count") : 0);
-                nodeData.cpu.core_allocated = static_cast<int>(metrics.count("core_allocated") ? metrics.at("core_allocated") : 0);
-                nodeData.cpu.temperature = metrics.count("temperature") ? metrics.at("temperature") : 0.0;
-                nodeData.cpu.voltage = metrics.count("voltage") ? metrics.at("voltage") : 0.0;
-                nodeData.cpu.current = metrics.count("current") ? metrics.at("current") : 0.0;
-                nodeData.cpu.power = metrics.count("power") ? metrics.at("power") : 0.0;
-            }
-            else if (tableType == "memory") {
-                nodeData.memory.has_data = true;
-                nodeData.memory.timestamp = result.timestamp;
-                const auto& metrics = result.metrics;
-                
-                nodeData.memory.total = static_cast<int64_t>(metrics.count("total") ? metrics.at("total") : 0);
-                nodeData.memory.used = static_cast<int64_t>(metrics.count("used") ? metrics.at("used") : 0);
-                nodeData.memory.free = static_cast<int64_t>(metrics.count("free") ? metrics.at("free") : 0);
-                nodeData.memory.usage_percent = metrics.count("usage_percent") ? metrics.at("usage_percent") : 0.0;
-            }
-            else if (tableType == "disk") {
-            NodeResourceData::DiskData diskData;
-            diskData.device = result.labels.count("device") ? result.labels.at("device") : "unknown";
-            diskData.mount_point = result.labels.count("mount_point") ? result.labels.at("mount_point") : "/";
-            diskData.total = static_cast<int64_t>(result.metrics.count("total") ? result.metrics.at("total") : 0);
-            diskData.used = static_cast<int64_t>(result.metrics.count("used") ? result.metrics.at("used") : 0);
-            diskData.free = static_cast<int64_t>(result.metrics.count("free") ? result.metrics.at("free") : 0);
-            diskData.usage_percent = result.metrics.count("usage_percent") ? result.metrics.at("usage_percent") : 0.0;
-            diskData.timestamp = result.timestamp;
-            
-            nodeData.disks.push_back(diskData);
-        }
-            else if (tableType == "network") {
-            NodeResourceData::NetworkData networkData;
-            networkData.interface = result.labels.count("interface") ? result.labels.at("interface") : "unknown";
-            networkData.rx_bytes = static_cast<int64_t>(result.metrics.count("rx_bytes") ? result.metrics.at("rx_bytes") : 0);
-            networkData.tx_bytes = static_cast<int64_t>(result.metrics.count("tx_bytes") ? result.metrics.at("tx_bytes") : 0);
-            networkData.rx_packets = static_cast<int64_t>(result.metrics.count("rx_packets") ? result.metrics.at("rx_packets") : 0);
-            networkData.tx_packets = static_cast<int64_t>(result.metrics.count("tx_packets") ? result.metrics.at("tx_packets") : 0);
-            networkData.rx_errors = static_cast<int>(result.metrics.count("rx_errors") ? result.metrics.at("rx_errors") : 0);
-            networkData.tx_errors = static_cast<int>(result.metrics.count("tx_errors") ? result.metrics.at("tx_errors") : 0);
-            networkData.rx_rate = static_cast<int64_t>(result.metrics.count("rx_rate") ? result.metrics.at("rx_rate") : 0);
-            networkData.tx_rate = static_cast<int64_t>(result.metrics.count("tx_rate") ? result.metrics.at("tx_rate") : 0);
-            networkData.timestamp = result.timestamp;
-            
-            nodeData.networks.push_back(networkData);
-        }
-            else if (tableType == "gpu") {
-            NodeResourceData::GpuData gpuData;
-            gpuData.index = result.labels.count("gpu_index") ? std::stoi(result.labels.at("gpu_index")) : 0;
-            gpuData.name = result.labels.count("gpu_name") ? result.labels.at("gpu_name") : "Unknown GPU";
-            gpuData.compute_usage = result.metrics.count("compute_usage") ? result.metrics.at("compute_usage") : 0.0;
-            gpuData.mem_usage = result.metrics.count("mem_usage") ? result.metrics.at("mem_usage") : 0.0;
-            gpuData.mem_used = static_cast<int64_t>(result.metrics.count("mem_used") ? result.metrics.at("mem_used") : 0);
-            gpuData.mem_total = static_cast<int64_t>(result.metrics.count("mem_total") ? result.metrics.at("mem_total") : 0);
-            gpuData.temperature = result.metrics.count("temperature") ? result.metrics.at("temperature") : 0.0;
-            gpuData.power = result.metrics.count("power") ? result.metrics.at("power") : 0.0;
-            gpuData.timestamp = result.timestamp;
-            
-            nodeData.gpus.push_back(gpuData);
-        }
-            else if (tableType == "container") {
-                nodeData.container.timestamp = result.timestamp;
-                const auto& metrics = result.metrics;
-                
-                nodeData.container.container_count = static_cast<int>(metrics.count("container_count") ? metrics.at("container_count") : 0);
-                nodeData.container.paused_count = static_cast<int>(metrics.count("paused_count") ? metrics.at("paused_count") : 0);
-                nodeData.container.running_count = static_cast<int>(metrics.count("running_count") ? metrics.at("running_count") : 0);
-                nodeData.container.stopped_count = static_cast<int>(metrics.count("stopped_count") ? metrics.at("stopped_count") : 0);
+        // 合并所有超级表的LAST_ROW查询为一个UNION ALL语句，table_type为超级表在布局中的序号
+        std::string condition = "host_ip = '" + hostIp + "'";
+        std::string combinedSql;
+        Layout::forEachStable([&](auto tag) {
+            using S = typename decltype(tag)::type;
+            if (!combinedSql.empty()) {
+                combinedSql += " UNION ALL ";
             }
-            else if (tableType == "sensor") {
-            NodeResourceData::SensorData sensorData;
-                sensorData.sequence = result.labels.count("sensor_seq") ? std::stoi(result.labels.at("sensor_seq")) : 0;
-                sensorData.type = result.labels.count("sensor_type") ? std::stoi(result.labels.at("sensor_type")) : 0;
-                sensorData.name = result.labels.count("sensor_name") ? result.labels.at("sensor_name") : "Unknown Sensor";
-            sensorData.value = result.metrics.count("sensor_value") ? result.metrics.at("sensor_value") : 0.0;
-            sensorData.alarm_type = result.metrics.count("alarm_type") ? result.metrics.at("alarm_type") : 0;
-            sensorData.timestamp = result.timestamp;
-            
-            nodeData.sensors.push_back(sensorData);
+            combinedSql += Layout::select<S>(metric_schema::SelectMode::LAST_ROW, condition);
+        });
+        
+        executeRawQuery(combinedSql, [&](TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, int field_count) {
+            if (static_cast<size_t>(field_count) < Layout::columnCount()) {
+                return;
             }
-        }
+            int64_t timestamp = Layout::decodeTimestamp(row, fields);
+            Layout::dispatch(Layout::decodeTableIndex(row, fields), [&](auto tag) {
+                using S = typename decltype(tag)::type;
+                auto& target = latestRow(nodeData, tag);
+                Layout::decode<S>(row, lengths, fields, target);
+                target.timestamp = timestamp;
+            });
+        });
         
         LogManager::getLogger()->debug("ResourceStorage: Retrieved resource data for node {}: CPU={}, Memory={}, Disks={}, Networks={}, GPUs={}, Sensors={}", 
                                      hostIp, nodeData.cpu.has_data, nodeData.memory.has_data, 
@@ -704,6 +656,57 @@ NodeResourceData ResourceStorage::getNodeResourceData(const std::string& hostIp)
     return nodeData;
 }
 
+/*
+ * 获取多个主机的最新资源数据
+ * 
+ * 与 getNodeResourceData 使用相同的 UNION ALL 布局，每个超级表按 host_ip 和标签分组，
+ * 无论多少主机只执行一次查询。host_ips 为空时不按主机过滤。
+ * 查询失败时抛出异常（含 QueryDeadlineExceeded），由调用方决定如何响应。
+ */
+std::unordered_map<std::string, NodeResourceData> ResourceStorage::getLatestResourceData(const std::vector<std::string>& host_ips) {
+    using Layout = metric_schema::NodeQueryLayout;
+    std::unordered_map<std::string, NodeResourceData> latest;
+    
+    std::string condition;
+    for (const auto& host_ip : host_ips) {
+        condition += (condition.empty() ? "host_ip IN ('" : ", '") + host_ip + "'";
+    }
+    if (!condition.empty()) {
+        condition += ")";
+    }
+    
+    std::string combinedSql;
+    Layout::forEachStable([&](auto tag) {
+        using S = typename decltype(tag)::type;
+        if (!combinedSql.empty()) {
+            combinedSql += " UNION ALL ";
+        }
+        combinedSql += Layout::select<S>(metric_schema::SelectMode::LAST_ROW_BY_HOST, condition);
+    });
+    
+    executeRawQuery(combinedSql, [&](TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, int field_count) {
+        if (static_cast<size_t>(field_count) <= Layout::columnCount()) {
+            return;
+        }
+        std::string host_ip = Layout::decodeHost(row, lengths, fields);
+        if (host_ip.empty()) {
+            return;
+        }
+        NodeResourceData& nodeData = latest[host_ip];
+        nodeData.host_ip = host_ip;
+        int64_t timestamp = Layout::decodeTimestamp(row, fields);
+        Layout::dispatch(Layout::decodeTableIndex(row, fields), [&](auto tag) {
+            using S = typename decltype(tag)::type;
+            auto& target = latestRow(nodeData, tag);
+            Layout::decode<S>(row, lengths, fields, target);
+            target.timestamp = timestamp;
+        });
+    });
+    
+    LogManager::getLogger()->debug("ResourceStorage: Retrieved latest resource data for {} nodes", latest.size());
+    return latest;
+}
+
 // 时间范围解析辅助函数
 std::chrono::seconds parseTimeRange(const std::string& time_range) {
     if (time_range.empty()) {
@@ -761,136 +764,48 @@ NodeResourceRangeData ResourceStorage::getNodeResourceRangeData(const std::strin
             return rangeData;
         }
         
-        // 构建合并的UNION ALL查询
+        // 构建合并的UNION ALL查询，未知的指标类型忽略
+        using Layout = metric_schema::NodeQueryLayout;
+        std::string condition = "host_ip = '" + hostIp + "' AND ts > NOW() - " + time_range;
         std::ostringstream combinedSql;
         bool firstQuery = true;
         
         for (const std::string& metric : metrics) {
-            if (!firstQuery) {
-                combinedSql << " UNION ALL ";
-            }
-            firstQuery = false;
-            
-            if (metric == "cpu") {
-                combinedSql << "SELECT 'cpu' as table_type, ts, "
-                           << "usage_percent, load_avg_1m, load_avg_5m, load_avg_15m, "
-                           << "core_count, core_allocated, temperature, voltage, current, power, "
-                           << "NULL as device, NULL as mount_point, NULL as interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "NULL as total, NULL as used, NULL as free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM cpu WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-                           
-            } else if (metric == "memory") {
-                combinedSql << "SELECT 'memory' as table_type, ts, "
-                           << "usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, NULL as temperature, NULL as voltage, NULL as current, NULL as power, "
-                           << "NULL as device, NULL as mount_point, NULL as interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "total, used, free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM memory WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-                           
-            } else if (metric == "disk") {
-                combinedSql << "SELECT 'disk' as table_type, ts, "
-                           << "usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, NULL as temperature, NULL as voltage, NULL as current, NULL as power, "
-                           << "device, mount_point, NULL as interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "total, used, free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM disk WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-                           
-            } else if (metric == "network") {
-                combinedSql << "SELECT 'network' as table_type, ts, "
-                           << "NULL as usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, NULL as temperature, NULL as voltage, NULL as current, NULL as power, "
-                           << "NULL as device, NULL as mount_point, interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "NULL as total, NULL as used, NULL as free, "
-                           << "rx_bytes, tx_bytes, rx_packets, tx_packets, "
-                           << "rx_errors, tx_errors, rx_rate, tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM network WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-                           
-            } else if (metric == "gpu") {
-                combinedSql << "SELECT 'gpu' as table_type, ts, "
-                           << "NULL as usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, temperature, NULL as voltage, NULL as current, power, "
-                           << "NULL as device, NULL as mount_point, NULL as interface, "
-                           << "gpu_index, gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "NULL as total, NULL as used, NULL as free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "compute_usage, mem_usage, mem_used, mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM gpu WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-                           
-            } else if (metric == "container") {
-                combinedSql << "SELECT 'container' as table_type, ts, "
-                           << "NULL as usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, NULL as temperature, NULL as voltage, NULL as current, NULL as power, "
-                           << "NULL as device, NULL as mount_point, NULL as interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, NULL as sensor_seq, "
-                           << "NULL as sensor_name, NULL as sensor_type, NULL as box_id, NULL as slot_id, "
-                           << "NULL as total, NULL as used, NULL as free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "container_count, paused_count, running_count, stopped_count, "
-                           << "NULL as alarm_type, NULL as work_mode, NULL as speed, NULL as sensor_value "
-                           << "FROM container WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-            } else if (metric == "sensor") {
-                combinedSql << "SELECT 'sensor' as table_type, ts, "
-                           << "NULL as usage_percent, NULL as load_avg_1m, NULL as load_avg_5m, NULL as load_avg_15m, "
-                           << "NULL as core_count, NULL as core_allocated, NULL as temperature, NULL as voltage, NULL as current, NULL as power, "
-                           << "NULL as device, NULL as mount_point, NULL as interface, "
-                           << "NULL as gpu_index, NULL as gpu_name, NULL as fan_seq, sensor_seq, "
-                           << "sensor_name, sensor_type, box_id, slot_id, "
-                           << "NULL as total, NULL as used, NULL as free, "
-                           << "NULL as rx_bytes, NULL as tx_bytes, NULL as rx_packets, NULL as tx_packets, "
-                           << "NULL as rx_errors, NULL as tx_errors, NULL as rx_rate, NULL as tx_rate, "
-                           << "NULL as compute_usage, NULL as mem_usage, NULL as mem_used, NULL as mem_total, "
-                           << "NULL as container_count, NULL as paused_count, NULL as running_count, NULL as stopped_count, "
-                           << "alarm_type, NULL as work_mode, NULL as speed, sensor_value "
-                           << "FROM bmc_sensor_super WHERE host_ip = '" << hostIp << "' AND ts > NOW() - " << time_range;
-            }
+            Layout::forEachStable([&](auto tag) {
+                using S = typename decltype(tag)::type;
+                if (metric != S::metricType()) {
+                    return;
+                }
+                if (!firstQuery) {
+                    combinedSql << " UNION ALL ";
+                }
+                firstQuery = false;
+                combinedSql << Layout::select<S>(metric_schema::SelectMode::RANGE, condition);
+            });
         }
         
-        combinedSql << " ORDER BY ts ASC";
-        
-        // 执行合并查询
-        std::string finalSql = combinedSql.str();
-        logDebug("执行范围数据合并查询: " + finalSql);
-        auto allResults = executeQuerySQL(finalSql);
-        
         // 按table_type分组处理结果
         std::map<std::string, std::vector<QueryResult>> groupedResults;
-        for (const auto& result : allResults) {
-            std::string tableType = result.labels.count("table_type") ? result.labels.at("table_type") : "";
-            if (!tableType.empty()) {
-                groupedResults[tableType].push_back(result);
-            }
+        if (!firstQuery) {
+            combinedSql << " ORDER BY ts ASC";
+            
+            // 执行合并查询
+            std::string finalSql = combinedSql.str();
+            logDebug("执行范围数据合并查询: " + finalSql);
+            executeRawQuery(finalSql, [&](TAOS_ROW row, const int* lengths, const TAOS_FIELD* fields, int field_count) {
+                if (static_cast<size_t>(field_count) < Layout::columnCount()) {
+                    return;
+                }
+                int64_t timestamp = Layout::decodeTimestamp(row, fields);
+                Layout::dispatch(Layout::decodeTableIndex(row, fields), [&](auto tag) {
+                    using S = typename decltype(tag)::type;
+                    QueryResult result;
+                    result.timestamp = timestamp;
+                    result.labels["table_type"] = S::metricType();
+                    Layout::decode<S>(row, lengths, fields, result);
+                    groupedResults[S::metricType()].push_back(std::move(result));
+                });
+            });
         }
         
         // 为每个请求的指标类型创建时间序列数据
@@ -953,192 +868,72 @@ nlohmann::json NodeResourceRangeData::to_json() const {
     
     // 容器指标（暂时为空）
     metrics["container"] = nlohmann::json::object();
-    
-    for (const auto& ts : time_series) {
-        if (ts.metric_type == "cpu") {
-            // CPU数据是数组格式
-            nlohmann::json cpu_array = nlohmann::json::array();
-            for (const auto& point : ts.data_points) {
-                nlohmann::json cpu_point;
-                
-                // 从metrics中提取所有字段
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        cpu_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        cpu_point[metric.first] = metric.second;
-                    }
-                }
-                
-                cpu_array.push_back(cpu_point);
+
+    auto pointToJson = [](const QueryResult& point) {
+        nlohmann::json out;
+        for (const auto& metric : point.metrics) {
+            if (metric.first == "timestamp") {
+                out["timestamp"] = static_cast<int64_t>(metric.second);
+            } else {
+                out[metric.first] = metric.second;
             }
-            metrics["cpu"] = cpu_array;
-            
-        } else if (ts.metric_type == "memory") {
-            // Memory数据是数组格式
-            nlohmann::json memory_array = nlohmann::json::array();
-            for (const auto& point : ts.data_points) {
-                nlohmann::json memory_point;
-                
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        memory_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        memory_point[metric.first] = metric.second;
-                    }
-                }
-                
-                memory_array.push_back(memory_point);
+        }
+        return out;
+    };
+
+    // 单一数据源的指标为数组格式
+    auto arrayJson = [&](const TimeSeriesData& ts) {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& point : ts.data_points) {
+            array.push_back(pointToJson(point));
+        }
+        return array;
+    };
+
+    // 多设备的指标按分组标签聚合为 {分组: [数据点]}，append_tags 追加模式中绑定的标签字段
+    auto groupedJson = [&](const TimeSeriesData& ts, const std::string& group_label, const std::string& fallback,
+                           const std::function<void(const QueryResult&, nlohmann::json&)>& append_tags) {
+        std::map<std::string, nlohmann::json> group_data;
+        for (const auto& point : ts.data_points) {
+            auto it = point.labels.find(group_label);
+            const std::string& key = it != point.labels.end() ? it->second : fallback;
+            nlohmann::json point_json = pointToJson(point);
+            append_tags(point, point_json);
+            auto group = group_data.find(key);
+            if (group == group_data.end()) {
+                group = group_data.emplace(key, nlohmann::json::array()).first;
             }
-            metrics["memory"] = memory_array;
-            
+            group->second.push_back(point_json);
+        }
+        nlohmann::json groups;
+        for (const auto& group : group_data) {
+            groups[group.first] = group.second;
+        }
+        return groups;
+    };
+    
+    for (const auto& ts : time_series) {
+        if (ts.metric_type == "cpu" || ts.metric_type == "memory" || ts.metric_type == "container") {
+            metrics[ts.metric_type] = arrayJson(ts);
         } else if (ts.metric_type == "disk") {
             // Disk数据按设备分组
-            nlohmann::json disk_groups;
-            std::map<std::string, nlohmann::json> device_data;
-            
-            for (const auto& point : ts.data_points) {
-                std::string device_key = point.labels.count("group_key") ? point.labels.at("group_key") : "unknown";
-                
-                nlohmann::json disk_point;
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        disk_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        disk_point[metric.first] = metric.second;
-                    }
-                }
-                
-                // 添加标签字段
-                if (point.labels.count("device")) {
-                    disk_point["device"] = point.labels.at("device");
-                }
-                if (point.labels.count("mount_point")) {
-                    disk_point["mount_point"] = point.labels.at("mount_point");
-                }
-                
-                if (device_data.find(device_key) == device_data.end()) {
-                    device_data[device_key] = nlohmann::json::array();
-                }
-                device_data[device_key].push_back(disk_point);
-            }
-            
-            for (const auto& device : device_data) {
-                disk_groups[device.first] = device.second;
-            }
-            metrics["disk"] = disk_groups;
-            
+            metrics["disk"] = groupedJson(ts, "group_key", "unknown", metric_schema::appendTagsJson<metric_schema::DiskStable>);
         } else if (ts.metric_type == "network") {
             // Network数据按接口分组
-            nlohmann::json network_groups;
-            std::map<std::string, nlohmann::json> interface_data;
-            
-            for (const auto& point : ts.data_points) {
-                std::string interface_key = point.labels.count("group_key") ? point.labels.at("group_key") : "unknown";
-                
-                nlohmann::json network_point;
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        network_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        network_point[metric.first] = metric.second;
-                    }
-                }
-                
-                // 添加接口字段
-                if (point.labels.count("interface")) {
-                    network_point["interface"] = point.labels.at("interface");
-                }
-                
-                if (interface_data.find(interface_key) == interface_data.end()) {
-                    interface_data[interface_key] = nlohmann::json::array();
-                }
-                interface_data[interface_key].push_back(network_point);
-            }
-            
-            for (const auto& interface : interface_data) {
-                network_groups[interface.first] = interface.second;
-            }
-            metrics["network"] = network_groups;
-            
+            metrics["network"] = groupedJson(ts, "group_key", "unknown", metric_schema::appendTagsJson<metric_schema::NetworkStable>);
         } else if (ts.metric_type == "gpu") {
             // GPU数据按GPU索引分组
-            nlohmann::json gpu_groups;
-            std::map<std::string, nlohmann::json> gpu_data;
-            
-            for (const auto& point : ts.data_points) {
-                std::string gpu_key = point.labels.count("group_key") ? point.labels.at("group_key") : "gpu_0";
-                
-                nlohmann::json gpu_point;
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        gpu_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        gpu_point[metric.first] = metric.second;
-                    }
-                }
-                
-                // 添加GPU相关字段
-                if (point.labels.count("gpu_index")) {
-                    gpu_point["index"] = std::stoi(point.labels.at("gpu_index"));
-                }
-                if (point.labels.count("gpu_name")) {
-                    gpu_point["name"] = point.labels.at("gpu_name");
-                }
-                
-                if (gpu_data.find(gpu_key) == gpu_data.end()) {
-                    gpu_data[gpu_key] = nlohmann::json::array();
-                }
-                gpu_data[gpu_key].push_back(gpu_point);
-            }
-            
-            for (const auto& gpu : gpu_data) {
-                gpu_groups[gpu.first] = gpu.second;
-            }
-            metrics["gpu"] = gpu_groups;
-        } else if (ts.metric_type == "container") {
-            nlohmann::json container_array = nlohmann::json::array();
-
-            for (const auto& point : ts.data_points) {
-                nlohmann::json container_point;
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        container_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        container_point[metric.first] = metric.second;
-                    }
-                }
-                container_array.push_back(container_point);
-            }
-
-            metrics["container"] = container_array;
+            metrics["gpu"] = groupedJson(ts, "group_key", "gpu_0", metric_schema::appendTagsJson<metric_schema::GpuStable>);
         } else if (ts.metric_type == "sensor") {
-            // Sensor数据按传感器类型分组
-            nlohmann::json sensor_groups;
-            std::map<std::string, nlohmann::json> sensor_data;
-
-            for (const auto& point : ts.data_points) {
-                std::string sensor_key = point.labels.count("sensor_name") ? point.labels.at("sensor_name") : "sensor_0";
-
-                nlohmann::json sensor_point;
-                for (const auto& metric : point.metrics) {
-                    if (metric.first == "timestamp") {
-                        sensor_point["timestamp"] = static_cast<int64_t>(metric.second);
-                    } else {
-                        sensor_point[metric.first] = metric.second;
+            // Sensor数据按传感器名称分组；box_id/slot_id 在 bmc_sensor_super 中是标签，仍按原输出写入每个数据点
+            metrics["sensor"] = groupedJson(ts, "sensor_name", "sensor_0", [](const QueryResult& point, nlohmann::json& out) {
+                for (const char* tag : {"box_id", "slot_id"}) {
+                    auto it = point.labels.find(tag);
+                    if (it != point.labels.end()) {
+                        out[tag] = std::stoll(it->second);
                     }
                 }
-
-                if (sensor_data.find(sensor_key) == sensor_data.end()) {
-                    sensor_data[sensor_key] = nlohmann::json::array();
-                }
-                sensor_data[sensor_key].push_back(sensor_point);
-            }
-            
-            for (const auto& sensor : sensor_data) {
-                sensor_groups[sensor.first] = sensor.second;
-            }
-            metrics["sensor"] = sensor_groups;
+            });
         }
     }
     
@@ -0,0 +1,69 @@
+#include "ewma_baseline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // 标准差相对均值的下限和绝对下限，恒定序列仍能对变化给出有限的分数
+    const double kRelativeStddevFloor = 1e-3;
+    const double kAbsoluteStddevFloor = 1e-9;
+}
+
+bool EwmaBaseline::update(const EwmaParams& params, int64_t timestamp_ms, double value, double& score) {
+    if (!std::isfinite(value)) {
+        return false;
+    }
+    m_last_timestamp = std::max(m_last_timestamp, timestamp_ms);
+
+    if (m_count == 0) {
+        m_mean = value;
+        m_variance = 0.0;
+        m_count = 1;
+        return false;
+    }
+
+    double diff = value - m_mean;
+    double sigma = std::max({stddev(), params.min_stddev, kRelativeStddevFloor * std::fabs(m_mean),
+                             kAbsoluteStddevFloor});
+    bool scored = m_count >= params.warmup;
+    if (scored) {
+        double z = diff / sigma;
+        switch (params.direction) {
+            case AnomalyDirection::UP:
+                score = z;
+                break;
+            case AnomalyDirection::DOWN:
+                score = -z;
+                break;
+            case AnomalyDirection::BOTH:
+                score = std::fabs(z);
+                break;
+        }
+        if (params.clip > 0.0) {
+            double bound = params.clip * sigma;
+            diff = std::min(std::max(diff, -bound), bound);
+        }
+    }
+
+    double alpha = std::max(params.alpha, 1.0 / (static_cast<double>(m_count) + 1.0));
+    double increment = alpha * diff;
+    m_mean += increment;
+    m_variance = (1.0 - alpha) * (m_variance + diff * increment);
+    if (m_count < std::numeric_limits<uint32_t>::max()) {
+        ++m_count;
+    }
+    return scored;
+}
+
+double EwmaBaseline::stddev() const {
+    return std::sqrt(std::max(m_variance, 0.0));
+}
+
+bool EwmaBaseline::parseDirection(const std::string& name, AnomalyDirection& direction) {
+    if (name == "both") direction = AnomalyDirection::BOTH;
+    else if (name == "up") direction = AnomalyDirection::UP;
+    else if (name == "down") direction = AnomalyDirection::DOWN;
+    else return false;
+    return true;
+}
@@ -0,0 +1,26 @@
+#include "flap_detector.h"
+
+FlapDetector::FlapDetector(int64_t window_ms, size_t threshold)
+    : m_window_ms(window_ms > 0 ? window_ms : 1), m_threshold(threshold > 0 ? threshold : 1) {
+}
+
+bool FlapDetector::record(int64_t timestamp_ms) {
+    if (!m_changes.empty() && timestamp_ms < m_changes.back()) {
+        timestamp_ms = m_changes.back();
+    }
+    m_changes.push_back(timestamp_ms);
+
+    int64_t cutoff = timestamp_ms - m_window_ms;
+    while (!m_changes.empty() && m_changes.front() <= cutoff) {
+        m_changes.pop_front();
+    }
+
+    if (m_changes.size() >= m_threshold) {
+        m_flapping = true;
+    }
+    return m_flapping;
+}
+
+int64_t FlapDetector::quietAt() const {
+    return m_changes.empty() ? 0 : m_changes.back() + m_window_ms;
+}
@@ -0,0 +1,75 @@
+#include "linear_trend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // 拟合直线至少需要的样本数
+    const uint32_t kMinFitSamples = 3;
+}
+
+void LinearTrend::add(int64_t timestamp_ms, double value, double tau_s) {
+    if (!std::isfinite(value)) {
+        return;
+    }
+    if (m_count > 0) {
+        if (timestamp_ms < m_last_timestamp) {
+            timestamp_ms = m_last_timestamp;
+        }
+        // 原点平移到新样本：旧样本的 t 减去 dt
+        double dt = static_cast<double>(timestamp_ms - m_last_timestamp) / 1000.0;
+        m_stt = m_stt - 2.0 * dt * m_st + dt * dt * m_sw;
+        m_stx = m_stx - dt * m_sx;
+        m_st = m_st - dt * m_sw;
+
+        double decay = tau_s > 0.0 ? std::exp(-dt / tau_s) : 1.0;
+        m_sw *= decay;
+        m_st *= decay;
+        m_sx *= decay;
+        m_stt *= decay;
+        m_stx *= decay;
+    }
+    m_last_timestamp = timestamp_ms;
+
+    // 新样本位于 t = 0，只增加 Σw 和 Σw·x
+    m_sw += 1.0;
+    m_sx += value;
+    if (m_count < std::numeric_limits<uint32_t>::max()) {
+        ++m_count;
+    }
+}
+
+bool LinearTrend::fit(double min_span_s, double& level, double& slope) const {
+    if (m_count < kMinFitSamples || spanSeconds() < min_span_s) {
+        return false;
+    }
+    double denominator = m_sw * m_stt - m_st * m_st;
+    if (!(denominator > 0.0)) {
+        return false;
+    }
+    slope = (m_sw * m_stx - m_st * m_sx) / denominator;
+    level = (m_sx - slope * m_st) / m_sw;
+    return std::isfinite(slope) && std::isfinite(level);
+}
+
+double LinearTrend::spanSeconds() const {
+    if (m_sw <= 0.0) {
+        return 0.0;
+    }
+    double mean_t = m_st / m_sw;
+    double variance = m_stt / m_sw - mean_t * mean_t;
+    return std::sqrt(12.0 * std::max(variance, 0.0));
+}
+
+bool LinearTrend::timeToReach(double level, double slope, double capacity, double& seconds) {
+    if (level >= capacity) {
+        seconds = 0.0;
+        return true;
+    }
+    if (!(slope > 0.0)) {
+        return false;
+    }
+    seconds = (capacity - level) / slope;
+    return true;
+}
@@ -465,6 +465,34 @@ MySQLConnectionPool::PoolStats MySQLConnectionPool::getStats() const {
     return stats;
 }
 
+bool MySQLConnectionPool::killQuery(unsigned long thread_id) {
+    if (shutdown_) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(kill_mutex_);
+    const std::string kill_sql = "KILL QUERY " + std::to_string(thread_id);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!kill_connection_) {
+            kill_connection_ = createConnection();
+            if (!kill_connection_) {
+                return false;
+            }
+        }
+        if (mysql_query(kill_connection_->get(), kill_sql.c_str()) == 0) {
+            return true;
+        }
+        unsigned int error = mysql_errno(kill_connection_->get());
+        // 1094: 线程不存在（语句已结束），无需重试
+        if (error == 1094) {
+            return true;
+        }
+        logWarning("通过专用连接中止查询失败: " + std::string(mysql_error(kill_connection_->get())));
+        kill_connection_.reset();
+    }
+    return false;
+}
+
 bool MySQLConnectionPool::isHealthy() const {
     if (!initialized_ || shutdown_) {
         return false;
@@ -0,0 +1,170 @@
+#include "query_deadline.h"
+#include "log_manager.h"
+#include <algorithm>
+
+namespace {
+    thread_local QueryDeadlineScope* t_current_scope = nullptr;
+}
+
+QueryDeadline QueryDeadline::afterMs(int64_t timeout_ms) {
+    QueryDeadline deadline;
+    if (timeout_ms > 0) {
+        deadline.m_set = true;
+        deadline.m_time_point = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+    return deadline;
+}
+
+bool QueryDeadline::expired() const {
+    return m_set && Clock::now() >= m_time_point;
+}
+
+int64_t QueryDeadline::remainingMs() const {
+    if (!m_set) {
+        return -1;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(m_time_point - Clock::now()).count();
+    return remaining > 0 ? remaining : 0;
+}
+
+QueryDeadlineScope::QueryDeadlineScope(const QueryDeadline& deadline)
+    : m_deadline(deadline), m_previous(t_current_scope) {
+    t_current_scope = this;
+}
+
+QueryDeadlineScope::~QueryDeadlineScope() {
+    t_current_scope = m_previous;
+}
+
+const QueryDeadline& QueryDeadlineScope::current() {
+    static const QueryDeadline kNoDeadline;
+    return t_current_scope ? t_current_scope->m_deadline : kNoDeadline;
+}
+
+void QueryDeadlineScope::markExceeded() {
+    if (t_current_scope) {
+        t_current_scope->m_exceeded = true;
+    }
+}
+
+int QueryDeadlineScope::acquireTimeoutMs() {
+    const QueryDeadline& deadline = current();
+    if (!deadline.isSet()) {
+        return 0;
+    }
+    // 0 表示使用连接池默认值，因此至少等待1毫秒
+    return static_cast<int>(std::max<int64_t>(1, deadline.remainingMs()));
+}
+
+void QueryDeadlineScope::throwIfExpired(const std::string& what) {
+    if (current().expired()) {
+        markExceeded();
+        throw QueryDeadlineExceeded("Query deadline exceeded: " + what);
+    }
+}
+
+QueryWatchdog& QueryWatchdog::getInstance() {
+    static QueryWatchdog instance;
+    return instance;
+}
+
+QueryWatchdog::~QueryWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+uint64_t QueryWatchdog::arm(QueryDeadline::Clock::time_point deadline, std::function<void()> cancel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&QueryWatchdog::run, this);
+    }
+    uint64_t id = m_next_id++;
+    m_entries[id] = Entry{deadline, std::move(cancel)};
+    m_schedule.emplace(deadline, id);
+    m_cv.notify_all();
+    return id;
+}
+
+bool QueryWatchdog::disarm(uint64_t id) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        auto range = m_schedule.equal_range(it->second.deadline);
+        for (auto sit = range.first; sit != range.second; ++sit) {
+            if (sit->second == id) {
+                m_schedule.erase(sit);
+                break;
+            }
+        }
+        m_entries.erase(it);
+        return false;
+    }
+
+    // 回调正在执行时等待其完成，避免连接归还后仍被中止
+    m_cv.wait(lock, [this, id] { return m_running_id != id; });
+    return m_fired.erase(id) > 0;
+}
+
+void QueryWatchdog::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        if (m_schedule.empty()) {
+            m_cv.wait(lock);
+            continue;
+        }
+
+        auto next = m_schedule.begin();
+        if (QueryDeadline::Clock::now() < next->first) {
+            m_cv.wait_until(lock, next->first);
+            continue;
+        }
+
+        uint64_t id = next->second;
+        m_schedule.erase(next);
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) {
+            continue;
+        }
+        std::function<void()> cancel = std::move(it->second.cancel);
+        m_entries.erase(it);
+        m_fired.insert(id);
+        m_running_id = id;
+
+        lock.unlock();
+        try {
+            cancel();
+        } catch (const std::exception& e) {
+            LogManager::getLogger()->error("QueryWatchdog: cancel callback failed: {}", e.what());
+        }
+        lock.lock();
+
+        m_running_id = 0;
+        m_cv.notify_all();
+    }
+}
+
+QueryWatchdog::Guard::Guard(std::function<void()> cancel) {
+    const QueryDeadline& deadline = QueryDeadlineScope::current();
+    if (deadline.isSet()) {
+        m_id = QueryWatchdog::getInstance().arm(deadline.timePoint(), std::move(cancel));
+        m_armed = true;
+    }
+}
+
+QueryWatchdog::Guard::~Guard() {
+    release();
+}
+
+bool QueryWatchdog::Guard::release() {
+    if (m_armed) {
+        m_fired = QueryWatchdog::getInstance().disarm(m_id);
+        m_armed = false;
+    }
+    return m_fired;
+}
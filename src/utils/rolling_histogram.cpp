@@ -0,0 +1,68 @@
+#include "rolling_histogram.h"
+
+#include <algorithm>
+
+RollingHistogram::RollingHistogram(int64_t slot_ms) : m_slot_ms(slot_ms > 0 ? slot_ms : 1) {
+}
+
+size_t RollingHistogram::bucketOf(uint64_t value) {
+    if (value == 0) {
+        return 0;
+    }
+    size_t bucket = 64 - static_cast<size_t>(__builtin_clzll(value));
+    return std::min(bucket, kBuckets - 1);
+}
+
+void RollingHistogram::observe(int64_t now_ms, uint64_t value) {
+    int64_t epoch = std::max(now_ms / m_slot_ms, m_last_epoch);
+    m_last_epoch = epoch;
+
+    Slot& slot = m_slots[static_cast<size_t>(epoch) % kSlots];
+    if (slot.epoch != epoch) {
+        slot = Slot();
+        slot.epoch = epoch;
+    }
+    ++slot.buckets[bucketOf(value)];
+    ++slot.count;
+    slot.sum += value;
+    slot.max = std::max(slot.max, value);
+}
+
+HistogramSummary RollingHistogram::summary(int64_t now_ms) const {
+    HistogramSummary result;
+    int64_t epoch = std::max(now_ms / m_slot_ms, m_last_epoch);
+
+    std::array<uint64_t, kBuckets> buckets{};
+    for (const Slot& slot : m_slots) {
+        if (slot.epoch < 0 || slot.epoch <= epoch - static_cast<int64_t>(kSlots)) {
+            continue;
+        }
+        for (size_t i = 0; i < kBuckets; ++i) {
+            buckets[i] += slot.buckets[i];
+        }
+        result.count += slot.count;
+        result.sum += slot.sum;
+        result.max = std::max(result.max, slot.max);
+    }
+    if (result.count == 0) {
+        return result;
+    }
+
+    // 第 rank 个值所在桶的上界，最后一个桶没有上界，取最大值
+    auto quantile = [&](double q) {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(result.count) + 0.999999));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t upper = i == 0 ? 0 : (i + 1 < kBuckets ? (uint64_t(1) << i) - 1 : result.max);
+                return std::min(upper, result.max);
+            }
+        }
+        return result.max;
+    };
+    result.p50 = quantile(0.50);
+    result.p90 = quantile(0.90);
+    result.p99 = quantile(0.99);
+    return result;
+}
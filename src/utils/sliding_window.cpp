@@ -0,0 +1,109 @@
+#include "sliding_window.h"
+
+SlidingWindow::SlidingWindow(WindowFunc func, int64_t window_ms)
+    : m_func(func), m_window_ms(window_ms > 0 ? window_ms : 1) {
+}
+
+void SlidingWindow::add(int64_t timestamp_ms, double value) {
+    if (timestamp_ms < m_last_timestamp) {
+        timestamp_ms = m_last_timestamp;
+    }
+    m_last_timestamp = timestamp_ms;
+    evict(timestamp_ms);
+
+    if (usesExtremes()) {
+        bool is_min = m_func == WindowFunc::MIN;
+        while (!m_extremes.empty() &&
+               (is_min ? m_extremes.back().value >= value : m_extremes.back().value <= value)) {
+            m_extremes.pop_back();
+        }
+        m_extremes.push_back(Point{timestamp_ms, value, 0.0});
+        return;
+    }
+
+    double increase = 0.0;
+    if (m_func == WindowFunc::RATE && !m_points.empty()) {
+        double previous = m_points.back().value;
+        increase = value >= previous ? value - previous : value;
+        m_increase += increase;
+    }
+    m_sum += value;
+    m_points.push_back(Point{timestamp_ms, value, increase});
+}
+
+void SlidingWindow::evict(int64_t timestamp_ms) {
+    int64_t cutoff = timestamp_ms - m_window_ms;
+
+    while (!m_extremes.empty() && m_extremes.front().timestamp <= cutoff) {
+        m_extremes.pop_front();
+    }
+
+    while (!m_points.empty() && m_points.front().timestamp <= cutoff) {
+        m_sum -= m_points.front().value;
+        m_points.pop_front();
+        // 新的首个样本的增量发生在窗口外
+        if (!m_points.empty()) {
+            m_increase -= m_points.front().increase;
+        }
+    }
+
+    // 窗口清空时归零，避免浮点累计误差
+    if (m_points.empty()) {
+        m_sum = 0.0;
+        m_increase = 0.0;
+    }
+}
+
+bool SlidingWindow::value(double& result) const {
+    switch (m_func) {
+        case WindowFunc::MIN:
+        case WindowFunc::MAX:
+            if (m_extremes.empty()) {
+                return false;
+            }
+            result = m_extremes.front().value;
+            return true;
+        case WindowFunc::AVG:
+            if (m_points.empty()) {
+                return false;
+            }
+            result = m_sum / static_cast<double>(m_points.size());
+            return true;
+        case WindowFunc::SUM:
+            if (m_points.empty()) {
+                return false;
+            }
+            result = m_sum;
+            return true;
+        case WindowFunc::COUNT:
+            result = static_cast<double>(m_points.size());
+            return !m_points.empty();
+        case WindowFunc::RATE: {
+            if (m_points.size() < 2) {
+                return false;
+            }
+            int64_t elapsed_ms = m_points.back().timestamp - m_points.front().timestamp;
+            if (elapsed_ms <= 0) {
+                return false;
+            }
+            result = m_increase * 1000.0 / static_cast<double>(elapsed_ms);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SlidingWindow::empty() const {
+    return usesExtremes() ? m_extremes.empty() : m_points.empty();
+}
+
+bool SlidingWindow::parseFunc(const std::string& name, WindowFunc& func) {
+    if (name == "avg") func = WindowFunc::AVG;
+    else if (name == "min") func = WindowFunc::MIN;
+    else if (name == "max") func = WindowFunc::MAX;
+    else if (name == "sum") func = WindowFunc::SUM;
+    else if (name == "rate") func = WindowFunc::RATE;
+    else if (name == "count") func = WindowFunc::COUNT;
+    else return false;
+    return true;
+}
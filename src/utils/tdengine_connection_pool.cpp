@@ -763,4 +763,34 @@ TDengineConnectionGuard::~TDengineConnectionGuard() {
     if (connection_ && pool_) {
         pool_->releaseConnection(std::move(connection_));
     }
-}
\ No newline at end of file
+}
+
+//=============================================================================
+// 带截止时间的查询辅助函数
+//=============================================================================
+
+TAOS_RES* taosQueryWithDeadline(TAOS* taos, const std::string& sql) {
+    QueryDeadlineScope::throwIfExpired("TDengine query not started");
+
+    QueryWatchdog::Guard watchdog([taos]() {
+        LogManager::getLogger()->warn("TDengine query deadline reached, killing query");
+        taos_kill_query(taos);
+    });
+    TAOS_RES* res = taos_query(taos, sql.c_str());
+    if (watchdog.release()) {
+        taos_free_result(res);
+        QueryDeadlineScope::markExceeded();
+        throw QueryDeadlineExceeded("Query deadline exceeded: TDengine query killed");
+    }
+    return res;
+}
+
+bool taosStopIfDeadlineExceeded(TAOS_RES* res) {
+    if (!QueryDeadlineScope::current().expired()) {
+        return false;
+    }
+    taos_stop_query(res);
+    QueryDeadlineScope::markExceeded();
+    LogManager::getLogger()->warn("TDengine fetch deadline reached, query stopped");
+    return true;
+}
@@ -0,0 +1,183 @@
+#include "threshold_kernel.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define THRESHOLD_KERNEL_X86 1
+#endif
+
+namespace threshold_kernel {
+
+namespace {
+
+    enum class Implementation { AUTO, AVX2, SSE2, SCALAR };
+
+    std::atomic<Implementation> g_implementation{Implementation::AUTO};
+
+    template <ThresholdOp Op>
+    inline bool compare(double value, double threshold) {
+        switch (Op) {
+            case ThresholdOp::GT: return value > threshold;
+            case ThresholdOp::LT: return value < threshold;
+            case ThresholdOp::GE: return value >= threshold;
+            case ThresholdOp::LE: return value <= threshold;
+            case ThresholdOp::EQ: return value == threshold;
+            case ThresholdOp::NE: return value != threshold && value == value && threshold == threshold;  // NaN 不满足
+        }
+        return false;
+    }
+
+    // 一个位图字（最多64个值）的标量比较，也用于处理SIMD实现的尾部
+    template <ThresholdOp Op>
+    inline uint64_t compareWordScalar(const double* values, size_t n, double threshold) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bits |= static_cast<uint64_t>(compare<Op>(values[i], threshold)) << i;
+        }
+        return bits;
+    }
+
+    template <ThresholdOp Op>
+    void compareAndScalar(const double* values, size_t count, double threshold, uint64_t* mask) {
+        for (size_t w = 0; w * 64 < count; ++w) {
+            size_t n = count - w * 64 < 64 ? count - w * 64 : 64;
+            mask[w] &= compareWordScalar<Op>(values + w * 64, n, threshold);
+        }
+    }
+
+#ifdef THRESHOLD_KERNEL_X86
+    template <ThresholdOp Op>
+    inline __m128d compareSse2(__m128d v, __m128d t) {
+        switch (Op) {
+            case ThresholdOp::GT: return _mm_cmpgt_pd(v, t);
+            case ThresholdOp::LT: return _mm_cmplt_pd(v, t);
+            case ThresholdOp::GE: return _mm_cmpge_pd(v, t);
+            case ThresholdOp::LE: return _mm_cmple_pd(v, t);
+            case ThresholdOp::EQ: return _mm_cmpeq_pd(v, t);
+            case ThresholdOp::NE: return _mm_and_pd(_mm_cmpneq_pd(v, t), _mm_cmpord_pd(v, t));
+        }
+        return _mm_setzero_pd();
+    }
+
+    template <ThresholdOp Op>
+    void compareAndSse2(const double* values, size_t count, double threshold, uint64_t* mask) {
+        const __m128d t = _mm_set1_pd(threshold);
+        size_t w = 0;
+        for (; (w + 1) * 64 <= count; ++w) {
+            const double* block = values + w * 64;
+            uint64_t bits = 0;
+            for (size_t i = 0; i < 64; i += 2) {
+                int m = _mm_movemask_pd(compareSse2<Op>(_mm_loadu_pd(block + i), t));
+                bits |= static_cast<uint64_t>(m) << i;
+            }
+            mask[w] &= bits;
+        }
+        if (w * 64 < count) {
+            mask[w] &= compareWordScalar<Op>(values + w * 64, count - w * 64, threshold);
+        }
+    }
+
+    // 谓词使用有序比较（_OQ），NaN 比较结果为假
+    template <ThresholdOp Op, int Predicate>
+    __attribute__((target("avx2")))
+    void compareAndAvx2(const double* values, size_t count, double threshold, uint64_t* mask) {
+        const __m256d t = _mm256_set1_pd(threshold);
+        size_t w = 0;
+        for (; (w + 1) * 64 <= count; ++w) {
+            const double* block = values + w * 64;
+            uint64_t bits = 0;
+            for (size_t i = 0; i < 64; i += 4) {
+                int m = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(block + i), t, Predicate));
+                bits |= static_cast<uint64_t>(m) << i;
+            }
+            mask[w] &= bits;
+        }
+        if (w * 64 < count) {
+            mask[w] &= compareWordScalar<Op>(values + w * 64, count - w * 64, threshold);
+        }
+    }
+
+    bool hasAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+#endif
+
+    template <ThresholdOp Op>
+    void dispatch(const double* values, size_t count, double threshold, uint64_t* mask) {
+        const Implementation forced = g_implementation.load(std::memory_order_relaxed);
+        if (forced == Implementation::SCALAR) {
+            return compareAndScalar<Op>(values, count, threshold, mask);
+        }
+#ifdef THRESHOLD_KERNEL_X86
+        if (forced != Implementation::SSE2 && hasAvx2()) {
+            switch (Op) {
+                case ThresholdOp::GT: return compareAndAvx2<Op, _CMP_GT_OQ>(values, count, threshold, mask);
+                case ThresholdOp::LT: return compareAndAvx2<Op, _CMP_LT_OQ>(values, count, threshold, mask);
+                case ThresholdOp::GE: return compareAndAvx2<Op, _CMP_GE_OQ>(values, count, threshold, mask);
+                case ThresholdOp::LE: return compareAndAvx2<Op, _CMP_LE_OQ>(values, count, threshold, mask);
+                case ThresholdOp::EQ: return compareAndAvx2<Op, _CMP_EQ_OQ>(values, count, threshold, mask);
+                case ThresholdOp::NE: return compareAndAvx2<Op, _CMP_NEQ_OQ>(values, count, threshold, mask);
+            }
+        }
+        compareAndSse2<Op>(values, count, threshold, mask);
+#else
+        compareAndScalar<Op>(values, count, threshold, mask);
+#endif
+    }
+
+}  // namespace
+
+std::vector<uint64_t> fullMask(size_t count) {
+    std::vector<uint64_t> mask(maskWords(count), ~0ULL);
+    if (count % 64 != 0) {
+        mask.back() = (1ULL << (count % 64)) - 1;
+    }
+    return mask;
+}
+
+void compareAnd(const double* values, size_t count, ThresholdOp op, double threshold, uint64_t* mask) {
+    switch (op) {
+        case ThresholdOp::GT: return dispatch<ThresholdOp::GT>(values, count, threshold, mask);
+        case ThresholdOp::LT: return dispatch<ThresholdOp::LT>(values, count, threshold, mask);
+        case ThresholdOp::GE: return dispatch<ThresholdOp::GE>(values, count, threshold, mask);
+        case ThresholdOp::LE: return dispatch<ThresholdOp::LE>(values, count, threshold, mask);
+        case ThresholdOp::EQ: return dispatch<ThresholdOp::EQ>(values, count, threshold, mask);
+        case ThresholdOp::NE: return dispatch<ThresholdOp::NE>(values, count, threshold, mask);
+    }
+}
+
+const char* implementation() {
+    const Implementation forced = g_implementation.load(std::memory_order_relaxed);
+    if (forced == Implementation::SCALAR) {
+        return "scalar";
+    }
+#ifdef THRESHOLD_KERNEL_X86
+    return forced != Implementation::SSE2 && hasAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+bool setImplementation(const char* name) {
+    Implementation implementation;
+    if (name == nullptr || name[0] == '\0') {
+        implementation = Implementation::AUTO;
+    } else if (std::strcmp(name, "scalar") == 0) {
+        implementation = Implementation::SCALAR;
+#ifdef THRESHOLD_KERNEL_X86
+    } else if (std::strcmp(name, "sse2") == 0) {
+        implementation = Implementation::SSE2;
+    } else if (std::strcmp(name, "avx2") == 0 && hasAvx2()) {
+        implementation = Implementation::AVX2;
+#endif
+    } else {
+        return false;
+    }
+    g_implementation.store(implementation, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace threshold_kernel
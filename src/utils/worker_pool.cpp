@@ -0,0 +1,85 @@
+#include "worker_pool.h"
+#include "log_manager.h"
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+WorkerPool::WorkerPool(size_t thread_count) {
+    thread_count = std::max<size_t>(1, thread_count);
+    m_threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void WorkerPool::runAll(std::vector<std::function<void()>> tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    struct Batch {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = tasks.size();
+
+    for (auto& task : tasks) {
+        submit([batch, task]() {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                LogManager::getLogger()->error("WorkerPool: task failed: {}", e.what());
+            }
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (--batch->remaining == 0) {
+                batch->done.notify_all();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch] { return batch->remaining == 0; });
+}
+
+void WorkerPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LogManager::getLogger()->error("WorkerPool: task failed: {}", e.what());
+        }
+    }
+}